@@ -0,0 +1,49 @@
+#ifndef NATIVE_PRINT_H
+#define NATIVE_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "WString.h"
+
+// Arduino Print and Stream: subclasses provide write(uint8_t), and may
+// override the buffer write and availableForWrite(). There is no virtual
+// destructor, so Serial stays usable from task threads while the program
+// exits.
+class Print {
+public:
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text);
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int number, int base = 10) { return print(String(number, (unsigned char)base)); }
+    size_t print(unsigned int number, int base = 10) { return print(String(number, (unsigned char)base)); }
+    size_t print(long number, int base = 10) { return print(String(number, (unsigned char)base)); }
+    size_t print(unsigned long number, int base = 10) { return print(String(number, (unsigned char)base)); }
+    size_t print(double number, int decimals = 2) { return print(String(number, (unsigned int)decimals)); }
+
+    size_t println() { return write("\r\n"); }
+    template<typename T>
+    size_t println(const T& value) { return print(value) + println(); }
+    template<typename T>
+    size_t println(const T& value, int format) { return print(value, format) + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    void setTimeout(unsigned long ms) { timeout_ms = ms; }
+
+protected:
+    unsigned long timeout_ms = 1000;
+};
+
+#endif // NATIVE_PRINT_H
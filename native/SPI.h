@@ -0,0 +1,67 @@
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+// A device model on the native SPI bus, e.g. the ST7789 panel emulator.
+// It sees every byte clocked out and answers with the byte clocked in;
+// chip select and D/C are ordinary GPIOs it reads with digitalRead().
+class NativeSpiDevice {
+public:
+    virtual ~NativeSpiDevice() {}
+    virtual uint8_t transfer(uint8_t data) = 0;
+};
+
+class SPISettings {
+public:
+    SPISettings(uint32_t clock = 1000000, uint8_t bit_order = MSBFIRST, uint8_t data_mode = SPI_MODE0)
+        : clock(clock), bit_order(bit_order), data_mode(data_mode) {}
+
+    uint32_t clock;
+    uint8_t bit_order;
+    uint8_t data_mode;
+};
+
+// SPI master on the host: with no device attached, writes are dropped and
+// reads return 0xFF as from an open bus. Counts the bytes transferred.
+class SPIClass {
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+    void end() { started = false; }
+
+    void setFrequency(uint32_t hz) { settings.clock = hz; }
+    void setDataMode(uint8_t mode) { settings.data_mode = mode; }
+    void setBitOrder(uint8_t order) { settings.bit_order = order; }
+    void beginTransaction(SPISettings new_settings) { settings = new_settings; }
+    void endTransaction() {}
+
+    uint8_t transfer(uint8_t data);
+    uint16_t transfer16(uint16_t data);
+    void transfer(void* data, uint32_t size);
+    void write(uint8_t data) { transfer(data); }
+    void write16(uint16_t data) { transfer16(data); }
+    void writeBytes(const uint8_t* data, uint32_t size);
+
+    // Native only
+    void attachDevice(NativeSpiDevice* model) { device = model; }
+    uint64_t getBytesTransferred() const { return bytes_transferred; }
+    bool isStarted() const { return started; }
+
+private:
+    NativeSpiDevice* device = nullptr;
+    SPISettings settings;
+    uint64_t bytes_transferred = 0;
+    bool started = false;
+};
+
+extern SPIClass SPI;
+
+#endif // NATIVE_SPI_H
@@ -0,0 +1,78 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Arduino String on std::string, for the native build. Numbers format as
+// the ESP32 core does: integers in the given base, floats with a fixed
+// number of decimals (2 by default).
+class String {
+public:
+    String() {}
+    String(const char* text) : value(text != nullptr ? text : "") {}
+    String(const std::string& text) : value(text) {}
+    explicit String(char c) : value(1, c) {}
+    explicit String(unsigned char number, unsigned char base = 10) : value(formatUnsigned(number, base)) {}
+    explicit String(int number, unsigned char base = 10) : value(formatSigned(number, base)) {}
+    explicit String(unsigned int number, unsigned char base = 10) : value(formatUnsigned(number, base)) {}
+    explicit String(long number, unsigned char base = 10) : value(formatSigned(number, base)) {}
+    explicit String(unsigned long number, unsigned char base = 10) : value(formatUnsigned(number, base)) {}
+    explicit String(long long number, unsigned char base = 10) : value(formatSigned(number, base)) {}
+    explicit String(unsigned long long number, unsigned char base = 10) : value(formatUnsigned(number, base)) {}
+    explicit String(float number, unsigned int decimals = 2) : value(formatFloat(number, decimals)) {}
+    explicit String(double number, unsigned int decimals = 2) : value(formatFloat(number, decimals)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return (unsigned int)value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+    const std::string& str() const { return value; }
+
+    String& concat(const String& other) { value += other.value; return *this; }
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String& operator+=(const char* other) { value += other; return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+
+    char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    int indexOf(char c, unsigned int from = 0) const { return position(value.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return position(value.find(text.value, from)); }
+    int lastIndexOf(char c) const { return position(value.rfind(c)); }
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+    bool endsWith(const String& suffix) const;
+
+    bool equals(const String& other) const { return value == other.value; }
+    bool equalsIgnoreCase(const String& other) const;
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == (other != nullptr ? other : ""); }
+    bool operator!=(const String& other) const { return value != other.value; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return value < other.value; }
+
+    long toInt() const;
+    float toFloat() const;
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+    void replace(const String& find, const String& replacement);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+
+private:
+    std::string value;
+
+    static int position(size_t found) { return found == std::string::npos ? -1 : (int)found; }
+    static std::string formatSigned(long long number, unsigned char base);
+    static std::string formatUnsigned(unsigned long long number, unsigned char base);
+    static std::string formatFloat(double number, unsigned int decimals);
+};
+
+inline String operator+(const String& a, const String& b) { return String(a.str() + b.str()); }
+inline String operator+(const String& a, const char* b) { return String(a.str() + b); }
+inline String operator+(const char* a, const String& b) { return String(a + b.str()); }
+inline String operator+(const String& a, char b) { return String(a.str() + b); }
+
+#endif // NATIVE_WSTRING_H
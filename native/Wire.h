@@ -0,0 +1,67 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+// A device model on the native I2C bus. write() gets each complete write
+// transaction (register address first), read() fills a read transaction;
+// both return false to NACK.
+class NativeI2cDevice {
+public:
+    virtual ~NativeI2cDevice() {}
+    virtual bool write(const uint8_t* data, size_t len) = 0;
+    virtual bool read(uint8_t* out, size_t len) = 0;
+};
+
+// TwoWire on the host. Addresses with no model attached NACK, so sensor
+// drivers report their part as missing, as on a board without it.
+class TwoWire : public Stream {
+public:
+    static const int BUFFER_LENGTH = 128;
+    static const int MAX_DEVICES = 8;
+
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    bool end() { return true; }
+    bool setClock(uint32_t hz) { clock_hz = hz; return true; }
+    uint32_t getClock() { return clock_hz; }
+    void setTimeOut(uint16_t ms) { (void)ms; }
+
+    void beginTransmission(uint16_t address);
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+    // 0 on success, 2 if the address NACKed, 1 if the data was too long
+    uint8_t endTransmission(bool send_stop = true);
+    size_t requestFrom(uint16_t address, size_t len, bool send_stop = true);
+
+    int available() override { return (int)(rx_length - rx_index); }
+    int read() override { return rx_index < rx_length ? rx_buffer[rx_index++] : -1; }
+    int peek() override { return rx_index < rx_length ? rx_buffer[rx_index] : -1; }
+
+    // Native only; a null model detaches the address
+    bool attachDevice(uint8_t address, NativeI2cDevice* model);
+
+private:
+    struct Attached {
+        uint8_t address;
+        NativeI2cDevice* model;
+    };
+
+    Attached devices[MAX_DEVICES];
+    int device_count = 0;
+    uint32_t clock_hz = 100000;
+    uint16_t tx_address = 0;
+    uint8_t tx_buffer[BUFFER_LENGTH];
+    size_t tx_length = 0;
+    bool tx_overflow = false;
+    uint8_t rx_buffer[BUFFER_LENGTH];
+    size_t rx_length = 0;
+    size_t rx_index = 0;
+
+    NativeI2cDevice* find(uint16_t address);
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif // NATIVE_WIRE_H
@@ -0,0 +1,362 @@
+#include <Arduino.h>
+#include <stdarg.h>
+#include <chrono>
+#include <mutex>
+#include "native_hal.h"
+
+EspClass ESP;
+HardwareSerial Serial;
+
+// --- Clock ---
+
+static const std::chrono::steady_clock::time_point clock_start = std::chrono::steady_clock::now();
+static std::mutex clock_lock;
+static uint64_t clock_offset_us = 0;
+static bool clock_manual = false;
+
+static uint64_t realMicros() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                           clock_start).count();
+}
+
+uint64_t nativeGetMicros() {
+    std::lock_guard<std::mutex> guard(clock_lock);
+    return clock_manual ? clock_offset_us : clock_offset_us + realMicros();
+}
+
+void nativeSetManualClock(bool manual) {
+    std::lock_guard<std::mutex> guard(clock_lock);
+    if (manual == clock_manual) {
+        return;
+    }
+    // Carry on from the current time either way
+    if (manual) {
+        clock_offset_us += realMicros();
+    } else {
+        clock_offset_us -= realMicros();
+    }
+    clock_manual = manual;
+}
+
+void nativeAdvanceMicros(uint64_t us) {
+    std::lock_guard<std::mutex> guard(clock_lock);
+    clock_offset_us += us;
+}
+
+void nativeSetMicros(uint64_t us) {
+    std::lock_guard<std::mutex> guard(clock_lock);
+    if (clock_manual && us > clock_offset_us) {
+        clock_offset_us = us;
+    }
+}
+
+unsigned long millis() {
+    return (unsigned long)(uint32_t)(nativeGetMicros() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)(uint32_t)nativeGetMicros();
+}
+
+void delay(uint32_t ms) {
+    nativeAdvanceMicros((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    nativeAdvanceMicros(us);
+}
+
+void yield() {
+}
+
+// --- GPIO ---
+
+struct Pin {
+    uint8_t mode;
+    uint8_t level;
+    uint16_t analog;
+    int interrupt_mode;
+    void (*handler)(void);
+};
+
+static Pin pins[NATIVE_PIN_COUNT];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < NATIVE_PIN_COUNT) {
+        pins[pin].mode = mode;
+        if (mode == INPUT_PULLUP) {
+            pins[pin].level = HIGH;
+        }
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < NATIVE_PIN_COUNT) {
+        pins[pin].level = value ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < NATIVE_PIN_COUNT ? pins[pin].level : LOW;
+}
+
+uint16_t analogRead(uint8_t pin) {
+    return pin < NATIVE_PIN_COUNT ? pins[pin].analog : 0;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+    if (pin < NATIVE_PIN_COUNT) {
+        pins[pin].handler = handler;
+        pins[pin].interrupt_mode = mode;
+    }
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin < NATIVE_PIN_COUNT) {
+        pins[pin].handler = nullptr;
+    }
+}
+
+uint8_t nativeGetPinMode(uint8_t pin) {
+    return pin < NATIVE_PIN_COUNT ? pins[pin].mode : 0;
+}
+
+void nativeSetPinLevel(uint8_t pin, int level) {
+    if (pin >= NATIVE_PIN_COUNT) {
+        return;
+    }
+    Pin& p = pins[pin];
+    uint8_t old_level = p.level;
+    p.level = level ? HIGH : LOW;
+    if (p.handler == nullptr || p.level == old_level) {
+        return;
+    }
+    bool rising = p.level == HIGH;
+    if (p.interrupt_mode == CHANGE || (p.interrupt_mode == RISING && rising) ||
+        (p.interrupt_mode == FALLING && !rising)) {
+        p.handler();
+    }
+}
+
+void nativeSetAnalogValue(uint8_t pin, uint16_t raw) {
+    if (pin < NATIVE_PIN_COUNT) {
+        pins[pin].analog = raw;
+    }
+}
+
+// --- Random numbers ---
+// A fixed-seed generator rather than the hardware RNG, so runs repeat
+
+static uint64_t random_state = 0x853C49E6748FEA9BULL;
+
+static uint32_t nextRandom() {
+    random_state = random_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(random_state >> 33);
+}
+
+long random(long max_value) {
+    return max_value <= 0 ? 0 : (long)(nextRandom() % (uint32_t)max_value);
+}
+
+long random(long min_value, long max_value) {
+    return min_value >= max_value ? min_value : min_value + random(max_value - min_value);
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) {
+        random_state = seed;
+    }
+}
+
+// --- Memory ---
+// The heap figures are not meaningful on the host and read as 0
+
+void* ps_malloc(size_t size) {
+    return malloc(size);
+}
+
+void* ps_calloc(size_t count, size_t size) {
+    return calloc(count, size);
+}
+
+void* ps_realloc(void* pointer, size_t size) {
+    return realloc(pointer, size);
+}
+
+bool psramFound() {
+    return true;
+}
+
+uint32_t EspClass::getHeapSize() { return 0; }
+uint32_t EspClass::getFreeHeap() { return 0; }
+uint32_t EspClass::getMinFreeHeap() { return 0; }
+uint32_t EspClass::getMaxAllocHeap() { return 0; }
+uint32_t EspClass::getPsramSize() { return 0; }
+uint32_t EspClass::getFreePsram() { return 0; }
+uint32_t EspClass::getMinFreePsram() { return 0; }
+uint32_t EspClass::getMaxAllocPsram() { return 0; }
+
+void EspClass::restart() {
+    fflush(stdout);
+    exit(0);
+}
+
+// --- Print and Serial ---
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (written < size && write(buffer[written]) == 1) {
+        written++;
+    }
+    return written;
+}
+
+size_t Print::write(const char* text) {
+    return text == nullptr ? 0 : write((const uint8_t*)text, strlen(text));
+}
+
+size_t Print::printf(const char* format, ...) {
+    char small[128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+    if ((size_t)length < sizeof(small)) {
+        return write((const uint8_t*)small, length);
+    }
+    char* large = (char*)malloc(length + 1);
+    if (large == nullptr) {
+        return 0;
+    }
+    va_start(args, format);
+    vsnprintf(large, length + 1, format, args);
+    va_end(args);
+    size_t written = write((const uint8_t*)large, length);
+    free(large);
+    return written;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+// --- String ---
+
+std::string String::formatSigned(long long number, unsigned char base) {
+    if (number < 0 && base == 10) {
+        return "-" + formatUnsigned(0ULL - (unsigned long long)number, base);
+    }
+    return formatUnsigned((unsigned long long)number, base);
+}
+
+std::string String::formatUnsigned(unsigned long long number, unsigned char base) {
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    char digits[65];
+    int pos = sizeof(digits) - 1;
+    digits[pos] = '\0';
+    do {
+        int digit = (int)(number % base);
+        digits[--pos] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        number /= base;
+    } while (number > 0);
+    return std::string(digits + pos);
+}
+
+std::string String::formatFloat(double number, unsigned int decimals) {
+    if (std::isnan(number)) {
+        return "nan";
+    }
+    if (std::isinf(number)) {
+        return number > 0 ? "inf" : "-inf";
+    }
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f", decimals > 20 ? 20 : (int)decimals, number);
+    return text;
+}
+
+String String::substring(unsigned int from) const {
+    return from < value.size() ? String(value.substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        std::swap(from, to);
+    }
+    return from < value.size() ? String(value.substr(from, to - from)) : String();
+}
+
+bool String::endsWith(const String& suffix) const {
+    return value.size() >= suffix.value.size() &&
+           value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+}
+
+bool String::equalsIgnoreCase(const String& other) const {
+    if (value.size() != other.value.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < value.size(); i++) {
+        if (tolower((unsigned char)value[i]) != tolower((unsigned char)other.value[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+long String::toInt() const {
+    return strtol(value.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+    return strtof(value.c_str(), nullptr);
+}
+
+void String::toLowerCase() {
+    for (char& c : value) {
+        c = (char)tolower((unsigned char)c);
+    }
+}
+
+void String::toUpperCase() {
+    for (char& c : value) {
+        c = (char)toupper((unsigned char)c);
+    }
+}
+
+void String::trim() {
+    size_t first = value.find_first_not_of(" \t\r\n\f\v");
+    if (first == std::string::npos) {
+        value.clear();
+        return;
+    }
+    size_t last = value.find_last_not_of(" \t\r\n\f\v");
+    value = value.substr(first, last - first + 1);
+}
+
+void String::replace(const String& find, const String& replacement) {
+    if (find.value.empty()) {
+        return;
+    }
+    for (size_t pos = value.find(find.value); pos != std::string::npos;
+         pos = value.find(find.value, pos + replacement.value.size())) {
+        value.replace(pos, find.value.size(), replacement.value);
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < value.size()) {
+        value.erase(index, count);
+    }
+}
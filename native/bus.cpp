@@ -0,0 +1,128 @@
+#include <SPI.h>
+#include <Wire.h>
+
+SPIClass SPI;
+TwoWire Wire;
+TwoWire Wire1;
+
+// --- SPI ---
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {
+    (void)sck;
+    (void)miso;
+    (void)mosi;
+    (void)ss;
+    started = true;
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+    bytes_transferred++;
+    return device != nullptr ? device->transfer(data) : 0xFF;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data) {
+    uint8_t high = transfer(data >> 8);
+    uint8_t low = transfer(data & 0xFF);
+    return ((uint16_t)high << 8) | low;
+}
+
+void SPIClass::transfer(void* data, uint32_t size) {
+    uint8_t* bytes = (uint8_t*)data;
+    for (uint32_t i = 0; i < size; i++) {
+        bytes[i] = transfer(bytes[i]);
+    }
+}
+
+void SPIClass::writeBytes(const uint8_t* data, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        transfer(data[i]);
+    }
+}
+
+// --- I2C ---
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+    (void)sda;
+    (void)scl;
+    if (frequency != 0) {
+        clock_hz = frequency;
+    }
+    return true;
+}
+
+bool TwoWire::attachDevice(uint8_t address, NativeI2cDevice* model) {
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i].address == address) {
+            if (model != nullptr) {
+                devices[i].model = model;
+            } else {
+                devices[i] = devices[--device_count];
+            }
+            return true;
+        }
+    }
+    if (model == nullptr) {
+        return true;
+    }
+    if (device_count >= MAX_DEVICES) {
+        return false;
+    }
+    devices[device_count++] = { address, model };
+    return true;
+}
+
+NativeI2cDevice* TwoWire::find(uint16_t address) {
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i].address == address) {
+            return devices[i].model;
+        }
+    }
+    return nullptr;
+}
+
+void TwoWire::beginTransmission(uint16_t address) {
+    tx_address = address;
+    tx_length = 0;
+    tx_overflow = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (tx_length >= sizeof(tx_buffer)) {
+        tx_overflow = true;
+        return 0;
+    }
+    tx_buffer[tx_length++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t len) {
+    size_t written = 0;
+    while (written < len && write(data[written]) == 1) {
+        written++;
+    }
+    return written;
+}
+
+uint8_t TwoWire::endTransmission(bool send_stop) {
+    (void)send_stop;
+    if (tx_overflow) {
+        return 1;
+    }
+    NativeI2cDevice* model = find(tx_address);
+    if (model == nullptr) {
+        return 2;
+    }
+    return model->write(tx_buffer, tx_length) ? 0 : 3;
+}
+
+size_t TwoWire::requestFrom(uint16_t address, size_t len, bool send_stop) {
+    (void)send_stop;
+    rx_index = 0;
+    rx_length = 0;
+    NativeI2cDevice* model = find(address);
+    if (model == nullptr || len > sizeof(rx_buffer) || !model->read(rx_buffer, len)) {
+        return 0;
+    }
+    rx_length = len;
+    return len;
+}
@@ -0,0 +1,165 @@
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct NativeTask {
+    std::mutex lock;
+    std::condition_variable notified;
+    uint32_t notifications = 0;
+};
+
+struct NativeSemaphore {
+    std::mutex lock;
+    std::condition_variable given;
+    UBaseType_t count;
+    UBaseType_t max_count;
+};
+
+static thread_local NativeTask* current_task = nullptr;
+
+// Waits on a condition for up to ticks (ms), or for ever
+template<typename Predicate>
+static bool waitFor(std::condition_variable& condition, std::unique_lock<std::mutex>& guard, TickType_t ticks,
+                    Predicate ready) {
+    if (ticks == portMAX_DELAY) {
+        condition.wait(guard, ready);
+        return true;
+    }
+    return condition.wait_for(guard, std::chrono::milliseconds(ticks), ready);
+}
+
+// --- Critical sections ---
+
+static uint32_t threadToken() {
+    static std::atomic<uint32_t> next_token(1);
+    static thread_local uint32_t token = next_token++;
+    return token;
+}
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+    uint32_t self = threadToken();
+    if (__atomic_load_n(&mux->owner, __ATOMIC_ACQUIRE) == self) {
+        mux->count++;
+        return;
+    }
+    uint32_t expected = 0;
+    while (!__atomic_compare_exchange_n(&mux->owner, &expected, self, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        expected = 0;
+        std::this_thread::yield();
+    }
+    mux->count = 1;
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+    if (--mux->count == 0) {
+        __atomic_store_n(&mux->owner, 0, __ATOMIC_RELEASE);
+    }
+}
+
+// --- Tasks ---
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth, void* param,
+                                   UBaseType_t priority, TaskHandle_t* created, BaseType_t core) {
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    (void)core;
+    NativeTask* task = new NativeTask();
+    if (created != nullptr) {
+        *created = task;
+    }
+    std::thread([function, param, task]() {
+        current_task = task;
+        function(param);
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* param,
+                       UBaseType_t priority, TaskHandle_t* created) {
+    return xTaskCreatePinnedToCore(function, name, stack_depth, param, priority, created, 0);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (current_task == nullptr) {
+        current_task = new NativeTask();
+    }
+    return current_task;
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+// Task delays are real sleeps: they pace other threads, not the program clock
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+    }
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if (task == nullptr) {
+        return pdFAIL;
+    }
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->notifications++;
+    task->notified.notify_one();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    NativeTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> guard(task->lock);
+    waitFor(task->notified, guard, ticks_to_wait, [task]() { return task->notifications > 0; });
+    uint32_t value = task->notifications;
+    if (value > 0) {
+        task->notifications = clear_on_exit ? 0 : value - 1;
+    }
+    return value;
+}
+
+// --- Semaphores ---
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    NativeSemaphore* semaphore = new NativeSemaphore();
+    semaphore->count = initial_count;
+    semaphore->max_count = max_count;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> guard(semaphore->lock);
+    if (!waitFor(semaphore->given, guard, ticks_to_wait, [semaphore]() { return semaphore->count > 0; })) {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> guard(semaphore->lock);
+    if (semaphore->count >= semaphore->max_count) {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    semaphore->given.notify_one();
+    return pdTRUE;
+}
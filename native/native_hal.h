@@ -0,0 +1,31 @@
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <stdint.h>
+
+// What the native build lets a host program see and drive behind the
+// Arduino API.
+//
+// Clock: micros() starts at 0 when the program starts. By default it
+// follows real time, and delay()/delayMicroseconds() move it on without
+// sleeping, so boot waits and panel resets take no wall-clock time. With a
+// manual clock, time only moves when the program says so - delay() or
+// nativeAdvanceMicros() - and every run sees the same timestamps.
+//
+// GPIO: pins keep the last level written; inputs read what
+// nativeSetPinLevel() set, analogRead() what nativeSetAnalogValue() set.
+// A rising or falling edge set from the host calls the attached interrupt
+// handler.
+
+void nativeSetManualClock(bool manual);
+void nativeAdvanceMicros(uint64_t us);
+void nativeSetMicros(uint64_t us);      // Manual clock only; never goes back
+uint64_t nativeGetMicros();             // 64-bit, without the 32-bit wrap
+
+static const int NATIVE_PIN_COUNT = 49;
+
+uint8_t nativeGetPinMode(uint8_t pin);
+void nativeSetPinLevel(uint8_t pin, int level);
+void nativeSetAnalogValue(uint8_t pin, uint16_t raw);
+
+#endif // NATIVE_HAL_H
@@ -0,0 +1,466 @@
+#include "sensor_models.h"
+#include "native_hal.h"
+
+static bool timeReached(uint32_t now_us, uint32_t at_us) {
+    return (int32_t)(now_us - at_us) >= 0;
+}
+
+// --- BMP180 ---
+
+static const uint8_t BMP180_REG_CALIBRATION = 0xAA;
+static const uint8_t BMP180_REG_CHIP_ID = 0xD0;
+static const uint8_t BMP180_REG_CONTROL = 0xF4;
+static const uint8_t BMP180_REG_RESULT = 0xF6;
+static const uint8_t BMP180_CONTROL_SCO = 0x20;    // Conversion running
+
+// Maximum conversion times from the datasheet, by oversampling setting
+static const uint32_t bmp180_pressure_us[4] = { 4500, 7500, 13500, 25500 };
+static const uint32_t bmp180_temperature_us = 4500;
+
+Bmp180Model::Bmp180Model(const Calibration& cal) {
+    memset(registers, 0, sizeof(registers));
+    registers[BMP180_REG_CHIP_ID] = 0x55;
+    const uint16_t words[11] = { (uint16_t)cal.ac1, (uint16_t)cal.ac2, (uint16_t)cal.ac3, cal.ac4, cal.ac5, cal.ac6,
+                                 (uint16_t)cal.b1, (uint16_t)cal.b2, (uint16_t)cal.mb, (uint16_t)cal.mc,
+                                 (uint16_t)cal.md };
+    for (int i = 0; i < 11; i++) {
+        registers[BMP180_REG_CALIBRATION + i * 2] = words[i] >> 8;
+        registers[BMP180_REG_CALIBRATION + i * 2 + 1] = words[i] & 0xFF;
+    }
+    pointer = 0;
+    result = 0;
+    ready_us = 0;
+    converting = false;
+    raw_temperature = 0;
+    raw_pressure = 0;
+    conversions = 0;
+}
+
+bool Bmp180Model::write(const uint8_t* data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    pointer = data[0];
+    if (len < 2) {
+        return true;
+    }
+    finishConversion();
+    registers[pointer] = data[1];
+    if (pointer != BMP180_REG_CONTROL) {
+        return true;
+    }
+
+    uint8_t oss = data[1] >> 6;
+    if ((data[1] & 0x3F) == 0x2E) {
+        result = (uint32_t)raw_temperature << 8;
+        ready_us = micros() + bmp180_temperature_us;
+    } else if ((data[1] & 0x3F) == 0x34) {
+        result = (raw_pressure << (8 - oss)) & 0xFFFFFF;
+        ready_us = micros() + bmp180_pressure_us[oss];
+    } else {
+        return true;
+    }
+    registers[BMP180_REG_CONTROL] |= BMP180_CONTROL_SCO;
+    converting = true;
+    conversions++;
+    return true;
+}
+
+void Bmp180Model::finishConversion() {
+    if (!converting || !timeReached(micros(), ready_us)) {
+        return;
+    }
+    registers[BMP180_REG_RESULT] = result >> 16;
+    registers[BMP180_REG_RESULT + 1] = (result >> 8) & 0xFF;
+    registers[BMP180_REG_RESULT + 2] = result & 0xFF;
+    registers[BMP180_REG_CONTROL] &= ~BMP180_CONTROL_SCO;
+    converting = false;
+}
+
+bool Bmp180Model::read(uint8_t* out, size_t len) {
+    finishConversion();
+    for (size_t i = 0; i < len; i++) {
+        out[i] = registers[pointer++];
+    }
+    return true;
+}
+
+// --- MS5611 ---
+
+static const uint8_t MS5611_CMD_RESET = 0x1E;
+static const uint8_t MS5611_CMD_ADC_READ = 0x00;
+static const uint8_t MS5611_CMD_D1 = 0x40;
+static const uint8_t MS5611_CMD_D2 = 0x50;
+static const uint8_t MS5611_CMD_PROM = 0xA0;
+
+// Maximum conversion times for OSR 256..4096
+static const uint32_t ms5611_conversion_us[5] = { 600, 1170, 2280, 4540, 9040 };
+
+// CRC4 over the PROM, application note AN520 (written out separately from
+// the driver's copy)
+static uint8_t ms5611Crc(const uint16_t* prom) {
+    uint16_t rem = 0;
+    for (int i = 0; i < 16; i++) {
+        uint16_t word = i / 2 == 7 ? (prom[7] & 0xFF00) : prom[i / 2];
+        rem ^= (i % 2 == 0) ? (word >> 8) : (word & 0xFF);
+        for (int bit = 0; bit < 8; bit++) {
+            rem = (rem & 0x8000) ? (uint16_t)((rem << 1) ^ 0x3000) : (uint16_t)(rem << 1);
+        }
+    }
+    return (rem >> 12) & 0x0F;
+}
+
+Ms5611Model::Ms5611Model(const uint16_t coefficients[6]) {
+    prom[0] = 0x0C1A;   // Factory data
+    for (int i = 0; i < 6; i++) {
+        prom[i + 1] = coefficients[i];
+    }
+    prom[7] = 0x4D20;   // Serial code; the CRC goes in the low nibble
+    prom[7] |= ms5611Crc(prom);
+    command = MS5611_CMD_RESET;
+    adc = 0;
+    conversion_us = 0;
+    start_us = 0;
+    converting = false;
+    raw_pressure = 0;
+    raw_temperature = 0;
+    conversions = 0;
+    early_reads = 0;
+}
+
+bool Ms5611Model::write(const uint8_t* data, size_t len) {
+    if (len != 1) {
+        return len == 0;
+    }
+    uint8_t cmd = data[0];
+    uint8_t osr = (cmd & 0x0F) / 2;
+    if (cmd == MS5611_CMD_RESET) {
+        converting = false;
+        adc = 0;
+    } else if ((cmd & 0xF0) == MS5611_CMD_D1 || (cmd & 0xF0) == MS5611_CMD_D2) {
+        if (osr > 4 || (cmd & 0x01) != 0) {
+            return true;   // Not a conversion command; ignored
+        }
+        adc = (cmd & 0xF0) == MS5611_CMD_D1 ? raw_pressure : raw_temperature;
+        conversion_us = ms5611_conversion_us[osr];
+        start_us = micros();
+        converting = true;
+        conversions++;
+    }
+    command = cmd;
+    return true;
+}
+
+bool Ms5611Model::read(uint8_t* out, size_t len) {
+    uint32_t value = 0;
+    size_t width = 0;
+    if (command >= MS5611_CMD_PROM && command <= MS5611_CMD_PROM + 14 && (command & 0x01) == 0) {
+        value = prom[(command - MS5611_CMD_PROM) / 2];
+        width = 2;
+    } else if (command == MS5611_CMD_ADC_READ) {
+        if (converting && timeReached(micros(), start_us + conversion_us)) {
+            value = adc;
+        } else if (converting) {
+            early_reads++;
+        }
+        converting = false;   // One read per conversion; the next one reads 0
+        width = 3;
+    }
+    for (size_t i = 0; i < len; i++) {
+        out[i] = i < width ? (value >> (8 * (width - 1 - i))) & 0xFF : 0;
+    }
+    return true;
+}
+
+// --- BMP388 / BMP390 ---
+
+static const uint8_t BMP3_REG_CHIP_ID = 0x00;
+static const uint8_t BMP3_REG_FIFO_LENGTH = 0x12;
+static const uint8_t BMP3_REG_FIFO_DATA = 0x14;
+static const uint8_t BMP3_REG_FIFO_CONFIG1 = 0x17;
+static const uint8_t BMP3_REG_FIFO_CONFIG2 = 0x18;
+static const uint8_t BMP3_REG_OSR = 0x1C;
+static const uint8_t BMP3_REG_CALIBRATION = 0x31;
+static const uint8_t BMP3_REG_CMD = 0x7E;
+
+static const uint8_t BMP3_FIFO_MODE = 0x01;
+static const uint8_t BMP3_FIFO_STOP_ON_FULL = 0x02;
+static const uint8_t BMP3_FIFO_PRESS_EN = 0x08;
+static const uint8_t BMP3_FIFO_TEMP_EN = 0x10;
+
+Bmp3Model::Bmp3Model(uint8_t chip_id, const uint8_t calibration[21]) {
+    memset(registers, 0, sizeof(registers));
+    registers[BMP3_REG_CHIP_ID] = chip_id;
+    memcpy(&registers[BMP3_REG_CALIBRATION], calibration, 21);
+    pointer = 0;
+    dropped_frames = 0;
+    reset();
+}
+
+// Reset values of the configuration registers (datasheet section 4.3)
+void Bmp3Model::reset() {
+    memset(&registers[0x15], 0, 0x20 - 0x15);
+    registers[BMP3_REG_FIFO_CONFIG1] = BMP3_FIFO_STOP_ON_FULL;
+    registers[BMP3_REG_FIFO_CONFIG2] = 0x02;
+    registers[BMP3_REG_OSR] = 0x02;
+    fifo_length = 0;
+}
+
+size_t Bmp3Model::frameLength(uint8_t header) {
+    switch (header) {
+        case 0x94:
+            return 7;
+        case 0x90:
+        case 0x84:
+        case 0xA0:
+            return 4;
+        case 0x44:
+        case 0x48:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+void Bmp3Model::dropOldestFrame() {
+    size_t len = frameLength(fifo[0]);
+    memmove(fifo, fifo + len, fifo_length - len);
+    fifo_length -= len;
+    dropped_frames++;
+}
+
+void Bmp3Model::addFrame(uint8_t header, const uint8_t* payload, size_t len) {
+    while (fifo_length + 1 + len > FIFO_SIZE) {
+        if (registers[BMP3_REG_FIFO_CONFIG1] & BMP3_FIFO_STOP_ON_FULL) {
+            dropped_frames++;
+            return;
+        }
+        dropOldestFrame();
+    }
+    fifo[fifo_length++] = header;
+    memcpy(fifo + fifo_length, payload, len);
+    fifo_length += len;
+}
+
+void Bmp3Model::measure(uint32_t raw_temperature, uint32_t raw_pressure) {
+    uint8_t config = registers[BMP3_REG_FIFO_CONFIG1];
+    if (!(config & BMP3_FIFO_MODE)) {
+        return;
+    }
+    bool temperature = config & BMP3_FIFO_TEMP_EN;
+    bool pressure = config & BMP3_FIFO_PRESS_EN;
+    uint8_t payload[6];
+    size_t len = 0;
+    if (temperature) {
+        for (int i = 0; i < 3; i++) {
+            payload[len++] = (raw_temperature >> (8 * i)) & 0xFF;
+        }
+    }
+    if (pressure) {
+        for (int i = 0; i < 3; i++) {
+            payload[len++] = (raw_pressure >> (8 * i)) & 0xFF;
+        }
+    }
+    if (temperature || pressure) {
+        addFrame(0x80 | (pressure ? 0x04 : 0) | (temperature ? 0x10 : 0), payload, len);
+    }
+}
+
+bool Bmp3Model::write(const uint8_t* data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    pointer = data[0];
+    // Burst writes alternate register and value
+    for (size_t i = 1; i < len; i += 2) {
+        uint8_t reg = data[i - 1];
+        uint8_t value = data[i];
+        if (reg == BMP3_REG_CMD) {
+            if (value == 0xB0) {
+                fifo_length = 0;
+            } else if (value == 0xB6) {
+                reset();
+            }
+        } else if (reg >= 0x15 && reg < 0x20) {
+            registers[reg] = value;
+        }
+    }
+    return true;
+}
+
+bool Bmp3Model::read(uint8_t* out, size_t len) {
+    if (pointer != BMP3_REG_FIFO_DATA) {
+        registers[BMP3_REG_FIFO_LENGTH] = fifo_length & 0xFF;
+        registers[BMP3_REG_FIFO_LENGTH + 1] = (fifo_length >> 8) & 0x01;
+        for (size_t i = 0; i < len; i++) {
+            out[i] = registers[pointer++ & 0x7F];
+        }
+        return true;
+    }
+
+    // Whole frames only; a partial one stays for the next read
+    size_t pos = 0;
+    while (fifo_length > 0 && pos + frameLength(fifo[0]) <= len) {
+        size_t frame = frameLength(fifo[0]);
+        memcpy(out + pos, fifo, frame);
+        memmove(fifo, fifo + frame, fifo_length - frame);
+        fifo_length -= frame;
+        pos += frame;
+    }
+    if (fifo_length > 0) {
+        size_t partial = len - pos;
+        memcpy(out + pos, fifo, partial);
+        return true;
+    }
+    // Past the end: empty frames, a header and a dummy byte each
+    for (size_t i = 0; pos < len; i++) {
+        out[pos++] = i % 2 == 0 ? 0x80 : 0x00;
+    }
+    return true;
+}
+
+// --- QMI8658C ---
+
+static const uint8_t QMI_REG_WHO_AM_I = 0x00;
+static const uint8_t QMI_REG_CTRL7 = 0x08;
+static const uint8_t QMI_REG_CTRL9 = 0x0A;
+static const uint8_t QMI_REG_FIFO_WTM_TH = 0x13;
+static const uint8_t QMI_REG_FIFO_CTRL = 0x14;
+static const uint8_t QMI_REG_FIFO_SMPL_CNT = 0x15;
+static const uint8_t QMI_REG_FIFO_STATUS = 0x16;
+static const uint8_t QMI_REG_FIFO_DATA = 0x17;
+static const uint8_t QMI_REG_STATUSINT = 0x2D;
+static const uint8_t QMI_REG_RESET = 0x60;
+
+static const uint8_t QMI_FIFO_RD_MODE = 0x80;
+static const uint8_t QMI_FIFO_MODE_FIFO = 0x01;
+static const uint8_t QMI_FIFO_MODE_STREAM = 0x02;
+static const uint8_t QMI_STATUS_FULL = 0x80;
+static const uint8_t QMI_STATUS_WTM = 0x40;
+static const uint8_t QMI_STATUS_OVERFLOW = 0x20;
+static const uint8_t QMI_STATUS_NOT_EMPTY = 0x10;
+static const uint8_t QMI_STATUSINT_CMD_DONE = 0x80;
+
+static const uint8_t QMI_CMD_ACK = 0x00;
+static const uint8_t QMI_CMD_RST_FIFO = 0x04;
+static const uint8_t QMI_CMD_REQ_FIFO = 0x05;
+
+Qmi8658Model::Qmi8658Model(int pin) {
+    int2_pin = pin;
+    pointer = 0;
+    overwritten = 0;
+    bad_fifo_reads = 0;
+    fifo_reads = 0;
+    reset();
+}
+
+void Qmi8658Model::reset() {
+    memset(registers, 0, sizeof(registers));
+    registers[QMI_REG_WHO_AM_I] = 0x05;
+    registers[0x01] = 0x7C;   // Revision ID
+    fifo_length = 0;
+    overflow = false;
+    updateInterrupt();
+}
+
+size_t Qmi8658Model::fifoCapacity() const {
+    return (size_t)16 << ((registers[QMI_REG_FIFO_CTRL] >> 2) & 0x03);
+}
+
+void Qmi8658Model::updateInterrupt() {
+    if (int2_pin < 0) {
+        return;
+    }
+    uint8_t watermark = registers[QMI_REG_FIFO_WTM_TH];
+    bool high = watermark > 0 && getFifoSamples() >= watermark;
+    nativeSetPinLevel(int2_pin, high ? HIGH : LOW);
+}
+
+void Qmi8658Model::runCommand(uint8_t cmd) {
+    if (cmd == QMI_CMD_ACK) {
+        registers[QMI_REG_STATUSINT] &= ~QMI_STATUSINT_CMD_DONE;
+        return;
+    }
+    if (cmd == QMI_CMD_RST_FIFO) {
+        fifo_length = 0;
+        overflow = false;
+        updateInterrupt();
+    } else if (cmd == QMI_CMD_REQ_FIFO) {
+        registers[QMI_REG_FIFO_CTRL] |= QMI_FIFO_RD_MODE;
+        overflow = false;
+    }
+    registers[QMI_REG_STATUSINT] |= QMI_STATUSINT_CMD_DONE;
+}
+
+void Qmi8658Model::measure(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz) {
+    uint8_t mode = registers[QMI_REG_FIFO_CTRL] & 0x03;
+    if ((registers[QMI_REG_CTRL7] & 0x03) != 0x03 || isFifoReadMode() ||
+        (mode != QMI_FIFO_MODE_FIFO && mode != QMI_FIFO_MODE_STREAM)) {
+        return;
+    }
+    if (getFifoSamples() >= fifoCapacity()) {
+        if (mode == QMI_FIFO_MODE_FIFO) {
+            return;
+        }
+        memmove(fifo, fifo + SAMPLE_BYTES, fifo_length - SAMPLE_BYTES);
+        fifo_length -= SAMPLE_BYTES;
+        overwritten++;
+        overflow = true;
+    }
+    const int16_t values[6] = { ax, ay, az, gx, gy, gz };
+    for (int i = 0; i < 6; i++) {
+        fifo[fifo_length++] = (uint16_t)values[i] & 0xFF;
+        fifo[fifo_length++] = (uint16_t)values[i] >> 8;
+    }
+    updateInterrupt();
+}
+
+bool Qmi8658Model::write(const uint8_t* data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    pointer = data[0];
+    for (size_t i = 1; i < len; i++) {
+        uint8_t reg = pointer++ & 0x7F;
+        if (reg == QMI_REG_RESET) {
+            if (data[i] == 0xB0) {
+                reset();
+            }
+        } else if (reg == QMI_REG_CTRL9) {
+            runCommand(data[i]);
+        } else if ((reg >= 0x02 && reg <= 0x0A) || reg == QMI_REG_FIFO_WTM_TH || reg == QMI_REG_FIFO_CTRL) {
+            registers[reg] = data[i];
+        }
+    }
+    return true;
+}
+
+bool Qmi8658Model::read(uint8_t* out, size_t len) {
+    if (pointer == QMI_REG_FIFO_DATA) {
+        fifo_reads++;
+        if (!isFifoReadMode()) {
+            bad_fifo_reads++;
+            memset(out, 0, len);
+            return true;
+        }
+        size_t n = len < fifo_length ? len : fifo_length;
+        memcpy(out, fifo, n);
+        memmove(fifo, fifo + n, fifo_length - n);
+        fifo_length -= n;
+        memset(out + n, 0, len - n);
+        updateInterrupt();
+        return true;
+    }
+
+    size_t words = fifo_length / 2;
+    registers[QMI_REG_FIFO_SMPL_CNT] = words & 0xFF;
+    registers[QMI_REG_FIFO_STATUS] = (uint8_t)((words >> 8) & 0x03) |
+                                     (getFifoSamples() >= fifoCapacity() ? QMI_STATUS_FULL : 0) |
+                                     (registers[QMI_REG_FIFO_WTM_TH] > 0 &&
+                                      getFifoSamples() >= registers[QMI_REG_FIFO_WTM_TH] ? QMI_STATUS_WTM : 0) |
+                                     (overflow ? QMI_STATUS_OVERFLOW : 0) | (fifo_length > 0 ? QMI_STATUS_NOT_EMPTY : 0);
+    for (size_t i = 0; i < len; i++) {
+        out[i] = registers[pointer++ & 0x7F];
+    }
+    return true;
+}
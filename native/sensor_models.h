@@ -0,0 +1,151 @@
+#ifndef SENSOR_MODELS_H
+#define SENSOR_MODELS_H
+
+#include <Wire.h>
+
+// Register models of the barometers and the IMU for the native I2C bus, so
+// the drivers in src/ can be run against them on a host. Each one answers
+// the part's register protocol from its datasheet, with conversion times on
+// micros(), and takes its raw ADC values from the program. Attach one with
+// Wire.attachDevice(address, &model).
+
+// BMP180: chip ID, 22-byte calibration EEPROM at 0xAA, and a control
+// register that starts a temperature or pressure conversion. The result
+// register keeps the previous result until the conversion time has passed.
+class Bmp180Model : public NativeI2cDevice {
+public:
+    struct Calibration {
+        int16_t ac1, ac2, ac3;
+        uint16_t ac4, ac5, ac6;
+        int16_t b1, b2, mb, mc, md;
+    };
+
+    explicit Bmp180Model(const Calibration& calibration);
+
+    bool write(const uint8_t* data, size_t len) override;
+    bool read(uint8_t* out, size_t len) override;
+
+    // Raw values the next conversions return (UP before the oss shift)
+    void setRaw(uint16_t ut, uint32_t up) { raw_temperature = ut; raw_pressure = up; }
+    uint32_t getConversions() const { return conversions; }
+
+private:
+    uint8_t registers[256];
+    uint8_t pointer;
+    uint32_t result;            // Loaded into 0xF6-0xF8 once ready
+    uint32_t ready_us;
+    bool converting;
+    uint16_t raw_temperature;
+    uint32_t raw_pressure;
+    uint32_t conversions;
+
+    void finishConversion();
+};
+
+// MS5611: reset, PROM read (0xA0-0xAE, CRC4 in the last word), D1/D2
+// conversion commands and the ADC read command. Reading the ADC before
+// the conversion is done, or twice, returns 0, as the part does.
+class Ms5611Model : public NativeI2cDevice {
+public:
+    // coefficients[0..5] are the datasheet's C1..C6
+    explicit Ms5611Model(const uint16_t coefficients[6]);
+
+    bool write(const uint8_t* data, size_t len) override;
+    bool read(uint8_t* out, size_t len) override;
+
+    void setRaw(uint32_t d1, uint32_t d2) { raw_pressure = d1; raw_temperature = d2; }
+    uint32_t getConversions() const { return conversions; }
+    uint32_t getEarlyReads() const { return early_reads; }
+
+private:
+    uint16_t prom[8];
+    uint8_t command;
+    uint32_t adc;
+    uint32_t conversion_us;     // Conversion time of the OSR in progress
+    uint32_t start_us;
+    bool converting;
+    uint32_t raw_pressure;
+    uint32_t raw_temperature;
+    uint32_t conversions;
+    uint32_t early_reads;
+};
+
+// BMP388/BMP390: chip ID, calibration NVM at 0x31, configuration registers
+// and the 512-byte FIFO. The program adds measurements with measure(), which
+// stores them as FIFO_CONFIG1 selects (pressure + temperature, either one,
+// or nothing while the FIFO is off); when the FIFO is full the oldest frame
+// is overwritten unless stop-on-full is set. A burst read of FIFO_DATA
+// returns whole frames, and a frame that did not fit is sent again by the
+// next read; past the last frame it reads as empty (0x80).
+class Bmp3Model : public NativeI2cDevice {
+public:
+    static const size_t FIFO_SIZE = 512;
+
+    Bmp3Model(uint8_t chip_id, const uint8_t calibration[21]);
+
+    bool write(const uint8_t* data, size_t len) override;
+    bool read(uint8_t* out, size_t len) override;
+
+    void measure(uint32_t raw_temperature, uint32_t raw_pressure);
+    void addFrame(uint8_t header, const uint8_t* payload, size_t len);   // Any frame, as is
+
+    uint8_t getRegister(uint8_t reg) const { return registers[reg]; }
+    size_t getFifoBytes() const { return fifo_length; }
+    uint32_t getDroppedFrames() const { return dropped_frames; }
+
+private:
+    uint8_t registers[128];
+    uint8_t pointer;
+    uint8_t fifo[FIFO_SIZE];
+    size_t fifo_length;
+    uint32_t dropped_frames;
+
+    static size_t frameLength(uint8_t header);
+    void reset();
+    void dropOldestFrame();
+};
+
+// QMI8658C: WHO_AM_I, soft reset, the control registers, CTRL9 host
+// commands (CmdDone in STATUSINT until the host acks) and the FIFO. The
+// program adds samples with measure(), which go into the FIFO while both
+// sensors are on and it is not being read; stream mode overwrites the
+// oldest sample when full and flags the overflow in FIFO_STATUS, FIFO mode
+// stops. FIFO_DATA reads out only after CTRL_CMD_REQ_FIFO has put the FIFO
+// in read mode, until the host clears FIFO_CTRL bit 7. With an interrupt
+// pin, INT2 goes high while the FIFO holds at least the watermark.
+class Qmi8658Model : public NativeI2cDevice {
+public:
+    static const size_t SAMPLE_BYTES = 12;   // Accel XYZ, gyro XYZ, int16 LE
+
+    explicit Qmi8658Model(int int2_pin = -1);
+
+    bool write(const uint8_t* data, size_t len) override;
+    bool read(uint8_t* out, size_t len) override;
+
+    void measure(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz);
+
+    uint8_t getRegister(uint8_t reg) const { return registers[reg]; }
+    size_t getFifoSamples() const { return fifo_length / SAMPLE_BYTES; }
+    bool isFifoReadMode() const { return registers[0x14] & 0x80; }
+    uint32_t getOverwrittenSamples() const { return overwritten; }
+    uint32_t getBadFifoReads() const { return bad_fifo_reads; }   // FIFO_DATA outside read mode
+    uint32_t getFifoReads() const { return fifo_reads; }
+
+private:
+    uint8_t registers[128];
+    uint8_t pointer;
+    uint8_t fifo[128 * SAMPLE_BYTES];
+    size_t fifo_length;
+    bool overflow;
+    uint32_t overwritten;
+    uint32_t bad_fifo_reads;
+    uint32_t fifo_reads;
+    int int2_pin;
+
+    size_t fifoCapacity() const;
+    void reset();
+    void runCommand(uint8_t cmd);
+    void updateInterrupt();
+};
+
+#endif // SENSOR_MODELS_H
@@ -0,0 +1,156 @@
+#include "st7789_panel.h"
+
+static const uint8_t CMD_SWRESET = 0x01;
+static const uint8_t CMD_SLPIN = 0x10;
+static const uint8_t CMD_SLPOUT = 0x11;
+static const uint8_t CMD_DISPOFF = 0x28;
+static const uint8_t CMD_DISPON = 0x29;
+static const uint8_t CMD_CASET = 0x2A;
+static const uint8_t CMD_RASET = 0x2B;
+static const uint8_t CMD_RAMWR = 0x2C;
+static const uint8_t CMD_MADCTL = 0x36;
+
+static const uint8_t MADCTL_MY = 0x80;
+static const uint8_t MADCTL_MX = 0x40;
+static const uint8_t MADCTL_MV = 0x20;
+
+St7789Panel::St7789Panel(uint8_t cs, uint8_t dc) : cs_pin(cs), dc_pin(dc) {
+    memset(memory, 0, sizeof(memory));
+    pixels_written = 0;
+    reset();
+}
+
+// Power-on state; frame memory is left as it was
+void St7789Panel::reset() {
+    command = 0;
+    parameter_index = 0;
+    madctl = 0;
+    column_start = 0;
+    column_end = MEMORY_WIDTH - 1;
+    row_start = 0;
+    row_end = MEMORY_HEIGHT - 1;
+    column = 0;
+    row = 0;
+    pixel_high = 0;
+    sleeping = true;
+    display_on = false;
+}
+
+uint8_t St7789Panel::transfer(uint8_t data) {
+    if (digitalRead(cs_pin) != LOW) {
+        return 0xFF;
+    }
+    if (digitalRead(dc_pin) == LOW) {
+        startCommand(data);
+    } else {
+        addParameter(data);
+    }
+    return 0xFF;
+}
+
+void St7789Panel::startCommand(uint8_t cmd) {
+    command = cmd;
+    parameter_index = 0;
+    switch (cmd) {
+        case CMD_SWRESET:
+            reset();
+            break;
+        case CMD_SLPIN:
+            sleeping = true;
+            break;
+        case CMD_SLPOUT:
+            sleeping = false;
+            break;
+        case CMD_DISPOFF:
+            display_on = false;
+            break;
+        case CMD_DISPON:
+            display_on = true;
+            break;
+        case CMD_RAMWR:
+            column = column_start;
+            row = row_start;
+            break;
+        default:
+            break;
+    }
+}
+
+void St7789Panel::addParameter(uint8_t data) {
+    if (command == CMD_RAMWR) {
+        // Two bytes per RGB565 pixel, high byte first
+        if (parameter_index++ % 2 == 0) {
+            pixel_high = data;
+        } else {
+            writePixel(((uint16_t)pixel_high << 8) | data);
+        }
+        return;
+    }
+    if (parameter_index < sizeof(parameters)) {
+        parameters[parameter_index] = data;
+    }
+    parameter_index++;
+    if (command == CMD_MADCTL && parameter_index == 1) {
+        madctl = data;
+    } else if ((command == CMD_CASET || command == CMD_RASET) && parameter_index == 4) {
+        uint16_t start = ((uint16_t)parameters[0] << 8) | parameters[1];
+        uint16_t end = ((uint16_t)parameters[2] << 8) | parameters[3];
+        if (command == CMD_CASET) {
+            column_start = start;
+            column_end = end;
+        } else {
+            row_start = start;
+            row_end = end;
+        }
+    }
+}
+
+void St7789Panel::writePixel(uint16_t color) {
+    // Window addresses are in the orientation MADCTL selects
+    int x = (madctl & MADCTL_MV) ? row : column;
+    int y = (madctl & MADCTL_MV) ? column : row;
+    if (madctl & MADCTL_MX) {
+        x = MEMORY_WIDTH - 1 - x;
+    }
+    if (madctl & MADCTL_MY) {
+        y = MEMORY_HEIGHT - 1 - y;
+    }
+    if (x >= 0 && x < MEMORY_WIDTH && y >= 0 && y < MEMORY_HEIGHT) {
+        memory[y * MEMORY_WIDTH + x] = color;
+    }
+    pixels_written++;
+
+    if (column < column_end) {
+        column++;
+    } else {
+        column = column_start;
+        row = row < row_end ? row + 1 : row_start;
+    }
+}
+
+uint16_t St7789Panel::getPixel(int x, int y) const {
+    if (x < 0 || x >= MEMORY_WIDTH || y < 0 || y >= MEMORY_HEIGHT) {
+        return 0;
+    }
+    return memory[y * MEMORY_WIDTH + x];
+}
+
+bool St7789Panel::writePPM(const char* path, int x, int y, int width, int height) const {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    for (int row_index = 0; row_index < height; row_index++) {
+        for (int column_index = 0; column_index < width; column_index++) {
+            uint16_t color = getPixel(x + column_index, y + row_index);
+            uint8_t rgb[3] = {
+                (uint8_t)(((color >> 11) & 0x1F) * 255 / 31),
+                (uint8_t)(((color >> 5) & 0x3F) * 255 / 63),
+                (uint8_t)((color & 0x1F) * 255 / 31)
+            };
+            fwrite(rgb, 1, sizeof(rgb), file);
+        }
+    }
+    return fclose(file) == 0;
+}
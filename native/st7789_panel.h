@@ -0,0 +1,57 @@
+#ifndef ST7789_PANEL_H
+#define ST7789_PANEL_H
+
+#include <SPI.h>
+
+// ST7789 controller model for the native SPI bus, so the display code can
+// be run and its output looked at on a host. It decodes the command stream
+// the way the controller does - D/C low for a command byte, high for its
+// parameters, ignored while CS is high - and keeps the 240x320 RGB565
+// frame memory:
+//   - CASET/RASET set the window, RAMWR fills it pixel by pixel, wrapping
+//     from the window's right edge to its next row
+//   - MADCTL MV exchanges rows and columns, MX/MY mirror them
+//   - SWRESET, SLPIN/SLPOUT and DISPON/DISPOFF set the state it reports
+// Other commands (power, gamma, inversion) are accepted and ignored, so
+// the frame memory holds the RGB565 values the firmware drew.
+class St7789Panel : public NativeSpiDevice {
+public:
+    static const int MEMORY_WIDTH = 240;
+    static const int MEMORY_HEIGHT = 320;
+
+    St7789Panel(uint8_t cs_pin, uint8_t dc_pin);
+
+    uint8_t transfer(uint8_t data) override;
+
+    uint16_t getPixel(int x, int y) const;
+    bool isSleeping() const { return sleeping; }
+    bool isDisplayOn() const { return display_on; }
+    uint32_t getPixelsWritten() const { return pixels_written; }
+
+    // Writes a region of frame memory as a binary PPM image
+    bool writePPM(const char* path, int x, int y, int width, int height) const;
+
+private:
+    uint8_t cs_pin;
+    uint8_t dc_pin;
+    uint16_t memory[MEMORY_WIDTH * MEMORY_HEIGHT];
+
+    uint8_t command;
+    uint8_t parameter_index;
+    uint8_t parameters[4];
+    uint8_t madctl;
+    uint16_t column_start, column_end;
+    uint16_t row_start, row_end;
+    uint16_t column, row;       // RAMWR position
+    uint8_t pixel_high;
+    bool sleeping;
+    bool display_on;
+    uint32_t pixels_written;
+
+    void reset();
+    void startCommand(uint8_t cmd);
+    void addParameter(uint8_t data);
+    void writePixel(uint16_t color);
+};
+
+#endif // ST7789_PANEL_H
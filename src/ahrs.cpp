@@ -0,0 +1,144 @@
+#include "ahrs.h"
+#include <math.h>
+
+static const float DEG_TO_RAD = 0.017453293f;
+static const float RAD_TO_DEG = 57.29578f;
+
+Ahrs::Ahrs() {
+    kp = DEFAULT_KP;
+    ki = DEFAULT_KI;
+    reset();
+}
+
+void Ahrs::reset() {
+    q0 = 1.0f;
+    q1 = 0.0f;
+    q2 = 0.0f;
+    q3 = 0.0f;
+    bias_x = 0.0f;
+    bias_y = 0.0f;
+    bias_z = 0.0f;
+    vertical_acceleration = 0.0f;
+    initialised = false;
+    correcting = false;
+}
+
+void Ahrs::setGains(float new_kp, float new_ki) {
+    kp = new_kp;
+    ki = new_ki;
+}
+
+void Ahrs::alignWithGravity(float ax, float ay, float az) {
+    // Roll and pitch from the gravity vector, yaw zero
+    float roll = atan2f(ay, az);
+    float pitch = atan2f(-ax, sqrtf(ay * ay + az * az));
+    float cr = cosf(roll * 0.5f);
+    float sr = sinf(roll * 0.5f);
+    float cp = cosf(pitch * 0.5f);
+    float sp = sinf(pitch * 0.5f);
+    q0 = cr * cp;
+    q1 = sr * cp;
+    q2 = cr * sp;
+    q3 = -sr * sp;
+}
+
+void Ahrs::update(float gx, float gy, float gz, float ax, float ay, float az, float dt) {
+    float norm_sq = ax * ax + ay * ay + az * az;
+
+    if (!initialised) {
+        if (norm_sq > 0.0f) {
+            alignWithGravity(ax, ay, az);
+            initialised = true;
+        }
+        vertical_acceleration = 0.0f;
+        return;
+    }
+
+    gx *= DEG_TO_RAD;
+    gy *= DEG_TO_RAD;
+    gz *= DEG_TO_RAD;
+
+    // Correct towards gravity only while the accelerometer measures about 1 g
+    float recip_norm = norm_sq > 0.0f ? fastInvSqrt(norm_sq) : 0.0f;
+    float norm = norm_sq * recip_norm;
+    correcting = fabsf(norm - 1.0f) < ACCEL_GATE_G;
+    if (correcting) {
+        float nx = ax * recip_norm;
+        float ny = ay * recip_norm;
+        float nz = az * recip_norm;
+
+        // Half the estimated up direction in the body frame
+        float half_vx = q1 * q3 - q0 * q2;
+        float half_vy = q0 * q1 + q2 * q3;
+        float half_vz = q0 * q0 - 0.5f + q3 * q3;
+
+        // Error is the cross product of measured and estimated up
+        float half_ex = ny * half_vz - nz * half_vy;
+        float half_ey = nz * half_vx - nx * half_vz;
+        float half_ez = nx * half_vy - ny * half_vx;
+
+        if (ki > 0.0f) {
+            bias_x += 2.0f * ki * half_ex * dt;
+            bias_y += 2.0f * ki * half_ey * dt;
+            bias_z += 2.0f * ki * half_ez * dt;
+        }
+        gx += 2.0f * kp * half_ex;
+        gy += 2.0f * kp * half_ey;
+        gz += 2.0f * kp * half_ez;
+    }
+    gx += bias_x;
+    gy += bias_y;
+    gz += bias_z;
+
+    // Integrate q' = 0.5 * q x omega
+    gx *= 0.5f * dt;
+    gy *= 0.5f * dt;
+    gz *= 0.5f * dt;
+    float qa = q0;
+    float qb = q1;
+    float qc = q2;
+    q0 += -qb * gx - qc * gy - q3 * gz;
+    q1 += qa * gx + qc * gz - q3 * gy;
+    q2 += qa * gy - qb * gz + q3 * gx;
+    q3 += qa * gz + qb * gy - qc * gx;
+
+    float q_norm = fastInvSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= q_norm;
+    q1 *= q_norm;
+    q2 *= q_norm;
+    q3 *= q_norm;
+
+    // Specific force along earth up, minus the 1 g a resting sensor reads
+    float v[3];
+    getUpVector(v);
+    vertical_acceleration = ax * v[0] + ay * v[1] + az * v[2] - 1.0f;
+}
+
+void Ahrs::getQuaternion(float q[4]) const {
+    q[0] = q0;
+    q[1] = q1;
+    q[2] = q2;
+    q[3] = q3;
+}
+
+void Ahrs::getUpVector(float v[3]) const {
+    v[0] = 2.0f * (q1 * q3 - q0 * q2);
+    v[1] = 2.0f * (q0 * q1 + q2 * q3);
+    v[2] = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+}
+
+float Ahrs::getTiltDeg() const {
+    float v[3];
+    getUpVector(v);
+    float c = v[2];
+    if (c > 1.0f) {
+        c = 1.0f;
+    } else if (c < -1.0f) {
+        c = -1.0f;
+    }
+    return acosf(c) * RAD_TO_DEG;
+}
+
+float Ahrs::getVerticalAcceleration() const {
+    return vertical_acceleration;
+}
@@ -0,0 +1,66 @@
+#ifndef AHRS_H
+#define AHRS_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Reciprocal square root from the IEEE-754 bit pattern plus two Newton
+// steps: relative error below 5e-6, no division and no sqrtf()
+inline float fastInvSqrt(float x) {
+    uint32_t i;
+    memcpy(&i, &x, sizeof(i));
+    i = 0x5F375A86 - (i >> 1);
+    float y;
+    memcpy(&y, &i, sizeof(y));
+    float half_x = 0.5f * x;
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    return y;
+}
+
+// Mahony complementary orientation filter.
+// Integrates the gyro into a body-to-earth quaternion and pulls it towards
+// the accelerometer's gravity direction with a PI controller; the integral
+// term learns the gyro bias. During boost and other high-g phases the
+// accelerometer no longer points at gravity, so correction is skipped while
+// the measured magnitude is more than ACCEL_GATE_G away from 1 g and the
+// filter runs on the gyro alone.
+// Body frame: +Z up when the board lies flat (accel_z = +1 g at rest).
+// All state is inline - no allocation, no trigonometry per update.
+class Ahrs {
+public:
+    static constexpr float DEFAULT_KP = 1.0f;     // Proportional gain (1/s)
+    static constexpr float DEFAULT_KI = 0.02f;    // Integral gain (1/s^2)
+    static constexpr float ACCEL_GATE_G = 0.15f;
+
+    Ahrs();
+
+    void reset();
+    void setGains(float kp, float ki);
+
+    // Gyro in deg/s, accel in g, dt in seconds. The first call aligns the
+    // attitude with the accelerometer instead of integrating.
+    void update(float gx, float gy, float gz, float ax, float ay, float az, float dt);
+
+    bool isInitialised() const { return initialised; }
+    bool isCorrecting() const { return correcting; }   // False while gated (high g)
+
+    void getQuaternion(float q[4]) const;
+    float getTiltDeg() const;                 // Body Z axis from vertical
+    float getVerticalAcceleration() const;    // Earth-frame up, gravity removed (g)
+
+    // Earth up axis expressed in the body frame
+    void getUpVector(float v[3]) const;
+
+private:
+    float q0, q1, q2, q3;
+    float bias_x, bias_y, bias_z;   // Integral feedback (rad/s)
+    float kp, ki;
+    float vertical_acceleration;
+    bool initialised;
+    bool correcting;
+
+    void alignWithGravity(float ax, float ay, float az);
+};
+
+#endif // AHRS_H
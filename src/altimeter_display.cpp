@@ -2,6 +2,9 @@
 #include "simple_font.h"
 #include <Arduino.h>
 
+// Min/max per column for the history graph
+static HistoryPyramid::Point graph_points[128];
+
 AltimeterDisplay::AltimeterDisplay(TFTTest* display) {
     tft = display;
     current_altitude = 0.0;
@@ -14,6 +17,14 @@ AltimeterDisplay::AltimeterDisplay(TFTTest* display) {
     imu_status = false;
     battery_voltage = 0.0;
     battery_percentage = 0;
+    climb_rate_1s = 0.0;
+    climb_rate_10s = 0.0;
+    peak_accel_1s = 0.0;
+    peak_accel = 0.0;
+    peak_accel_phase = '-';
+    tilt = 0.0;
+    history = nullptr;
+    flight_summary = nullptr;
     last_update = 0;
     needs_full_refresh = true;
     display_mode = MODE_OVERVIEW;
@@ -65,6 +76,12 @@ void AltimeterDisplay::drawHeader() {
         case MODE_GYRO_DETAIL:
             title = "GYRO";   // New gyroscope mode
             break;
+        case MODE_HISTORY:
+            title = "HIST";   // Altitude graph
+            break;
+        case MODE_SUMMARY:
+            title = "LAST";   // Last saved flight
+            break;
         default:
             title = "ALT";
             break;
@@ -101,6 +118,12 @@ void AltimeterDisplay::drawDataArea() {
         case MODE_GYRO_DETAIL:
             drawGyroData();
             break;
+        case MODE_HISTORY:
+            drawHistoryGraph();
+            break;
+        case MODE_SUMMARY:
+            drawFlightSummary();
+            break;
     }
 }
 
@@ -131,6 +154,32 @@ void AltimeterDisplay::drawAltitudeData() {
         drawNumber(44, y, diff, 2, diff_color);
         drawText(112, y, "m", diff_color);
         
+    } else {
+        // Altitude detail - rates and peaks over the sliding windows
+        drawText(2, y, "ALT", COLOR_ALTITUDE);
+        drawNumber(44, y, current_altitude, 1, COLOR_ALTITUDE);
+        drawText(112, y, "m", COLOR_ALTITUDE);
+        y += 18;
+        
+        // Climb rate over the last second
+        drawText(2, y, "CLB", COLOR_ALTITUDE);
+        drawNumber(44, y, climb_rate_1s, 1, COLOR_ALTITUDE);
+        y += 18;
+        
+        // Average climb rate over the last 10 seconds
+        drawText(2, y, "AVG", COLOR_TEXT);
+        drawNumber(44, y, climb_rate_10s, 1, COLOR_TEXT);
+        y += 18;
+        
+        // Peak acceleration over the last second
+        drawText(2, y, "PKG", COLOR_IMU);
+        drawNumber(44, y, peak_accel_1s, 2, COLOR_IMU);
+        drawText(112, y, "g", COLOR_IMU);
+        y += 18;
+        
+        drawText(2, y, "MAX", COLOR_MAX_ALT);
+        drawNumber(44, y, max_altitude, 1, COLOR_MAX_ALT);
+        drawText(112, y, "m", COLOR_MAX_ALT);
     }
 }
 
@@ -147,7 +196,7 @@ void AltimeterDisplay::drawEnvironmentalData() {
     
     // Pressure - ensure it fits on screen
     drawText(2, y, "hPa", COLOR_PRESSURE);
-    drawNumber(56, y, pressure/100.0, 0, COLOR_PRESSURE);
+    drawNumber(56, y, pressure/100.0f, 0, COLOR_PRESSURE);
 
 }
 
@@ -172,13 +221,21 @@ void AltimeterDisplay::drawIMUData() {
         drawText(2, y, "Z", COLOR_IMU);
         drawNumber(32, y, accel_z, 2, COLOR_IMU);
         drawText(100, y, "g", COLOR_IMU);
-        y += 25;  // Extra spacing
+        y += 18;  // Good spacing
         
         // Calculate and display acceleration magnitude
-        float accel_mag = sqrt(accel_x*accel_x + accel_y*accel_y + accel_z*accel_z);
+        float accel_mag = sqrtf(accel_x*accel_x + accel_y*accel_y + accel_z*accel_z);
         drawText(2, y, "MAG", COLOR_IMU);
         drawNumber(32, y, accel_mag, 2, COLOR_IMU);
         drawText(100, y, "g", COLOR_IMU);
+        y += 18;  // Good spacing
+        
+        // Peak magnitude from every IMU sample, with the phase it happened in
+        char phase_text[2] = {peak_accel_phase, '\0'};
+        drawText(2, y, "PK", COLOR_MAX_ALT);
+        drawNumber(32, y, peak_accel, 2, COLOR_MAX_ALT);
+        drawText(100, y, "g", COLOR_MAX_ALT);
+        drawText(114, y, phase_text, COLOR_MAX_ALT);
         
     } else {
         drawText(2, y, "IMU NOT FOUND", COLOR_STATUS_ERROR);
@@ -212,13 +269,19 @@ void AltimeterDisplay::drawGyroData() {
         drawText(2, y, "Z", COLOR_IMU);
         drawNumber(32, y, gyro_z, 1, COLOR_IMU);
         drawText(90, y, "°/s", COLOR_IMU);
-        y += 25;  // Extra spacing
+        y += 18;  // Good spacing
         
         // Calculate and display gyroscope magnitude
-        float gyro_mag = sqrt(gyro_x*gyro_x + gyro_y*gyro_y + gyro_z*gyro_z);
+        float gyro_mag = sqrtf(gyro_x*gyro_x + gyro_y*gyro_y + gyro_z*gyro_z);
         drawText(2, y, "MAG", COLOR_IMU);
         drawNumber(48, y, gyro_mag, 1, COLOR_IMU);
         drawText(90, y, "°/s", COLOR_IMU);
+        y += 18;  // Good spacing
+        
+        // Tilt from vertical, from the AHRS
+        drawText(2, y, "TLT", COLOR_TEXT);
+        drawNumber(48, y, tilt, 1, COLOR_TEXT);
+        drawText(90, y, "°", COLOR_TEXT);
         
     } else {
         drawText(2, y, "IMU NOT FOUND", COLOR_STATUS_ERROR);
@@ -231,6 +294,104 @@ void AltimeterDisplay::drawGyroData() {
     }
 }
 
+void AltimeterDisplay::drawHistoryGraph() {
+    int y = DATA_AREA_Y + 3;
+    
+    if (history == nullptr || !history->isReady() || history->isEmpty()) {
+        drawText(2, y, "NO HISTORY", COLOR_TEXT);
+        return;
+    }
+    
+    // Last GRAPH_SPAN_MS, or everything recorded if that is shorter
+    uint32_t to_ms = history->getNewestMs() + 1;
+    uint32_t from_ms = to_ms > GRAPH_SPAN_MS ? to_ms - GRAPH_SPAN_MS : 0;
+    if (from_ms < history->getOldestMs()) {
+        from_ms = history->getOldestMs();
+    }
+    size_t count = history->query(HistoryPyramid::CHANNEL_ALTITUDE, from_ms, to_ms, graph_points, GRAPH_WIDTH);
+    
+    // Scale to the visible range, at least 2 m so ground noise stays flat
+    float low = 0.0f;
+    float high = 0.0f;
+    bool any = false;
+    for (size_t i = 0; i < count; i++) {
+        const HistoryPyramid::Point& p = graph_points[i];
+        if (!p.valid) {
+            continue;
+        }
+        if (!any || p.min < low) low = p.min;
+        if (!any || p.max > high) high = p.max;
+        any = true;
+    }
+    if (!any) {
+        drawText(2, y, "NO HISTORY", COLOR_TEXT);
+        return;
+    }
+    if (high - low < 2.0f) {
+        float mid = (high + low) * 0.5f;
+        low = mid - 1.0f;
+        high = mid + 1.0f;
+    }
+    
+    // Top of the range as the label
+    drawNumber(2, y, high, 1, COLOR_MAX_ALT);
+    drawText(112, y, "m", COLOR_MAX_ALT);
+    
+    // Each column is a vertical bar from the bucket minimum to its maximum,
+    // so short spikes survive any zoom level
+    const int graph_top = DATA_AREA_Y + 20;
+    const int graph_height = 128 - graph_top;
+    float scale = (graph_height - 1) / (high - low);
+    for (size_t i = 0; i < count; i++) {
+        const HistoryPyramid::Point& p = graph_points[i];
+        if (!p.valid) {
+            continue;
+        }
+        int y_max = graph_top + (graph_height - 1) - (int)((p.max - low) * scale + 0.5f);
+        int y_min = graph_top + (graph_height - 1) - (int)((p.min - low) * scale + 0.5f);
+        tft->fillRect(i, y_max, 1, y_min - y_max + 1, COLOR_ALTITUDE);
+    }
+}
+
+void AltimeterDisplay::drawFlightSummary() {
+    int y = DATA_AREA_Y + 3;
+    
+    if (flight_summary == nullptr) {
+        drawText(2, y, "NO FLIGHTS", COLOR_TEXT);
+        return;
+    }
+    const FlightSummary& s = *flight_summary;
+    
+    char title[16];
+    snprintf(title, sizeof(title), "FLT %u", (unsigned)s.flight_number);
+    drawText(2, y, title, COLOR_TEXT);
+    y += 18;
+    
+    drawText(2, y, "APO", COLOR_MAX_ALT);
+    drawNumber(40, y, s.apogee_m, 1, COLOR_MAX_ALT);
+    drawText(112, y, "m", COLOR_MAX_ALT);
+    y += 18;
+    
+    drawText(2, y, "MAX", COLOR_IMU);
+    drawNumber(40, y, s.max_acceleration_g, 2, COLOR_IMU);
+    drawText(112, y, "g", COLOR_IMU);
+    y += 18;
+    
+    // Fastest climb and mean descent rate, m/s
+    drawText(2, y, "UP", COLOR_ALTITUDE);
+    drawNumber(40, y, s.max_ascent_rate, 1, COLOR_ALTITUDE);
+    y += 18;
+    drawText(2, y, "DN", COLOR_ALTITUDE);
+    drawNumber(40, y, s.mean_descent_rate, 1, COLOR_ALTITUDE);
+    y += 18;
+    
+    // Launch to touchdown, or the whole recording if either was missed
+    bool timed = s.launched && s.landed;
+    drawText(2, y, timed ? "T" : "REC", COLOR_TEXT);
+    drawNumber(40, y, timed ? s.touchdown_s - s.launch_s : s.recording_s, 1, COLOR_TEXT);
+    drawText(112, y, "s", COLOR_TEXT);
+}
+
 void AltimeterDisplay::drawNumber(int x, int y, float value, int decimals, uint16_t color) {
     char buffer[20];
     
@@ -348,6 +509,44 @@ void AltimeterDisplay::setBatteryData(float voltage, int percentage) {
     battery_percentage = percentage;
 }
 
+void AltimeterDisplay::setWindowStats(float climb_1s, float climb_10s, float peak_g_1s) {
+    climb_rate_1s = climb_1s;
+    climb_rate_10s = climb_10s;
+    peak_accel_1s = peak_g_1s;
+}
+
+void AltimeterDisplay::setPeakAcceleration(float peak_g, char phase_code) {
+    peak_accel = peak_g;
+    peak_accel_phase = phase_code;
+}
+
+void AltimeterDisplay::setTilt(float tilt_deg) {
+    tilt = tilt_deg;
+}
+
+void AltimeterDisplay::setPipelineData(const SensorPipeline& pipeline) {
+    const SensorState& state = pipeline.getState();
+    setAltitudeData(state.current_altitude, state.max_altitude);
+    setEnvironmentalData(state.temperature, state.pressure);
+    setWindowStats(pipeline.getStats(SensorPipeline::CHANNEL_ALTITUDE, SensorPipeline::WINDOW_1S).getRate(),
+                   pipeline.getStats(SensorPipeline::CHANNEL_ALTITUDE, SensorPipeline::WINDOW_10S).getRate(),
+                   pipeline.getStats(SensorPipeline::CHANNEL_ACCELERATION, SensorPipeline::WINDOW_1S).getMax());
+    const PeakTracker::Peak& peak = pipeline.getPeaks().getPeak(PeakTracker::CHANNEL_MAGNITUDE);
+    setTilt(state.tilt);
+    setPeakAcceleration(peak.value.toFloat(), peak.valid ? FlightPhaseDetector::getPhaseName(peak.phase)[0] : '-');
+}
+
+void AltimeterDisplay::setHistory(const HistoryPyramid* store) {
+    history = store;
+}
+
+void AltimeterDisplay::setFlightSummary(const FlightSummary* summary) {
+    flight_summary = summary;
+    if (display_mode == MODE_SUMMARY) {
+        needs_full_refresh = true;
+    }
+}
+
 void AltimeterDisplay::resetMaxAltitude() {
     max_altitude = current_altitude;
 }
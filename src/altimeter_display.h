@@ -2,6 +2,9 @@
 #define ALTIMETER_DISPLAY_H
 
 #include "tft_test.h"
+#include "history_pyramid.h"
+#include "flight_summary.h"
+#include "sensor_pipeline.h"
 #include <Arduino.h>
 
 class AltimeterDisplay {
@@ -13,6 +16,8 @@ private:
     static const int STATUS_HEIGHT = 0;       // Remove status bar completely
     static const int DATA_AREA_Y = HEADER_HEIGHT + STATUS_HEIGHT;
     static const int DATA_AREA_HEIGHT = 112;  // Increased significantly (128 - 16 = 112)
+    static const int GRAPH_WIDTH = 128;       // One history point per pixel column
+    static const uint32_t GRAPH_SPAN_MS = 120000;  // Altitude graph covers the last 2 minutes
     
     // Colors (RGB565)
     static const uint16_t COLOR_BACKGROUND = 0x0000;  // Black
@@ -38,6 +43,14 @@ private:
     bool imu_status;
     float battery_voltage;
     int battery_percentage;
+    float climb_rate_1s;
+    float climb_rate_10s;
+    float peak_accel_1s;
+    float peak_accel;
+    char peak_accel_phase;
+    float tilt;
+    const HistoryPyramid* history;
+    const FlightSummary* flight_summary;
     
     // Display state
     unsigned long last_update;
@@ -52,6 +65,8 @@ private:
     void drawEnvironmentalData();
     void drawIMUData();
     void drawGyroData();
+    void drawHistoryGraph();
+    void drawFlightSummary();
     void drawBatterySymbol(int x, int y, int percentage);
     void drawNumber(int x, int y, float value, int decimals, uint16_t color);
     void drawText(int x, int y, const char* text, uint16_t color);
@@ -67,6 +82,12 @@ public:
     void setIMUData(float ax, float ay, float az, float gx, float gy, float gz);
     void setSensorStatus(bool bmp_ok, bool imu_ok);
     void setBatteryData(float voltage, int percentage);
+    void setWindowStats(float climb_1s, float climb_10s, float peak_g_1s);
+    void setPeakAcceleration(float peak_g, char phase_code);
+    void setTilt(float tilt_deg);
+    void setPipelineData(const SensorPipeline& pipeline);   // Everything above from the pipeline's state
+    void setHistory(const HistoryPyramid* store);
+    void setFlightSummary(const FlightSummary* summary);   // Last saved flight, or null
     void resetMaxAltitude();
     void nextDisplayMode();
     void forceRefresh();
@@ -78,7 +99,9 @@ public:
         MODE_ENVIRONMENTAL = 2,
         MODE_IMU_DETAIL = 3,
         MODE_GYRO_DETAIL = 4,
-        MODE_COUNT = 5
+        MODE_HISTORY = 5,
+        MODE_SUMMARY = 6,
+        MODE_COUNT = 7
     };
 };
 
@@ -0,0 +1,68 @@
+#ifndef ALTITUDE_TABLE_H
+#define ALTITUDE_TABLE_H
+
+#include <stdint.h>
+
+// Generated by tools/gen_altitude_table.py - do not edit.
+// Altitude (Q15.16 m) at BASE_PA + i * 2^STEP_SHIFT Pa, sea level 101325 Pa.
+static const int32_t ALTITUDE_TABLE_BASE_PA = 30000;
+static const int ALTITUDE_TABLE_STEP_SHIFT = 8;
+static const int ALTITUDE_TABLE_SIZE = 315;
+
+static const int32_t altitude_table[ALTITUDE_TABLE_SIZE] = {
+    600661781, 596932301, 593228286, 589549349, 585895113, 582265212,
+    578659286, 575076985, 571517964, 567981888, 564468430, 560977269,
+    557508090, 554060588, 550634461, 547229415, 543845163, 540481423,
+    537137919, 533814382, 530510546, 527226153, 523960948, 520714683,
+    517487115, 514278003, 511087114, 507914219, 504759091, 501621511,
+    498501261, 495398129, 492311907, 489242389, 486189376, 483152670,
+    480132078, 477127410, 474138479, 471165102, 468207101, 465264297,
+    462336519, 459423594, 456525357, 453641642, 450772287, 447917135,
+    445076029, 442248815, 439435342, 436635462, 433849029, 431075900,
+    428315934, 425568991, 422834935, 420113632, 417404949, 414708757,
+    412024928, 409353335, 406693854, 404046364, 401410744, 398786876,
+    396174644, 393573933, 390984629, 388406622, 385839802, 383284061,
+    380739293, 378205394, 375682259, 373169787, 370667878, 368176434,
+    365695357, 363224550, 360763921, 358313374, 355872819, 353442165,
+    351021322, 348610202, 346208719, 343816787, 341434322, 339061239,
+    336697458, 334342896, 331997474, 329661113, 327333735, 325015263,
+    322705622, 320404736, 318112532, 315828936, 313553878, 311287286,
+    309029089, 306779219, 304537608, 302304187, 300078891, 297861653,
+    295652409, 293451094, 291257645, 289072000, 286894097, 284723875,
+    282561273, 280406232, 278258694, 276118599, 273985891, 271860513,
+    269742408, 267631522, 265527800, 263431187, 261341631, 259259077,
+    257183474, 255114771, 253052916, 250997859, 248949550, 246907939,
+    244872978, 242844619, 240822813, 238807515, 236798676, 234796252,
+    232800196, 230810464, 228827010, 226849792, 224878764, 222913884,
+    220955109, 219002397, 217055706, 215114996, 213180224, 211251350,
+    209328335, 207411139, 205499723, 203594047, 201694074, 199799765,
+    197911083, 196027990, 194150450, 192278427, 190411884, 188550785,
+    186695095, 184844780, 182999803, 181160132, 179325732, 177496570,
+    175672612, 173853825, 172040177, 170231634, 168428166, 166629741,
+    164836327, 163047892, 161264407, 159485841, 157712163, 155943343,
+    154179353, 152420162, 150665741, 148916063, 147171097, 145430816,
+    143695192, 141964196, 140237803, 138515983, 136798711, 135085960,
+    133377702, 131673912, 129974564, 128279632, 126589090, 124902913,
+    123221076, 121543554, 119870323, 118201357, 116536633, 114876127,
+    113219814, 111567672, 109919677, 108275805, 106636034, 105000341,
+    103368703, 101741098, 100117503, 98497897, 96882258, 95270565,
+    93662795, 92058927, 90458941, 88862815, 87270528, 85682061,
+    84097392, 82516502, 80939370, 79365976, 77796301, 76230325,
+    74668029, 73109393, 71554398, 70003026, 68455257, 66911073,
+    65370455, 63833385, 62299845, 60769817, 59243282, 57720223,
+    56200623, 54684464, 53171728, 51662398, 50156458, 48653890,
+    47154677, 45658803, 44166250, 42677004, 41191047, 39708363,
+    38228936, 36752750, 35279789, 33810039, 32343482, 30880103,
+    29419888, 27962821, 26508886, 25058069, 23610356, 22165730,
+    20724177, 19285684, 17850235, 16417816, 14988412, 13562010,
+    12138596, 10718155, 9300674, 7886139, 6474537, 5065853,
+    3660074, 2257188, 857180, -539962, -1934252, -3325702,
+    -4714326, -6100136, -7483145, -8863365, -10240810, -11615491,
+    -12987420, -14356611, -15723076, -17086826, -18447873, -19806230,
+    -21161908, -22514919, -23865275, -25212987, -26558067, -27900526,
+    -29240377, -30577629, -31912295, -33244385, -34573910, -35900882,
+    -37225312, -38547210, -39866587, -41183454, -42497821, -43809700,
+    -45119100, -46426032, -47730507
+};
+
+#endif // ALTITUDE_TABLE_H
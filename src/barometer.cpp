@@ -0,0 +1,36 @@
+#include "barometer.h"
+#include "bmp180_barometer.h"
+#include "bmp3_barometer.h"
+#include "ms5611_barometer.h"
+
+Barometer* detectBarometer(I2CBus& bus) {
+    // The drivers are small; keep one of each instead of allocating. There
+    // is only one sensor bus, so binding them on the first call is fine.
+    static Bmp3Barometer bmp3(bus);
+    static Bmp180Barometer bmp180(bus);
+    static Ms5611Barometer ms5611(bus);
+
+    // BMP3xx first: it has an unambiguous chip ID at both addresses.
+    // BMP180 next, then MS5611, whose PROM CRC rejects anything else at 0x77.
+    const uint8_t bmp3_addresses[] = { Bmp3Barometer::ADDRESS_PRIMARY, Bmp3Barometer::ADDRESS_SECONDARY };
+    for (uint8_t addr : bmp3_addresses) {
+        bmp3.setAddress(addr);
+        if (bmp3.begin()) {
+            return &bmp3;
+        }
+    }
+
+    if (bmp180.begin()) {
+        return &bmp180;
+    }
+
+    const uint8_t ms5611_addresses[] = { Ms5611Barometer::ADDRESS_PRIMARY, Ms5611Barometer::ADDRESS_SECONDARY };
+    for (uint8_t addr : ms5611_addresses) {
+        ms5611.setAddress(addr);
+        if (ms5611.begin()) {
+            return &ms5611;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,47 @@
+#ifndef BAROMETER_H
+#define BAROMETER_H
+
+#include <Arduino.h>
+#include "i2c_bus.h"
+#include "sensor_source.h"
+
+// Barometer driver interface.
+// Conversions run in the background: begin() starts the first one, poll()
+// advances the driver's state machine without blocking and reports whether
+// samples are waiting, and readBatch() burst-reads them (a FIFO drain on
+// parts that have one). Each sample carries the time it was measured.
+class Barometer : public BaroSource {
+public:
+    enum Type {
+        TYPE_NONE = 0,
+        TYPE_BMP180 = 1,
+        TYPE_BMP3XX = 2,    // BMP388 / BMP390
+        TYPE_MS5611 = 3
+    };
+
+    // Probes the part, reads its calibration and starts converting
+    virtual bool begin() = 0;
+
+    // Kicks off a measurement (no-op for parts that convert continuously)
+    virtual bool startConversion() = 0;
+
+    // Non-blocking; returns true once at least one sample is waiting
+    virtual bool poll() = 0;
+
+    // Polls, then returns the waiting samples (oldest first) and keeps the
+    // next conversion going
+    size_t readBatch(BaroSample* out, size_t max) override = 0;
+
+    bool read(BaroSample& out) override { return readBatch(&out, 1) == 1; }
+
+    virtual bool hasFifo() const { return false; }
+    virtual Type getType() const = 0;
+    virtual const char* getName() const = 0;
+    virtual uint8_t getAddress() const = 0;
+    virtual uint32_t getMaxClockHz() const = 0;   // Fastest I2C clock the part supports on Wire
+};
+
+// Probes the bus for a supported barometer; returns nullptr if none answers
+Barometer* detectBarometer(I2CBus& bus);
+
+#endif // BAROMETER_H
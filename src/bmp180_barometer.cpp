@@ -0,0 +1,172 @@
+#include "bmp180_barometer.h"
+
+// Registers and commands (BMP180 datasheet, section 5)
+#define BMP180_REG_CALIBRATION 0xAA
+#define BMP180_REG_CHIP_ID     0xD0
+#define BMP180_REG_CONTROL     0xF4
+#define BMP180_REG_RESULT      0xF6
+#define BMP180_CHIP_ID         0x55
+#define BMP180_CMD_TEMPERATURE 0x2E
+#define BMP180_CMD_PRESSURE    0x34
+
+// Maximum conversion times in microseconds, by oversampling setting
+static const uint32_t pressure_conversion_us[4] = { 4500, 7500, 13500, 25500 };
+static const uint32_t temperature_conversion_us = 4500;
+
+Bmp180Barometer::Bmp180Barometer(I2CBus& i2c, uint8_t oversampling) : bus(i2c) {
+    oss = oversampling > 3 ? 3 : oversampling;
+    state = STATE_IDLE;
+    conversion_start_us = 0;
+    conversion_time_us = 0;
+    pressure_count = 0;
+    b5 = 0;
+    have_temperature = false;
+    has_waiting = false;
+}
+
+bool Bmp180Barometer::begin() {
+    uint8_t chip_id = 0;
+    if (!bus.readRegister(ADDRESS, BMP180_REG_CHIP_ID, &chip_id, 1) || chip_id != BMP180_CHIP_ID) {
+        return false;
+    }
+
+    uint8_t cal[22];
+    if (!bus.readRegister(ADDRESS, BMP180_REG_CALIBRATION, cal, sizeof(cal))) {
+        return false;
+    }
+    ac1 = (int16_t)((cal[0] << 8) | cal[1]);
+    ac2 = (int16_t)((cal[2] << 8) | cal[3]);
+    ac3 = (int16_t)((cal[4] << 8) | cal[5]);
+    ac4 = (uint16_t)((cal[6] << 8) | cal[7]);
+    ac5 = (uint16_t)((cal[8] << 8) | cal[9]);
+    ac6 = (uint16_t)((cal[10] << 8) | cal[11]);
+    b1 = (int16_t)((cal[12] << 8) | cal[13]);
+    b2 = (int16_t)((cal[14] << 8) | cal[15]);
+    mb = (int16_t)((cal[16] << 8) | cal[17]);
+    mc = (int16_t)((cal[18] << 8) | cal[19]);
+    md = (int16_t)((cal[20] << 8) | cal[21]);
+
+    // All-zero or all-one calibration means the EEPROM read went wrong
+    if (ac1 == 0 || ac1 == -1 || md == 0) {
+        return false;
+    }
+
+    have_temperature = false;
+    has_waiting = false;
+    return startConversion();
+}
+
+bool Bmp180Barometer::startConversion() {
+    if (!have_temperature || pressure_count >= TEMPERATURE_EVERY) {
+        return startTemperature();
+    }
+    return startPressure();
+}
+
+bool Bmp180Barometer::startTemperature() {
+    if (!bus.writeRegister(ADDRESS, BMP180_REG_CONTROL, BMP180_CMD_TEMPERATURE)) {
+        state = STATE_IDLE;
+        return false;
+    }
+    state = STATE_TEMPERATURE;
+    conversion_start_us = micros();
+    conversion_time_us = temperature_conversion_us;
+    return true;
+}
+
+bool Bmp180Barometer::startPressure() {
+    if (!bus.writeRegister(ADDRESS, BMP180_REG_CONTROL, BMP180_CMD_PRESSURE + (oss << 6))) {
+        state = STATE_IDLE;
+        return false;
+    }
+    state = STATE_PRESSURE;
+    conversion_start_us = micros();
+    conversion_time_us = pressure_conversion_us[oss];
+    return true;
+}
+
+bool Bmp180Barometer::poll() {
+    if (has_waiting) {
+        return true;
+    }
+    if (state == STATE_IDLE) {
+        startConversion();   // Recover from a failed start
+        return false;
+    }
+    if (micros() - conversion_start_us < conversion_time_us) {
+        return false;
+    }
+
+    if (state == STATE_TEMPERATURE) {
+        if (finishTemperature()) {
+            pressure_count = 0;
+        }
+        startPressure();
+        return false;
+    }
+
+    finishPressure();
+    startConversion();
+    return has_waiting;
+}
+
+bool Bmp180Barometer::finishTemperature() {
+    uint8_t raw[2];
+    if (!bus.readRegister(ADDRESS, BMP180_REG_RESULT, raw, 2)) {
+        return false;
+    }
+    int32_t ut = (raw[0] << 8) | raw[1];
+
+    int32_t x1 = ((ut - (int32_t)ac6) * (int32_t)ac5) >> 15;
+    int32_t x2 = ((int32_t)mc << 11) / (x1 + md);
+    b5 = x1 + x2;
+    have_temperature = true;
+    return true;
+}
+
+bool Bmp180Barometer::finishPressure() {
+    uint8_t raw[3];
+    if (!bus.readRegister(ADDRESS, BMP180_REG_RESULT, raw, 3)) {
+        return false;
+    }
+    pressure_count++;
+    int32_t up = (((int32_t)raw[0] << 16) | ((int32_t)raw[1] << 8) | raw[2]) >> (8 - oss);
+
+    // Datasheet integer compensation, section 3.5
+    int32_t b6 = b5 - 4000;
+    int32_t x1 = ((int32_t)b2 * ((b6 * b6) >> 12)) >> 11;
+    int32_t x2 = ((int32_t)ac2 * b6) >> 11;
+    int32_t x3 = x1 + x2;
+    int32_t b3 = ((((int32_t)ac1 * 4 + x3) << oss) + 2) / 4;
+    x1 = ((int32_t)ac3 * b6) >> 13;
+    x2 = ((int32_t)b1 * ((b6 * b6) >> 12)) >> 16;
+    x3 = ((x1 + x2) + 2) >> 2;
+    uint32_t b4 = ((uint32_t)ac4 * (uint32_t)(x3 + 32768)) >> 15;
+    uint32_t b7 = ((uint32_t)up - b3) * (uint32_t)(50000 >> oss);
+    int32_t p;
+    if (b7 < 0x80000000) {
+        p = (b7 * 2) / b4;
+    } else {
+        p = (b7 / b4) * 2;
+    }
+    x1 = (p >> 8) * (p >> 8);
+    x1 = (x1 * 3038) >> 16;
+    x2 = (-7357 * p) >> 16;
+    p = p + ((x1 + x2 + 3791) >> 4);
+
+    // Stamped at the end of the conversion, not when it was read
+    waiting.time_us = conversion_start_us + conversion_time_us;
+    waiting.pressure_pa = p;
+    waiting.temperature_c = ((b5 + 8) >> 4) / 10.0f;
+    has_waiting = true;
+    return true;
+}
+
+size_t Bmp180Barometer::readBatch(BaroSample* out, size_t max) {
+    if (max == 0 || !poll()) {
+        return 0;
+    }
+    out[0] = waiting;
+    has_waiting = false;
+    return 1;
+}
@@ -0,0 +1,214 @@
+#include "bmp3_barometer.h"
+
+// Registers (BMP388 datasheet, section 4)
+#define BMP3_REG_CHIP_ID      0x00
+#define BMP3_REG_FIFO_LENGTH  0x12
+#define BMP3_REG_FIFO_DATA    0x14
+#define BMP3_REG_FIFO_CONFIG1 0x17
+#define BMP3_REG_FIFO_CONFIG2 0x18
+#define BMP3_REG_PWR_CTRL     0x1B
+#define BMP3_REG_OSR          0x1C
+#define BMP3_REG_ODR          0x1D
+#define BMP3_REG_CONFIG       0x1F
+#define BMP3_REG_CALIBRATION  0x31
+#define BMP3_REG_CMD          0x7E
+
+#define BMP3_CHIP_ID_388      0x50
+#define BMP3_CHIP_ID_390      0x60
+#define BMP3_CMD_FIFO_FLUSH   0xB0
+#define BMP3_CMD_SOFT_RESET   0xB6
+
+// FIFO frame headers
+#define BMP3_FRAME_PRESS_TEMP 0x94
+#define BMP3_FRAME_TEMP       0x90
+#define BMP3_FRAME_PRESS      0x84
+#define BMP3_FRAME_TIME       0xA0
+#define BMP3_FRAME_EMPTY      0x80
+#define BMP3_FRAME_CONFIG_ERR 0x44
+#define BMP3_FRAME_CONFIG_CHG 0x48
+
+static uint32_t le24(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+Bmp3Barometer::Bmp3Barometer(I2CBus& i2c, uint8_t i2c_address) : bus(i2c) {
+    address = i2c_address;
+    chip_id = 0;
+    t_lin = 0.0f;
+    queue_head = 0;
+    queue_count = 0;
+}
+
+bool Bmp3Barometer::begin() {
+    if (!bus.readRegister(address, BMP3_REG_CHIP_ID, &chip_id, 1)) {
+        return false;
+    }
+    if (chip_id != BMP3_CHIP_ID_388 && chip_id != BMP3_CHIP_ID_390) {
+        return false;
+    }
+
+    bus.writeRegister(address, BMP3_REG_CMD, BMP3_CMD_SOFT_RESET);
+    delay(3);   // Only at boot: reset takes 2 ms
+
+    uint8_t nvm[21];
+    if (!bus.readRegister(address, BMP3_REG_CALIBRATION, nvm, sizeof(nvm))) {
+        return false;
+    }
+    uint16_t t1 = nvm[0] | (nvm[1] << 8);
+    uint16_t t2 = nvm[2] | (nvm[3] << 8);
+    int8_t t3 = (int8_t)nvm[4];
+    int16_t p1 = (int16_t)(nvm[5] | (nvm[6] << 8));
+    int16_t p2 = (int16_t)(nvm[7] | (nvm[8] << 8));
+    int8_t p3 = (int8_t)nvm[9];
+    int8_t p4 = (int8_t)nvm[10];
+    uint16_t p5 = nvm[11] | (nvm[12] << 8);
+    uint16_t p6 = nvm[13] | (nvm[14] << 8);
+    int8_t p7 = (int8_t)nvm[15];
+    int8_t p8 = (int8_t)nvm[16];
+    int16_t p9 = (int16_t)(nvm[17] | (nvm[18] << 8));
+    int8_t p10 = (int8_t)nvm[19];
+    int8_t p11 = (int8_t)nvm[20];
+
+    par_t1 = t1 / 0.00390625f;                      // 2^-8
+    par_t2 = t2 / 1073741824.0f;                    // 2^30
+    par_t3 = t3 / 281474976710656.0f;               // 2^48
+    par_p1 = (p1 - 16384) / 1048576.0f;             // (P1 - 2^14) / 2^20
+    par_p2 = (p2 - 16384) / 536870912.0f;           // (P2 - 2^14) / 2^29
+    par_p3 = p3 / 4294967296.0f;                    // 2^32
+    par_p4 = p4 / 137438953472.0f;                  // 2^37
+    par_p5 = p5 / 0.125f;                           // 2^-3
+    par_p6 = p6 / 64.0f;                            // 2^6
+    par_p7 = p7 / 256.0f;                           // 2^8
+    par_p8 = p8 / 32768.0f;                         // 2^15
+    par_p9 = p9 / 281474976710656.0f;               // 2^48
+    par_p10 = p10 / 281474976710656.0f;             // 2^48
+    par_p11 = p11 / 36893488147419103232.0f;        // 2^65
+
+    // x8 pressure, x1 temperature oversampling, IIR coefficient 3, 50 Hz.
+    // FIFO stores pressure + temperature frames and overwrites the oldest
+    // when full (stop-on-full off), so after a late drain the newest frame
+    // is still one period old at most, which drainFifo()'s timestamps rely on.
+    bool ok = bus.writeRegister(address, BMP3_REG_OSR, 0x03)
+              && bus.writeRegister(address, BMP3_REG_ODR, 0x02)
+              && bus.writeRegister(address, BMP3_REG_CONFIG, 2 << 1)
+              && bus.writeRegister(address, BMP3_REG_FIFO_CONFIG2, 0x08)
+              && bus.writeRegister(address, BMP3_REG_FIFO_CONFIG1, 0x19)
+              && bus.writeRegister(address, BMP3_REG_CMD, BMP3_CMD_FIFO_FLUSH)
+              && bus.writeRegister(address, BMP3_REG_PWR_CTRL, 0x33);   // Normal mode, both sensors
+    queue_head = 0;
+    queue_count = 0;
+    return ok;
+}
+
+float Bmp3Barometer::compensateTemperature(uint32_t raw) {
+    float partial1 = (float)raw - par_t1;
+    float partial2 = partial1 * par_t2;
+    t_lin = partial2 + (partial1 * partial1) * par_t3;
+    return t_lin;
+}
+
+float Bmp3Barometer::compensatePressure(uint32_t raw) const {
+    float t = t_lin;
+    float t2 = t * t;
+    float t3 = t2 * t;
+    float up = (float)raw;
+
+    float out1 = par_p5 + par_p6 * t + par_p7 * t2 + par_p8 * t3;
+    float out2 = up * (par_p1 + par_p2 * t + par_p3 * t2 + par_p4 * t3);
+    float up2 = up * up;
+    float out3 = up2 * (par_p9 + par_p10 * t) + up2 * up * par_p11;
+    return out1 + out2 + out3;
+}
+
+size_t Bmp3Barometer::drainFifo() {
+    uint8_t len_raw[2];
+    if (!bus.readRegister(address, BMP3_REG_FIFO_LENGTH, len_raw, 2)) {
+        return 0;
+    }
+    size_t fifo_bytes = len_raw[0] | ((len_raw[1] & 0x01) << 8);
+    if (fifo_bytes == 0) {
+        return 0;
+    }
+
+    // Only whole pressure + temperature frames, and only what fits
+    size_t room = QUEUE_SIZE - queue_count;
+    size_t frames = fifo_bytes / FRAME_BYTES;
+    if (frames > MAX_FRAMES) {
+        frames = MAX_FRAMES;
+    }
+    if (frames > room) {
+        frames = room;
+    }
+    if (frames == 0) {
+        return 0;
+    }
+
+    uint8_t data[MAX_FRAMES * FRAME_BYTES];
+    uint32_t read_time = micros();
+    if (!bus.readRegister(address, BMP3_REG_FIFO_DATA, data, frames * FRAME_BYTES)) {
+        return 0;
+    }
+
+    const uint32_t period_us = 1000000 / ODR_HZ;
+    BaroSample parsed[MAX_FRAMES];
+    size_t count = 0;
+    size_t pos = 0;
+    size_t bytes = frames * FRAME_BYTES;
+    while (pos < bytes) {
+        uint8_t header = data[pos++];
+        if (header == BMP3_FRAME_PRESS_TEMP && pos + 6 <= bytes) {
+            compensateTemperature(le24(&data[pos]));
+            parsed[count].pressure_pa = compensatePressure(le24(&data[pos + 3]));
+            parsed[count].temperature_c = t_lin;
+            count++;
+            pos += 6;
+        } else if (header == BMP3_FRAME_TEMP && pos + 3 <= bytes) {
+            compensateTemperature(le24(&data[pos]));
+            pos += 3;
+        } else if (header == BMP3_FRAME_PRESS && pos + 3 <= bytes) {
+            parsed[count].pressure_pa = compensatePressure(le24(&data[pos]));
+            parsed[count].temperature_c = t_lin;
+            count++;
+            pos += 3;
+        } else if (header == BMP3_FRAME_TIME && pos + 3 <= bytes) {
+            pos += 3;
+        } else if ((header == BMP3_FRAME_CONFIG_ERR || header == BMP3_FRAME_CONFIG_CHG) && pos + 1 <= bytes) {
+            pos += 1;
+        } else {
+            pos--;   // Empty frame, garbage or a frame cut off - stop here
+            break;
+        }
+    }
+
+    // The newest frame in the FIFO was measured at most one period before
+    // the read and frames are one period apart going backwards; this burst
+    // ends before whatever it left in the FIFO
+    size_t frames_left = (fifo_bytes - pos) / FRAME_BYTES;
+
+    for (size_t i = 0; i < count; i++) {
+        parsed[i].time_us = read_time - (uint32_t)(count - 1 - i + frames_left) * period_us;
+        queue[(queue_head + queue_count) % QUEUE_SIZE] = parsed[i];
+        queue_count++;
+    }
+    return count;
+}
+
+bool Bmp3Barometer::poll() {
+    if (queue_count == 0) {
+        drainFifo();
+    }
+    return queue_count > 0;
+}
+
+size_t Bmp3Barometer::readBatch(BaroSample* out, size_t max) {
+    if (queue_count < max) {
+        drainFifo();
+    }
+    size_t n = 0;
+    while (n < max && queue_count > 0) {
+        out[n++] = queue[queue_head];
+        queue_head = (queue_head + 1) % QUEUE_SIZE;
+        queue_count--;
+    }
+    return n;
+}
@@ -0,0 +1,56 @@
+#ifndef BMP3_BAROMETER_H
+#define BMP3_BAROMETER_H
+
+#include "barometer.h"
+
+// BMP388 / BMP390 driver. The part converts continuously at ODR_HZ into its
+// 512-byte FIFO; readBatch() drains up to a whole batch of pressure and
+// temperature frames per I2C transaction instead of one sample per poll.
+class Bmp3Barometer : public Barometer {
+public:
+    static const uint8_t ADDRESS_PRIMARY = 0x77;
+    static const uint8_t ADDRESS_SECONDARY = 0x76;
+    static const uint32_t ODR_HZ = 50;
+
+    Bmp3Barometer(I2CBus& bus, uint8_t address = ADDRESS_PRIMARY);
+
+    void setAddress(uint8_t i2c_address) { address = i2c_address; }
+
+    bool begin() override;
+    bool startConversion() override { return true; }   // Normal mode, always converting
+    bool poll() override;
+    size_t readBatch(BaroSample* out, size_t max) override;
+
+    bool hasFifo() const override { return true; }
+    Type getType() const override { return TYPE_BMP3XX; }
+    const char* getName() const override { return chip_id == 0x60 ? "BMP390" : "BMP388"; }
+    uint8_t getAddress() const override { return address; }
+    uint32_t getMaxClockHz() const override { return 400000; }   // Wire has no 3.4 MHz Hs mode
+
+private:
+    static const size_t FRAME_BYTES = 7;     // Header + temperature + pressure
+    static const size_t MAX_FRAMES = 18;     // One 126-byte burst
+    static const size_t QUEUE_SIZE = 32;
+
+    I2CBus& bus;
+    uint8_t address;
+    uint8_t chip_id;
+
+    // Calibration converted to floats (datasheet section 9.1)
+    float par_t1, par_t2, par_t3;
+    float par_p1, par_p2, par_p3, par_p4, par_p5, par_p6;
+    float par_p7, par_p8, par_p9, par_p10, par_p11;
+
+    float t_lin;    // Last compensated temperature
+
+    // Samples drained from the FIFO but not yet handed out
+    BaroSample queue[QUEUE_SIZE];
+    size_t queue_head;
+    size_t queue_count;
+
+    size_t drainFifo();
+    float compensateTemperature(uint32_t raw);
+    float compensatePressure(uint32_t raw) const;
+};
+
+#endif // BMP3_BAROMETER_H
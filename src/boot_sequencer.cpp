@@ -0,0 +1,74 @@
+#include "boot_sequencer.h"
+#include "deferred_log.h"
+
+BootSequencer::BootSequencer() {
+    step_count = 0;
+    total_duration_ms = 0;
+}
+
+bool BootSequencer::addStep(uint16_t ready_msg, StartFunction start, PollFunction poll, uint32_t timeout_ms) {
+    if (step_count >= MAX_STEPS) {
+        return false;
+    }
+
+    Step& step = steps[step_count++];
+    step.ready_msg = ready_msg;
+    step.start = start;
+    step.poll = poll;
+    step.timeout_ms = timeout_ms;
+    step.started_ms = 0;
+    step.duration_ms = 0;
+    step.state = STEP_PENDING;
+    return true;
+}
+
+void BootSequencer::finish(int index, StepState state) {
+    Step& step = steps[index];
+    step.state = state;
+    step.duration_ms = millis() - step.started_ms;
+    if (state == STEP_READY) {
+        dlog.log(step.ready_msg, step.duration_ms);
+    } else {
+        DLOG(BOOT_STEP_FAILED, index, step.duration_ms);
+    }
+}
+
+void BootSequencer::run() {
+    uint32_t run_start = millis();
+
+    // Start everything first so the steps' waits overlap
+    for (int i = 0; i < step_count; i++) {
+        Step& step = steps[i];
+        step.started_ms = millis();
+        if (step.start != nullptr && !step.start()) {
+            finish(i, STEP_FAILED);
+        } else if (step.poll == nullptr) {
+            finish(i, STEP_READY);
+        } else {
+            step.state = STEP_RUNNING;
+        }
+    }
+
+    bool pending = true;
+    while (pending) {
+        pending = false;
+        for (int i = 0; i < step_count; i++) {
+            Step& step = steps[i];
+            if (step.state != STEP_RUNNING) {
+                continue;
+            }
+            if (step.poll()) {
+                finish(i, STEP_READY);
+            } else if (millis() - step.started_ms >= step.timeout_ms) {
+                finish(i, STEP_FAILED);
+            } else {
+                pending = true;
+            }
+        }
+        if (pending) {
+            delay(1);  // Yield to WiFi/idle tasks while waiting
+        }
+    }
+
+    total_duration_ms = millis() - run_start;
+}
@@ -0,0 +1,56 @@
+#ifndef BOOT_SEQUENCER_H
+#define BOOT_SEQUENCER_H
+
+#include <Arduino.h>
+
+// Runs independent boot steps concurrently.
+// Every step is started up front, then all pending steps are polled
+// round-robin until each reports ready (or times out). A slow step such as
+// the TFT reset sequence therefore no longer delays the sensor bring-up, and
+// fixed delay() calls become readiness checks.
+class BootSequencer {
+public:
+    typedef bool (*StartFunction)();  // Returns false if the step failed outright
+    typedef bool (*PollFunction)();   // Returns true once the step is ready
+
+    static const int MAX_STEPS = 8;
+
+    BootSequencer();
+
+    // poll may be nullptr for steps that are complete once started.
+    // ready_msg is a LogMessageId taking the step duration in ms.
+    bool addStep(uint16_t ready_msg, StartFunction start, PollFunction poll, uint32_t timeout_ms);
+
+    // Starts every step and polls until all are ready, failed or timed out
+    void run();
+
+    bool isReady(int index) { return index < step_count && steps[index].state == STEP_READY; }
+    uint32_t getDuration(int index) { return index < step_count ? steps[index].duration_ms : 0; }
+    uint32_t getTotalDuration() { return total_duration_ms; }
+
+private:
+    enum StepState {
+        STEP_PENDING,
+        STEP_RUNNING,
+        STEP_READY,
+        STEP_FAILED
+    };
+
+    struct Step {
+        uint16_t ready_msg;
+        StartFunction start;
+        PollFunction poll;
+        uint32_t timeout_ms;
+        uint32_t started_ms;
+        uint32_t duration_ms;
+        StepState state;
+    };
+
+    Step steps[MAX_STEPS];
+    int step_count;
+    uint32_t total_duration_ms;
+
+    void finish(int index, StepState state);
+};
+
+#endif // BOOT_SEQUENCER_H
@@ -0,0 +1,61 @@
+#include "calibration_cache.h"
+#include <Preferences.h>
+
+static const char* NVS_NAMESPACE = "altimeter";
+static const char* NVS_KEY = "calib";
+
+// Changes smaller than this are not worth an NVS write
+static const float PRESSURE_SAVE_THRESHOLD = 50.0;    // Pa (~4 m)
+static const float TEMPERATURE_SAVE_THRESHOLD = 2.0;  // C
+
+CalibrationCache::CalibrationCache() {
+    cached.baseline_pressure = 101325.0;
+    cached.baseline_altitude = 0.0;
+    cached.temperature = 0.0;
+    cached_valid = false;
+}
+
+bool CalibrationCache::load(CalibrationData& data) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        return false;
+    }
+
+    StoredBlob blob;
+    size_t len = prefs.getBytes(NVS_KEY, &blob, sizeof(blob));
+    prefs.end();
+
+    if (len != sizeof(blob) || blob.version != FORMAT_VERSION) {
+        return false;
+    }
+
+    cached = blob.data;
+    cached_valid = true;
+    data = cached;
+    return true;
+}
+
+bool CalibrationCache::save(const CalibrationData& data) {
+    if (cached_valid &&
+        fabs(data.baseline_pressure - cached.baseline_pressure) < PRESSURE_SAVE_THRESHOLD &&
+        fabs(data.temperature - cached.temperature) < TEMPERATURE_SAVE_THRESHOLD) {
+        return true;  // Cache is already close enough
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        return false;
+    }
+
+    StoredBlob blob;
+    blob.version = FORMAT_VERSION;
+    blob.data = data;
+    bool ok = prefs.putBytes(NVS_KEY, &blob, sizeof(blob)) == sizeof(blob);
+    prefs.end();
+
+    if (ok) {
+        cached = data;
+        cached_valid = true;
+    }
+    return ok;
+}
@@ -0,0 +1,39 @@
+#ifndef CALIBRATION_CACHE_H
+#define CALIBRATION_CACHE_H
+
+#include <Arduino.h>
+
+// Calibration values persisted in NVS between boots.
+// Loading these at power-on gives a usable ground reference immediately,
+// instead of waiting for the barometer to settle before the first reading.
+struct CalibrationData {
+    float baseline_pressure;   // Ground-level pressure (Pa)
+    float baseline_altitude;   // Ground altitude above sea level (m)
+    float temperature;         // Last ground temperature (C)
+};
+
+class CalibrationCache {
+private:
+    static const uint32_t FORMAT_VERSION = 1;
+
+    struct StoredBlob {
+        uint32_t version;
+        CalibrationData data;
+    };
+
+    CalibrationData cached;
+    bool cached_valid;
+
+public:
+    CalibrationCache();
+
+    // Reads the cached values from NVS; returns false if none are stored
+    bool load(CalibrationData& data);
+
+    // Writes to NVS only when the values moved noticeably, to spare flash wear
+    bool save(const CalibrationData& data);
+
+    bool isValid() { return cached_valid; }
+};
+
+#endif // CALIBRATION_CACHE_H
@@ -0,0 +1,416 @@
+#include "compressed_series.h"
+#include <string.h>
+#include <math.h>
+
+static const uint8_t NO_WINDOW = 0xFF;   // XOR column has no leading/trailing window yet
+static const uint32_t TIME_MAX_BITS = 4 + 32;
+static const uint32_t XOR_MAX_BITS = 2 + 5 + 5 + 32;
+static const uint32_t DELTA_MAX_BITS = 4 + 32;
+
+// MSB-first bit stream; blocks are zeroed when opened, so writing only ORs
+static void putBits(uint8_t* data, uint32_t& bit, uint32_t value, int count) {
+    while (count > 0) {
+        int room = 8 - (int)(bit & 7);
+        int take = count < room ? count : room;
+        uint32_t chunk = (value >> (count - take)) & ((1u << take) - 1);
+        data[bit >> 3] |= (uint8_t)(chunk << (room - take));
+        bit += take;
+        count -= take;
+    }
+}
+
+static uint32_t getBits(const uint8_t* data, uint32_t& bit, int count) {
+    uint32_t value = 0;
+    while (count > 0) {
+        int room = 8 - (int)(bit & 7);
+        int take = count < room ? count : room;
+        uint32_t chunk = (data[bit >> 3] >> (room - take)) & ((1u << take) - 1);
+        value = (value << take) | chunk;
+        bit += take;
+        count -= take;
+    }
+    return value;
+}
+
+// Number of leading '1' bits before a '0', up to max (the last prefix has no '0')
+static int getPrefix(const uint8_t* data, uint32_t& bit, int max) {
+    int ones = 0;
+    while (ones < max && getBits(data, bit, 1) == 1) {
+        ones++;
+    }
+    return ones;
+}
+
+static int leadingZeros(uint32_t x) {
+    int n = 0;
+    while ((x & 0x80000000u) == 0) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
+
+static int trailingZeros(uint32_t x) {
+    int n = 0;
+    while ((x & 1u) == 0) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static uint32_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bitsToFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Signed value in buckets: '0' for zero, then '10', '110', '1110' with
+// increasingly wide fields and '1111' for the full 32 bits
+struct Bucket {
+    int prefix_bits;
+    uint32_t prefix;
+    int width;
+};
+
+static const Bucket TIME_BUCKETS[4] = { { 2, 0x2, 7 }, { 3, 0x6, 12 }, { 4, 0xE, 20 }, { 4, 0xF, 32 } };
+static const Bucket DELTA_BUCKETS[4] = { { 2, 0x2, 6 }, { 3, 0x6, 12 }, { 4, 0xE, 20 }, { 4, 0xF, 32 } };
+
+// Zigzag folds the sign into bit 0 so small changes either way stay small
+static uint32_t zigzag(uint32_t value) {
+    return (value << 1) ^ (uint32_t)((int32_t)value >> 31);
+}
+
+static uint32_t unzigzag(uint32_t value) {
+    return (value >> 1) ^ (0u - (value & 1u));
+}
+
+static void putBucketed(uint8_t* data, uint32_t& bit, uint32_t zigzagged, const Bucket* buckets) {
+    if (zigzagged == 0) {
+        putBits(data, bit, 0, 1);
+        return;
+    }
+    int b = 0;
+    while (b < 3 && (zigzagged >> buckets[b].width) != 0) {
+        b++;
+    }
+    putBits(data, bit, buckets[b].prefix, buckets[b].prefix_bits);
+    putBits(data, bit, zigzagged, buckets[b].width);
+}
+
+static uint32_t getBucketed(const uint8_t* data, uint32_t& bit, const Bucket* buckets) {
+    int ones = getPrefix(data, bit, 4);
+    if (ones == 0) {
+        return 0;
+    }
+    return getBits(data, bit, buckets[ones - 1].width);
+}
+
+CompressedSeries::Iterator::Iterator() {
+    series = nullptr;
+    block = 0;
+    sample = 0;
+    bit = 0;
+    time_us = 0;
+    delta_us = 0;
+}
+
+CompressedSeries::CompressedSeries() {
+    column_count = 0;
+    blocks = nullptr;
+    block_table = nullptr;
+    read_only = false;
+    block_capacity = 0;
+    clear();
+}
+
+void CompressedSeries::configure(const Column* new_columns, int count) {
+    if (count > MAX_COLUMNS) {
+        count = MAX_COLUMNS;
+    }
+    column_count = count;
+    for (int c = 0; c < count; c++) {
+        columns[c] = new_columns[c];
+        scale[c] = new_columns[c].resolution > 0.0f ? 1.0f / new_columns[c].resolution : 1.0f;
+    }
+}
+
+bool CompressedSeries::begin(void* memory, size_t bytes) {
+    if (memory == nullptr || bytes / BLOCK_BYTES < 2) {
+        return false;
+    }
+    blocks = static_cast<uint8_t*>(memory);
+    block_table = nullptr;
+    read_only = false;
+    block_capacity = bytes / BLOCK_BYTES;
+    clear();
+    return true;
+}
+
+bool CompressedSeries::attach(const void* memory, uint32_t count) {
+    if (memory == nullptr || count == 0) {
+        return false;
+    }
+    // Never written through: append() checks read_only
+    blocks = static_cast<uint8_t*>(const_cast<void*>(memory));
+    block_table = nullptr;
+    read_only = true;
+    block_capacity = count;
+    clear();
+    block_count = count;
+    for (uint32_t b = 0; b < count; b++) {
+        sample_count += blockHeader(b)->sample_count;
+    }
+    return true;
+}
+
+bool CompressedSeries::attach(const uint8_t* const* table, uint32_t count) {
+    if (table == nullptr || count == 0) {
+        return false;
+    }
+    blocks = const_cast<uint8_t*>(table[0]);
+    block_table = table;
+    read_only = true;
+    block_capacity = count;
+    clear();
+    block_count = count;
+    for (uint32_t b = 0; b < count; b++) {
+        sample_count += blockHeader(b)->sample_count;
+    }
+    return true;
+}
+
+void CompressedSeries::clear() {
+    first_block = 0;
+    block_count = 0;
+    sample_count = 0;
+    dropped_samples = 0;
+    last_time_us = 0;
+    last_delta_us = 0;
+}
+
+uint8_t* CompressedSeries::blockAddress(uint32_t ring_index) const {
+    if (block_table != nullptr) {
+        return const_cast<uint8_t*>(block_table[ring_index]);
+    }
+    return blocks + ring_index * BLOCK_BYTES;
+}
+
+CompressedSeries::BlockHeader* CompressedSeries::blockHeader(uint32_t ring_index) const {
+    return reinterpret_cast<BlockHeader*>(blockAddress(ring_index));
+}
+
+uint8_t* CompressedSeries::blockData(uint32_t ring_index) const {
+    return blockAddress(ring_index) + sizeof(BlockHeader);
+}
+
+uint32_t CompressedSeries::maxSampleBits() const {
+    uint32_t bits = TIME_MAX_BITS;
+    for (int c = 0; c < column_count; c++) {
+        bits += columns[c].encoding == ENCODING_XOR ? XOR_MAX_BITS : DELTA_MAX_BITS;
+    }
+    return bits;
+}
+
+uint32_t CompressedSeries::quantise(int column, float value) const {
+    float steps = value * scale[column];
+    if (steps >= 2147483520.0f) {
+        return 0x7FFFFFFF;
+    }
+    if (steps <= -2147483648.0f) {
+        return 0x80000000u;
+    }
+    return (uint32_t)(int32_t)floorf(steps + 0.5f);
+}
+
+float CompressedSeries::toValue(int column, uint32_t stored) const {
+    if (columns[column].encoding == ENCODING_XOR) {
+        return bitsToFloat(stored);
+    }
+    return (float)(int32_t)stored * columns[column].resolution;
+}
+
+void CompressedSeries::openBlock(uint32_t time_us, const float* values) {
+    if (block_count == block_capacity) {
+        // Full: the oldest block makes room
+        uint32_t lost = blockHeader(first_block)->sample_count;
+        dropped_samples += lost;
+        sample_count -= lost;
+        first_block = (first_block + 1) % block_capacity;
+        block_count--;
+    }
+    uint32_t index = (first_block + block_count) % block_capacity;
+    memset(blocks + index * BLOCK_BYTES, 0, BLOCK_BYTES);
+
+    // The first sample is stored raw so the block decodes on its own
+    uint8_t* data = blockData(index);
+    uint32_t bit = 0;
+    for (int c = 0; c < column_count; c++) {
+        previous[c] = columns[c].encoding == ENCODING_XOR ? floatBits(values[c]) : quantise(c, values[c]);
+        leading[c] = NO_WINDOW;
+        trailing[c] = 0;
+        putBits(data, bit, previous[c], 32);
+    }
+    last_time_us = time_us;
+    last_delta_us = 0;
+
+    BlockHeader* header = blockHeader(index);
+    header->first_time_us = time_us;
+    header->bit_count = bit;
+    header->sample_count = 1;
+    block_count++;
+}
+
+void CompressedSeries::append(uint32_t time_us, const float* values) {
+    if (!isReady() || read_only) {
+        return;
+    }
+
+    uint32_t index = (first_block + block_count - 1) % block_capacity;
+    BlockHeader* header = blockHeader(index);
+    const uint32_t block_bits = (BLOCK_BYTES - sizeof(BlockHeader)) * 8;
+    if (block_count == 0 || header->bit_count + maxSampleBits() > block_bits) {
+        openBlock(time_us, values);
+        sample_count++;
+        return;
+    }
+
+    uint8_t* data = blockData(index);
+    uint32_t bit = header->bit_count;
+
+    // Timestamp: change in the sample interval, wrap-safe in uint32
+    int32_t delta = (int32_t)(time_us - last_time_us);
+    putBucketed(data, bit, zigzag((uint32_t)delta - (uint32_t)last_delta_us), TIME_BUCKETS);
+    last_time_us = time_us;
+    last_delta_us = delta;
+
+    for (int c = 0; c < column_count; c++) {
+        if (columns[c].encoding == ENCODING_DELTA) {
+            uint32_t q = quantise(c, values[c]);
+            putBucketed(data, bit, zigzag(q - previous[c]), DELTA_BUCKETS);
+            previous[c] = q;
+            continue;
+        }
+
+        uint32_t bits = floatBits(values[c]);
+        uint32_t x = bits ^ previous[c];
+        previous[c] = bits;
+        if (x == 0) {
+            putBits(data, bit, 0, 1);
+            continue;
+        }
+        int lz = leadingZeros(x);
+        int tz = trailingZeros(x);
+        if (leading[c] != NO_WINDOW && lz >= leading[c] && tz >= trailing[c]) {
+            // Fits the previous window
+            putBits(data, bit, 0x2, 2);
+            putBits(data, bit, x >> trailing[c], 32 - leading[c] - trailing[c]);
+        } else {
+            int length = 32 - lz - tz;
+            putBits(data, bit, 0x3, 2);
+            putBits(data, bit, (uint32_t)lz, 5);
+            putBits(data, bit, (uint32_t)(length - 1), 5);
+            putBits(data, bit, x >> tz, length);
+            leading[c] = (uint8_t)lz;
+            trailing[c] = (uint8_t)tz;
+        }
+    }
+
+    // Count last, so a reader never sees a half-written sample
+    header->bit_count = bit;
+    header->sample_count++;
+    sample_count++;
+}
+
+CompressedSeries::Iterator CompressedSeries::iterate() const {
+    Iterator it;
+    it.series = this;
+    return it;
+}
+
+size_t CompressedSeries::getBytesUsed() const {
+    size_t bytes = 0;
+    for (uint32_t b = 0; b < block_count; b++) {
+        const BlockHeader* header = blockHeader((first_block + b) % block_capacity);
+        bytes += sizeof(BlockHeader) + (header->bit_count + 7) / 8;
+    }
+    return bytes;
+}
+
+const uint8_t* CompressedSeries::getBlock(uint32_t ordinal) const {
+    if (ordinal >= block_count) {
+        return nullptr;
+    }
+    return blockAddress((first_block + ordinal) % block_capacity);
+}
+
+uint32_t CompressedSeries::getFirstTimeUs() const {
+    return block_count > 0 ? blockHeader(first_block)->first_time_us : 0;
+}
+
+bool CompressedSeries::Iterator::next(uint32_t& out_time_us, float* values) {
+    if (series == nullptr || !series->isReady()) {
+        return false;
+    }
+
+    while (block < series->block_count) {
+        uint32_t index = (series->first_block + block) % series->block_capacity;
+        const BlockHeader* header = series->blockHeader(index);
+        if (sample >= header->sample_count) {
+            block++;
+            sample = 0;
+            continue;
+        }
+
+        const uint8_t* data = series->blockData(index);
+        int columns = series->column_count;
+        if (sample == 0) {
+            bit = 0;
+            time_us = header->first_time_us;
+            delta_us = 0;
+            for (int c = 0; c < columns; c++) {
+                previous[c] = getBits(data, bit, 32);
+                leading[c] = NO_WINDOW;
+                trailing[c] = 0;
+            }
+        } else {
+            delta_us = (int32_t)((uint32_t)delta_us + unzigzag(getBucketed(data, bit, TIME_BUCKETS)));
+            time_us += delta_us;
+
+            for (int c = 0; c < columns; c++) {
+                if (series->columns[c].encoding == ENCODING_DELTA) {
+                    previous[c] += unzigzag(getBucketed(data, bit, DELTA_BUCKETS));
+                    continue;
+                }
+                if (getBits(data, bit, 1) == 0) {
+                    continue;   // Unchanged
+                }
+                if (getBits(data, bit, 1) == 0) {
+                    int length = 32 - leading[c] - trailing[c];
+                    previous[c] ^= getBits(data, bit, length) << trailing[c];
+                } else {
+                    int lz = (int)getBits(data, bit, 5);
+                    int length = (int)getBits(data, bit, 5) + 1;
+                    int tz = 32 - lz - length;
+                    previous[c] ^= getBits(data, bit, length) << tz;
+                    leading[c] = (uint8_t)lz;
+                    trailing[c] = (uint8_t)tz;
+                }
+            }
+        }
+
+        for (int c = 0; c < columns; c++) {
+            values[c] = series->toValue(c, previous[c]);
+        }
+        out_time_us = time_us;
+        sample++;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,129 @@
+#ifndef COMPRESSED_SERIES_H
+#define COMPRESSED_SERIES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compressed in-RAM time series in the style of Facebook's Gorilla.
+// Each sample is a timestamp plus up to MAX_COLUMNS float values:
+//   - timestamps: delta-of-delta, '0' for a steady sample clock, then
+//     7, 12, 20 or 32 bit buckets
+//   - ENCODING_XOR columns: the float XORed with the previous one; only the
+//     meaningful bits are stored, reusing the previous leading/trailing zero
+//     window when they fit. Lossless
+//   - ENCODING_DELTA columns: quantised to `resolution` (e.g. the sensor's
+//     LSB), then the zigzagged change is stored in 6, 12, 20 or 32 bit
+//     buckets. Lossless for data already on that grid
+// Samples go into fixed BLOCK_BYTES blocks that each start from a raw
+// sample, so a block decodes on its own. The blocks form a ring in
+// caller-provided memory (PSRAM on the device): when it is full, append()
+// recycles the oldest block. Nothing is allocated and there is no Arduino
+// dependency.
+// Single writer; an Iterator must not run across an append() that
+// recycles the block it is reading. Exported blocks (getBlock()) can be
+// stored as they are and read back in place with attach(), contiguous or
+// scattered (e.g. across flash segments).
+class CompressedSeries {
+public:
+    enum Encoding {
+        ENCODING_XOR,
+        ENCODING_DELTA
+    };
+
+    struct Column {
+        Encoding encoding;
+        float resolution;    // ENCODING_DELTA quantum, in the value's units
+    };
+
+    static const int MAX_COLUMNS = 6;
+    static const size_t BLOCK_BYTES = 4096;
+
+    // Decodes samples oldest first
+    class Iterator {
+    public:
+        Iterator();
+        bool next(uint32_t& time_us, float* values);
+
+    private:
+        friend class CompressedSeries;
+        const CompressedSeries* series;
+        uint32_t block;        // Blocks visited, oldest first
+        uint32_t sample;       // Index within the block
+        uint32_t bit;
+        uint32_t time_us;
+        int32_t delta_us;
+        uint32_t previous[MAX_COLUMNS];   // Float bits or quantised value
+        uint8_t leading[MAX_COLUMNS];
+        uint8_t trailing[MAX_COLUMNS];
+    };
+
+    CompressedSeries();
+
+    // Columns must be set before begin(); count is clamped to MAX_COLUMNS
+    void configure(const Column* columns, int count);
+    int getColumnCount() const { return column_count; }
+
+    // memory is split into BLOCK_BYTES blocks; false if it holds fewer than 2
+    bool begin(void* memory, size_t bytes);
+    bool isReady() const { return blocks != nullptr; }
+    void clear();
+
+    // Read-only view of exported blocks, oldest first (e.g. a mapped flight
+    // archive); configure() the same columns first. append() is ignored.
+    bool attach(const void* memory, uint32_t count);
+    // Same, with the blocks wherever table[0..count) points; the table must
+    // outlive the series
+    bool attach(const uint8_t* const* table, uint32_t count);
+
+    void append(uint32_t time_us, const float* values);
+    Iterator iterate() const;
+
+    uint32_t getSampleCount() const { return sample_count; }
+    uint32_t getDroppedSamples() const { return dropped_samples; }   // Lost to recycled blocks
+    size_t getBytesUsed() const;
+    size_t getCapacityBytes() const { return block_capacity * BLOCK_BYTES; }
+    uint32_t getFirstTimeUs() const;
+    uint32_t getLastTimeUs() const { return last_time_us; }
+    const Column& getColumn(int column) const { return columns[column]; }
+
+    // Blocks in use, oldest first, BLOCK_BYTES each
+    uint32_t getBlockCount() const { return block_count; }
+    const uint8_t* getBlock(uint32_t ordinal) const;
+
+private:
+    struct BlockHeader {
+        uint32_t first_time_us;
+        uint32_t sample_count;
+        uint32_t bit_count;      // Valid bits in the stream after the header
+    };
+
+    Column columns[MAX_COLUMNS];
+    int column_count;
+    float scale[MAX_COLUMNS];    // 1 / resolution
+
+    uint8_t* blocks;
+    const uint8_t* const* block_table;   // attach()ed scattered blocks, else null
+    bool read_only;
+    uint32_t block_capacity;
+    uint32_t first_block;        // Oldest block in the ring
+    uint32_t block_count;        // Blocks in use
+    uint32_t sample_count;
+    uint32_t dropped_samples;
+
+    // Encoder state for the open block
+    uint32_t last_time_us;
+    int32_t last_delta_us;
+    uint32_t previous[MAX_COLUMNS];
+    uint8_t leading[MAX_COLUMNS];
+    uint8_t trailing[MAX_COLUMNS];
+
+    uint8_t* blockAddress(uint32_t ring_index) const;
+    BlockHeader* blockHeader(uint32_t ring_index) const;
+    uint8_t* blockData(uint32_t ring_index) const;
+    uint32_t maxSampleBits() const;
+    void openBlock(uint32_t time_us, const float* values);
+    uint32_t quantise(int column, float value) const;
+    float toValue(int column, uint32_t stored) const;
+};
+
+#endif // COMPRESSED_SERIES_H
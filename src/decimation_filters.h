@@ -0,0 +1,48 @@
+#ifndef DECIMATION_FILTERS_H
+#define DECIMATION_FILTERS_H
+
+#include <stdint.h>
+
+// Generated by tools/gen_decimation_filters.py - do not edit.
+// Kaiser-windowed sinc low-pass per decimation stage, Q15, unity DC gain;
+// passband 40% of the output Nyquist, 60 dB stopband.
+static const int DECIMATION_COEFF_FRAC_BITS = 15;
+static const int DECIMATION_STAGES = 3;
+static const int DECIMATION_MAX_TAPS = 33;
+
+// Stage 0: decimate by 5, 33 taps
+static const int16_t decimation_stage0[33] = {
+    -8, 0, 35, 97, 152, 141, 0, -283, -627, -848,
+    -704, 0, 1303, 3019, 4763, 6068, 6552, 6068, 4763, 3019,
+    1303, 0, -704, -848, -627, -283, 0, 141, 152, 97,
+    35, 0, -8
+};
+
+// Stage 1: decimate by 4, 27 taps
+static const int16_t decimation_stage1[27] = {
+    -12, 0, 67, 172, 202, 0, -474, -978, -996, 0,
+    2141, 4905, 7262, 8190, 7262, 4905, 2141, 0, -996, -978,
+    -474, 0, 202, 172, 67, 0, -12
+};
+
+// Stage 2: decimate by 5, 33 taps
+static const int16_t decimation_stage2[33] = {
+    -8, 0, 35, 97, 152, 141, 0, -283, -627, -848,
+    -704, 0, 1303, 3019, 4763, 6068, 6552, 6068, 4763, 3019,
+    1303, 0, -704, -848, -627, -283, 0, 141, 152, 97,
+    35, 0, -8
+};
+
+struct DecimationStageTable {
+    uint8_t factor;
+    uint8_t taps;
+    const int16_t* coeffs;
+};
+
+static const DecimationStageTable decimation_stages[DECIMATION_STAGES] = {
+    { 5, 33, decimation_stage0 },
+    { 4, 27, decimation_stage1 },
+    { 5, 33, decimation_stage2 }
+};
+
+#endif // DECIMATION_FILTERS_H
@@ -0,0 +1,264 @@
+#include "deferred_log.h"
+
+DeferredLog dlog;
+
+static const char* const log_formats[] = {
+#define LOG_MESSAGE_FORMAT(id, fmt) fmt,
+    LOG_MESSAGES(LOG_MESSAGE_FORMAT)
+#undef LOG_MESSAGE_FORMAT
+};
+
+const char* getLogFormat(uint16_t msg_id) {
+    if (msg_id >= LOG_MESSAGE_COUNT) {
+        return nullptr;
+    }
+    return log_formats[msg_id];
+}
+
+DeferredLog::DeferredLog() {
+    head = 0;
+    tail = 0;
+    dropped_pending = 0;
+    dropped_total = 0;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    output = nullptr;
+    output_mode = OUTPUT_TEXT;
+    drain_task = nullptr;
+}
+
+bool DeferredLog::begin(Print* out, OutputMode mode, UBaseType_t priority) {
+    output = out;
+    output_mode = mode;
+    if (drain_task != nullptr) {
+        return true;
+    }
+    // Core 0 keeps formatting and USB I/O off the core running loop()
+    return xTaskCreatePinnedToCore(drainTaskEntry, "dlog", 4096, this, priority, &drain_task, 0) == pdPASS;
+}
+
+void DeferredLog::push(Record& record) {
+    record.timestamp_ms = millis();
+
+    portENTER_CRITICAL(&lock);
+    uint16_t next = (head + 1) % BUFFER_RECORDS;
+    if (next == tail) {
+        // Buffer full - drop the newest record rather than block the caller
+        dropped_pending++;
+        dropped_total++;
+    } else {
+        ring[head] = record;
+        head = next;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+bool DeferredLog::pop(Record& record) {
+    bool available = false;
+
+    portENTER_CRITICAL(&lock);
+    if (tail != head) {
+        record = ring[tail];
+        tail = (tail + 1) % BUFFER_RECORDS;
+        available = true;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    return available;
+}
+
+size_t DeferredLog::formatRecord(const Record& record, char* buffer, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    const char* fmt = getLogFormat(record.msg_id);
+    if (fmt == nullptr) {
+        int written = snprintf(buffer, size, "[log] unknown message %u", (unsigned)record.msg_id);
+        return (written < 0) ? 0 : ((size_t)written < size ? written : size - 1);
+    }
+
+    size_t pos = 0;
+    int arg = 0;
+    const char* p = fmt;
+
+    while (*p && pos + 1 < size) {
+        if (*p != '%') {
+            buffer[pos++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            buffer[pos++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision; length modifiers are implied by the argument tag
+        char spec[16];
+        int n = 0;
+        spec[n++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && n < 12) {
+            spec[n++] = *p++;
+        }
+        while (*p == 'l' || *p == 'h' || *p == 'z') {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        char conv = *p++;
+        spec[n++] = conv;
+        spec[n] = '\0';
+
+        if (conv == 's') {
+            // Text slots up to the one holding the terminating NUL
+            bool ended = false;
+            while (!ended && arg < MAX_ARGS && argType(record.arg_types, arg) == ARG_TEXT) {
+                uint32_t chars = record.args[arg++];
+                for (int c = 0; c < 4 && pos + 1 < size; c++) {
+                    char ch = (char)(chars >> (c * 8));
+                    if (ch == '\0') {
+                        ended = true;
+                        break;
+                    }
+                    buffer[pos++] = ch;
+                }
+            }
+            continue;
+        }
+
+        uint32_t bits = (arg < MAX_ARGS) ? record.args[arg] : 0;
+        uint32_t type = (arg < MAX_ARGS) ? argType(record.arg_types, arg) : (uint32_t)ARG_NONE;
+        arg++;
+
+        float as_float;
+        if (type == ARG_FLOAT) {
+            memcpy(&as_float, &bits, sizeof(as_float));
+        } else if (type == ARG_INT) {
+            as_float = (float)(int32_t)bits;
+        } else {
+            as_float = (float)bits;
+        }
+
+        int written;
+        if (strchr("feEgGaA", conv)) {
+            written = snprintf(buffer + pos, size - pos, spec, (double)as_float);
+        } else if (strchr("dic", conv)) {
+            int value = (type == ARG_FLOAT) ? (int)as_float : (int)(int32_t)bits;
+            written = snprintf(buffer + pos, size - pos, spec, value);
+        } else {
+            unsigned int value = (type == ARG_FLOAT) ? (unsigned int)as_float : (unsigned int)bits;
+            written = snprintf(buffer + pos, size - pos, spec, value);
+        }
+
+        if (written > 0) {
+            pos += written;
+            if (pos >= size) {
+                pos = size - 1;
+            }
+        }
+    }
+
+    buffer[pos] = '\0';
+    return pos;
+}
+
+size_t DeferredLog::encodeFrame(const Record& record, uint8_t* buffer, size_t size) {
+    int arg_count = 0;
+    for (int i = 0; i < MAX_ARGS; i++) {
+        if (argType(record.arg_types, i) != ARG_NONE) {
+            arg_count = i + 1;
+        }
+    }
+
+    size_t frame_size = FRAME_HEADER_SIZE + arg_count * 4 + 1;
+    if (size < frame_size) {
+        return 0;
+    }
+
+    // Little-endian fields, matching tools/log_decode.py
+    size_t pos = 0;
+    buffer[pos++] = FRAME_SYNC_0;
+    buffer[pos++] = FRAME_SYNC_1;
+    buffer[pos++] = record.msg_id & 0xFF;
+    buffer[pos++] = record.msg_id >> 8;
+    for (int shift = 0; shift < 32; shift += 8) {
+        buffer[pos++] = (record.arg_types >> shift) & 0xFF;
+    }
+    for (int shift = 0; shift < 32; shift += 8) {
+        buffer[pos++] = (record.timestamp_ms >> shift) & 0xFF;
+    }
+    for (int i = 0; i < arg_count; i++) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            buffer[pos++] = (record.args[i] >> shift) & 0xFF;
+        }
+    }
+
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < pos; i++) {
+        checksum ^= buffer[i];
+    }
+    buffer[pos++] = checksum;
+
+    return pos;
+}
+
+void DeferredLog::writeBlocking(const uint8_t* data, size_t len) {
+    // Only ever called from the drain task, so waiting here is harmless
+    while (len > 0) {
+        int room = output->availableForWrite();
+        if (room <= 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        size_t chunk = ((size_t)room < len) ? (size_t)room : len;
+        size_t written = output->write(data, chunk);
+        data += written;
+        len -= written;
+    }
+}
+
+bool DeferredLog::drainOnce() {
+    Record record;
+    bool have_record = false;
+
+    portENTER_CRITICAL(&lock);
+    uint32_t dropped = dropped_pending;
+    dropped_pending = 0;
+    portEXIT_CRITICAL(&lock);
+
+    if (dropped > 0) {
+        record.timestamp_ms = millis();
+        record.msg_id = LOG_DROPPED;
+        record.arg_types = ARG_UINT;
+        record.args[0] = dropped;
+        have_record = true;
+    } else {
+        have_record = pop(record);
+    }
+
+    if (!have_record) {
+        return false;
+    }
+
+    if (output_mode == OUTPUT_BINARY) {
+        uint8_t frame[MAX_FRAME_SIZE];
+        size_t len = encodeFrame(record, frame, sizeof(frame));
+        writeBlocking(frame, len);
+    } else {
+        char line[192];
+        size_t len = formatRecord(record, line, sizeof(line) - 1);
+        line[len++] = '\n';
+        writeBlocking((const uint8_t*)line, len);
+    }
+
+    return true;
+}
+
+void DeferredLog::drainTaskEntry(void* param) {
+    DeferredLog* log = static_cast<DeferredLog*>(param);
+    for (;;) {
+        if (log->output == nullptr || !log->drainOnce()) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <Arduino.h>
+#include "log_messages.h"
+
+// Deferred binary logger.
+// Call sites only copy a message ID and raw 32-bit arguments into a ring
+// buffer; formatting and Serial I/O happen in a low-priority drain task, so a
+// USB CDC host that is not reading can never stall the sensor loop. In binary
+// mode the drain task writes raw frames instead, to be decoded offline with
+// tools/log_decode.py.
+class DeferredLog {
+public:
+    enum OutputMode {
+        OUTPUT_TEXT = 0,    // Formatted lines, same as the old Serial.printf output
+        OUTPUT_BINARY = 1   // Raw frames for the host decoder
+    };
+
+    // Argument type tags, 4 bits per argument in Record::arg_types
+    enum ArgType {
+        ARG_NONE = 0,
+        ARG_INT = 1,
+        ARG_UINT = 2,
+        ARG_FLOAT = 3,
+        ARG_TEXT = 4        // Up to 4 characters of a %s string, NUL-padded
+    };
+
+    static const int MAX_ARGS = 8;
+    static const int BUFFER_RECORDS = 128;
+
+    // Binary frame: sync (2) | msg_id (2) | arg_types (4) | timestamp_ms (4) | args (4 each) | xor checksum (1)
+    static const uint8_t FRAME_SYNC_0 = 0xA5;
+    static const uint8_t FRAME_SYNC_1 = 0x5A;
+    static const int FRAME_HEADER_SIZE = 12;
+    static const int MAX_FRAME_SIZE = FRAME_HEADER_SIZE + MAX_ARGS * 4 + 1;
+
+    struct Record {
+        uint32_t timestamp_ms;
+        uint16_t msg_id;
+        uint32_t arg_types;
+        uint32_t args[MAX_ARGS];
+    };
+
+    DeferredLog();
+
+    // Starts the drain task writing to out; records logged before this are kept
+    bool begin(Print* out, OutputMode mode = OUTPUT_TEXT, UBaseType_t priority = 1);
+    void setOutputMode(OutputMode mode) { output_mode = mode; }
+
+    template<typename... Args>
+    void log(uint16_t msg_id, Args... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "too many arguments for a deferred log message");
+        Record record;
+        record.msg_id = msg_id;
+        record.arg_types = 0;
+        packArgs(record, 0, args...);
+        push(record);
+    }
+
+    bool pop(Record& record);
+    uint32_t getDroppedCount() { return dropped_total; }
+
+    // Formatting helpers, shared by the drain task and host-side tools
+    static size_t formatRecord(const Record& record, char* buffer, size_t size);
+    static size_t encodeFrame(const Record& record, uint8_t* buffer, size_t size);
+
+private:
+    Record ring[BUFFER_RECORDS];
+    volatile uint16_t head;     // Next slot to write
+    volatile uint16_t tail;     // Next slot to read
+    uint32_t dropped_pending;   // Drops not yet reported by the drain task
+    uint32_t dropped_total;
+    portMUX_TYPE lock;
+
+    Print* output;
+    OutputMode output_mode;
+    TaskHandle_t drain_task;
+
+    void push(Record& record);
+    bool drainOnce();
+    void writeBlocking(const uint8_t* data, size_t len);
+    static void drainTaskEntry(void* param);
+
+    static uint32_t argType(uint32_t types, int index) { return (types >> (index * 4)) & 0x0F; }
+
+    static void packArg(Record& r, int i, uint32_t type, uint32_t bits) {
+        if (i >= MAX_ARGS) {
+            return;
+        }
+        r.arg_types |= type << (i * 4);
+        r.args[i] = bits;
+    }
+    // Each returns the number of argument slots it used
+    static int pack(Record& r, int i, int v)           { packArg(r, i, ARG_INT, (uint32_t)v); return 1; }
+    static int pack(Record& r, int i, long v)          { packArg(r, i, ARG_INT, (uint32_t)v); return 1; }
+    static int pack(Record& r, int i, char v)          { packArg(r, i, ARG_INT, (uint32_t)v); return 1; }
+    static int pack(Record& r, int i, bool v)          { packArg(r, i, ARG_INT, v ? 1 : 0); return 1; }
+    static int pack(Record& r, int i, unsigned int v)  { packArg(r, i, ARG_UINT, (uint32_t)v); return 1; }
+    static int pack(Record& r, int i, unsigned long v) { packArg(r, i, ARG_UINT, (uint32_t)v); return 1; }
+    static int pack(Record& r, int i, double v)        { return pack(r, i, (float)v); }
+    static int pack(Record& r, int i, float v) {
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        packArg(r, i, ARG_FLOAT, bits);
+        return 1;
+    }
+    // Strings are copied, 4 characters per slot, into the slots left (up to
+    // 32 characters - an SSID fits); a slot with a NUL ends them
+    static int pack(Record& r, int i, const char* v) {
+        int slots = 0;
+        bool ended = (v == nullptr);
+        do {
+            uint32_t bits = 0;
+            for (int c = 0; c < 4 && !ended; c++) {
+                if (*v == '\0') {
+                    ended = true;
+                } else {
+                    bits |= (uint32_t)(uint8_t)*v++ << (c * 8);
+                }
+            }
+            packArg(r, i + slots++, ARG_TEXT, bits);
+        } while (!ended && i + slots < MAX_ARGS);
+        return slots;
+    }
+
+    static void packArgs(Record&, int) {}
+    template<typename T, typename... Rest>
+    static void packArgs(Record& r, int i, T first, Rest... rest) {
+        packArgs(r, i + pack(r, i, first), rest...);
+    }
+};
+
+extern DeferredLog dlog;
+
+// DLOG(STATUS, alt, max) -> dlog.log(LOG_STATUS, alt, max)
+#define DLOG(id, ...) dlog.log(LOG_##id, ##__VA_ARGS__)
+
+#endif // DEFERRED_LOG_H
@@ -0,0 +1,164 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Saturating Q-format fixed-point numbers.
+// Fixed<F> stores value * 2^F in an int32_t. Every operation is integer
+// arithmetic with a defined rounding rule, so the same inputs give the same
+// bits on the ESP32 and on a host, and overflow clamps to the largest
+// representable value instead of wrapping. Convert to float only for
+// display, logging and the web UI.
+template<int FRAC_BITS>
+class Fixed {
+public:
+    static_assert(FRAC_BITS > 0 && FRAC_BITS < 31, "Fixed needs 1..30 fraction bits");
+
+    static const int FRAC = FRAC_BITS;
+    static const int32_t RAW_MAX = INT32_MAX;
+    static const int32_t RAW_MIN = INT32_MIN;
+    static const int32_t RAW_ONE = (int32_t)1 << FRAC_BITS;
+
+    Fixed() : raw(0) {}
+
+    static Fixed fromRaw(int32_t value) {
+        Fixed f;
+        f.raw = value;
+        return f;
+    }
+
+    static Fixed fromInt(int32_t value) {
+        return fromRaw(saturate((int64_t)value << FRAC_BITS));
+    }
+
+    // Rounds to nearest; NaN becomes 0
+    static Fixed fromFloat(float value) {
+        float scaled = value * (float)RAW_ONE;
+        if (!(scaled == scaled)) {
+            return Fixed();
+        }
+        if (scaled >= 2147483647.0f) {
+            return fromRaw(RAW_MAX);
+        }
+        if (scaled <= -2147483648.0f) {
+            return fromRaw(RAW_MIN);
+        }
+        return fromRaw((int32_t)(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f));
+    }
+
+    // Changes the number of fraction bits, rounding to nearest
+    template<int OTHER_BITS>
+    static Fixed convert(Fixed<OTHER_BITS> other) {
+        int64_t v = other.getRaw();
+        if (OTHER_BITS > FRAC_BITS) {
+            const int shift = OTHER_BITS > FRAC_BITS ? OTHER_BITS - FRAC_BITS : 0;
+            v = (v + ((int64_t)1 << (shift - 1))) >> shift;
+        } else {
+            v <<= (FRAC_BITS > OTHER_BITS ? FRAC_BITS - OTHER_BITS : 0);
+        }
+        return fromRaw(saturate(v));
+    }
+
+    int32_t getRaw() const { return raw; }
+    float toFloat() const { return raw * (1.0f / RAW_ONE); }
+    int32_t toInt() const { return raw >> FRAC_BITS; }   // Rounds towards -infinity
+
+    Fixed operator+(Fixed o) const { return fromRaw(saturate((int64_t)raw + o.raw)); }
+    Fixed operator-(Fixed o) const { return fromRaw(saturate((int64_t)raw - o.raw)); }
+    Fixed operator-() const { return fromRaw(saturate(-(int64_t)raw)); }
+
+    // Products round to nearest (ties towards +infinity)
+    Fixed operator*(Fixed o) const {
+        int64_t p = (int64_t)raw * o.raw;
+        return fromRaw(saturate((p + ((int64_t)1 << (FRAC_BITS - 1))) >> FRAC_BITS));
+    }
+
+    // Truncates towards zero; division by zero saturates
+    Fixed operator/(Fixed o) const {
+        if (o.raw == 0) {
+            return fromRaw(raw >= 0 ? RAW_MAX : RAW_MIN);
+        }
+        return fromRaw(saturate(((int64_t)raw << FRAC_BITS) / o.raw));
+    }
+
+    Fixed operator*(int32_t k) const { return fromRaw(saturate((int64_t)raw * k)); }
+    Fixed operator/(int32_t k) const {
+        if (k == 0) {
+            return fromRaw(raw >= 0 ? RAW_MAX : RAW_MIN);
+        }
+        return fromRaw(saturate((int64_t)raw / k));
+    }
+
+    Fixed& operator+=(Fixed o) { return *this = *this + o; }
+    Fixed& operator-=(Fixed o) { return *this = *this - o; }
+
+    bool operator<(Fixed o) const { return raw < o.raw; }
+    bool operator>(Fixed o) const { return raw > o.raw; }
+    bool operator<=(Fixed o) const { return raw <= o.raw; }
+    bool operator>=(Fixed o) const { return raw >= o.raw; }
+    bool operator==(Fixed o) const { return raw == o.raw; }
+    bool operator!=(Fixed o) const { return raw != o.raw; }
+
+    // Without a branch on the sign, which mispredicts on noisy samples
+    // around zero; |RAW_MIN| saturates to RAW_MAX
+    Fixed abs() const {
+        uint32_t mask = (uint32_t)(raw >> 31);
+        uint32_t m = ((uint32_t)raw ^ mask) - mask;
+        return fromRaw((int32_t)(m - (m >> 31)));
+    }
+
+    // sqrt(a^2 + b^2 + c^2) without overflow for any inputs, exact to the
+    // last bit (floor of the true root)
+    static Fixed magnitude(Fixed a, Fixed b, Fixed c) {
+        uint64_t sum = (uint64_t)((int64_t)a.raw * a.raw)
+                     + (uint64_t)((int64_t)b.raw * b.raw)
+                     + (uint64_t)((int64_t)c.raw * c.raw);
+        return fromRaw(saturate((int64_t)isqrt64(sum)));
+    }
+
+    static int32_t saturate(int64_t v) {
+        if (v > RAW_MAX) {
+            return RAW_MAX;
+        }
+        if (v < RAW_MIN) {
+            return RAW_MIN;
+        }
+        return (int32_t)v;
+    }
+
+    // Integer square root (floor). The float estimate is only a starting
+    // point - the integer checks at the end make the result exact, so it
+    // never depends on the FPU. Below 2^24 the estimate is already within
+    // one; above, a Newton step brings it back there.
+    static uint64_t isqrt64(uint64_t v) {
+        if (v < 2) {
+            return v;
+        }
+        uint64_t r = (uint64_t)sqrtf((float)v);
+        if (r >= ((uint64_t)1 << 24)) {
+            r = (r + v / r) >> 1;
+        }
+        if (r > 0xFFFFFFFFull) {
+            r = 0xFFFFFFFFull;
+        }
+        while (r * r > v) {
+            r--;
+        }
+        while ((r + 1) * (r + 1) <= v && r < 0xFFFFFFFFull) {
+            r++;
+        }
+        return r;
+    }
+
+private:
+    int32_t raw;
+};
+
+// Formats used by the sensor pipeline
+typedef Fixed<8> PressureFx;       // Pa, Q23.8: 0.004 Pa steps, up to 8.3 MPa
+typedef Fixed<16> AltitudeFx;      // m, Q15.16: 15 um steps, +-32 km
+typedef Fixed<16> AccelFx;         // g, Q15.16
+typedef Fixed<8> TemperatureFx;    // C, Q23.8
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,26 @@
+#ifndef FLASH_DEVICE_H
+#define FLASH_DEVICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Raw NOR flash access used by the segment store.
+// Erasing sets a whole sector to 0xFF; writing can only clear bits, so a
+// byte is written once between erases. The store only talks to this
+// interface, so the same code runs on a flash partition or against a
+// file-backed emulator with injected power loss on a host.
+class FlashDevice {
+public:
+    virtual ~FlashDevice() {}
+
+    virtual size_t size() const = 0;
+    virtual size_t sectorSize() const = 0;
+
+    virtual bool read(size_t offset, void* out, size_t len) = 0;
+    virtual bool write(size_t offset, const void* data, size_t len) = 0;
+
+    // offset and len are multiples of sectorSize()
+    virtual bool erase(size_t offset, size_t len) = 0;
+};
+
+#endif // FLASH_DEVICE_H
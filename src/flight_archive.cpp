@@ -0,0 +1,242 @@
+#include "flight_archive.h"
+#include <string.h>
+
+static_assert(MappedLog::PAGE_BYTES == CompressedSeries::BLOCK_BYTES && FLIGHT_ARCHIVE_DATA_OFFSET == MappedLog::PAGE_BYTES,
+              "archive blocks must map to whole pages");
+
+static const uint8_t STREAM_RECORD_TYPES[ARCHIVE_STREAM_COUNT] = { RECORD_BARO, RECORD_IMU };
+static const int STREAM_COLUMNS[ARCHIVE_STREAM_COUNT] = { 2, 6 };
+
+bool isValidFlightArchiveHeader(const FlightArchiveHeader& header) {
+    if (header.magic != FLIGHT_ARCHIVE_MAGIC || header.version != FLIGHT_ARCHIVE_VERSION ||
+        header.header_size != sizeof(FlightArchiveHeader) || header.block_bytes != CompressedSeries::BLOCK_BYTES) {
+        return false;
+    }
+    for (int s = 0; s < ARCHIVE_STREAM_COUNT; s++) {
+        if (header.streams[s].record_type != STREAM_RECORD_TYPES[s] ||
+            header.streams[s].column_count != STREAM_COLUMNS[s]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t getFlightArchiveSize(const FlightArchiveHeader& header) {
+    size_t size = FLIGHT_ARCHIVE_DATA_OFFSET;
+    for (int s = 0; s < ARCHIVE_STREAM_COUNT; s++) {
+        size += (size_t)header.streams[s].block_count * CompressedSeries::BLOCK_BYTES;
+    }
+    return size;
+}
+
+FlightArchiveWriter::FlightArchiveWriter() {
+    store = nullptr;
+    memset(&header, 0, sizeof(header));
+    for (int s = 0; s < ARCHIVE_STREAM_COUNT; s++) {
+        series[s] = nullptr;
+    }
+    stream = 0;
+    block = 0;
+    header_written = false;
+    done = false;
+    failed = false;
+}
+
+bool FlightArchiveWriter::begin(SegmentStore* output, const CompressedSeries& baro, const CompressedSeries& imu,
+                                uint32_t flight_number) {
+    store = output;
+    series[ARCHIVE_STREAM_BARO] = &baro;
+    series[ARCHIVE_STREAM_IMU] = &imu;
+    stream = 0;
+    block = 0;
+    header_written = false;
+    done = false;
+    failed = false;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = FLIGHT_ARCHIVE_MAGIC;
+    header.version = FLIGHT_ARCHIVE_VERSION;
+    header.header_size = sizeof(FlightArchiveHeader);
+    header.block_bytes = CompressedSeries::BLOCK_BYTES;
+    header.flight_number = flight_number;
+    for (int s = 0; s < ARCHIVE_STREAM_COUNT; s++) {
+        const CompressedSeries& source = *series[s];
+        FlightArchiveStream& info = header.streams[s];
+        if (source.getColumnCount() != STREAM_COLUMNS[s]) {
+            failed = true;
+            return false;
+        }
+        info.record_type = STREAM_RECORD_TYPES[s];
+        info.column_count = (uint8_t)source.getColumnCount();
+        info.block_count = source.getBlockCount();
+        info.sample_count = source.getSampleCount();
+        info.first_time_us = source.getFirstTimeUs();
+        info.last_time_us = source.getLastTimeUs();
+        for (int c = 0; c < source.getColumnCount(); c++) {
+            info.encodings[c] = (uint8_t)source.getColumn(c).encoding;
+            info.resolutions[c] = source.getColumn(c).resolution;
+        }
+    }
+    failed = store == nullptr || !store->create(flight_number);
+    return !failed;
+}
+
+bool FlightArchiveWriter::step() {
+    if (!isActive()) {
+        return false;
+    }
+
+    if (!header_written) {
+        // Header, then zeros up to the first block
+        static const uint8_t zeros[128] = { 0 };
+        header_written = true;
+        bool ok = store->append(&header, sizeof(header));
+        for (size_t n = sizeof(header); ok && n < FLIGHT_ARCHIVE_DATA_OFFSET; n += sizeof(zeros)) {
+            ok = store->append(zeros, sizeof(zeros));
+        }
+        if (!ok) {
+            fail();
+        }
+        return ok;
+    }
+
+    while (stream < ARCHIVE_STREAM_COUNT && block >= header.streams[stream].block_count) {
+        stream++;
+        block = 0;
+    }
+    if (stream >= ARCHIVE_STREAM_COUNT) {
+        done = store->close();
+        failed = !done;
+        return false;
+    }
+
+    const uint8_t* data = series[stream]->getBlock(block);
+    if (data == nullptr || !store->append(data, CompressedSeries::BLOCK_BYTES)) {
+        fail();
+        return false;
+    }
+    block++;
+    return true;
+}
+
+// Leaves the blocks already committed, as a power loss would
+void FlightArchiveWriter::fail() {
+    failed = true;
+    store->abort();
+}
+
+FlightArchiveReader::FlightArchiveReader() {
+    memset(&header, 0, sizeof(header));
+    for (int s = 0; s < ARCHIVE_STREAM_COUNT; s++) {
+        has_pending[s] = false;
+    }
+    open = false;
+    truncated = false;
+}
+
+bool FlightArchiveReader::openMemory(const uint8_t* data, size_t size) {
+    return openBlocks(data, nullptr, size);
+}
+
+bool FlightArchiveReader::openMapped(const MappedLog& log) {
+    if (log.getPageCount() == 0) {
+        return false;
+    }
+    return openBlocks(log.getPage(0), log.getPages(), log.getSize());
+}
+
+// The header is at data; the blocks follow it in place, or one per page
+// from pages[1] if the archive is scattered
+bool FlightArchiveReader::openBlocks(const uint8_t* data, const uint8_t* const* pages, size_t size) {
+    open = false;
+    if (data == nullptr || size < sizeof(FlightArchiveHeader)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (!isValidFlightArchiveHeader(header) || size < FLIGHT_ARCHIVE_DATA_OFFSET) {
+        return false;
+    }
+
+    // A log cut short by a power loss keeps the blocks that made it
+    uint32_t available = (size - FLIGHT_ARCHIVE_DATA_OFFSET) / CompressedSeries::BLOCK_BYTES;
+    truncated = getFlightArchiveSize(header) > size;
+    uint32_t first_block = 0;
+    for (int s = 0; s < ARCHIVE_STREAM_COUNT; s++) {
+        FlightArchiveStream& info = header.streams[s];
+        if (info.block_count > available) {
+            info.block_count = available;
+        }
+        available -= info.block_count;
+        CompressedSeries::Column columns[CompressedSeries::MAX_COLUMNS];
+        for (int c = 0; c < info.column_count; c++) {
+            columns[c].encoding = (CompressedSeries::Encoding)info.encodings[c];
+            columns[c].resolution = info.resolutions[c];
+        }
+        series[s] = CompressedSeries();
+        series[s].configure(columns, info.column_count);
+        if (info.block_count > 0 && pages != nullptr) {
+            series[s].attach(pages + 1 + first_block, info.block_count);
+        } else if (info.block_count > 0) {
+            series[s].attach(data + FLIGHT_ARCHIVE_DATA_OFFSET + (size_t)first_block * CompressedSeries::BLOCK_BYTES,
+                             info.block_count);
+        }
+        first_block += info.block_count;
+    }
+    open = true;
+    rewind();
+    return true;
+}
+
+void FlightArchiveReader::rewind() {
+    for (int s = 0; s < ARCHIVE_STREAM_COUNT; s++) {
+        iterators[s] = series[s].iterate();
+        has_pending[s] = false;
+        if (open) {
+            fetch(s);
+        }
+    }
+}
+
+void FlightArchiveReader::fetch(int stream) {
+    float values[CompressedSeries::MAX_COLUMNS];
+    uint32_t time_us;
+    has_pending[stream] = iterators[stream].next(time_us, values);
+    if (!has_pending[stream]) {
+        return;
+    }
+    FlightRecord& record = pending[stream];
+    memset(&record, 0, sizeof(record));
+    record.type = header.streams[stream].record_type;
+    record.time_us = time_us;
+    for (int c = 0; c < header.streams[stream].column_count; c++) {
+        record.values[c] = values[c];
+    }
+}
+
+bool FlightArchiveReader::next(FlightRecord& out) {
+    if (!open) {
+        return false;
+    }
+    bool baro = has_pending[ARCHIVE_STREAM_BARO];
+    bool imu = has_pending[ARCHIVE_STREAM_IMU];
+    if (!baro && !imu) {
+        return false;
+    }
+    int stream;
+    if (!imu) {
+        stream = ARCHIVE_STREAM_BARO;
+    } else if (!baro) {
+        stream = ARCHIVE_STREAM_IMU;
+    } else {
+        // Wrap-safe comparison; ties go to the barometer
+        int32_t order = (int32_t)(pending[ARCHIVE_STREAM_BARO].time_us - pending[ARCHIVE_STREAM_IMU].time_us);
+        stream = order <= 0 ? ARCHIVE_STREAM_BARO : ARCHIVE_STREAM_IMU;
+    }
+    out = pending[stream];
+    fetch(stream);
+    return true;
+}
+
+bool readFlightArchiveHeader(SegmentStore& store, const SegmentStore::Log& log, FlightArchiveHeader& out) {
+    return store.read(log, 0, &out, sizeof(out)) == sizeof(out) && isValidFlightArchiveHeader(out);
+}
@@ -0,0 +1,125 @@
+#ifndef FLIGHT_ARCHIVE_H
+#define FLIGHT_ARCHIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "compressed_series.h"
+#include "flight_record.h"
+#include "mapped_log.h"
+#include "segment_store.h"
+
+// Stored flight archive: the compressed in-RAM recording written out as it
+// is. A 128-byte little-endian header describing the barometer and IMU
+// series, padded to FLIGHT_ARCHIVE_DATA_OFFSET, then each series'
+// CompressedSeries blocks (BLOCK_BYTES each, oldest first). Blocks stay
+// 4 KB aligned, so none straddles a SegmentStore segment. Every block
+// decodes on its own, so an archive can be downloaded, mapped and iterated
+// in place without conversion. A full-rate flight is ~5x smaller than the
+// same FlightRecord log.
+static const uint32_t FLIGHT_ARCHIVE_MAGIC = 0x41465454;  // "TTFA"
+static const uint16_t FLIGHT_ARCHIVE_VERSION = 2;
+static const size_t FLIGHT_ARCHIVE_DATA_OFFSET = CompressedSeries::BLOCK_BYTES;
+
+enum FlightArchiveStreamIndex {
+    ARCHIVE_STREAM_BARO,    // pressure (Pa), temperature (C)
+    ARCHIVE_STREAM_IMU,     // accel x/y/z (g), gyro x/y/z (deg/s)
+    ARCHIVE_STREAM_COUNT
+};
+
+struct FlightArchiveStream {
+    uint8_t record_type;        // FlightRecordType of the decoded samples
+    uint8_t column_count;
+    uint16_t reserved;
+    uint32_t block_count;
+    uint32_t sample_count;
+    uint32_t first_time_us;
+    uint32_t last_time_us;
+    uint8_t encodings[CompressedSeries::MAX_COLUMNS];
+    uint16_t reserved2;
+    float resolutions[CompressedSeries::MAX_COLUMNS];
+};
+
+struct FlightArchiveHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t block_bytes;
+    uint32_t flight_number;
+    FlightArchiveStream streams[ARCHIVE_STREAM_COUNT];
+    uint32_t reserved[2];
+};
+
+static_assert(sizeof(FlightArchiveStream) == 52, "FlightArchiveStream layout changed");
+static_assert(sizeof(FlightArchiveHeader) == 128, "FlightArchiveHeader layout changed");
+
+bool isValidFlightArchiveHeader(const FlightArchiveHeader& header);
+
+// Total bytes of the archive for a header
+size_t getFlightArchiveSize(const FlightArchiveHeader& header);
+
+// Writes an archive as a SegmentStore log with the flight number as its
+// id, a block at a time, so saving a flight never holds up the caller for
+// more than one BLOCK_BYTES write and one sector erase. The series must
+// not be appended to until it is done.
+class FlightArchiveWriter {
+public:
+    FlightArchiveWriter();
+
+    bool begin(SegmentStore* store, const CompressedSeries& baro, const CompressedSeries& imu, uint32_t flight_number);
+    bool step();                 // Writes the next piece; false once finished or failed
+    bool isActive() const { return store != nullptr && !done && !failed; }
+    bool isDone() const { return done; }
+    bool hasFailed() const { return failed; }
+    uint32_t getFlightNumber() const { return header.flight_number; }
+    size_t getSize() const { return getFlightArchiveSize(header); }
+
+private:
+    SegmentStore* store;
+    const CompressedSeries* series[ARCHIVE_STREAM_COUNT];
+    FlightArchiveHeader header;
+    int stream;
+    uint32_t block;
+    bool header_written;
+    bool done;
+    bool failed;
+
+    void fail();
+};
+
+// Reads an archive in place - from one buffer (a file) or from the pages of
+// a MappedLog straight out of flash - and merges the two series back into
+// FlightRecords in timestamp order, the barometer first on ties as in
+// SensorPipeline::processBatch(). An archive cut short by a power loss is
+// read as far as its whole blocks go; the header's block counts are
+// trimmed to match. The memory must stay mapped while the reader is used.
+class FlightArchiveReader {
+public:
+    FlightArchiveReader();
+
+    bool openMemory(const uint8_t* data, size_t size);
+    bool openMapped(const MappedLog& log);
+    bool isOpen() const { return open; }
+    bool isTruncated() const { return truncated; }
+    const FlightArchiveHeader& getHeader() const { return header; }
+    const CompressedSeries& getSeries(FlightArchiveStreamIndex stream) const { return series[stream]; }
+
+    bool next(FlightRecord& out);
+    void rewind();
+
+private:
+    FlightArchiveHeader header;
+    CompressedSeries series[ARCHIVE_STREAM_COUNT];
+    CompressedSeries::Iterator iterators[ARCHIVE_STREAM_COUNT];
+    FlightRecord pending[ARCHIVE_STREAM_COUNT];
+    bool has_pending[ARCHIVE_STREAM_COUNT];
+    bool open;
+    bool truncated;
+
+    bool openBlocks(const uint8_t* data, const uint8_t* const* pages, size_t size);
+    void fetch(int stream);
+};
+
+// Header of a stored log, e.g. for a directory listing
+bool readFlightArchiveHeader(SegmentStore& store, const SegmentStore::Log& log, FlightArchiveHeader& out);
+
+#endif // FLIGHT_ARCHIVE_H
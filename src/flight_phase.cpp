@@ -0,0 +1,95 @@
+#include "flight_phase.h"
+#include <math.h>
+
+FlightPhaseDetector::FlightPhaseDetector() {
+    reset();
+}
+
+void FlightPhaseDetector::reset() {
+    phase = PHASE_PRELAUNCH;
+    changed = false;
+    max_altitude_agl = 0.0;
+    high_accel_since = 0;
+    high_accel_active = false;
+    landed_reference = 0.0;
+    landed_since = 0;
+    phase_start_ms = 0;
+}
+
+void FlightPhaseDetector::enter(FlightPhase next, uint32_t now_ms) {
+    phase = next;
+    phase_start_ms = now_ms;
+    changed = true;
+}
+
+FlightPhase FlightPhaseDetector::update(uint32_t now_ms, float altitude_agl, float accel_g) {
+    changed = false;
+
+    if (isInFlight() && altitude_agl > max_altitude_agl) {
+        max_altitude_agl = altitude_agl;
+    }
+
+    switch (phase) {
+        case PHASE_PRELAUNCH: {
+            if (accel_g >= LAUNCH_ACCEL_G) {
+                if (!high_accel_active) {
+                    high_accel_active = true;
+                    high_accel_since = now_ms;
+                }
+            } else {
+                high_accel_active = false;
+            }
+
+            bool accel_launch = high_accel_active && (now_ms - high_accel_since >= LAUNCH_ACCEL_MS);
+            if (accel_launch || altitude_agl >= LAUNCH_ALTITUDE_M) {
+                max_altitude_agl = altitude_agl;
+                enter(PHASE_BOOST, now_ms);
+            }
+            break;
+        }
+
+        case PHASE_BOOST:
+            if (altitude_agl < max_altitude_agl - APOGEE_DROP_M) {
+                enter(PHASE_DESCENT, now_ms);  // Burnout was missed entirely
+                landed_reference = altitude_agl;
+                landed_since = now_ms;
+            } else if (accel_g < BURNOUT_ACCEL_G) {
+                enter(PHASE_COAST, now_ms);
+            }
+            break;
+
+        case PHASE_COAST:
+            if (altitude_agl < max_altitude_agl - APOGEE_DROP_M) {
+                enter(PHASE_DESCENT, now_ms);
+                landed_reference = altitude_agl;
+                landed_since = now_ms;
+            }
+            break;
+
+        case PHASE_DESCENT:
+            if (fabsf(altitude_agl - landed_reference) > LANDED_WINDOW_M) {
+                landed_reference = altitude_agl;
+                landed_since = now_ms;
+            } else if (now_ms - landed_since >= LANDED_TIME_MS) {
+                enter(PHASE_LANDED, now_ms);
+            }
+            break;
+
+        case PHASE_LANDED:
+        default:
+            break;
+    }
+
+    return phase;
+}
+
+const char* FlightPhaseDetector::getPhaseName(FlightPhase phase) {
+    switch (phase) {
+        case PHASE_PRELAUNCH: return "PRELAUNCH";
+        case PHASE_BOOST:     return "BOOST";
+        case PHASE_COAST:     return "COAST";
+        case PHASE_DESCENT:   return "DESCENT";
+        case PHASE_LANDED:    return "LANDED";
+        default:              return "UNKNOWN";
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef FLIGHT_PHASE_H
+#define FLIGHT_PHASE_H
+
+#include <stdint.h>
+
+enum FlightPhase {
+    PHASE_PRELAUNCH = 0,   // On the pad / ground idle after boot
+    PHASE_BOOST = 1,       // Motor burning
+    PHASE_COAST = 2,       // Burnout to apogee
+    PHASE_DESCENT = 3,     // Apogee to touchdown
+    PHASE_LANDED = 4,      // Stationary after descent
+    PHASE_COUNT = 5
+};
+
+// Flight phase state machine driven by altitude above ground and total
+// acceleration. Thresholds are time-based rather than sample-count based so
+// detection behaves the same at 5 Hz and at high sample rates.
+class FlightPhaseDetector {
+private:
+    static constexpr float LAUNCH_ACCEL_G = 2.5;       // Sustained acceleration that means launch
+    static const uint32_t LAUNCH_ACCEL_MS = 100;
+    static constexpr float LAUNCH_ALTITUDE_M = 15.0;   // Backup launch trigger if acceleration was missed
+    static constexpr float BURNOUT_ACCEL_G = 1.2;      // Below this the motor is done
+    static constexpr float APOGEE_DROP_M = 5.0;        // Drop below max that confirms apogee
+    static constexpr float LANDED_WINDOW_M = 2.0;      // Altitude band that counts as stationary
+
+    FlightPhase phase;
+    bool changed;
+    float max_altitude_agl;
+    uint32_t high_accel_since;
+    bool high_accel_active;
+    float landed_reference;
+    uint32_t landed_since;
+    uint32_t phase_start_ms;
+
+    void enter(FlightPhase next, uint32_t now_ms);
+
+public:
+    static const uint32_t LANDED_TIME_MS = 5000;       // Still this long after descent means landed
+
+    FlightPhaseDetector();
+
+    void reset();
+
+    // Feed one sample; returns the (possibly new) phase
+    FlightPhase update(uint32_t now_ms, float altitude_agl, float accel_g);
+
+    FlightPhase getPhase() const { return phase; }
+    bool phaseChanged() const { return changed; }   // True if the last update() changed phase
+    bool isInFlight() const { return phase == PHASE_BOOST || phase == PHASE_COAST || phase == PHASE_DESCENT; }
+    float getMaxAltitudeAgl() const { return max_altitude_agl; }
+    uint32_t getPhaseStartMs() const { return phase_start_ms; }
+    uint32_t getTouchdownMs() const { return landed_since; }   // Start of the still period, once LANDED
+
+    static const char* getPhaseName(FlightPhase phase);
+};
+
+#endif // FLIGHT_PHASE_H
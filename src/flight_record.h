@@ -0,0 +1,109 @@
+#ifndef FLIGHT_RECORD_H
+#define FLIGHT_RECORD_H
+
+#include <stdint.h>
+#include <string.h>
+#include "sensor_types.h"
+
+// On-disk flight log format.
+// A 16-byte header followed by fixed-size 32-byte little-endian records in
+// time order. Fixed-size records can be iterated in place from a mapped
+// buffer and resynchronised by offset alone.
+static const uint32_t FLIGHT_LOG_MAGIC = 0x4C465454;  // "TTFL"
+static const uint16_t FLIGHT_LOG_VERSION = 1;
+
+struct FlightLogHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t start_time_us;     // Sample clock at the first record
+    uint32_t reserved;
+};
+
+enum FlightRecordType : uint8_t {
+    RECORD_BARO = 1,    // values: pressure (Pa), temperature (C)
+    RECORD_IMU = 2,     // values: accel x/y/z (g), gyro x/y/z (deg/s)
+    RECORD_EVENT = 3    // flags: event type, values: phase, altitude AGL
+};
+
+struct FlightRecord {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t time_us;
+    float values[6];
+};
+
+static_assert(sizeof(FlightLogHeader) == 16, "FlightLogHeader layout changed");
+static_assert(sizeof(FlightRecord) == 32, "FlightRecord layout changed");
+
+inline void initFlightLogHeader(FlightLogHeader& header, uint32_t start_time_us) {
+    header.magic = FLIGHT_LOG_MAGIC;
+    header.version = FLIGHT_LOG_VERSION;
+    header.record_size = sizeof(FlightRecord);
+    header.start_time_us = start_time_us;
+    header.reserved = 0;
+}
+
+inline bool isValidFlightLogHeader(const FlightLogHeader& header) {
+    return header.magic == FLIGHT_LOG_MAGIC && header.version == FLIGHT_LOG_VERSION &&
+           header.record_size == sizeof(FlightRecord);
+}
+
+inline FlightRecord makeBaroRecord(const BaroSample& sample) {
+    FlightRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = RECORD_BARO;
+    record.time_us = sample.time_us;
+    record.values[0] = sample.pressure_pa;
+    record.values[1] = sample.temperature_c;
+    return record;
+}
+
+inline FlightRecord makeImuRecord(const ImuSample& sample) {
+    FlightRecord record;
+    record.type = RECORD_IMU;
+    record.flags = 0;
+    record.reserved = 0;
+    record.time_us = sample.time_us;
+    record.values[0] = sample.accel_x;
+    record.values[1] = sample.accel_y;
+    record.values[2] = sample.accel_z;
+    record.values[3] = sample.gyro_x;
+    record.values[4] = sample.gyro_y;
+    record.values[5] = sample.gyro_z;
+    return record;
+}
+
+inline FlightRecord makeEventRecord(uint32_t time_us, uint8_t event, float phase, float altitude_agl) {
+    FlightRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = RECORD_EVENT;
+    record.flags = event;
+    record.time_us = time_us;
+    record.values[0] = phase;
+    record.values[1] = altitude_agl;
+    return record;
+}
+
+inline BaroSample toBaroSample(const FlightRecord& record) {
+    BaroSample sample;
+    sample.time_us = record.time_us;
+    sample.pressure_pa = record.values[0];
+    sample.temperature_c = record.values[1];
+    return sample;
+}
+
+inline ImuSample toImuSample(const FlightRecord& record) {
+    ImuSample sample;
+    sample.time_us = record.time_us;
+    sample.accel_x = record.values[0];
+    sample.accel_y = record.values[1];
+    sample.accel_z = record.values[2];
+    sample.gyro_x = record.values[3];
+    sample.gyro_y = record.values[4];
+    sample.gyro_z = record.values[5];
+    return sample;
+}
+
+#endif // FLIGHT_RECORD_H
@@ -0,0 +1,235 @@
+#include "flight_recorder.h"
+#include "deferred_log.h"
+
+FlightRecorder::FlightRecorder() {
+    recording = false;
+    phase = PHASE_PRELAUNCH;
+    logs_lock = nullptr;
+    logs_mapped = nullptr;
+    next_flight = 1;
+    newest_flight = 0;
+    newest_us = 0;
+    summarising = false;
+    has_summary = false;
+}
+
+bool FlightRecorder::begin() {
+    // Quantised to the sensors' resolution: QMI8658 LSBs at +-16 g and
+    // +-2048 dps, 0.01 Pa and 0.01 C for the barometer
+    static const CompressedSeries::Column baro_columns[2] = {
+        { CompressedSeries::ENCODING_DELTA, 0.01f },
+        { CompressedSeries::ENCODING_DELTA, 0.01f }
+    };
+    static const CompressedSeries::Column imu_columns[6] = {
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 2048 },
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 2048 },
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 2048 },
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 16 },
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 16 },
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 16 }
+    };
+    if (logs_lock == nullptr) {
+        logs_lock = xSemaphoreCreateMutex();
+    }
+    baro.configure(baro_columns, 2);
+    imu.configure(imu_columns, 6);
+
+    recording = baro.begin(ps_malloc(BARO_BYTES), BARO_BYTES) && imu.begin(ps_malloc(IMU_BYTES), IMU_BYTES);
+    if (recording) {
+        DLOG(RECORDING_READY, (unsigned)((BARO_BYTES + IMU_BYTES) / 1024));
+    } else {
+        DLOG(RECORDING_FAILED, (unsigned)((BARO_BYTES + IMU_BYTES) / 1024));
+    }
+    return recording;
+}
+
+bool FlightRecorder::beginLogs(FlashDevice* flash, const uint8_t* mapped) {
+    if (flash == nullptr || !logs.begin(flash)) {
+        DLOG(LOGS_NO_PARTITION);
+        return false;
+    }
+    logs_mapped = mapped;
+
+    unsigned incomplete = 0;
+    for (int i = 0; i < logs.getLogCount(); i++) {
+        const SegmentStore::Log& log = logs.getLog(i);
+        if (log.id >= next_flight) {
+            next_flight = log.id + 1;
+        }
+        if (!log.complete) {
+            incomplete++;
+        }
+    }
+    DLOG(LOGS_STORED, logs.getLogCount(), incomplete, (unsigned)(logs.getCapacityBytes() / 1024));
+    if (next_flight > 1) {
+        startSummary(next_flight - 1);
+    }
+    return true;
+}
+
+void FlightRecorder::record(const BaroSample* baro_samples, size_t baro_count, const ImuSample* imu_samples,
+                            size_t imu_count) {
+    if (!recording) {
+        return;
+    }
+    for (size_t i = 0; i < baro_count; i++) {
+        float values[2] = { baro_samples[i].pressure_pa, baro_samples[i].temperature_c };
+        baro.append(baro_samples[i].time_us, values);
+    }
+    for (size_t i = 0; i < imu_count; i++) {
+        const ImuSample& s = imu_samples[i];
+        float values[6] = { s.accel_x, s.accel_y, s.accel_z, s.gyro_x, s.gyro_y, s.gyro_z };
+        imu.append(s.time_us, values);
+    }
+}
+
+void FlightRecorder::onPhaseChange(FlightPhase next, bool save) {
+    phase = next;
+    if (phase == PHASE_LANDED && recording) {
+        recording = false;
+        DLOG(RECORDING_STOPPED, imu.getSampleCount(), baro.getSampleCount(),
+             (unsigned)((imu.getBytesUsed() + baro.getBytesUsed()) / 1024));
+        if (save) {
+            startSave();
+        }
+    } else if (phase == PHASE_PRELAUNCH && !writer.isActive()) {
+        rearm();
+    }
+}
+
+bool FlightRecorder::update() {
+    if (summarising) {
+        return stepSummary();
+    }
+    if (!writer.isActive()) {
+        return false;
+    }
+    lock();
+    writer.step();
+    unlock();
+    if (writer.isActive()) {
+        return false;
+    }
+
+    if (writer.isDone()) {
+        DLOG(ARCHIVE_SAVED, writer.getFlightNumber(), (unsigned)(writer.getSize() / 1024));
+        startSummary(writer.getFlightNumber());
+    } else {
+        DLOG(ARCHIVE_FAILED, writer.getFlightNumber());
+    }
+
+    // Re-armed while saving: start the next recording now
+    if (phase == PHASE_PRELAUNCH) {
+        rearm();
+    }
+    return false;
+}
+
+bool FlightRecorder::summarise(uint32_t flight, FlightSummary& out) {
+    if (!logs.isReady() || logs_mapped == nullptr) {
+        return false;
+    }
+    lock();
+    bool cached = has_summary && last_summary.flight_number == flight;
+    if (cached) {
+        out = last_summary;
+    }
+    const SegmentStore::Log* log = cached ? nullptr : logs.findLog(flight);
+    bool mapped = log != nullptr && summary_log.mapStore(logs, *log, logs_mapped);
+    unlock();
+    if (cached) {
+        return true;
+    }
+
+    bool ok = mapped && summary_reader.openMapped(summary_log) && summariseFlightArchive(summary_reader, out);
+    // A save that recycled the log's first segment meanwhile has dropped it
+    // from the store, and the pages just read may be from the new log
+    lock();
+    ok = ok && logs.findLog(flight) != nullptr;
+    unlock();
+    return ok;
+}
+
+void FlightRecorder::lock() {
+    xSemaphoreTake(logs_lock, portMAX_DELAY);
+}
+
+void FlightRecorder::unlock() {
+    xSemaphoreGive(logs_lock);
+}
+
+void FlightRecorder::rearm() {
+    if (recording || !imu.isReady() || !baro.isReady()) {
+        return;
+    }
+    imu.clear();
+    baro.clear();
+    recording = true;
+}
+
+// Starts writing the stopped recording as the next flight log
+void FlightRecorder::startSave() {
+    if (!logs.isReady() || writer.isActive() || imu.getSampleCount() == 0) {
+        return;
+    }
+    uint32_t flight = next_flight++;
+    lock();
+    bool started = writer.begin(&logs, baro, imu, flight);
+    unlock();
+    if (!started) {
+        DLOG(ARCHIVE_FAILED, flight);
+    }
+}
+
+// Maps the newest flight for the display's LAST screen; update() reads it
+void FlightRecorder::startSummary(uint32_t flight) {
+    bool mapped = false;
+    if (logs_mapped != nullptr) {
+        lock();
+        const SegmentStore::Log* log = logs.findLog(flight);
+        mapped = log != nullptr && newest_log.mapStore(logs, *log, logs_mapped);
+        unlock();
+    }
+    if (!mapped || !newest_reader.openMapped(newest_log)) {
+        DLOG(SUMMARY_FAILED, flight);
+        return;
+    }
+    newest_reader.rewind();
+    newest_summariser.reset();
+    newest_flight = flight;
+    newest_us = 0;
+    summarising = true;
+}
+
+// Summarises the next records of the newest flight without the lock, as
+// summarise() does. True once it has ended; the time spent is logged.
+bool FlightRecorder::stepSummary() {
+    uint32_t start = micros();
+    FlightRecord record;
+    bool more = true;
+    for (uint32_t i = 0; i < SUMMARY_RECORDS_PER_UPDATE && more; i++) {
+        more = newest_reader.next(record);
+        if (more) {
+            newest_summariser.add(record);
+        }
+    }
+    newest_us += micros() - start;
+    if (more) {
+        return false;
+    }
+    summarising = false;
+
+    FlightSummary summary;
+    bool ok = finishFlightArchiveSummary(newest_reader, newest_summariser, summary);
+    lock();
+    ok = ok && logs.findLog(newest_flight) != nullptr;
+    last_summary = summary;
+    has_summary = ok;
+    unlock();
+    if (ok) {
+        DLOG(SUMMARY_READY, newest_flight, summary.apogee_m, summary.max_acceleration_g, (unsigned)(newest_us / 1000));
+    } else {
+        DLOG(SUMMARY_FAILED, newest_flight);
+    }
+    return true;
+}
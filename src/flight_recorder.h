@@ -0,0 +1,101 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <Arduino.h>
+#include "compressed_series.h"
+#include "flash_device.h"
+#include "flight_archive.h"
+#include "flight_phase.h"
+#include "flight_summary.h"
+#include "mapped_log.h"
+#include "segment_store.h"
+#include "sensor_types.h"
+
+// Flight recording and flight logs, shared by the firmware (main.cpp) and
+// the native build (main_native.cpp).
+//
+// Every barometer and IMU sample is kept compressed in PSRAM (~6 bytes per
+// IMU sample, ~5 minutes at 448 Hz), so a whole flight stays in memory
+// without touching flash. While waiting on the pad the oldest blocks are
+// recycled; recording stops at landing so the flight is kept. It is then
+// written as a flight archive to the segment store, one 4 KB block per
+// update() so sampling never waits on flash. Segments are used round
+// robin, so new flights overwrite the oldest, and a power loss while
+// saving keeps everything already committed. Re-arming on the pad starts a
+// new recording once the flight is saved. Saved flights are summarised in
+// place from the mapped store, the newest a few blocks per update() like
+// the save. Other tasks (the web server) use the store only between lock()
+// and unlock().
+class FlightRecorder {
+public:
+    static const size_t BARO_BYTES = 128 * 1024;
+    static const size_t IMU_BYTES = 896 * 1024;
+    static const uint32_t SUMMARY_RECORDS_PER_UPDATE = 2048;   // About three blocks of IMU samples
+
+    FlightRecorder();
+
+    // Recording buffers in PSRAM; without them nothing is recorded
+    bool begin();
+
+    // Flight logs on `flash` (null if there is none), readable in place at
+    // `mapped`. Numbering continues after the newest stored flight, which
+    // update() then summarises for getLastSummary().
+    bool beginLogs(FlashDevice* flash, const uint8_t* mapped);
+
+    void record(const BaroSample* baro, size_t baro_count, const ImuSample* imu, size_t imu_count);
+
+    // Call on every phase change. LANDED stops the recording and, if save
+    // is set, starts saving it as the next flight; PRELAUNCH re-arms once
+    // nothing is being saved.
+    void onPhaseChange(FlightPhase phase, bool save);
+
+    // Writes the next block of a save in progress, or summarises the next
+    // SUMMARY_RECORDS_PER_UPDATE records of the newest flight once it is
+    // saved. True once, when that summary has ended; getLastSummary() then
+    // describes the new flight.
+    bool update();
+
+    // Summarises a stored flight in one pass, decoding it in place, or
+    // copies getLastSummary() if that is the flight. The lock is held only
+    // while the log is looked up and mapped, so a save is not held up.
+    bool summarise(uint32_t flight, FlightSummary& out);
+
+    void lock();
+    void unlock();
+
+    bool isRecording() const { return recording; }
+    bool isSaving() const { return writer.isActive(); }
+    bool isSummarising() const { return summarising; }
+    const CompressedSeries& getBaroRecording() const { return baro; }
+    const CompressedSeries& getImuRecording() const { return imu; }
+    SegmentStore& getLogs() { return logs; }   // Between lock() and unlock()
+    const FlightSummary* getLastSummary() const { return has_summary ? &last_summary : nullptr; }
+
+private:
+    CompressedSeries baro;
+    CompressedSeries imu;
+    bool recording;
+    FlightPhase phase;
+    SemaphoreHandle_t logs_lock;
+    SegmentStore logs;
+    const uint8_t* logs_mapped;
+    FlightArchiveWriter writer;
+    uint32_t next_flight;
+    MappedLog summary_log;              // For summarise()
+    FlightArchiveReader summary_reader;
+    MappedLog newest_log;               // For the summary update() runs
+    FlightArchiveReader newest_reader;
+    FlightSummariser newest_summariser;
+    uint32_t newest_flight;
+    uint32_t newest_us;                 // Spent in update() so far
+    bool summarising;
+    FlightSummary last_summary;
+    bool has_summary;
+
+    void rearm();
+    void startSave();
+    void startSummary(uint32_t flight);
+    bool stepSummary();
+};
+
+#endif // FLIGHT_RECORDER_H
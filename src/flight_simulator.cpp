@@ -0,0 +1,213 @@
+#include "flight_simulator.h"
+#include <math.h>
+
+static const float GRAVITY = 9.80665f;
+
+FlightProfile FlightProfile::modelRocket() {
+    FlightProfile p;
+    p.pad_time_s = 10.0f;
+    p.thrust_n = 30.0f;
+    p.burn_time_s = 1.6f;
+    p.dry_mass_kg = 0.50f;
+    p.propellant_mass_kg = 0.06f;
+    p.drag_area_m2 = 0.00115f;       // Cd 0.5, 54 mm airframe
+    p.drogue_rate_ms = 15.0f;
+    p.main_rate_ms = 5.0f;
+    p.main_deploy_agl_m = 100.0f;
+    p.spin_rate_dps = 90.0f;
+    p.ground_altitude_m = 350.0f;
+    p.ground_temperature_c = 22.0f;
+    p.pressure_noise_pa = 3.0f;      // BMP180 ultra high resolution
+    p.temperature_noise_c = 0.05f;
+    p.accel_noise_g = 0.005f;
+    p.gyro_noise_dps = 0.1f;
+    p.boost_vibration_g = 0.3f;
+    return p;
+}
+
+FlightProfile FlightProfile::groundIdle() {
+    FlightProfile p = modelRocket();
+    p.pad_time_s = 1.0e9f;
+    return p;
+}
+
+FlightSimulator::FlightSimulator() {
+    clock = nullptr;
+    begin(FlightProfile::groundIdle(), 1);
+}
+
+void FlightSimulator::begin(const FlightProfile& flight_profile, uint64_t random_seed) {
+    profile = flight_profile;
+    seed = random_seed;
+    reset();
+}
+
+void FlightSimulator::reset() {
+    rng.seedWith(seed);
+    time_us = 0;
+    altitude_agl = 0.0f;
+    velocity = 0.0f;
+    acceleration = 0.0f;
+    roll_rate = 0.0f;
+    max_altitude_agl = 0.0f;
+    phase = SIM_GROUND_IDLE;
+    update(0);
+}
+
+float FlightSimulator::airDensity(float altitude_asl) const {
+    // ISA troposphere
+    return 1.225f * powf(1.0f - 2.25577e-5f * altitude_asl, 4.25588f);
+}
+
+void FlightSimulator::step() {
+    const float dt = STEP_US * 1.0e-6f;
+    time_us += STEP_US;
+    float t = time_us * 1.0e-6f;
+
+    float rho = airDensity(profile.ground_altitude_m + altitude_agl);
+    float mass = profile.dry_mass_kg;
+    float thrust = 0.0f;
+    float drag_area = profile.drag_area_m2;
+
+    switch (phase) {
+        case SIM_GROUND_IDLE:
+            if (t >= profile.pad_time_s) {
+                phase = SIM_BOOST;
+            }
+            break;
+
+        case SIM_BOOST: {
+            float burned = (t - profile.pad_time_s) / profile.burn_time_s;
+            if (burned >= 1.0f) {
+                phase = SIM_COAST;
+            } else {
+                thrust = profile.thrust_n;
+                mass += profile.propellant_mass_kg * (1.0f - burned);
+            }
+            break;
+        }
+
+        case SIM_COAST:
+            if (velocity <= 0.0f) {
+                phase = profile.drogue_rate_ms > 0.0f ? SIM_DROGUE : SIM_MAIN;
+            }
+            break;
+
+        case SIM_DROGUE:
+            // Size the canopy so it settles at the profile's descent rate
+            drag_area += 2.0f * mass * GRAVITY / (rho * profile.drogue_rate_ms * profile.drogue_rate_ms);
+            if (altitude_agl <= profile.main_deploy_agl_m) {
+                phase = SIM_MAIN;
+            }
+            break;
+
+        case SIM_MAIN:
+            drag_area += 2.0f * mass * GRAVITY / (rho * profile.main_rate_ms * profile.main_rate_ms);
+            break;
+
+        case SIM_LANDED:
+        default:
+            acceleration = 0.0f;
+            return;
+    }
+
+    float drag = -0.5f * rho * velocity * fabsf(velocity) * drag_area;
+    acceleration = (thrust + drag) / mass - GRAVITY;
+
+    // The rail holds the rocket until thrust exceeds weight
+    if (phase == SIM_GROUND_IDLE || (altitude_agl <= 0.0f && acceleration < 0.0f && phase == SIM_BOOST)) {
+        acceleration = 0.0f;
+    }
+
+    // Semi-implicit Euler - stable for the drag time constants involved
+    velocity += acceleration * dt;
+    altitude_agl += velocity * dt;
+
+    if (altitude_agl > max_altitude_agl) {
+        max_altitude_agl = altitude_agl;
+    }
+
+    if ((phase == SIM_DROGUE || phase == SIM_MAIN) && altitude_agl <= 0.0f) {
+        altitude_agl = 0.0f;
+        velocity = 0.0f;
+        acceleration = 0.0f;
+        phase = SIM_LANDED;
+    }
+
+    // Fin misalignment spins the airframe up with airspeed; chutes stop it
+    if (phase == SIM_BOOST || phase == SIM_COAST) {
+        roll_rate = profile.spin_rate_dps * fminf(fabsf(velocity) / 50.0f, 1.0f);
+    } else {
+        roll_rate *= 0.995f;
+    }
+}
+
+const SimSample& FlightSimulator::update(uint32_t now_us) {
+    while ((int32_t)(now_us - time_us) >= (int32_t)STEP_US) {
+        step();
+    }
+
+    float altitude_asl = profile.ground_altitude_m + altitude_agl;
+    sample.time_us = now_us;
+    sample.pressure_pa = 101325.0f * powf(1.0f - 2.25577e-5f * altitude_asl, 5.25588f)
+                         + profile.pressure_noise_pa * rng.gaussian();
+    sample.temperature_c = profile.ground_temperature_c - 0.0065f * altitude_agl
+                           + profile.temperature_noise_c * rng.gaussian();
+
+    // An accelerometer measures specific force: 1 g at rest, ~0 g in free fall
+    float accel_noise = profile.accel_noise_g;
+    if (phase == SIM_BOOST) {
+        accel_noise += profile.boost_vibration_g;
+    }
+    sample.accel_x = accel_noise * rng.gaussian();
+    sample.accel_y = accel_noise * rng.gaussian();
+    sample.accel_z = (acceleration + GRAVITY) / GRAVITY + accel_noise * rng.gaussian();
+
+    sample.gyro_x = profile.gyro_noise_dps * rng.gaussian();
+    sample.gyro_y = profile.gyro_noise_dps * rng.gaussian();
+    sample.gyro_z = roll_rate + profile.gyro_noise_dps * rng.gaussian();
+
+    return sample;
+}
+
+void FlightSimulator::refresh() {
+    if (clock == nullptr) {
+        return;
+    }
+    uint32_t now = clock();
+    if (now != sample.time_us) {
+        update(now);
+    }
+}
+
+bool FlightSimulator::read(BaroSample& out) {
+    refresh();
+    out.time_us = sample.time_us;
+    out.pressure_pa = sample.pressure_pa;
+    out.temperature_c = sample.temperature_c;
+    return true;
+}
+
+bool FlightSimulator::read(ImuSample& out) {
+    refresh();
+    out.time_us = sample.time_us;
+    out.accel_x = sample.accel_x;
+    out.accel_y = sample.accel_y;
+    out.accel_z = sample.accel_z;
+    out.gyro_x = sample.gyro_x;
+    out.gyro_y = sample.gyro_y;
+    out.gyro_z = sample.gyro_z;
+    return true;
+}
+
+const char* FlightSimulator::getPhaseName(SimPhase phase) {
+    switch (phase) {
+        case SIM_GROUND_IDLE: return "GROUND_IDLE";
+        case SIM_BOOST:       return "BOOST";
+        case SIM_COAST:       return "COAST";
+        case SIM_DROGUE:      return "DROGUE";
+        case SIM_MAIN:        return "MAIN";
+        case SIM_LANDED:      return "LANDED";
+        default:              return "UNKNOWN";
+    }
+}
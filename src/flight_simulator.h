@@ -0,0 +1,115 @@
+#ifndef FLIGHT_SIMULATOR_H
+#define FLIGHT_SIMULATOR_H
+
+#include <stdint.h>
+#include "sim_random.h"
+#include "sensor_source.h"
+
+// Physical description of a simulated flight.
+// All values are SI; the defaults describe a small single-deploy model rocket
+// climbing to roughly 250 m.
+struct FlightProfile {
+    float pad_time_s;             // Ground idle before ignition
+    float thrust_n;               // Average motor thrust
+    float burn_time_s;
+    float dry_mass_kg;
+    float propellant_mass_kg;
+    float drag_area_m2;           // Cd * A of the airframe
+    float drogue_rate_ms;         // Descent rate under drogue (0 = no drogue)
+    float main_rate_ms;           // Descent rate under main
+    float main_deploy_agl_m;      // Main opens below this altitude on the way down
+    float spin_rate_dps;          // Roll rate induced by fin misalignment during boost
+    float ground_altitude_m;      // Launch site elevation
+    float ground_temperature_c;
+
+    // Sensor noise (1 sigma)
+    float pressure_noise_pa;
+    float temperature_noise_c;
+    float accel_noise_g;
+    float gyro_noise_dps;
+    float boost_vibration_g;      // Extra accelerometer noise while the motor burns
+
+    static FlightProfile modelRocket();   // ~250 m, drogue + main
+    static FlightProfile groundIdle();    // Never launches - bench testing
+};
+
+enum SimPhase {
+    SIM_GROUND_IDLE = 0,
+    SIM_BOOST = 1,
+    SIM_COAST = 2,
+    SIM_DROGUE = 3,
+    SIM_MAIN = 4,
+    SIM_LANDED = 5
+};
+
+// One set of sensor readings, as the real sensors would report them
+struct SimSample {
+    uint32_t time_us;
+    float pressure_pa;
+    float temperature_c;
+    float accel_x, accel_y, accel_z;   // g, body frame (Z along the airframe)
+    float gyro_x, gyro_y, gyro_z;      // deg/s
+};
+
+// Seeded, clock-injected flight simulator.
+// The vertical trajectory is integrated in fixed 1 ms steps (thrust, ISA air
+// density drag, recovery devices), so the result depends only on the profile,
+// the seed and the times it is sampled at - never on how often update() is
+// called or on millis(). Sensor streams (pressure, temperature, 6-axis IMU)
+// are derived from the same state, so they always agree with each other.
+class FlightSimulator : public BaroSource, public ImuSource {
+public:
+    typedef uint32_t (*Clock)();   // Microseconds
+
+private:
+    static const uint32_t STEP_US = 1000;
+
+    FlightProfile profile;
+    SimRandom rng;
+    uint64_t seed;
+
+    // Truth state
+    uint32_t time_us;       // Integrated up to here
+    float altitude_agl;
+    float velocity;
+    float acceleration;     // Kinematic, m/s^2 up
+    float roll_rate;        // deg/s
+    float max_altitude_agl;
+    SimPhase phase;
+
+    SimSample sample;
+    Clock clock;
+
+    void refresh();
+
+    void step();
+    float airDensity(float altitude_asl) const;
+
+public:
+    FlightSimulator();
+
+    void begin(const FlightProfile& flight_profile, uint64_t random_seed);
+    void reset();   // Back to the pad with the same profile and seed
+
+    // Advances the trajectory to now_us and draws a new noisy sample.
+    // The clock is supplied by the caller: micros() on the device, a loop
+    // counter on the host to run far faster than real time.
+    const SimSample& update(uint32_t now_us);
+
+    const SimSample& getSample() const { return sample; }
+
+    // As a BaroSource/ImuSource the simulator reads the time from this clock
+    // and advances itself; both reads at the same time share one sample
+    void setClock(Clock sample_clock) { clock = sample_clock; }
+    bool read(BaroSample& out) override;
+    bool read(ImuSample& out) override;
+    SimPhase getPhase() const { return phase; }
+    float getTrueAltitudeAgl() const { return altitude_agl; }
+    float getTrueVelocity() const { return velocity; }
+    float getMaxAltitudeAgl() const { return max_altitude_agl; }
+    bool hasLanded() const { return phase == SIM_LANDED; }
+
+    static const char* getPhaseName(SimPhase phase);
+};
+
+#endif // FLIGHT_SIMULATOR_H
@@ -0,0 +1,167 @@
+#include "flight_summary.h"
+#include <math.h>
+#include <string.h>
+#include "fixed_point.h"
+#include "sensor_types.h"
+
+static float toSeconds(bool seen, uint32_t ms) {
+    return seen ? ms / 1000.0f : FlightSummary::NOT_SEEN;
+}
+
+FlightSummariser::FlightSummariser()
+    : smoothing(SMOOTHING_US), climb(1000000) {
+    reset();
+}
+
+void FlightSummariser::reset() {
+    detector.reset();
+    smoothing.reset();
+    climb.reset();
+    started = false;
+    start_us = 0;
+    last_us = 0;
+    baro_samples = 0;
+    imu_samples = 0;
+    ground_sum = 0.0f;
+    ground_altitude = 0.0f;
+    altitude = 0.0f;
+    acceleration = 1.0f;
+    max_acceleration_squared = 0.0f;
+    max_acceleration_ms = 0;
+    apogee = 0.0f;
+    apogee_ms = 0;
+    max_ascent_rate = 0.0f;
+    max_descent_rate = 0.0f;
+    launch_ms = 0;
+    burnout_ms = 0;
+    touchdown_ms = 0;
+    touchdown_altitude = 0.0f;
+    launched = false;
+    burned_out = false;
+    landed = false;
+}
+
+void FlightSummariser::add(const FlightRecord& record) {
+    if (!started) {
+        started = true;
+        start_us = record.time_us;
+    }
+    last_us = record.time_us;
+    uint32_t now_ms = (record.time_us - start_us) / 1000;   // Wrap-safe
+
+    if (record.type == RECORD_BARO) {
+        float absolute = pressureToAltitudeFx(PressureFx::fromFloat(record.values[0])).toFloat();
+        if (baro_samples < GROUND_SAMPLES) {
+            ground_sum += absolute;
+            ground_altitude = ground_sum / (baro_samples + 1);
+        }
+        baro_samples++;
+        smoothing.add(record.time_us, absolute - ground_altitude);
+        altitude = smoothing.getMean();
+        climb.add(record.time_us, altitude);
+
+        if (detector.isInFlight()) {
+            if (altitude > apogee) {
+                apogee = altitude;
+                apogee_ms = now_ms;
+            }
+            float rate = climb.getRate();
+            if (detector.getPhase() == PHASE_DESCENT) {
+                if (-rate > max_descent_rate) {
+                    max_descent_rate = -rate;
+                }
+            } else if (rate > max_ascent_rate) {
+                max_ascent_rate = rate;
+            }
+        }
+    } else if (record.type == RECORD_IMU) {
+        imu_samples++;
+        float squared = record.values[0] * record.values[0] + record.values[1] * record.values[1] +
+                        record.values[2] * record.values[2];
+        if (squared > max_acceleration_squared) {
+            max_acceleration_squared = squared;
+            max_acceleration_ms = now_ms;
+        }
+        acceleration = sqrtf(squared);
+    } else {
+        return;
+    }
+
+    detector.update(now_ms, altitude, acceleration);
+    if (!detector.phaseChanged()) {
+        return;
+    }
+    switch (detector.getPhase()) {
+        case PHASE_BOOST:
+            launched = true;
+            launch_ms = now_ms;
+            apogee = altitude;
+            apogee_ms = now_ms;
+            break;
+        case PHASE_COAST:
+            burned_out = true;
+            burnout_ms = now_ms;
+            break;
+        case PHASE_LANDED:
+            // Confirmed after a still period; touchdown was at its start
+            landed = true;
+            touchdown_ms = detector.getTouchdownMs();
+            touchdown_altitude = altitude;
+            break;
+        default:
+            break;
+    }
+}
+
+void FlightSummariser::endAtLanding() {
+    uint32_t end_ms = (last_us - start_us) / 1000;
+    if (!launched || landed || end_ms < apogee_ms + FlightPhaseDetector::LANDED_TIME_MS) {
+        return;
+    }
+    landed = true;
+    touchdown_ms = end_ms - FlightPhaseDetector::LANDED_TIME_MS;
+    touchdown_altitude = altitude;
+}
+
+void FlightSummariser::getSummary(FlightSummary& out) const {
+    memset(&out, 0, sizeof(out));
+    out.baro_samples = baro_samples;
+    out.imu_samples = imu_samples;
+    out.recording_s = (last_us - start_us) / 1.0e6f;
+    out.launched = launched;
+    out.landed = landed;
+    out.apogee_m = apogee;
+    out.apogee_s = toSeconds(launched, apogee_ms);
+    out.max_acceleration_g = sqrtf(max_acceleration_squared);
+    out.max_acceleration_s = toSeconds(imu_samples > 0, max_acceleration_ms);
+    out.max_ascent_rate = max_ascent_rate;
+    out.max_descent_rate = max_descent_rate;
+    out.launch_s = toSeconds(launched, launch_ms);
+    out.burnout_s = toSeconds(burned_out, burnout_ms);
+    out.touchdown_s = toSeconds(landed, touchdown_ms);
+    if (landed && touchdown_ms > apogee_ms) {
+        out.mean_descent_rate = (apogee - touchdown_altitude) * 1000.0f / (touchdown_ms - apogee_ms);
+    }
+}
+
+bool summariseFlightArchive(FlightArchiveReader& reader, FlightSummary& out) {
+    if (!reader.isOpen()) {
+        return false;
+    }
+    FlightSummariser summariser;
+    FlightRecord record;
+    reader.rewind();
+    while (reader.next(record)) {
+        summariser.add(record);
+    }
+    return finishFlightArchiveSummary(reader, summariser, out);
+}
+
+bool finishFlightArchiveSummary(const FlightArchiveReader& reader, FlightSummariser& summariser, FlightSummary& out) {
+    if (!reader.isTruncated()) {
+        summariser.endAtLanding();
+    }
+    summariser.getSummary(out);
+    out.flight_number = reader.getHeader().flight_number;
+    return out.baro_samples > 0;
+}
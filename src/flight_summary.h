@@ -0,0 +1,96 @@
+#ifndef FLIGHT_SUMMARY_H
+#define FLIGHT_SUMMARY_H
+
+#include <stdint.h>
+#include "flight_archive.h"
+#include "flight_phase.h"
+#include "flight_record.h"
+#include "window_stats.h"
+
+// Key numbers of one recorded flight. Times are seconds from the first
+// sample of the recording; an event that was not seen is at NOT_SEEN.
+struct FlightSummary {
+    static constexpr float NOT_SEEN = -1.0f;
+
+    uint32_t flight_number;
+    uint32_t baro_samples;
+    uint32_t imu_samples;
+    float recording_s;
+    bool launched;
+    bool landed;
+    float apogee_m;              // Above the pad
+    float apogee_s;
+    float max_acceleration_g;    // Total, in any direction
+    float max_acceleration_s;
+    float max_ascent_rate;       // m/s over 1 s
+    float max_descent_rate;      // m/s over 1 s, positive down
+    float mean_descent_rate;     // m/s from apogee to touchdown
+    float launch_s;
+    float burnout_s;
+    float touchdown_s;
+};
+
+// Builds a FlightSummary from FlightRecords in time order in one pass,
+// with fixed memory and no powf(). Altitude comes from the pipeline's
+// fixed-point table, relative to the mean of the first GROUND_SAMPLES
+// barometer readings, smoothed over SMOOTHING_US so one bad reading cannot
+// set the apogee. Launch, burnout and landing come from a
+// FlightPhaseDetector fed the same way as the live one. No Arduino
+// dependency.
+class FlightSummariser {
+public:
+    static const uint32_t GROUND_SAMPLES = 10;
+    static const uint32_t SMOOTHING_US = 250000;
+
+    FlightSummariser();
+
+    void reset();
+    void add(const FlightRecord& record);
+
+    // For a recording that stopped when the live detector reported LANDED,
+    // as every saved archive does. That was LANDED_TIME_MS into its still
+    // period, so this detector, fed smoothed altitude, may not have seen
+    // enough of it. Call after the last record: touchdown is taken at the
+    // start of the live still period.
+    void endAtLanding();
+
+    void getSummary(FlightSummary& out) const;
+
+private:
+    FlightPhaseDetector detector;
+    WindowStats<8> smoothing;    // Altitude AGL
+    WindowStats<10> climb;       // Smoothed altitude, for the 1 s rate
+    bool started;
+    uint32_t start_us;
+    uint32_t last_us;
+    uint32_t baro_samples;
+    uint32_t imu_samples;
+    float ground_sum;
+    float ground_altitude;
+    float altitude;              // Smoothed, AGL
+    float acceleration;          // Latest total, g
+    float max_acceleration_squared;
+    uint32_t max_acceleration_ms;
+    float apogee;
+    uint32_t apogee_ms;
+    float max_ascent_rate;
+    float max_descent_rate;
+    uint32_t launch_ms;
+    uint32_t burnout_ms;
+    uint32_t touchdown_ms;
+    float touchdown_altitude;
+    bool launched;
+    bool burned_out;
+    bool landed;
+};
+
+// Summarises a whole archive from its first record; false if it holds no
+// barometer samples. A complete archive ends at landing (endAtLanding()),
+// one cut short by a power loss does not
+bool summariseFlightArchive(FlightArchiveReader& reader, FlightSummary& out);
+
+// The end of summariseFlightArchive() for a caller that feeds the reader's
+// records to summariser itself, e.g. a few blocks at a time
+bool finishFlightArchiveSummary(const FlightArchiveReader& reader, FlightSummariser& summariser, FlightSummary& out);
+
+#endif // FLIGHT_SUMMARY_H
@@ -0,0 +1,101 @@
+#include "history_json.h"
+#include <stdio.h>
+#include <string.h>
+
+HistoryJsonStream::HistoryJsonStream(const HistoryPyramid& history_store, HistoryPyramid::Channel channel_id,
+                                     uint32_t from, uint32_t to, size_t points)
+    : history(history_store) {
+    channel = channel_id;
+    from_ms = from;
+    to_ms = to > from ? to : from;
+    if (points < 1) {
+        points = 1;
+    } else if (points > MAX_POINTS) {
+        points = MAX_POINTS;
+    }
+    count = to_ms > from_ms ? points : 0;
+    stage = STAGE_HEADER;
+    next_point = 0;
+    batch_first = 0;
+    batch_size = 0;
+    pending_length = 0;
+    pending_offset = 0;
+}
+
+size_t HistoryJsonStream::read(uint8_t* buffer, size_t max_length) {
+    size_t written = 0;
+    while (written < max_length) {
+        if (pending_offset == pending_length) {
+            if (stage == STAGE_DONE) {
+                break;
+            }
+            formatNext();
+            continue;
+        }
+        size_t n = pending_length - pending_offset;
+        if (n > max_length - written) {
+            n = max_length - written;
+        }
+        memcpy(buffer + written, pending + pending_offset, n);
+        pending_offset += n;
+        written += n;
+    }
+    return written;
+}
+
+void HistoryJsonStream::formatNext() {
+    int length = 0;
+    switch (stage) {
+        case STAGE_HEADER:
+            length = snprintf(pending, sizeof(pending),
+                              "{\"channel\":\"%s\",\"from_ms\":%lu,\"to_ms\":%lu,\"newest_ms\":%lu,"
+                              "\"bucket_ms\":%lu,\"count\":%u,\"points\":[",
+                              HistoryPyramid::getChannelName(channel), (unsigned long)from_ms,
+                              (unsigned long)to_ms, (unsigned long)history.getNewestMs(),
+                              (unsigned long)history.getQueryBucketMs(from_ms, to_ms, count), (unsigned)count);
+            stage = count > 0 ? STAGE_POINTS : STAGE_FOOTER;
+            break;
+
+        case STAGE_POINTS: {
+            if (next_point >= batch_first + batch_size) {
+                batch_first = next_point;
+                batch_size = history.query(channel, from_ms, to_ms, count, next_point, batch, BATCH);
+                if (batch_size == 0) {
+                    // Store went away mid-response: close the array early
+                    stage = STAGE_FOOTER;
+                    break;
+                }
+            }
+            const HistoryPyramid::Point& p = batch[next_point - batch_first];
+            const char* separator = next_point > 0 ? "," : "";
+            if (p.valid) {
+                length = snprintf(pending, sizeof(pending), "%s[%lu,%.3f,%.3f,%.3f]", separator,
+                                  (unsigned long)p.time_ms, p.min, p.max, p.mean);
+            } else {
+                length = snprintf(pending, sizeof(pending), "%s[%lu,null,null,null]", separator,
+                                  (unsigned long)p.time_ms);
+            }
+            next_point++;
+            if (next_point >= count) {
+                stage = STAGE_FOOTER;
+            }
+            break;
+        }
+
+        case STAGE_FOOTER:
+            length = snprintf(pending, sizeof(pending), "]}");
+            stage = STAGE_DONE;
+            break;
+
+        case STAGE_DONE:
+            break;
+    }
+
+    if (length < 0) {
+        length = 0;
+    } else if ((size_t)length >= sizeof(pending)) {
+        length = sizeof(pending) - 1;
+    }
+    pending_length = (size_t)length;
+    pending_offset = 0;
+}
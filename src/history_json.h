@@ -0,0 +1,57 @@
+#ifndef HISTORY_JSON_H
+#define HISTORY_JSON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "history_pyramid.h"
+
+// /history response body, produced piece by piece for a chunked HTTP
+// response:
+//   {"channel":"altitude","from_ms":..,"to_ms":..,"newest_ms":..,
+//    "bucket_ms":..,"count":N,"points":[[time_ms,min,max,mean],...]}
+// with null values where there is no data. Each point is the min/max
+// envelope (and mean) of its slice of [from_ms, to_ms), read from the
+// HistoryPyramid BATCH points at a time, so memory use does not depend on
+// the point count and a request never holds the whole body.
+// No Arduino dependency: read() just fills the caller's buffer.
+class HistoryJsonStream {
+public:
+    static const size_t MAX_POINTS = 2000;
+
+    // points is clamped to 1..MAX_POINTS
+    HistoryJsonStream(const HistoryPyramid& history, HistoryPyramid::Channel channel,
+                      uint32_t from_ms, uint32_t to_ms, size_t points);
+
+    // Copies up to max_length bytes of the body; 0 once it is complete
+    size_t read(uint8_t* buffer, size_t max_length);
+
+private:
+    enum Stage {
+        STAGE_HEADER,
+        STAGE_POINTS,
+        STAGE_FOOTER,
+        STAGE_DONE
+    };
+
+    static const size_t BATCH = 16;
+
+    const HistoryPyramid& history;
+    HistoryPyramid::Channel channel;
+    uint32_t from_ms;
+    uint32_t to_ms;
+    size_t count;
+
+    Stage stage;
+    size_t next_point;
+    HistoryPyramid::Point batch[BATCH];
+    size_t batch_first;
+    size_t batch_size;
+
+    char pending[160];      // Formatted text not yet handed out
+    size_t pending_length;
+    size_t pending_offset;
+
+    void formatNext();
+};
+
+#endif // HISTORY_JSON_H
@@ -0,0 +1,217 @@
+#include "history_pyramid.h"
+#include <string.h>
+
+static const uint32_t BUCKET_MS[HistoryPyramid::LEVELS] = { 100, 1000, 10000, 100000 };
+static const uint32_t CAPACITY[HistoryPyramid::LEVELS] = { 3000, 3600, 2160, 864 };
+static const uint32_t NO_INDEX = 0xFFFFFFFF;
+static const char* const CHANNEL_NAMES[HistoryPyramid::CHANNEL_COUNT] = {
+    "altitude", "vertical_speed", "acceleration"
+};
+
+HistoryPyramid::HistoryPyramid() {
+    for (int level = 0; level < LEVELS; level++) {
+        slots[level] = nullptr;
+    }
+    newest_ms = 0;
+    oldest_ms = 0;
+    empty = true;
+}
+
+size_t HistoryPyramid::requiredBytes() {
+    size_t total = 0;
+    for (int level = 0; level < LEVELS; level++) {
+        total += CAPACITY[level] * sizeof(Slot);
+    }
+    return total;
+}
+
+uint32_t HistoryPyramid::getBucketMs(int level) {
+    return BUCKET_MS[level];
+}
+
+uint32_t HistoryPyramid::getCapacity(int level) {
+    return CAPACITY[level];
+}
+
+const char* HistoryPyramid::getChannelName(Channel channel) {
+    return channel < CHANNEL_COUNT ? CHANNEL_NAMES[channel] : "unknown";
+}
+
+bool HistoryPyramid::parseChannel(const char* name, Channel& out) {
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        if (strcmp(name, CHANNEL_NAMES[c]) == 0) {
+            out = (Channel)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HistoryPyramid::begin(void* memory, size_t bytes) {
+    if (memory == nullptr || bytes < requiredBytes()) {
+        return false;
+    }
+    Slot* next = static_cast<Slot*>(memory);
+    for (int level = 0; level < LEVELS; level++) {
+        slots[level] = next;
+        next += CAPACITY[level];
+    }
+    clear();
+    return true;
+}
+
+void HistoryPyramid::clear() {
+    if (!isReady()) {
+        return;
+    }
+    for (int level = 0; level < LEVELS; level++) {
+        for (uint32_t i = 0; i < CAPACITY[level]; i++) {
+            slots[level][i].index = NO_INDEX;
+        }
+    }
+    newest_ms = 0;
+    oldest_ms = 0;
+    empty = true;
+}
+
+void HistoryPyramid::add(Channel channel, uint32_t time_ms, float value) {
+    if (!isReady()) {
+        return;
+    }
+
+    for (int level = 0; level < LEVELS; level++) {
+        uint32_t index = time_ms / BUCKET_MS[level];
+        Slot& slot = slots[level][index % CAPACITY[level]];
+        if (slot.index != index) {
+            // First sample in this bucket: recycle the slot
+            slot.index = index;
+            for (int c = 0; c < CHANNEL_COUNT; c++) {
+                slot.channels[c].count = 0;
+            }
+        }
+
+        Aggregate& a = slot.channels[channel];
+        if (a.count == 0) {
+            a.min = value;
+            a.max = value;
+            a.sum = value;
+        } else {
+            if (value < a.min) {
+                a.min = value;
+            }
+            if (value > a.max) {
+                a.max = value;
+            }
+            a.sum += value;
+        }
+        a.count++;
+    }
+
+    if (empty) {
+        oldest_ms = time_ms;
+        empty = false;
+    }
+    if (time_ms > newest_ms) {
+        newest_ms = time_ms;
+    }
+}
+
+const HistoryPyramid::Slot* HistoryPyramid::findSlot(int level, uint32_t index) const {
+    const Slot& slot = slots[level][index % CAPACITY[level]];
+    return slot.index == index ? &slot : nullptr;
+}
+
+// First time still held at a level
+static uint32_t retentionStart(int level, uint32_t newest_ms) {
+    uint32_t newest_index = newest_ms / BUCKET_MS[level];
+    if (newest_index < CAPACITY[level]) {
+        return 0;
+    }
+    return (newest_index - CAPACITY[level] + 1) * BUCKET_MS[level];
+}
+
+uint32_t HistoryPyramid::getOldestMs() const {
+    uint32_t start = retentionStart(LEVELS - 1, newest_ms);
+    return oldest_ms > start ? oldest_ms : start;
+}
+
+int HistoryPyramid::chooseLevel(uint32_t from_ms, uint32_t to_ms, size_t count) const {
+    uint32_t span_per_point_ms = (to_ms - from_ms) / count;
+    int level = 0;
+    while (level + 1 < LEVELS && BUCKET_MS[level + 1] <= span_per_point_ms) {
+        level++;
+    }
+    // The finer levels forget sooner; go coarser if the range starts
+    // before what this level still holds
+    while (level + 1 < LEVELS && from_ms < retentionStart(level, newest_ms)) {
+        level++;
+    }
+    return level;
+}
+
+uint32_t HistoryPyramid::getQueryBucketMs(uint32_t from_ms, uint32_t to_ms, size_t count) const {
+    if (to_ms <= from_ms || count == 0) {
+        return BUCKET_MS[0];
+    }
+    return BUCKET_MS[chooseLevel(from_ms, to_ms, count)];
+}
+
+size_t HistoryPyramid::query(Channel channel, uint32_t from_ms, uint32_t to_ms, Point* out, size_t count) const {
+    return query(channel, from_ms, to_ms, count, 0, out, count);
+}
+
+size_t HistoryPyramid::query(Channel channel, uint32_t from_ms, uint32_t to_ms, size_t count,
+                             size_t first, Point* out, size_t out_count) const {
+    if (!isReady() || to_ms <= from_ms || count == 0 || first >= count) {
+        return 0;
+    }
+    if (out_count > count - first) {
+        out_count = count - first;
+    }
+
+    uint32_t span = to_ms - from_ms;
+    int level = chooseLevel(from_ms, to_ms, count);
+    uint32_t bucket_ms = BUCKET_MS[level];
+
+    for (size_t i = 0; i < out_count; i++) {
+        size_t k = first + i;
+        uint32_t t0 = from_ms + (uint32_t)((uint64_t)span * k / count);
+        uint32_t t1 = from_ms + (uint32_t)((uint64_t)span * (k + 1) / count);
+        if (t1 <= t0) {
+            t1 = t0 + 1;
+        }
+
+        Point& p = out[i];
+        p.time_ms = t0;
+        p.valid = false;
+        float sum = 0.0f;
+        uint32_t n = 0;
+        for (uint32_t index = t0 / bucket_ms; index <= (t1 - 1) / bucket_ms; index++) {
+            const Slot* slot = findSlot(level, index);
+            if (slot == nullptr || slot->channels[channel].count == 0) {
+                continue;
+            }
+            const Aggregate& a = slot->channels[channel];
+            if (!p.valid) {
+                p.min = a.min;
+                p.max = a.max;
+                p.valid = true;
+            } else {
+                if (a.min < p.min) {
+                    p.min = a.min;
+                }
+                if (a.max > p.max) {
+                    p.max = a.max;
+                }
+            }
+            sum += a.sum;
+            n += a.count;
+        }
+        if (p.valid) {
+            p.mean = sum / n;
+        } else {
+            p.min = p.max = p.mean = 0.0f;
+        }
+    }
+    return out_count;
+}
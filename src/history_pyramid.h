@@ -0,0 +1,96 @@
+#ifndef HISTORY_PYRAMID_H
+#define HISTORY_PYRAMID_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Multi-resolution time-series history for graphs.
+// Each channel is kept at LEVELS resolutions - 100 ms, 1 s, 10 s and 100 s
+// buckets - with min, max and mean per bucket. Every sample updates the open
+// bucket of every level, so there is never a roll-up pass or a rescan, and
+// older data survives at coarser resolution for longer:
+//     level 0: 100 ms x 3000 = 5 min     level 2:  10 s x 2160 = 6 h
+//     level 1:   1 s x 3600 = 1 h        level 3: 100 s x  864 = 24 h
+// query() picks the coarsest level whose buckets are no wider than one
+// output point, so each point merges at most 10 buckets whatever the range
+// (more only for spans over 1000 s per point, beyond the coarsest level).
+// The buckets (~500 KB) live in caller-provided memory - PSRAM on the
+// device - so the class itself has no allocation and no Arduino dependency.
+class HistoryPyramid {
+public:
+    enum Channel {
+        CHANNEL_ALTITUDE,         // m AGL
+        CHANNEL_VERTICAL_SPEED,   // m/s
+        CHANNEL_ACCELERATION,     // Earth-frame vertical, g
+        CHANNEL_COUNT
+    };
+
+    static const int LEVELS = 4;
+
+    struct Point {
+        uint32_t time_ms;   // Start of the point's time span
+        float min;
+        float max;
+        float mean;
+        bool valid;         // False where there is no data
+    };
+
+    HistoryPyramid();
+
+    static size_t requiredBytes();
+
+    // memory must hold requiredBytes() and stay valid; false if too small
+    bool begin(void* memory, size_t bytes);
+    bool isReady() const { return slots[0] != nullptr; }
+    void clear();
+
+    void add(Channel channel, uint32_t time_ms, float value);
+
+    // Fills up to count points evenly covering [from_ms, to_ms); returns the
+    // number written (0 if not ready or the range is empty)
+    size_t query(Channel channel, uint32_t from_ms, uint32_t to_ms, Point* out, size_t count) const;
+
+    // Points first .. first + out_count - 1 of the same count-point query,
+    // for callers that stream a long series through a small buffer
+    size_t query(Channel channel, uint32_t from_ms, uint32_t to_ms, size_t count,
+                 size_t first, Point* out, size_t out_count) const;
+
+    // Oldest time still held at any resolution, and the newest sample
+    uint32_t getOldestMs() const;
+    uint32_t getNewestMs() const { return newest_ms; }
+    bool isEmpty() const { return empty; }
+
+    static uint32_t getBucketMs(int level);
+    static uint32_t getCapacity(int level);
+
+    // Bucket width a query over [from_ms, to_ms) with count points reads
+    uint32_t getQueryBucketMs(uint32_t from_ms, uint32_t to_ms, size_t count) const;
+
+    static const char* getChannelName(Channel channel);   // "altitude" etc.
+    static bool parseChannel(const char* name, Channel& out);
+
+private:
+    struct Aggregate {
+        float min;
+        float max;
+        float sum;
+        uint32_t count;
+    };
+
+    // Bucket index (time / bucket width) tells whether a slot is current
+    // or left over from an earlier pass round the ring
+    struct Slot {
+        uint32_t index;
+        Aggregate channels[CHANNEL_COUNT];
+    };
+
+    Slot* slots[LEVELS];
+    uint32_t newest_ms;
+    uint32_t oldest_ms;
+    bool empty;
+
+    const Slot* findSlot(int level, uint32_t index) const;
+    int chooseLevel(uint32_t from_ms, uint32_t to_ms, size_t count) const;
+};
+
+#endif // HISTORY_PYRAMID_H
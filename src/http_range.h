@@ -0,0 +1,82 @@
+#ifndef HTTP_RANGE_H
+#define HTTP_RANGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+
+enum ByteRangeResult {
+    RANGE_NONE,             // No usable Range header: send the whole file
+    RANGE_OK,               // Send [start, start + length) with 206
+    RANGE_UNSATISFIABLE     // Reply 416
+};
+
+// Reads the decimal digits at p into value, saturating instead of wrapping.
+// Returns the first character after them, or nullptr if there are none:
+// unlike strtoull(), no sign or whitespace is accepted
+inline const char* parseRangeNumber(const char* p, unsigned long long& value) {
+    const char* first = p;
+    value = 0;
+    while (*p >= '0' && *p <= '9') {
+        unsigned digit = (unsigned)(*p - '0');
+        value = value > (~0ULL - digit) / 10 ? ~0ULL : value * 10 + digit;
+        p++;
+    }
+    return p != first ? p : nullptr;
+}
+
+// Parses a single HTTP "Range: bytes=..." value against a file of `size`
+// bytes: "a-b", "a-" and the suffix form "-n". Multiple ranges and other
+// units are not supported, and malformed values are ignored; both fall back
+// to the whole file, which RFC 9110 allows. No Arduino dependency.
+inline ByteRangeResult parseByteRange(const char* header, size_t size, size_t& start, size_t& length) {
+    start = 0;
+    length = size;
+    if (header == nullptr || strncasecmp(header, "bytes=", 6) != 0) {
+        return RANGE_NONE;
+    }
+    const char* spec = header + 6;
+    while (*spec == ' ') {
+        spec++;
+    }
+
+    const char* end;
+    unsigned long long first, last;
+    if (*spec == '-') {
+        // Suffix range: the last n bytes
+        end = parseRangeNumber(spec + 1, last);
+        if (end == nullptr || *end != '\0') {
+            return RANGE_NONE;
+        }
+        if (last == 0 || size == 0) {
+            return RANGE_UNSATISFIABLE;
+        }
+        length = last < size ? (size_t)last : size;
+        start = size - length;
+        return RANGE_OK;
+    }
+
+    end = parseRangeNumber(spec, first);
+    if (end == nullptr || *end != '-') {
+        return RANGE_NONE;
+    }
+    last = ~0ULL;
+    if (end[1] != '\0') {
+        end = parseRangeNumber(end + 1, last);
+        if (end == nullptr || *end != '\0' || last < first) {
+            return RANGE_NONE;
+        }
+    }
+    if (first >= size) {
+        return RANGE_UNSATISFIABLE;
+    }
+    if (last >= size) {
+        last = size - 1;
+    }
+    start = (size_t)first;
+    length = (size_t)(last - first + 1);
+    return RANGE_OK;
+}
+
+#endif // HTTP_RANGE_H
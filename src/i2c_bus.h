@@ -0,0 +1,38 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Register-level I2C access used by the sensor drivers.
+// Drivers only talk to this interface, so the same driver code runs on the
+// Wire peripheral or against a scripted fake bus on a host.
+class I2CBus {
+public:
+    static const size_t MAX_TRANSFER = 128;   // ESP32 Wire buffer size
+
+    virtual ~I2CBus() {}
+
+    // Plain write: data[0] is usually the register address or a command
+    virtual bool write(uint8_t address, const uint8_t* data, size_t len) = 0;
+
+    // Plain read without a register address (e.g. MS5611 ADC result)
+    virtual bool read(uint8_t address, uint8_t* out, size_t len) = 0;
+
+    // Writes reg, then reads len bytes after a repeated start
+    virtual bool readRegister(uint8_t address, uint8_t reg, uint8_t* out, size_t len) = 0;
+
+    // Bus clock request; buses without a configurable clock ignore it
+    virtual void setClock(uint32_t /*hz*/) {}
+
+    bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+        uint8_t data[2] = { reg, value };
+        return write(address, data, 2);
+    }
+
+    bool writeCommand(uint8_t address, uint8_t command) {
+        return write(address, &command, 1);
+    }
+};
+
+#endif // I2C_BUS_H
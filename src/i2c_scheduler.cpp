@@ -0,0 +1,203 @@
+#include "i2c_scheduler.h"
+#include "metrics.h"
+
+static Counter i2c_errors("altimeter_i2c_errors_total", "I2C transactions that failed after a retry");
+static Counter i2c_retries("altimeter_i2c_retries_total", "I2C transactions retried after a failure");
+static Counter i2c_transactions("altimeter_i2c_transactions_total", "I2C transactions run by the bus scheduler");
+static Gauge i2c_clock("altimeter_i2c_clock_hz", "I2C bus clock");
+static Gauge i2c_queue_max("altimeter_i2c_queue_depth_max", "Most I2C transactions queued at once");
+
+I2CScheduler::I2CScheduler(I2CBus& i2c) : bus(i2c) {
+    task = nullptr;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    for (int i = 0; i < PRIORITY_COUNT; i++) {
+        queue_head[i] = nullptr;
+        queue_tail[i] = nullptr;
+    }
+    queued = 0;
+    device_count = 0;
+    clock_hz = PROBE_CLOCK_HZ;
+    applied_clock_hz = 0;
+    memset(&unregistered, 0, sizeof(unregistered));
+    unregistered.priority = PRIORITY_OTHER;
+    unregistered.max_clock_hz = PROBE_CLOCK_HZ;
+    unregistered.name = "other";
+}
+
+bool I2CScheduler::begin(UBaseType_t priority, BaseType_t core) {
+    i2c_clock.set(clock_hz);
+    if (task != nullptr) {
+        return true;
+    }
+    return xTaskCreatePinnedToCore(taskEntry, "i2c", 3072, this, priority, &task, core) == pdPASS;
+}
+
+bool I2CScheduler::addDevice(uint8_t address, Priority priority, uint32_t max_clock_hz, const char* name) {
+    if (device_count >= MAX_DEVICES) {
+        return false;
+    }
+    DeviceStats& d = devices[device_count++];
+    memset(&d, 0, sizeof(d));
+    d.address = address;
+    d.priority = priority;
+    d.max_clock_hz = max_clock_hz;
+    d.name = name;
+
+    // Applied by the next transfer, on the bus task
+    uint32_t slowest = MAX_CLOCK_HZ;
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i].max_clock_hz < slowest) {
+            slowest = devices[i].max_clock_hz;
+        }
+    }
+    clock_hz = slowest;
+    i2c_clock.set(clock_hz);
+    return true;
+}
+
+I2CScheduler::DeviceStats& I2CScheduler::statsFor(uint8_t address) {
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i].address == address) {
+            return devices[i];
+        }
+    }
+    return unregistered;
+}
+
+bool I2CScheduler::submit(Transaction& t) {
+    t.state = STATE_QUEUED;
+    t.queued_us = micros();
+    t.next = nullptr;
+
+    if (task == nullptr) {
+        execute(t);
+        return true;
+    }
+
+    Priority priority = statsFor(t.address).priority;
+    portENTER_CRITICAL(&lock);
+    if (queue_tail[priority] == nullptr) {
+        queue_head[priority] = &t;
+    } else {
+        queue_tail[priority]->next = &t;
+    }
+    queue_tail[priority] = &t;
+    uint32_t depth = ++queued;
+    portEXIT_CRITICAL(&lock);
+
+    if (depth > i2c_queue_max.get()) {
+        i2c_queue_max.set(depth);
+    }
+    xTaskNotifyGive(task);
+    return true;
+}
+
+I2CScheduler::Transaction* I2CScheduler::dequeue() {
+    Transaction* t = nullptr;
+    portENTER_CRITICAL(&lock);
+    for (int p = 0; p < PRIORITY_COUNT && t == nullptr; p++) {
+        if (queue_head[p] != nullptr) {
+            t = queue_head[p];
+            queue_head[p] = t->next;
+            if (queue_head[p] == nullptr) {
+                queue_tail[p] = nullptr;
+            }
+            queued--;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+    return t;
+}
+
+bool I2CScheduler::transfer(const Transaction& t) {
+    if (t.rx_len == 0) {
+        return bus.write(t.address, t.tx, t.tx_len);
+    }
+    if (t.tx_len == 0) {
+        return bus.read(t.address, t.rx, t.rx_len);
+    }
+    if (t.tx_len == 1) {
+        return bus.readRegister(t.address, t.tx[0], t.rx, t.rx_len);
+    }
+    return bus.write(t.address, t.tx, t.tx_len) && bus.read(t.address, t.rx, t.rx_len);
+}
+
+void I2CScheduler::execute(Transaction& t) {
+    DeviceStats& stats = statsFor(t.address);
+
+    uint32_t hz = &stats == &unregistered && clock_hz > PROBE_CLOCK_HZ ? PROBE_CLOCK_HZ : clock_hz;
+    if (hz != applied_clock_hz) {
+        bus.setClock(hz);
+        applied_clock_hz = hz;
+    }
+
+    bool ok = transfer(t);
+    if (!ok) {
+        stats.retries++;
+        i2c_retries.increment();
+        ok = transfer(t);
+    }
+    if (!ok) {
+        stats.errors++;
+        i2c_errors.increment();
+    }
+
+    uint32_t latency = micros() - t.queued_us;
+    stats.transactions++;
+    stats.bytes += t.tx_len + t.rx_len;
+    stats.latency_total_us += latency;
+    if (latency > stats.latency_max_us) {
+        stats.latency_max_us = latency;
+    }
+    i2c_transactions.increment();
+
+    t.state = ok ? STATE_DONE : STATE_FAILED;
+}
+
+bool I2CScheduler::wait(Transaction& t) {
+    // Wire's own timeout bounds every transfer, so this always returns.
+    // A stale notification just means one more trip round the loop.
+    while (t.state == STATE_QUEUED) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    return t.state == STATE_DONE;
+}
+
+bool I2CScheduler::runBlocking(Transaction& t) {
+    t.waiter = task != nullptr ? xTaskGetCurrentTaskHandle() : nullptr;
+    submit(t);
+    return wait(t);
+}
+
+bool I2CScheduler::write(uint8_t address, const uint8_t* data, size_t len) {
+    Transaction t = { address, data, len, nullptr, 0, STATE_IDLE, 0, nullptr, nullptr };
+    return runBlocking(t);
+}
+
+bool I2CScheduler::read(uint8_t address, uint8_t* out, size_t len) {
+    Transaction t = { address, nullptr, 0, out, len, STATE_IDLE, 0, nullptr, nullptr };
+    return runBlocking(t);
+}
+
+bool I2CScheduler::readRegister(uint8_t address, uint8_t reg, uint8_t* out, size_t len) {
+    Transaction t = { address, &reg, 1, out, len, STATE_IDLE, 0, nullptr, nullptr };
+    return runBlocking(t);
+}
+
+void I2CScheduler::taskEntry(void* param) {
+    I2CScheduler* self = static_cast<I2CScheduler*>(param);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Re-check the queues after every transaction so a higher priority
+        // request that arrived meanwhile goes next
+        Transaction* t;
+        while ((t = self->dequeue()) != nullptr) {
+            TaskHandle_t waiter = t->waiter;
+            self->execute(*t);
+            if (waiter != nullptr) {
+                xTaskNotifyGive(waiter);
+            }
+        }
+    }
+}
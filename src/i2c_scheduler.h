@@ -0,0 +1,113 @@
+#ifndef I2C_SCHEDULER_H
+#define I2C_SCHEDULER_H
+
+#include <Arduino.h>
+#include "i2c_bus.h"
+
+// Owns the sensor I2C bus and serialises every transaction through one
+// high-priority task, highest priority class first (IMU FIFO drains before
+// barometer reads before anything else), FIFO within a class. Failed
+// transfers are retried once. Per-device transaction counts, errors,
+// retries and latency (queued to completed) are kept for /i2c.
+//
+// Drivers use the blocking I2CBus calls, which queue a transaction and
+// sleep until the bus task has run it; submit() is the non-blocking form.
+// Until begin() starts the task, transactions run inline in the caller.
+class I2CScheduler : public I2CBus {
+public:
+    enum Priority {
+        PRIORITY_IMU = 0,
+        PRIORITY_BARO = 1,
+        PRIORITY_OTHER = 2,
+        PRIORITY_COUNT = 3
+    };
+
+    enum State {
+        STATE_IDLE,
+        STATE_QUEUED,
+        STATE_DONE,
+        STATE_FAILED
+    };
+
+    // One bus operation: an optional register/command write followed by an
+    // optional read (repeated start between them)
+    struct Transaction {
+        uint8_t address;
+        const uint8_t* tx;
+        size_t tx_len;
+        uint8_t* rx;
+        size_t rx_len;
+
+        volatile State state;
+        uint32_t queued_us;
+        TaskHandle_t waiter;
+        Transaction* next;
+    };
+
+    struct DeviceStats {
+        uint8_t address;
+        Priority priority;
+        uint32_t max_clock_hz;
+        const char* name;
+        uint32_t transactions;
+        uint32_t errors;
+        uint32_t retries;
+        uint32_t bytes;
+        uint32_t latency_max_us;
+        uint64_t latency_total_us;
+    };
+
+    static const int MAX_DEVICES = 8;
+    static const uint32_t MAX_CLOCK_HZ = 1000000;   // ESP32 I2C fast mode plus
+    static const uint32_t PROBE_CLOCK_HZ = 400000;  // Fast mode, for parts not yet known
+
+    explicit I2CScheduler(I2CBus& bus);
+
+    // Starts the bus task; 'core' should be the core running loop() so a
+    // queued transaction preempts the caller immediately
+    bool begin(UBaseType_t priority = 3, BaseType_t core = 1);
+
+    // Registers a device. The bus clock is the slowest registered device's
+    // limit (never above MAX_CLOCK_HZ), so it only goes past PROBE_CLOCK_HZ
+    // once every registered device supports it. Unregistered addresses -
+    // e.g. while probing - run as PRIORITY_OTHER, at PROBE_CLOCK_HZ at most.
+    bool addDevice(uint8_t address, Priority priority, uint32_t max_clock_hz, const char* name);
+
+    // Non-blocking: queues t and returns. Poll t.state, or set t.waiter to
+    // the calling task and wait() for it; t must stay alive until then.
+    bool submit(Transaction& t);
+    bool wait(Transaction& t);
+
+    bool write(uint8_t address, const uint8_t* data, size_t len) override;
+    bool read(uint8_t address, uint8_t* out, size_t len) override;
+    bool readRegister(uint8_t address, uint8_t reg, uint8_t* out, size_t len) override;
+
+    uint32_t getClockHz() const { return clock_hz; }
+    int getDeviceCount() const { return device_count; }
+    const DeviceStats& getDeviceStats(int index) const { return devices[index]; }
+
+private:
+    I2CBus& bus;
+    TaskHandle_t task;
+    portMUX_TYPE lock;
+
+    Transaction* queue_head[PRIORITY_COUNT];
+    Transaction* queue_tail[PRIORITY_COUNT];
+    uint32_t queued;
+
+    DeviceStats devices[MAX_DEVICES];
+    DeviceStats unregistered;   // Probes and unknown addresses
+    int device_count;
+    uint32_t clock_hz;          // For registered devices
+    uint32_t applied_clock_hz;  // Last set on the bus; 0 before the first transfer
+
+    DeviceStats& statsFor(uint8_t address);
+    Transaction* dequeue();
+    bool transfer(const Transaction& t);
+    void execute(Transaction& t);
+    bool runBlocking(Transaction& t);
+
+    static void taskEntry(void* param);
+};
+
+#endif // I2C_SCHEDULER_H
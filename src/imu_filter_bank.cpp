@@ -0,0 +1,132 @@
+#include "imu_filter_bank.h"
+#include "fixed_point.h"
+
+static_assert(ImuFilterBank::STREAM_COUNT == DECIMATION_STAGES, "One stream per decimation stage");
+
+// Samples go through the filters as Q15.16 - plenty for +-16 g and +-2048 dps
+typedef Fixed<16> ImuFx;
+
+ImuFilterBank::ImuFilterBank() {
+    input_hz = 0;
+    for (int s = 0; s < STREAM_COUNT; s++) {
+        subscriber_count[s] = 0;
+    }
+    reset();
+}
+
+void ImuFilterBank::setInputRate(uint32_t hz) {
+    input_hz = hz;
+    reset();
+}
+
+float ImuFilterBank::getRateHz(Stream stream) const {
+    float rate = input_hz;
+    for (int k = 0; k <= stream; k++) {
+        rate /= decimation_stages[k].factor;
+    }
+    return rate;
+}
+
+void ImuFilterBank::reset() {
+    for (int k = 0; k < DECIMATION_STAGES; k++) {
+        stages[k].pos = 0;
+        stages[k].phase = 0;
+        stages[k].primed = false;
+    }
+    for (int s = 0; s < STREAM_COUNT; s++) {
+        latest[s] = ImuSample();
+        output_count[s] = 0;
+    }
+}
+
+bool ImuFilterBank::subscribe(Stream stream, Handler handler) {
+    if (subscriber_count[stream] >= MAX_SUBSCRIBERS) {
+        return false;
+    }
+    subscribers[stream][subscriber_count[stream]++] = handler;
+    return true;
+}
+
+void ImuFilterBank::add(const ImuSample& sample) {
+    int32_t values[CHANNELS] = {
+        ImuFx::fromFloat(sample.accel_x).getRaw(),
+        ImuFx::fromFloat(sample.accel_y).getRaw(),
+        ImuFx::fromFloat(sample.accel_z).getRaw(),
+        ImuFx::fromFloat(sample.gyro_x).getRaw(),
+        ImuFx::fromFloat(sample.gyro_y).getRaw(),
+        ImuFx::fromFloat(sample.gyro_z).getRaw()
+    };
+
+    if (input_hz == 0) {
+        for (int s = 0; s < STREAM_COUNT; s++) {
+            publish(s, values, sample.time_us);
+        }
+        return;
+    }
+    push(0, values, sample.time_us);
+}
+
+void ImuFilterBank::push(int k, const int32_t values[CHANNELS], uint32_t time_us) {
+    const DecimationStageTable& table = decimation_stages[k];
+    const int taps = table.taps;
+    Stage& s = stages[k];
+
+    // The first sample fills the whole delay line, so there is no start-up
+    // transient from zeros
+    if (!s.primed) {
+        for (int i = 0; i < 2 * taps; i++) {
+            for (int c = 0; c < CHANNELS; c++) {
+                s.history[c][i] = values[c];
+            }
+            s.times[i] = time_us;
+        }
+        s.primed = true;
+    }
+
+    for (int c = 0; c < CHANNELS; c++) {
+        s.history[c][s.pos] = values[c];
+        s.history[c][s.pos + taps] = values[c];
+    }
+    s.times[s.pos] = time_us;
+    s.times[s.pos + taps] = time_us;
+    s.pos = s.pos + 1 == taps ? 0 : s.pos + 1;
+
+    if (++s.phase < table.factor) {
+        return;
+    }
+    s.phase = 0;
+
+    // history[c][pos .. pos + taps - 1] is now oldest to newest
+    int32_t out[CHANNELS];
+    for (int c = 0; c < CHANNELS; c++) {
+        const int32_t* x = &s.history[c][s.pos];
+        int64_t acc = 0;
+        for (int j = 0; j < taps; j++) {
+            acc += (int64_t)table.coeffs[j] * x[j];
+        }
+        out[c] = ImuFx::saturate((acc + (1 << (DECIMATION_COEFF_FRAC_BITS - 1))) >> DECIMATION_COEFF_FRAC_BITS);
+    }
+
+    // Linear phase: the output describes the sample at the centre tap
+    uint32_t centre_us = s.times[s.pos + taps / 2];
+    publish(k, out, centre_us);
+    if (k + 1 < DECIMATION_STAGES) {
+        push(k + 1, out, centre_us);
+    }
+}
+
+void ImuFilterBank::publish(int stream, const int32_t values[CHANNELS], uint32_t time_us) {
+    ImuSample& sample = latest[stream];
+    sample.time_us = time_us;
+    sample.accel_x = ImuFx::fromRaw(values[0]).toFloat();
+    sample.accel_y = ImuFx::fromRaw(values[1]).toFloat();
+    sample.accel_z = ImuFx::fromRaw(values[2]).toFloat();
+    sample.gyro_x = ImuFx::fromRaw(values[3]).toFloat();
+    sample.gyro_y = ImuFx::fromRaw(values[4]).toFloat();
+    sample.gyro_z = ImuFx::fromRaw(values[5]).toFloat();
+    output_count[stream]++;
+
+    for (int i = 0; i < subscriber_count[stream]; i++) {
+        subscribers[stream][i]((Stream)stream, sample);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef IMU_FILTER_BANK_H
+#define IMU_FILTER_BANK_H
+
+#include <stdint.h>
+#include "sensor_types.h"
+#include "decimation_filters.h"
+
+// Multi-rate decimation of the raw IMU stream.
+// A chain of polyphase FIR decimators (tables in decimation_filters.h,
+// generated by tools/gen_decimation_filters.py) turns the full-rate input
+// into anti-aliased streams at 1/5, 1/20 and 1/100 of the input rate - 100,
+// 25 and 5 Hz from the QMI8658 at 500 Hz. Each stage only evaluates its FIR
+// when an output is due, so the whole bank costs about 8 multiply-adds per
+// channel per input sample. Arithmetic is Q15.16 samples times Q15
+// coefficients in 64 bits, bit-exact like the rest of the pipeline.
+// Consumers either subscribe to a stream or read its latest sample. With an
+// input rate of 0 (unknown, e.g. the 5 Hz simulator fallback) every stream
+// passes the raw samples straight through.
+class ImuFilterBank {
+public:
+    enum Stream {
+        STREAM_LOG,       // Input / 5
+        STREAM_WEB,       // Input / 20
+        STREAM_DISPLAY,   // Input / 100
+        STREAM_COUNT
+    };
+
+    typedef void (*Handler)(Stream stream, const ImuSample& sample);
+
+    static const int MAX_SUBSCRIBERS = 4;
+
+    ImuFilterBank();
+
+    // Nominal input rate; 0 bypasses the filters
+    void setInputRate(uint32_t hz);
+    uint32_t getInputRate() const { return input_hz; }
+    float getRateHz(Stream stream) const;
+
+    void reset();
+    void add(const ImuSample& sample);
+
+    bool subscribe(Stream stream, Handler handler);
+    bool hasSample(Stream stream) const { return output_count[stream] > 0; }
+    const ImuSample& getLatest(Stream stream) const { return latest[stream]; }
+    uint32_t getOutputCount(Stream stream) const { return output_count[stream]; }
+
+private:
+    static const int CHANNELS = 6;   // accel x/y/z, gyro x/y/z
+
+    // Delay lines are written twice, taps apart, so the newest taps samples
+    // are always contiguous and the FIR needs no wrap handling
+    struct Stage {
+        int32_t history[CHANNELS][2 * DECIMATION_MAX_TAPS];
+        uint32_t times[2 * DECIMATION_MAX_TAPS];
+        uint8_t pos;
+        uint8_t phase;
+        bool primed;
+    };
+
+    Stage stages[DECIMATION_STAGES];
+    uint32_t input_hz;
+    ImuSample latest[STREAM_COUNT];
+    uint32_t output_count[STREAM_COUNT];
+    Handler subscribers[STREAM_COUNT][MAX_SUBSCRIBERS];
+    uint8_t subscriber_count[STREAM_COUNT];
+
+    void push(int stage, const int32_t values[CHANNELS], uint32_t time_us);
+    void publish(int stream, const int32_t values[CHANNELS], uint32_t time_us);
+};
+
+#endif // IMU_FILTER_BANK_H
@@ -1,72 +1,174 @@
 #include "imu_simulator.h"
+#include "deferred_log.h"
 #include <math.h>
 
+static const float HALF_PI = 1.5707963f;
+
+PhasorOscillator::PhasorOscillator(float amplitude, float omega, float phase) {
+    this->amplitude = amplitude;
+    this->omega = omega;
+    step_re = 1.0f;
+    step_im = 0.0f;
+    step_dt_us = 0;
+    reset(phase);
+}
+
+void PhasorOscillator::reset(float phase) {
+    re = cosf(phase);
+    im = sinf(phase);
+}
+
+float PhasorOscillator::next(uint32_t dt_us) {
+    if (dt_us != step_dt_us) {
+        float angle = omega * dt_us * 1.0e-6f;
+        step_re = cosf(angle);
+        step_im = sinf(angle);
+        step_dt_us = dt_us;
+    }
+
+    float new_re = re * step_re - im * step_im;
+    float new_im = re * step_im + im * step_re;
+
+    // Pull the phasor back onto the unit circle so rounding error never
+    // grows the amplitude, however many samples are generated
+    float gain = 1.5f - 0.5f * (new_re * new_re + new_im * new_im);
+    re = new_re * gain;
+    im = new_im * gain;
+
+    return amplitude * im;
+}
+
 IMUSimulator::IMUSimulator() {
-    accel_x = 0.0;
-    accel_y = 0.0;
-    accel_z = 1.0;  // 1g downward when stationary
-    gyro_x = 0.0;
-    gyro_y = 0.0;
-    gyro_z = 0.0;
-    last_update = 0;
+    // Very small amplitudes and slow frequencies, as on a real stationary device
+    accel_x_osc[0] = PhasorOscillator(0.05f, 0.2f);              // Very slow drift
+    accel_x_osc[1] = PhasorOscillator(0.02f, 1.1f);              // Small vibrations
+    accel_y_osc[0] = PhasorOscillator(0.04f, 0.15f, HALF_PI);
+    accel_y_osc[1] = PhasorOscillator(0.015f, 0.9f, HALF_PI);
+    accel_z_osc[0] = PhasorOscillator(0.03f, 0.3f);
+    accel_z_osc[1] = PhasorOscillator(0.01f, 2.1f);
+    gyro_x_osc = PhasorOscillator(0.5f, 0.1f);                   // Tiny pitch movements
+    gyro_y_osc = PhasorOscillator(0.3f, 0.12f, HALF_PI);         // Tiny roll movements
+    gyro_z_osc = PhasorOscillator(0.2f, 0.08f);                  // Tiny yaw movements
+    reseed(DEFAULT_SEED);
+
+    current.time_us = 0;
+    current.accel_x = 0.0;
+    current.accel_y = 0.0;
+    current.accel_z = 1.0;  // 1g downward when stationary
+    current.gyro_x = 0.0;
+    current.gyro_y = 0.0;
+    current.gyro_z = 0.0;
+    last_update_us = 0;
     initialized = false;
+    block_period_us = 0;
+    blocks_dropped = 0;
 }
 
 bool IMUSimulator::begin() {
-    // Simulate IMU initialization
-    delay(100);
-    
+    // Nothing to wait for - a real IMU would poll its WHO_AM_I register here
+
     // Always succeed for testing purposes
     // In real implementation, this would attempt to communicate with actual IMU
     initialized = true;  // Force success for testing
-    
+
     if (initialized) {
-        Serial.println("IMU Simulator: Initialized successfully");
-        last_update = millis();
+        DLOG(IMU_SIM_READY);
+        last_update_us = micros();
     } else {
-        Serial.println("IMU Simulator: Initialization failed (simulated)");
+        DLOG(IMU_SIM_FAILED);
     }
-    
+
     return initialized;
 }
 
+void IMUSimulator::reseed(uint32_t seed) {
+    noise.seedWith(seed);
+    sim_time_us = 0;
+    accel_x_osc[0].reset(0.0f);
+    accel_x_osc[1].reset(0.0f);
+    accel_y_osc[0].reset(HALF_PI);
+    accel_y_osc[1].reset(HALF_PI);
+    accel_z_osc[0].reset(0.0f);
+    accel_z_osc[1].reset(0.0f);
+    gyro_x_osc.reset(0.0f);
+    gyro_y_osc.reset(HALF_PI);
+    gyro_z_osc.reset(0.0f);
+}
+
+void IMUSimulator::generate(Sample* out, size_t n, uint32_t dt_us) {
+    for (size_t i = 0; i < n; i++) {
+        sim_time_us += dt_us;
+        Sample& s = out[i];
+        s.time_us = sim_time_us;
+
+        // Gaussian noise matched to the old uniform +-0.005 g / +-0.2 dps spread
+        s.accel_x = accel_x_osc[0].next(dt_us) + accel_x_osc[1].next(dt_us) + 0.003f * noise.gaussian();
+        s.accel_y = accel_y_osc[0].next(dt_us) + accel_y_osc[1].next(dt_us) + 0.003f * noise.gaussian();
+        s.accel_z = 1.0f + accel_z_osc[0].next(dt_us) + accel_z_osc[1].next(dt_us) + 0.002f * noise.gaussian();
+
+        s.gyro_x = gyro_x_osc.next(dt_us) + 0.1f * noise.gaussian();
+        s.gyro_y = gyro_y_osc.next(dt_us) + 0.1f * noise.gaussian();
+        s.gyro_z = gyro_z_osc.next(dt_us) + 0.05f * noise.gaussian();
+    }
+}
+
 bool IMUSimulator::update() {
     if (!initialized) {
         return false;
     }
-    
-    unsigned long now = millis();
-    if (now - last_update < 50) {  // Update at 20Hz
+
+    // One sample covering the time since the last call - no rate cap, so
+    // this keeps up with headless sampling
+    unsigned long now = micros();
+    uint32_t elapsed = now - last_update_us;
+    if (elapsed == 0) {
         return true;
     }
-    
-    last_update = now;
-    
-    // Generate realistic IMU data with minimal noise for stationary device
-    float time_sec = now / 1000.0;
-    
-    // Simulate very small movements that occur in real stationary devices
-    // Much smaller amplitudes and slower frequencies for realistic behavior
-    
-    // Simulate tiny lateral movements (X-axis) - typical sensor noise
-    accel_x = 0.05 * sin(time_sec * 0.2) +     // Very slow drift
-              0.02 * sin(time_sec * 1.1) +     // Small vibrations
-              (random(-5, 5) / 1000.0);        // Minimal noise ±0.005g
-    
-    // Simulate tiny forward/back movements (Y-axis)
-    accel_y = 0.04 * cos(time_sec * 0.15) +    // Very slow drift
-              0.015 * cos(time_sec * 0.9) +    // Small vibrations
-              (random(-5, 5) / 1000.0);        // Minimal noise ±0.005g
-    
-    // Simulate vertical movements (Z-axis) - gravity plus tiny variations
-    float vertical_variation = 0.03 * sin(time_sec * 0.3) + 
-                              0.01 * sin(time_sec * 2.1);  // Very small variations
-    accel_z = 1.0 + vertical_variation + (random(-3, 3) / 1000.0);  // 1g baseline + tiny variations
-    
-    // Simulate very small rotational movements (much more stable)
-    gyro_x = 0.5 * sin(time_sec * 0.1) + (random(-2, 2) / 10.0);   // Tiny pitch movements
-    gyro_y = 0.3 * cos(time_sec * 0.12) + (random(-2, 2) / 10.0);  // Tiny roll movements
-    gyro_z = 0.2 * sin(time_sec * 0.08) + (random(-1, 1) / 10.0);  // Tiny yaw movements
-    
+    last_update_us = now;
+
+    generate(&current, 1, elapsed);
+    current.time_us = now;  // Live samples are stamped with the device clock
+    return true;
+}
+
+void IMUSimulator::setBlockRate(uint32_t rate_hz) {
+    block_period_us = rate_hz > 0 ? 1000000 / rate_hz : 0;
+    blocks_dropped = 0;
+    last_update_us = micros();
+}
+
+size_t IMUSimulator::readBatch(ImuSample* out, size_t max) {
+    if (block_period_us == 0) {
+        return ImuSource::readBatch(out, max);
+    }
+    if (!initialized || max == 0) {
+        return 0;
+    }
+
+    unsigned long now = micros();
+    uint32_t due = (now - last_update_us) / block_period_us;
+    uint32_t limit = 1000000 / block_period_us;
+    if (due > limit) {
+        blocks_dropped += due - limit;
+        last_update_us += (due - limit) * block_period_us;
+        due = limit;
+    }
+    size_t n = due < max ? due : max;
+    generate(out, n, block_period_us);
+    for (size_t i = 0; i < n; i++) {
+        last_update_us += block_period_us;
+        out[i].time_us = last_update_us;
+    }
+    if (n > 0) {
+        current = out[n - 1];
+    }
+    return n;
+}
+
+bool IMUSimulator::read(ImuSample& out) {
+    if (!update()) {
+        return false;
+    }
+    out = current;
     return true;
-} 
\ No newline at end of file
+}
@@ -2,27 +2,80 @@
 #define IMU_SIMULATOR_H
 
 #include <Arduino.h>
+#include "sim_random.h"
+#include "sensor_source.h"
 
-class IMUSimulator {
+// Sine oscillator that rotates a unit phasor by a fixed angle per sample.
+// Costs four multiplies per sample instead of a sin() call; trig is only
+// evaluated when the sample period changes.
+class PhasorOscillator {
 private:
-    float accel_x, accel_y, accel_z;
-    float gyro_x, gyro_y, gyro_z;
-    unsigned long last_update;
+    float amplitude;
+    float omega;            // rad/s
+    float re, im;           // cos/sin of the current phase
+    float step_re, step_im; // cos/sin of omega * dt
+    uint32_t step_dt_us;
+
+public:
+    PhasorOscillator(float amplitude = 0.0f, float omega = 0.0f, float phase = 0.0f);
+
+    void reset(float phase);
+
+    // Advances by dt_us and returns amplitude * sin(phase)
+    float next(uint32_t dt_us);
+};
+
+class IMUSimulator : public ImuSource {
+public:
+    typedef ImuSample Sample;
+
+    static const uint32_t DEFAULT_SEED = 1;
+
+private:
+    // Stationary device: slow drift plus small vibrations on every axis
+    PhasorOscillator accel_x_osc[2];
+    PhasorOscillator accel_y_osc[2];
+    PhasorOscillator accel_z_osc[2];
+    PhasorOscillator gyro_x_osc;
+    PhasorOscillator gyro_y_osc;
+    PhasorOscillator gyro_z_osc;
+    SimRandom noise;
+    uint32_t sim_time_us;
+
+    Sample current;
+    unsigned long last_update_us;
     bool initialized;
-    
+    uint32_t block_period_us;   // 0: one sample per read
+    uint32_t blocks_dropped;
+
 public:
     IMUSimulator();
     bool begin();
     bool update();
-    
-    float getAccelX() { return accel_x; }
-    float getAccelY() { return accel_y; }
-    float getAccelZ() { return accel_z; }
-    float getGyroX() { return gyro_x; }
-    float getGyroY() { return gyro_y; }
-    float getGyroZ() { return gyro_z; }
-    
+    bool read(ImuSample& out) override;   // update() and return the new sample
+
+    // Pipeline stress mode: readBatch() hands over every sample due at rate_hz
+    // since the last call, as generate() blocks stamped on the device clock -
+    // like a FIFO IMU running at that rate. More than a second behind, the
+    // oldest samples are dropped and counted. 0 goes back to single samples.
+    void setBlockRate(uint32_t rate_hz);
+    size_t readBatch(ImuSample* out, size_t max) override;
+    uint32_t getDroppedSamples() const { return blocks_dropped; }
+
+    // Produces n consecutive samples dt_us apart. Output depends only on the
+    // seed and the sequence of calls, so it is reproducible at any rate.
+    void generate(Sample* out, size_t n, uint32_t dt_us);
+    void reseed(uint32_t seed);
+
+    float getAccelX() { return current.accel_x; }
+    float getAccelY() { return current.accel_y; }
+    float getAccelZ() { return current.accel_z; }
+    float getGyroX() { return current.gyro_x; }
+    float getGyroY() { return current.gyro_y; }
+    float getGyroZ() { return current.gyro_z; }
+    const Sample& getSample() { return current; }
+
     bool isAvailable() { return initialized; }
 };
 
-#endif // IMU_SIMULATOR_H 
\ No newline at end of file
+#endif // IMU_SIMULATOR_H
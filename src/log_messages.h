@@ -0,0 +1,129 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+#include <stdint.h>
+
+// Format string table for the deferred logger.
+// Only the message ID and the raw arguments are stored at the call site; the
+// text below is applied later by the log drain task, or offline by
+// tools/log_decode.py which parses this file. Append new messages at the end
+// so IDs in previously captured binary logs stay valid; a message that is no
+// longer logged keeps its entry, marked unused. Never edit a format in place:
+// old captures would decode with the new text and argument layout. Retire
+// the entry and append the new format instead.
+#define LOG_MESSAGES(X) \
+    X(DROPPED,              "[log] %u messages dropped") \
+    X(BANNER_RULE,          "========================================") \
+    X(BANNER_TITLE,         "    LOLIN S3 Mini Pro Altimeter v2.1") \
+    X(BANNER_MODE,          "*** PURE ALTIMETER MODE - NO TESTS ***") \
+    X(BANNER_APP,           "*** THIS IS THE MAIN ALTIMETER APP ***") \
+    X(BANNER_BOARD,         "Board: LOLIN S3 Mini Pro") \
+    X(BANNER_DISPLAY,       "Display: 0.85\" 128x128 TFT (ST7789)") \
+    X(BANNER_SENSOR,        "Sensor: BMP180 Pressure/Temperature") /* unused: replaced by BANNER_BAROMETERS */ \
+    X(BANNER_IMU,           "IMU: Simulated 6-DOF IMU") /* unused: replaced by BANNER_IMU_QMI8658 */ \
+    X(BUTTONS_READY,        "✓ Buttons initialized") \
+    X(LED_READY,            "✓ RGB LED initialized") \
+    X(TFT_INIT,             "Initializing TFT display...") \
+    X(TFT_READY,            "✓ TFT display initialized") \
+    X(BMP_INIT,             "Initializing BMP180 pressure sensor...") /* unused: replaced by BARO_PROBE */ \
+    X(BMP_READY,            "✓ BMP180 sensor initialized successfully") /* unused: replaced by BARO_READY */ \
+    X(BMP_PRESSURE,         "✓ Current pressure: %.2f hPa") \
+    X(BMP_ABS_ALTITUDE,     "✓ Absolute altitude: %.2f m above sea level") \
+    X(BMP_BASELINE,         "✓ Baseline pressure: %.2f hPa") \
+    X(BMP_MAX_INIT,         "✓ Max altitude initialized to: %.2f m") \
+    X(BMP_FAILED,           "✗ BMP180 sensor initialization failed!") /* unused: replaced by BARO_NOT_FOUND */ \
+    X(BMP_CHECK_WIRING,     "  Check connections: SDA→GPIO12, SCL→GPIO11") \
+    X(IMU_INIT,             "Initializing IMU simulator...") /* unused: replaced by IMU_START */ \
+    X(IMU_READY,            "✓ IMU simulator initialized successfully") /* unused: replaced by IMU_STARTED */ \
+    X(IMU_MAX_INIT,         "✓ Max acceleration initialized to: %.2fg (%c axis)") \
+    X(IMU_FAILED,           "✗ IMU simulator initialization failed!") /* unused: replaced by IMU_START_FAILED */ \
+    X(IMU_SIM_READY,        "IMU Simulator: Initialized successfully") \
+    X(IMU_SIM_FAILED,       "IMU Simulator: Initialization failed (simulated)") \
+    X(WIFI_INIT,            "Initializing WiFi and Web Server...") \
+    X(WIFI_READY,           "✓ WiFi and Web Server ready") \
+    X(WIFI_AP,              "✓ WiFi AP started") /* unused: replaced by WIFI_AP_SSID */ \
+    X(WIFI_IP,              "✓ IP: %u.%u.%u.%u") \
+    X(READY,                "🚀 ALTIMETER READY!") \
+    X(CONTROLS,             "Controls:") \
+    X(CONTROLS_A,           "  Button A (GPIO0)  - Reset max altitude & acceleration to zero") \
+    X(CONTROLS_B,           "  Button B (GPIO47) - Toggle display mode") /* unused: replaced by CONTROLS_B_HOLD */ \
+    X(CONTROLS_C,           "  Button C (GPIO48) - Toggle display on/off") \
+    X(BUTTON_A_RESET,       "Button A: Resetting max altitude and acceleration") \
+    X(MAX_ALT_RESET,        "✓ Max altitude reset to current: %.2f m") \
+    X(MAX_ACC_RESET,        "✓ Max acceleration reset to 0g") \
+    X(BUTTON_B_MODE,        "Button B: Display mode switched") \
+    X(BUTTON_C_ON,          "Button C: Display ON") \
+    X(BUTTON_C_OFF,         "Button C: Display OFF") \
+    X(STATUS,               "ALT: %.2fm (MAX: %.2fm) | ACC: %.2fg (MAX: %.2fg-%c) | TEMP: %.1f°C | PRESS: %.1f hPa") \
+    X(DEBUG_ALT,            "DEBUG ALT: pressure=%.0fPa, baseline=%.0fPa, current_altitude=%.2fm, max_altitude=%.2fm") \
+    X(DEBUG_ACC,            "DEBUG ACC: X=%.2fg, Y=%.2fg, Z=%.2fg, current_mag=%.2fg, max=%.2fg-%c") \
+    X(BOOT_STEP_FAILED,     "✗ Boot step %d failed after %u ms") \
+    X(BOOT_TFT_READY,       "✓ TFT display ready in %u ms") \
+    X(BOOT_BMP_READY,       "✓ BMP180 first reading in %u ms") /* unused: replaced by BOOT_BARO_READY */ \
+    X(BOOT_IMU_READY,       "✓ IMU ready in %u ms") \
+    X(BOOT_WIFI_STARTED,    "✓ WiFi bring-up started in background (%u ms)") /* unused: WiFi starts on demand */ \
+    X(BOOT_DONE,            "✓ Boot sequence %u ms, setup complete at %u ms") \
+    X(BOOT_FIRST_ALTITUDE,  "✓ First valid altitude at %u ms after power-on") \
+    X(CALIB_LOADED,         "✓ Cached baseline: %.2f hPa, %.1f m") \
+    X(CALIB_MISSING,        "No cached calibration - using first reading") \
+    X(CALIB_SAVED,          "✓ Baseline cached: %.2f hPa, %.1f m") \
+    X(CALIB_SAVE_FAILED,    "✗ Failed to cache calibration in NVS") \
+    X(NET_STARTED,          "✓ Network up in %u ms, free heap %u -> %u bytes") \
+    X(NET_STOPPED,          "Network stopped, free heap %u bytes") \
+    X(NET_BLOCKED,          "✗ Network start refused during flight") \
+    X(BUTTON_B_WIFI_ON,     "Button B (hold): WiFi ON") \
+    X(BUTTON_B_WIFI_OFF,    "Button B (hold): WiFi OFF") \
+    X(PHASE_PRELAUNCH,      "Flight phase: PRELAUNCH (%.1f m AGL)") \
+    X(PHASE_BOOST,          "Flight phase: BOOST (%.1f m AGL)") \
+    X(PHASE_COAST,          "Flight phase: COAST (%.1f m AGL)") \
+    X(PHASE_DESCENT,        "Flight phase: DESCENT (%.1f m AGL)") \
+    X(PHASE_LANDED,         "Flight phase: LANDED (%.1f m AGL)") \
+    X(HEADLESS_ON,          "Headless mode: display asleep, sampling every %u ms") \
+    X(HEADLESS_OFF,         "Headless mode off: display awake, sampling every %u ms") \
+    X(SAMPLE,               "S alt=%.2f p=%.1f t=%.2f ax=%.3f ay=%.3f az=%.3f") \
+    X(REPLAY_STARTED,       "Replay: started (real time: %d)") \
+    X(REPLAY_FAILED,        "✗ Replay: log file missing or invalid") \
+    X(REPLAY_FRAME,         "Replay frame %u at %u ms: %08x") \
+    X(REPLAY_DONE,          "Replay: done - baro=%u imu=%u max_alt=%.2f max_acc=%.3f frames=%u") \
+    X(BARO_DETECTED,        "✓ Barometer type %u (1=BMP180 2=BMP3xx 3=MS5611), FIFO: %d") \
+    X(IMU_DETECTED,         "✓ QMI8658 IMU at 0x%02x, FIFO at %u Hz") \
+    X(IMU_FALLBACK,         "IMU: no QMI8658 found, using the simulator") \
+    X(HISTORY_READY,        "✓ Graph history: %u KB in PSRAM") \
+    X(HISTORY_FAILED,       "✗ Graph history: no PSRAM for %u KB, graphs disabled") \
+    X(RECORDING_READY,      "✓ Flight recording: %u KB in PSRAM") \
+    X(RECORDING_FAILED,     "✗ Flight recording: no PSRAM for %u KB, recording disabled") \
+    X(RECORDING_STOPPED,    "Flight recording stopped: %u IMU + %u barometer samples in %u KB") \
+    X(LOGS_READY,           "✓ Flight logs: %u stored, %u KB free") /* unused: replaced by LOGS_STORED */ \
+    X(LOGS_FAILED,          "✗ Flight logs: LittleFS unavailable, flights will not be saved") /* unused: replaced by LOGS_NO_PARTITION */ \
+    X(ARCHIVE_SAVED,        "✓ Flight %u saved: %u KB") \
+    X(ARCHIVE_FAILED,       "✗ Flight %u: saving the flight log failed") \
+    X(ARCHIVE_DELETED,      "Flight log %u deleted to make room") /* unused: the segment store recycles the oldest */ \
+    X(SUMMARY_READY,        "✓ Flight %u: apogee %.1f m, %.2f g max (summarised from flash in %u ms)") \
+    X(SUMMARY_FAILED,       "✗ Flight %u: log could not be summarised") \
+    X(IMU_STRESS_STARTED,   "IMU stress: simulated %u Hz IMU blocks into the pipeline") \
+    X(IMU_STRESS_REPORT,    "IMU stress: %u samples/s processed, %.2f us per sample, %u dropped") \
+    X(BANNER_BAROMETERS,    "Sensor: BMP180/BMP388/BMP390/MS5611 barometer") \
+    X(BANNER_IMU_QMI8658,   "IMU: QMI8658C 6-axis (simulator fallback)") \
+    X(BARO_PROBE,           "Probing I2C for a barometer...") \
+    X(BARO_READY,           "✓ Barometer initialized successfully") \
+    X(BARO_NOT_FOUND,       "✗ No supported barometer found!") \
+    X(BOOT_BARO_READY,      "✓ Barometer first reading in %u ms") \
+    X(IMU_START,            "Initializing IMU...") \
+    X(IMU_STARTED,          "✓ IMU initialized successfully") \
+    X(IMU_START_FAILED,     "✗ IMU initialization failed!") \
+    X(WIFI_AP_SSID,         "✓ WiFi AP: %s") \
+    X(CONTROLS_B_HOLD,      "  Button B (GPIO47) - Toggle display mode (hold 2 s: WiFi on/off)") \
+    X(LOGS_STORED,          "✓ Flight logs: %u stored (%u cut short) in %u KB") \
+    X(LOGS_NO_PARTITION,    "✗ Flight logs: no flightlog partition, flights will not be saved")
+
+enum LogMessageId : uint16_t {
+#define LOG_MESSAGE_ENUM(id, fmt) LOG_##id,
+    LOG_MESSAGES(LOG_MESSAGE_ENUM)
+#undef LOG_MESSAGE_ENUM
+    LOG_MESSAGE_COUNT
+};
+
+// Returns the format string for a message ID, or nullptr if unknown
+const char* getLogFormat(uint16_t msg_id);
+
+#endif // LOG_MESSAGES_H
@@ -1,6 +1,5 @@
 #include <Arduino.h>
 #include <Adafruit_NeoPixel.h>
-#include <Adafruit_BMP085.h>
 #include <Wire.h>
 #include <WiFi.h>
 #include <AsyncTCP.h>
@@ -8,7 +7,30 @@
 #include "tft_test.h"
 #include "simple_font.h"
 #include "imu_simulator.h"
+#include "qmi8658_imu.h"
 #include "altimeter_display.h"
+#include "deferred_log.h"
+#include "metrics.h"
+#include "boot_sequencer.h"
+#include "calibration_cache.h"
+#include "flight_phase.h"
+#include "network_manager.h"
+#include "flight_simulator.h"
+#include "sensor_pipeline.h"
+#include "wire_bus.h"
+#include "i2c_scheduler.h"
+#include "barometer.h"
+#include "replay_source.h"
+#include "history_json.h"
+#include "flight_archive.h"
+#include "flight_recorder.h"
+#include "http_range.h"
+#include "partition_flash.h"
+#include "web_json.h"
+#include <memory>
+#ifdef REPLAY_FILE
+#include <LittleFS.h>
+#endif
 
 // --- PIN DEFINITIONS ---
 #define BUTTON_A_PIN 0
@@ -18,6 +40,7 @@
 #define RGB_POWER 7
 #define TFT_BL 33
 #define BATTERY_PIN 1  // ADC pin for battery voltage monitoring
+#define IMU_INT_PIN -1  // GPIO wired to the QMI8658 INT2 pin, -1 to poll the FIFO instead
 
 // --- WIFI CONFIGURATION ---
 const char* wifi_ssid = "Altimeter-S3";
@@ -26,33 +49,68 @@ const char* wifi_hostname = "altimeter";
 
 // --- GLOBAL OBJECTS ---
 Adafruit_NeoPixel pixels(1, RGB_DATA, NEO_GRB + NEO_KHZ800);
-Adafruit_BMP085 bmp;
-IMUSimulator imu;
+WireBus wire_bus(Wire);
+I2CScheduler i2c_bus(wire_bus);  // Every sensor transaction goes through here
+Qmi8658Imu qmi(i2c_bus, IMU_INT_PIN);
+IMUSimulator imu;  // Fallback when no QMI8658 answers
 TFTTest tft;
 AsyncWebServer server(80);
 AltimeterDisplay display(&tft);  // Add display instance
+BootSequencer boot;
+CalibrationCache calibration;
+NetworkManager network(wifi_ssid, wifi_password, wifi_hostname);
+FlightSimulator sensor_sim;  // Stands in for missing sensors
+Barometer* barometer = nullptr;  // Whichever part detectBarometer() finds
 
-// --- ALTIMETER STATE ---
-float current_altitude = 0.0;
-float max_altitude = 0.0;
-float baseline_pressure = 101325.0;  // Sea level pressure in Pascals
-float baseline_altitude = 0.0;       // Baseline altitude offset for zeroing
-float temperature = 0.0;
-float pressure = 0.0;
+// --- SENSOR PIPELINE ---
+// All sensor processing happens in the pipeline; its state is what the
+// display, web UI and logs show
+SensorPipeline pipeline;
+const SensorState& sensors = pipeline.getState();
+FlightPhaseDetector& flight_phase = pipeline.getPhaseDetector();
+BaroSource* baro_source = &sensor_sim;  // Replaced by the barometer or a replay at boot
+ImuSource* imu_source = &sensor_sim;
+ImuSource* imu_device = &imu;  // The QMI8658 if found, else the IMU simulator
+
+// --- GRAPH HISTORY ---
+// Altitude, vertical speed and acceleration at four resolutions for the
+// HIST screen; the ~500 KB of buckets go in PSRAM
+HistoryPyramid history;
+
+// --- FLIGHT RECORDING ---
+// Every sample is recorded in PSRAM until landing, then saved to the raw
+// "flightlog" partition (partitions.csv) a block per loop(); see
+// flight_recorder.h. Logs are listed at /logs, summarised in place from
+// the memory-mapped partition at /logs/summary and, a few blocks per
+// loop() after the save, on the display's LAST screen, and streamed by /logs/download with Range support. The web
+// server runs in its own task, so it holds recorder.lock() around store
+// access.
+FlightRecorder recorder;
+PartitionFlash flight_log_flash;
+
+// --- REPLAY ---
+// Build with -DREPLAY_FILE=\"/littlefs/flight.ttfl\" to feed a recorded flight
+// log through the pipeline instead of the sensors (add -DREPLAY_FAST to run
+// it as fast as possible rather than in real time)
+FlightRecordReader replay_reader;
+ReplaySource replay;
+bool replay_active = false;
+uint32_t replay_frames = 0;
+
+// --- GROUND REFERENCE ---
+const int baseline_sample_count = 10;        // Readings averaged into the baseline after boot
+const float baseline_stale_threshold = 200.0; // Pa (~17 m) - cached baseline from another site
 
 // --- BATTERY STATE ---
 float battery_voltage = 0.0;
 int battery_percentage = 0;
 
-// --- ACCELERATION STATE ---
-float current_acceleration = 0.0;
-float max_acceleration = 0.0;
-char max_acceleration_axis = 'Z';  // Track which axis had the max acceleration
-float accel_x = 0.0, accel_y = 0.0, accel_z = 0.0;
-float gyro_x = 0.0, gyro_y = 0.0, gyro_z = 0.0;  // Gyroscope data
-
 // --- DISPLAY STATE ---
 bool display_enabled = true;
+bool display_before_flight = true;     // Restored on landing
+volatile bool display_toggle_requested = false;  // Set by /toggle, handled in loop()
+volatile bool reset_requested = false;           // Set by /reset, handled in loop()
+bool headless = false;                 // Display asleep, sampling flat out
 int display_mode = 0;  // 0=Main, 1=Detailed
 bool needs_full_refresh = true;
 
@@ -74,9 +132,29 @@ unsigned long last_button_press = 0;
 const unsigned long button_debounce = 200;
 bool button_a_pressed = false;
 bool button_b_pressed = false;
+unsigned long button_b_down_since = 0;
+bool button_b_hold_handled = false;
+const unsigned long wifi_toggle_hold = 2000;  // Hold Button B this long to toggle WiFi
 bool button_c_pressed = false;
 
+// --- SIMULATION ---
+// Build with -DSIMULATE_FLIGHT to fly the model rocket profile (launch 10 s
+// after boot) whenever the barometer is missing; otherwise the simulator
+// just idles on the ground
+const uint32_t sim_seed = 1;
+// Build with -DIMU_STRESS_HZ=<rate> to stress the pipeline: the IMU simulator
+// replaces the QMI8658 and hands over generate() blocks at that rate, and
+// the throughput is logged every 5 s. Run it with the display off (Button C)
+// to measure the headless sample path.
+
 // --- TIMING ---
+const unsigned long display_sensor_interval = 200;  // 5Hz sensor updates while the display is on
+const unsigned long headless_min_interval = 10;     // Upper bound of 100Hz when headless
+const uint16_t imu_odr_hz = 500;                    // QMI8658 rate: its 128-sample FIFO covers a 200 ms display-mode poll
+unsigned long sensor_interval = display_sensor_interval;
+const size_t baro_batch_size = 16;  // A BMP3xx FIFO fills 10 samples per 200 ms at 50 Hz
+const size_t imu_batch_size = Qmi8658Imu::FIFO_SAMPLES;  // A full QMI8658 FIFO
+unsigned long sensor_update_us = 0;  // Smoothed duration of one updateSensors() call
 unsigned long last_sensor_update = 0;
 unsigned long last_display_update = 0;
 unsigned long last_battery_update = 0;
@@ -85,19 +163,61 @@ unsigned long last_battery_update = 0;
 bool bmp_available = false;
 bool imu_available = false;
 bool system_ready = false;
+bool first_altitude_recorded = false;
+bool error_screen_active = false;
+unsigned long error_screen_start = 0;
+
+// --- METRICS ---
+Counter loop_iterations("altimeter_loop_iterations_total", "Main loop iterations");
+Gauge loop_frequency("altimeter_loop_frequency_hz", "Main loop iterations per second");
+Counter sensor_samples("altimeter_sensor_samples_total", "Sensor update cycles completed");
+Gauge sensor_rate_achieved("altimeter_sensor_rate_hz", "Achieved sensor sample rate");
+Gauge sensor_rate_requested("altimeter_sensor_rate_target_hz", "Requested sensor sample rate");
+Gauge headless_active("altimeter_headless_active", "1 while the display is asleep and sampling runs at full rate");
+Gauge sensor_update_time("altimeter_sensor_update_us", "Smoothed time taken by one sensor update");
+Counter spi_bytes("altimeter_spi_bytes_total", "Bytes sent to the TFT over SPI");
+Gauge spi_bytes_per_frame("altimeter_spi_bytes_per_frame", "SPI bytes sent by the last display update");
+Counter web_requests("altimeter_web_requests_total", "HTTP requests served");
+Gauge wifi_clients("altimeter_wifi_clients", "Stations connected to the softAP");
+Gauge boot_setup_time("altimeter_boot_setup_ms", "Time from power-on to the end of setup()");
+Counter baro_spikes("altimeter_baro_spikes_total", "Barometer pressure spikes replaced or dropped");
+Gauge boot_first_altitude("altimeter_boot_first_altitude_ms", "Time from power-on to the first valid altitude");
+Gauge flight_log_erase_min("altimeter_flight_log_erase_count_min", "Fewest erases of any flight log segment");
+Gauge flight_log_erase_max("altimeter_flight_log_erase_count_max", "Most erases of any flight log segment");
 
 // --- FUNCTION PROTOTYPES ---
 void handleButtons();
 void updateSensors();
 void updateDisplay();
 void updateStatusLED();
-void setupWiFi();
+void updateRuntimeMetrics(unsigned long now);
+void collectScrapeMetrics();
+void onPipelineEvent(const SensorPipeline::Event& event);
+void recordFirstAltitude();
+void onDisplayImuSample(ImuFilterBank::Stream stream, const ImuSample& sample);
+bool parseFlightLogName(const char* name, uint32_t& flight);
+String getFlightLogsJSON();
+uint32_t sensorClock();
+bool startReplay();
+void setDisplayPower(bool on);
+void updateAcquisitionMode();
+void updateSensorInterval();
+bool bootStartDisplay();
+bool bootPollDisplay();
+bool bootStartBarometer();
+bool bootPollBarometer();
+bool bootStartIMU();
+void applyNetworkPolicy(FlightPhase phase);
 void setupWebServer();
+void startWebServer();
+void stopWebServer();
 void drawText(int x, int y, const char* text, uint16_t color);
 void drawNumber(int x, int y, float value, int decimals, uint16_t color);
 void drawMainDisplay();
 void drawDetailedDisplay();
-String getAltimeterJSON();
+AltimeterStatus getAltimeterStatus();
+String getI2CJSON();
+uint32_t parseHistoryTime(const String& value, uint32_t newest_ms);
 void updateBattery();
 float readBatteryVoltage();
 int calculateBatteryPercentage(float voltage);
@@ -105,24 +225,27 @@ int calculateBatteryPercentage(float voltage);
 void setup() {
   Serial.begin(115200);
   Wire.begin(12, 11);
-  delay(500);
-
-  Serial.println("========================================");
-  Serial.println("    LOLIN S3 Mini Pro Altimeter v2.1");
-  Serial.println("========================================");
-  Serial.println("*** PURE ALTIMETER MODE - NO TESTS ***");
-  Serial.println("*** THIS IS THE MAIN ALTIMETER APP ***");
-  Serial.println("Board: LOLIN S3 Mini Pro");
-  Serial.println("Display: 0.85\" 128x128 TFT (ST7789)");
-  Serial.println("Sensor: BMP180 Pressure/Temperature");
-  Serial.println("IMU: Simulated 6-DOF IMU");
-  Serial.println("========================================");
+  i2c_bus.begin();  // Bus task; probes run at 400 kHz, registered devices at the slowest one's limit
+
+  // Diagnostics are formatted and written by a low-priority task from here on
+  dlog.begin(&Serial);
+
+  DLOG(BANNER_RULE);
+  DLOG(BANNER_TITLE);
+  DLOG(BANNER_RULE);
+  DLOG(BANNER_MODE);
+  DLOG(BANNER_APP);
+  DLOG(BANNER_BOARD);
+  DLOG(BANNER_DISPLAY);
+  DLOG(BANNER_BAROMETERS);
+  DLOG(BANNER_IMU_QMI8658);
+  DLOG(BANNER_RULE);
 
   // Initialize buttons
   pinMode(BUTTON_A_PIN, INPUT_PULLUP);
   pinMode(BUTTON_B_PIN, INPUT_PULLUP);
   pinMode(BUTTON_C_PIN, INPUT_PULLUP);
-  Serial.println("✓ Buttons initialized");
+  DLOG(BUTTONS_READY);
 
   // Initialize RGB LED
   pinMode(RGB_POWER, OUTPUT);
@@ -130,73 +253,69 @@ void setup() {
   pixels.begin();
   pixels.setPixelColor(0, pixels.Color(255, 255, 0)); // Yellow - initializing
   pixels.show();
-  Serial.println("✓ RGB LED initialized");
+  DLOG(LED_READY);
 
-  // Initialize TFT display
-  Serial.println("Initializing TFT display...");
-  tft.begin();
-  
-  // Initialize backlight control
-  pinMode(TFT_BL, OUTPUT);
-  digitalWrite(TFT_BL, HIGH);  // Start with display on
-  
-  Serial.println("✓ TFT display initialized");
+  // Graph history in PSRAM; without it the pipeline and display just skip it
+  size_t history_bytes = HistoryPyramid::requiredBytes();
+  if (history.begin(ps_malloc(history_bytes), history_bytes)) {
+    pipeline.setHistory(&history);
+    display.setHistory(&history);
+    DLOG(HISTORY_READY, (unsigned)(history_bytes / 1024));
+  } else {
+    DLOG(HISTORY_FAILED, (unsigned)(history_bytes / 1024));
+  }
 
-  // Initialize display
-  tft.fillScreen(COLOR_BACKGROUND);
-  drawText(10, 50, "INITIALIZING...", COLOR_TEXT);
-  
-  // Initialize the AltimeterDisplay
-  display.begin();
+  recorder.begin();
+  bool partition = flight_log_flash.begin("flightlog");
+  recorder.beginLogs(partition ? &flight_log_flash : nullptr, flight_log_flash.map());
+  display.setFlightSummary(recorder.getLastSummary());
 
-  // Initialize BMP180 sensor
-  Serial.println("Initializing BMP180 pressure sensor...");
-  bmp_available = bmp.begin();
-  if (bmp_available) {
-    Serial.println("✓ BMP180 sensor initialized successfully");
-    
-    // Take initial pressure reading for reference
-    delay(1000); // Wait for sensor to stabilize
-    float current_pressure_pa = bmp.readPressure();
-    float current_pressure_hpa = current_pressure_pa / 100.0;
-    
-    // Calculate absolute altitude using standard sea level pressure
-    float absolute_altitude = bmp.readAltitude(101325.0);  // Use standard sea level pressure
-    
-    // Set baseline for relative measurements (if needed)
-    baseline_pressure = current_pressure_pa;
-    baseline_altitude = absolute_altitude;
-    
-    // Initialize current and max altitude
-    current_altitude = absolute_altitude;
-    max_altitude = absolute_altitude;
-    
-    Serial.printf("✓ Current pressure: %.2f hPa\n", current_pressure_hpa);
-    Serial.printf("✓ Absolute altitude: %.2f m above sea level\n", absolute_altitude);
-    Serial.printf("✓ Baseline pressure: %.2f hPa\n", baseline_pressure / 100.0);
-    Serial.printf("✓ Max altitude initialized to: %.2f m\n", max_altitude);
+  // Cached ground reference gives a usable altitude before the first reading
+  pipeline.setEventHandler(onPipelineEvent);
+  CalibrationData cal;
+  if (calibration.load(cal)) {
+    pipeline.setGroundReference(cal.baseline_pressure, cal.baseline_altitude);
+    pipeline.seed(cal.baseline_pressure, cal.temperature);
+    DLOG(CALIB_LOADED, cal.baseline_pressure / 100.0f, cal.baseline_altitude);
   } else {
-    Serial.println("✗ BMP180 sensor initialization failed!");
-    Serial.println("  Check connections: SDA→GPIO12, SCL→GPIO11");
+    DLOG(CALIB_MISSING);
   }
 
-  // Initialize IMU simulator
-  Serial.println("Initializing IMU simulator...");
-  imu_available = imu.begin();
-  if (imu_available) {
-    Serial.println("✓ IMU simulator initialized successfully");
-    
-    // Initialize max acceleration with a reasonable starting value
-    // Since gravity is ~1g, we expect at least that much in Z-axis
-    max_acceleration = 1.0;  // Start with 1g baseline
-    max_acceleration_axis = 'Z';
-    Serial.printf("✓ Max acceleration initialized to: %.2fg (%c axis)\n", max_acceleration, max_acceleration_axis);
-  } else {
-    Serial.println("✗ IMU simulator initialization failed!");
-    // Still initialize max acceleration for fallback simulation
-    max_acceleration = 1.0;
-    max_acceleration_axis = 'Z';
+  // Independent steps run concurrently: the TFT reset/sleep-out waits overlap
+  // the barometer bring-up. WiFi stays off until a Button B hold or landing
+  boot.addStep(LOG_BOOT_TFT_READY, bootStartDisplay, bootPollDisplay, 1000);
+  boot.addStep(LOG_BOOT_BARO_READY, bootStartBarometer, bootPollBarometer, 1000);
+  boot.addStep(LOG_BOOT_IMU_READY, bootStartIMU, nullptr, 0);
+  boot.run();
+
+#ifdef SIMULATE_FLIGHT
+  sensor_sim.begin(FlightProfile::modelRocket(), sim_seed);
+#else
+  sensor_sim.begin(FlightProfile::groundIdle(), sim_seed);
+#endif
+  sensor_sim.setClock(sensorClock);
+
+  // Missing sensors are replaced by one simulated flight, so the baro and IMU
+  // streams stay consistent with each other
+  if (bmp_available && imu_available) {
+    baro_source = barometer;
+    imu_source = imu_device;
   }
+#ifdef IMU_STRESS_HZ
+  imu_source = &imu;
+#endif
+  if (startReplay()) {
+    baro_source = &replay;
+    imu_source = &replay;
+  }
+
+  // The network stack stays off until requested (Button B hold, or landing)
+  setupWebServer();
+  network.begin(startWebServer, stopWebServer);
+  applyNetworkPolicy(flight_phase.getPhase());
+
+  // Initialize the AltimeterDisplay
+  display.begin();
 
   // Set LED color based on sensor status
   if (bmp_available && imu_available) {
@@ -209,43 +328,203 @@ void setup() {
     drawText(10, 40, "SENSOR ERROR", COLOR_STATUS_ERROR);
     drawText(10, 60, "CHECK SENSORS", COLOR_STATUS_ERROR);
     drawText(10, 80, "CONNECTIONS", COLOR_STATUS_ERROR);
-    delay(3000);
+    // Held by loop() instead of blocking boot for 3 s
+    error_screen_active = true;
+    error_screen_start = millis();
   }
   pixels.show();
 
-  // Initialize WiFi and Web Server
-  Serial.println("Initializing WiFi and Web Server...");
-  setupWiFi();
-  setupWebServer();
-  Serial.println("✓ WiFi and Web Server ready");
-
   // System ready
   system_ready = true;
   needs_full_refresh = true;
   
-  Serial.println("========================================");
-  Serial.println("🚀 ALTIMETER READY!");
-  Serial.println("========================================");
-  Serial.println("Controls:");
-  Serial.println("  Button A (GPIO0)  - Reset max altitude & acceleration to zero");
-  Serial.println("  Button B (GPIO47) - Toggle display mode");
-  Serial.println("  Button C (GPIO48) - Toggle display on/off");
-  Serial.println("========================================");
+  DLOG(BANNER_RULE);
+  DLOG(READY);
+  DLOG(BANNER_RULE);
+  DLOG(CONTROLS);
+  DLOG(CONTROLS_A);
+  DLOG(CONTROLS_B_HOLD);
+  DLOG(CONTROLS_C);
+  DLOG(BANNER_RULE);
+
+  sensor_rate_requested.set(1000.0f / sensor_interval);
+  boot_setup_time.set(millis());
+  DLOG(BOOT_DONE, boot.getTotalDuration(), millis());
 
   last_sensor_update = millis();
   last_display_update = millis();
 }
 
+// --- BOOT STEPS ---
+bool bootStartDisplay() {
+  DLOG(TFT_INIT);
+  tft.startInit();
+  return true;
+}
+
+bool bootPollDisplay() {
+  // Done once initialised, even if a sleep() during init put it straight to sleep
+  return tft.pollInit() || tft.isSleeping();
+}
+
+bool bootStartBarometer() {
+  DLOG(BARO_PROBE);
+  barometer = detectBarometer(i2c_bus);
+  bmp_available = barometer != nullptr;
+  if (!bmp_available) {
+    DLOG(BARO_NOT_FOUND);
+    DLOG(BMP_CHECK_WIRING);
+    return false;
+  }
+  DLOG(BARO_DETECTED, (unsigned)barometer->getType(), barometer->hasFifo());
+  i2c_bus.addDevice(barometer->getAddress(), I2CScheduler::PRIORITY_BARO, barometer->getMaxClockHz(),
+                    barometer->getName());
+  return true;
+}
+
+bool bootPollBarometer() {
+  // begin() already started converting; the first plausible reading is
+  // the readiness check (replaces the old fixed 1 s wait)
+  BaroSample first;
+  if (!barometer->read(first) || !isPlausibleBaroReading(first.temperature_c, first.pressure_pa)) {
+    return false;
+  }
+
+  pipeline.seed(first.pressure_pa, first.temperature_c);
+  recordFirstAltitude();
+
+  // A cached baseline from somewhere else is useless - start over from this reading
+  if (!calibration.isValid() || fabs(first.pressure_pa - sensors.baseline_pressure) > baseline_stale_threshold) {
+    pipeline.setGroundReference(first.pressure_pa, sensors.current_altitude);
+  }
+  pipeline.refineGroundReference(baseline_sample_count);  // Averaged by the pipeline from here on
+
+  DLOG(BARO_READY);
+  DLOG(BMP_PRESSURE, first.pressure_pa / 100.0f);
+  DLOG(BMP_ABS_ALTITUDE, sensors.current_altitude);
+  DLOG(BMP_BASELINE, sensors.baseline_pressure / 100.0f);
+  DLOG(BMP_MAX_INIT, sensors.max_altitude);
+  return true;
+}
+
+bool bootStartIMU() {
+  DLOG(IMU_START);
+#ifdef IMU_STRESS_HZ
+  // Stress build: the simulator stands in for the QMI8658 at IMU_STRESS_HZ
+  imu_available = imu.begin();
+  imu.setBlockRate(IMU_STRESS_HZ);
+  pipeline.getImuStreams().setInputRate(IMU_STRESS_HZ);
+  DLOG(IMU_STRESS_STARTED, (unsigned)IMU_STRESS_HZ);
+#else
+  if (qmi.begin(imu_odr_hz)) {
+    imu_device = &qmi;
+    imu_available = true;
+    i2c_bus.addDevice(qmi.getAddress(), I2CScheduler::PRIORITY_IMU, Qmi8658Imu::MAX_CLOCK_HZ, "QMI8658");
+    DLOG(IMU_DETECTED, qmi.getAddress(), 1000000 / qmi.getSamplePeriodUs());
+    pipeline.getImuStreams().setInputRate(1000000 / qmi.getSamplePeriodUs());
+  } else {
+    DLOG(IMU_FALLBACK);
+    imu_available = imu.begin();
+  }
+#endif
+
+  // Initialize max acceleration with a reasonable starting value
+  // Since gravity is ~1g, we expect at least that much in Z-axis
+  pipeline.resetMaxAcceleration(1.0);  // Start with 1g baseline
+  pipeline.getImuStreams().subscribe(ImuFilterBank::STREAM_DISPLAY, onDisplayImuSample);
+
+  if (imu_available) {
+    DLOG(IMU_STARTED);
+    DLOG(IMU_MAX_INIT, sensors.max_acceleration, sensors.max_acceleration_axis);
+  } else {
+    DLOG(IMU_START_FAILED);  // Fallback simulation still runs in updateSensors()
+  }
+  return true;
+}
+
+// The display reads the decimated stream: at 2 Hz, raw snapshots would
+// alias vibration into the readings
+void onDisplayImuSample(ImuFilterBank::Stream stream, const ImuSample& sample) {
+  display.setIMUData(sample.accel_x, sample.accel_y, sample.accel_z, sample.gyro_x, sample.gyro_y, sample.gyro_z);
+}
+
+void recordFirstAltitude() {
+  if (!first_altitude_recorded) {
+    first_altitude_recorded = true;
+    boot_first_altitude.set(millis());
+    DLOG(BOOT_FIRST_ALTITUDE, millis());
+  }
+}
+
+uint32_t sensorClock() {
+  return micros();
+}
+
+bool startReplay() {
+#ifdef REPLAY_FILE
+  if (!LittleFS.begin()) {
+    DLOG(REPLAY_FAILED);
+    return false;
+  }
+  FILE* log_file = fopen(REPLAY_FILE, "rb");
+  if (log_file == nullptr || !replay_reader.openFile(log_file)) {
+    DLOG(REPLAY_FAILED);
+    return false;
+  }
+#ifdef REPLAY_FAST
+  replay.begin(&replay_reader, false);
+#else
+  replay.begin(&replay_reader, true);
+#endif
+  
+  // Start from a clean pipeline so the run only depends on the log
+  pipeline.reset();
+  pipeline.refineGroundReference(baseline_sample_count);
+  pipeline.resetMaxAcceleration(1.0);
+  tft.setOutputHashing(true);
+  replay_active = true;
+  DLOG(REPLAY_STARTED, replay.isRealTime() ? 1 : 0);
+  return true;
+#else
+  return false;
+#endif
+}
+
 void loop() {
   unsigned long now = millis();
   
   // Handle button inputs
   handleButtons();
   
+  // Toggle requested over the web - applied here so SPI is only driven from loop()
+  if (display_toggle_requested) {
+    display_toggle_requested = false;
+    setDisplayPower(!display_enabled);
+  }
+
+  // Reset requested over the web - applied here, between batches, since
+  // processBatch() updates the maxima and peak trackers on every sample
+  if (reset_requested) {
+    reset_requested = false;
+    if (bmp_available) {
+      pipeline.resetMaxAltitude();
+    }
+    if (imu_available) {
+      pipeline.resetMaxAcceleration(0.0);
+    }
+    needs_full_refresh = true;
+  }
+  
   // Update sensors
-  if (now - last_sensor_update >= 200) {  // 5Hz sensor updates
+  if (now - last_sensor_update >= sensor_interval) {
+    unsigned long started_us = micros();
     updateSensors();
     last_sensor_update = now;
+    
+    // Track how long a sample takes so headless mode can run as fast as the bus allows
+    unsigned long took_us = micros() - started_us;
+    sensor_update_us = sensor_update_us == 0 ? took_us : (sensor_update_us * 7 + took_us) / 8;
+    updateAcquisitionMode();
   }
   
   // Update battery (every 5 seconds)
@@ -254,16 +533,35 @@ void loop() {
     last_battery_update = now;
   }
   
+  // Keep the sensor error screen up for 3 s after boot
+  if (error_screen_active && now - error_screen_start >= 3000) {
+    error_screen_active = false;
+  }
+  
+  // Finish waking the panel (SLPOUT needs 120 ms) without blocking sampling
+  if (!tft.isSleeping() && !tft.isReady()) {
+    tft.pollInit();
+  }
+  
   // Update display (only if enabled)
-  if (display_enabled && now - last_display_update >= 500) {  // 2Hz display updates
+  if (display_enabled && tft.isReady() && !error_screen_active && now - last_display_update >= 500) {  // 2Hz display updates
     updateDisplay();
     last_display_update = now;
   }
   
+  // Save a landed flight a block at a time, then summarise it
+  if (recorder.update()) {
+    display.setFlightSummary(recorder.getLastSummary());
+  }
+  
   // Update LED breathing effect
   updateStatusLED();
   
-  delay(10);
+  loop_iterations.increment();
+  updateRuntimeMetrics(now);
+  
+  // Headless: only yield, the sensor interval paces the loop
+  delay(headless ? 1 : 10);
 }
 
 void handleButtons() {
@@ -273,17 +571,24 @@ void handleButtons() {
   bool button_a_current = (digitalRead(BUTTON_A_PIN) == LOW);
   if (button_a_current && !button_a_pressed && (now - last_button_press) > button_debounce) {
     last_button_press = now;
-    Serial.println("Button A: Resetting max altitude and acceleration");
+    DLOG(BUTTON_A_RESET);
     
     if (bmp_available) {
       // Reset max altitude to current altitude
-      max_altitude = current_altitude;
+      pipeline.resetMaxAltitude();
       display.resetMaxAltitude();
-      Serial.printf("✓ Max altitude reset to current: %.2f m\n", max_altitude);
+      DLOG(MAX_ALT_RESET, sensors.max_altitude);
     }
     if (imu_available) {
-      max_acceleration = 0.0;
-      Serial.printf("✓ Max acceleration reset to 0g\n");
+      pipeline.resetMaxAcceleration(0.0);
+      DLOG(MAX_ACC_RESET);
+    }
+    // Re-arm launch detection for the next flight
+    if (flight_phase.getPhase() == PHASE_LANDED) {
+      if (!bmp_available && sensor_sim.hasLanded()) {
+        sensor_sim.reset();  // Back to the pad for another simulated flight
+      }
+      pipeline.rearmFlightDetection();  // Logged and applied by onPipelineEvent()
     }
     needs_full_refresh = true;
     
@@ -294,12 +599,37 @@ void handleButtons() {
   }
   button_a_pressed = button_a_current;
   
-  // Button B - Toggle display mode
+  // Button B - Short press: toggle display mode, hold: toggle WiFi
   bool button_b_current = (digitalRead(BUTTON_B_PIN) == LOW);
-  if (button_b_current && !button_b_pressed && (now - last_button_press) > button_debounce) {
+  if (button_b_current && !button_b_pressed) {
+    button_b_down_since = now;
+    button_b_hold_handled = false;
+  }
+  if (button_b_current && !button_b_hold_handled && now - button_b_down_since >= wifi_toggle_hold) {
+    button_b_hold_handled = true;
+    last_button_press = now;
+    // Ignored in flight: it would leave WiFi requested for when the network
+    // is allowed again
+    if (!network.isAllowed()) {
+      DLOG(NET_BLOCKED);
+    } else {
+      network.toggle();
+      if (network.isActive()) {
+        DLOG(BUTTON_B_WIFI_OFF);
+      } else {
+        DLOG(BUTTON_B_WIFI_ON);
+      }
+    }
+    
+    // Flash white
+    pixels.setPixelColor(0, pixels.Color(255, 255, 255));
+    pixels.show();
+    delay(100);
+  }
+  if (!button_b_current && button_b_pressed && !button_b_hold_handled && (now - last_button_press) > button_debounce) {
     last_button_press = now;
     display.nextDisplayMode();
-    Serial.printf("Button B: Display mode switched\n");
+    DLOG(BUTTON_B_MODE);
     needs_full_refresh = true;
     
     // Flash blue
@@ -313,16 +643,13 @@ void handleButtons() {
   bool button_c_current = (digitalRead(BUTTON_C_PIN) == LOW);
   if (button_c_current && !button_c_pressed && (now - last_button_press) > button_debounce) {
     last_button_press = now;
-    display_enabled = !display_enabled;
+    setDisplayPower(!display_enabled);
     
     if (display_enabled) {
-      Serial.println("Button C: Display ON");
-      digitalWrite(TFT_BL, HIGH);
-      needs_full_refresh = true;
+      DLOG(BUTTON_C_ON);
       pixels.setPixelColor(0, pixels.Color(0, 255, 0));
     } else {
-      Serial.println("Button C: Display OFF");
-      digitalWrite(TFT_BL, LOW);
+      DLOG(BUTTON_C_OFF);
       pixels.setPixelColor(0, pixels.Color(255, 0, 0));
     }
     
@@ -333,101 +660,257 @@ void handleButtons() {
 }
 
 void updateSensors() {
-  if (bmp_available) {
-    temperature = bmp.readTemperature();
-    pressure = bmp.readPressure();
-    
-    // Calculate absolute altitude using standard sea level pressure
-    current_altitude = bmp.readAltitude(101325.0);  // Standard sea level pressure
-    
-    // Track maximum altitude
-    if (current_altitude > max_altitude) {
-      max_altitude = current_altitude;
-    }
-  } else {
-    // Simulate altitude changes when BMP180 is not available (for testing)
-    float time_sec = millis() / 1000.0;
-    current_altitude = 350.0 + 5.0 * sin(time_sec * 0.1) + 2.0 * sin(time_sec * 0.3);  // Simulate around 350m elevation
-    temperature = 22.0 + 3.0 * sin(time_sec * 0.05);  // Simulated temperature
-    pressure = 101325.0 + 500.0 * sin(time_sec * 0.08);  // Simulated pressure
-    
-    // Track maximum altitude for simulated data
-    if (current_altitude > max_altitude) {
-      max_altitude = current_altitude;
-    }
+  if (replay_active) {
+    replay.advance(micros());
   }
   
-  if (imu_available) {
-    imu.update();
-    accel_x = imu.getAccelX();
-    accel_y = imu.getAccelY();
-    accel_z = imu.getAccelZ();
-    gyro_x = imu.getGyroX();
-    gyro_y = imu.getGyroY();
-    gyro_z = imu.getGyroZ();
-  } else {
-    // Simulate acceleration when IMU is not available (for testing)
-    float time_sec = millis() / 1000.0;
-    accel_x = 0.3 * sin(time_sec * 0.8) + 0.1 * sin(time_sec * 2.1);
-    accel_y = 0.25 * cos(time_sec * 0.6) + 0.15 * cos(time_sec * 1.8);
-    accel_z = 1.0 + 0.4 * sin(time_sec * 0.4) + 0.2 * sin(time_sec * 3.2);
-    gyro_x = 0.05 * sin(time_sec * 0.5);
-    gyro_y = 0.03 * cos(time_sec * 0.7);
-    gyro_z = 0.02 * sin(time_sec * 0.9);
-  }
-  
-  // Calculate total acceleration magnitude for display
-  current_acceleration = sqrt(accel_x*accel_x + accel_y*accel_y + accel_z*accel_z);
-  
-  // Track maximum acceleration from any individual axis
-  // Use fabs() for proper floating-point absolute values
-  float abs_accel_x = fabs(accel_x);
-  float abs_accel_y = fabs(accel_y);
-  float abs_accel_z = fabs(accel_z);
+  // Sources with a FIFO hand over everything measured since the last call;
+  // the others return at most one sample
+  static BaroSample baro[baro_batch_size];  // Static: too big for the loop task stack
+  static ImuSample imu_samples[imu_batch_size];
+  size_t baro_count = baro_source->readBatch(baro, baro_batch_size);
+  size_t imu_count = imu_source->readBatch(imu_samples, imu_batch_size);
+  recorder.record(baro, baro_count, imu_samples, imu_count);
   
-  // Find the highest acceleration from any axis
-  float max_current_axis = abs_accel_x;
-  char current_max_axis = 'X';
-  
-  if (abs_accel_y > max_current_axis) {
-    max_current_axis = abs_accel_y;
-    current_max_axis = 'Y';
+  // Altitude, ground reference, max tracking and flight phase, in the order
+  // the samples were measured; events come back through onPipelineEvent()
+#ifdef IMU_STRESS_HZ
+  // Keep going until the simulated FIFO is empty, timing only the pipeline
+  static uint32_t stress_samples = 0;
+  static uint32_t stress_us = 0;
+  static unsigned long stress_report_ms = millis();
+  while (true) {
+    unsigned long started_us = micros();
+    pipeline.processBatch(baro, baro_count, imu_samples, imu_count);
+    stress_us += micros() - started_us;
+    stress_samples += imu_count;
+    if (imu_count < imu_batch_size) {
+      break;
+    }
+    baro_count = 0;
+    imu_count = imu_source->readBatch(imu_samples, imu_batch_size);
+    recorder.record(baro, 0, imu_samples, imu_count);
   }
+  if (millis() - stress_report_ms >= 5000) {
+    float seconds = (millis() - stress_report_ms) / 1000.0f;
+    DLOG(IMU_STRESS_REPORT, (unsigned)(stress_samples / seconds), stress_samples > 0 ? (float)stress_us / stress_samples : 0.0f,
+         imu.getDroppedSamples());
+    stress_samples = 0;
+    stress_us = 0;
+    stress_report_ms = millis();
+  }
+#else
+  pipeline.processBatch(baro, baro_count, imu_samples, imu_count);
+#endif
   
-  if (abs_accel_z > max_current_axis) {
-    max_current_axis = abs_accel_z;
-    current_max_axis = 'Z';
+  // Headless runs are logged sample by sample (deferred, so this is only a copy)
+  if (headless) {
+    DLOG(SAMPLE, pipeline.getAltitudeAgl(), sensors.pressure, sensors.temperature,
+         sensors.accel_x, sensors.accel_y, sensors.accel_z);
   }
   
-  // Update maximum if this reading is higher
-  if (max_current_axis > max_acceleration) {
-    max_acceleration = max_current_axis;
-    max_acceleration_axis = current_max_axis;
+  // End of a replay: the summary line is what two runs get diffed on
+  if (replay_active && replay.isFinished()) {
+    replay_active = false;
+    DLOG(REPLAY_DONE, sensors.baro_samples, sensors.imu_samples, sensors.max_altitude, sensors.max_acceleration,
+         replay_frames);
   }
   
-  // Serial output every 5 seconds
+  // Status output every 5 seconds (deferred - only raw values are copied here)
   static unsigned long last_serial_output = 0;
   if (millis() - last_serial_output >= 5000) {
-    Serial.printf("ALT: %.2fm (MAX: %.2fm) | ACC: %.2fg (MAX: %.2fg-%c) | TEMP: %.1f°C | PRESS: %.1f hPa\n", 
-                  current_altitude, max_altitude, current_acceleration, max_acceleration, max_acceleration_axis, temperature, pressure/100.0);
-    Serial.printf("DEBUG ALT: raw_altitude=%.2fm, current_altitude=%.2fm, max_altitude=%.2fm\n", 
-                  bmp_available ? bmp.readAltitude(baseline_pressure) : current_altitude, current_altitude, max_altitude);
-    Serial.printf("DEBUG ACC: X=%.2fg, Y=%.2fg, Z=%.2fg, current_mag=%.2fg, max=%.2fg-%c\n", 
-                  accel_x, accel_y, accel_z, current_acceleration, max_acceleration, max_acceleration_axis);
+    DLOG(STATUS, sensors.current_altitude, sensors.max_altitude, sensors.current_acceleration, sensors.max_acceleration,
+         sensors.max_acceleration_axis, sensors.temperature, sensors.pressure / 100.0f);
+    DLOG(DEBUG_ALT, sensors.pressure, sensors.baseline_pressure, sensors.current_altitude, sensors.max_altitude);
+    DLOG(DEBUG_ACC, sensors.accel_x, sensors.accel_y, sensors.accel_z, sensors.current_acceleration,
+         sensors.max_acceleration, sensors.max_acceleration_axis);
     last_serial_output = millis();
   }
+  
+  sensor_samples.increment();
+}
+
+// "flight-<n>.ttfa", the download name of flight log n
+bool parseFlightLogName(const char* name, uint32_t& flight) {
+  if (strncmp(name, "flight-", 7) != 0 || !isdigit((unsigned char)name[7])) {
+    return false;
+  }
+  char* end;
+  unsigned long number = strtoul(name + 7, &end, 10);
+  if (strcmp(end, ".ttfa") != 0 || number == 0) {
+    return false;
+  }
+  flight = (uint32_t)number;
+  return true;
+}
+
+void onPipelineEvent(const SensorPipeline::Event& event) {
+  switch (event.type) {
+    case SensorPipeline::EVENT_FIRST_ALTITUDE:
+      recordFirstAltitude();
+      break;
+      
+    case SensorPipeline::EVENT_BASELINE_READY: {
+      // Cache the averaged ground reference so the next boot starts with a
+      // usable value - unless it came from the simulator or a replay
+      if (!bmp_available || replay_active) {
+        break;
+      }
+      CalibrationData cal;
+      cal.baseline_pressure = sensors.baseline_pressure;
+      cal.baseline_altitude = sensors.baseline_altitude;
+      cal.temperature = sensors.temperature;
+      if (calibration.save(cal)) {
+        DLOG(CALIB_SAVED, cal.baseline_pressure / 100.0f, cal.baseline_altitude);
+      } else {
+        DLOG(CALIB_SAVE_FAILED);
+      }
+      break;
+    }
+    
+    case SensorPipeline::EVENT_PHASE_CHANGE: {
+      // Flight phase drives the network policy (radio off in flight)
+      static const uint16_t phase_messages[PHASE_COUNT] = {
+        LOG_PHASE_PRELAUNCH, LOG_PHASE_BOOST, LOG_PHASE_COAST, LOG_PHASE_DESCENT, LOG_PHASE_LANDED
+      };
+      dlog.log(phase_messages[event.phase], event.value);
+      applyNetworkPolicy(event.phase);
+      
+      // Fly headless: put the display to sleep at launch, restore it after landing
+      if (event.phase == PHASE_BOOST) {
+        display_before_flight = display_enabled;
+        setDisplayPower(false);
+      } else if (event.phase == PHASE_LANDED) {
+        setDisplayPower(display_before_flight);
+      }
+      
+      // Keep the flight in memory after landing and save it (not a
+      // replayed one); re-arming starts over once it is saved
+      recorder.onPhaseChange(event.phase, !replay_active);
+      break;
+    }
+  }
 }
 
 void updateDisplay() {
   // Update the display with current sensor data
-  display.setAltitudeData(current_altitude, max_altitude);
-  display.setEnvironmentalData(temperature, pressure);
-  display.setIMUData(accel_x, accel_y, accel_z, gyro_x, gyro_y, gyro_z);
+  display.setPipelineData(pipeline);
   display.setSensorStatus(bmp_available, imu_available);
   display.setBatteryData(battery_voltage, battery_percentage);
   
   // Update the display
+  uint32_t spi_before = tft.getBytesTransferred();
+  if (replay_active) {
+    tft.setOutputHashing(true);  // Restarts the fingerprint for this frame
+  }
   display.update();
+  uint32_t spi_sent = tft.getBytesTransferred() - spi_before;
+  if (spi_sent > 0) {
+    spi_bytes.increment(spi_sent);
+    spi_bytes_per_frame.set(spi_sent);
+    if (replay_active) {
+      DLOG(REPLAY_FRAME, replay_frames++, pipeline.getTimeMs(), tft.getOutputHash());
+    }
+  }
+}
+
+void setDisplayPower(bool on) {
+  if (on == display_enabled) {
+    return;
+  }
+  display_enabled = on;
+  
+  if (on) {
+    tft.wake();  // loop() finishes the wake-up through pollInit()
+    needs_full_refresh = true;
+  } else {
+    tft.sleep();  // SLPIN, backlight off, SPI released
+  }
+  updateAcquisitionMode();
+}
+
+void updateAcquisitionMode() {
+  // No pixels to push, either because the user turned the display off or
+  // because we are flying: spend the time on sampling instead
+  bool want_headless = !display_enabled || flight_phase.isInFlight();
+  if (want_headless != headless) {
+    headless = want_headless;
+    headless_active.set(headless ? 1 : 0);
+    updateSensorInterval();
+    if (headless) {
+      DLOG(HEADLESS_ON, sensor_interval);
+    } else {
+      DLOG(HEADLESS_OFF, sensor_interval);
+    }
+  } else if (headless) {
+    updateSensorInterval();
+  }
+}
+
+void updateSensorInterval() {
+  if (headless) {
+    // As fast as a sample actually takes (plus slack for the LED, buttons
+    // and the logger), never faster than the cap
+    unsigned long sample_ms = sensor_update_us / 1000 + 2;
+    sensor_interval = max(headless_min_interval, sample_ms);
+  } else {
+    sensor_interval = display_sensor_interval;
+  }
+  sensor_rate_requested.set(1000.0f / sensor_interval);
+  sensor_update_time.set(sensor_update_us);
+}
+
+void updateRuntimeMetrics(unsigned long now) {
+  static unsigned long last_metrics_update = 0;
+  static uint32_t last_loop_count = 0;
+  static uint32_t last_sample_count = 0;
+  
+  unsigned long elapsed = now - last_metrics_update;
+  if (elapsed < 1000) {
+    return;
+  }
+  
+  uint32_t loops = loop_iterations.get();
+  uint32_t samples = sensor_samples.get();
+  loop_frequency.set((loops - last_loop_count) * 1000.0f / elapsed);
+  sensor_rate_achieved.set((samples - last_sample_count) * 1000.0f / elapsed);
+  
+  last_loop_count = loops;
+  last_sample_count = samples;
+  last_metrics_update = now;
+}
+
+void collectScrapeMetrics() {
+  static uint32_t last_baro_spikes = 0;
+  collectSystemMetrics();
+  if (sensors.baro_spikes < last_baro_spikes) {
+    last_baro_spikes = 0;  // Pipeline reset (replay)
+  }
+  baro_spikes.increment(sensors.baro_spikes - last_baro_spikes);
+  last_baro_spikes = sensors.baro_spikes;
+  SegmentStore& flight_logs = recorder.getLogs();
+  if (flight_logs.isReady()) {
+    recorder.lock();
+    flight_log_erase_min.set(flight_logs.getMinEraseCount());
+    flight_log_erase_max.set(flight_logs.getMaxEraseCount());
+    recorder.unlock();
+  }
+  wifi_clients.set(network.getClientCount());
+}
+
+void applyNetworkPolicy(FlightPhase phase) {
+  switch (phase) {
+    case PHASE_PRELAUNCH:
+      network.setAllowed(true);   // Started on demand with a Button B hold
+      break;
+    case PHASE_LANDED:
+      network.setAllowed(true);
+      network.requestStart();     // Ready for data retrieval after recovery
+      break;
+    default:
+      network.setAllowed(false);  // In flight: no radio activity, heap released
+      break;
+  }
 }
 
 void drawMainDisplay() {
@@ -443,35 +926,35 @@ void drawMainDisplay() {
   
   // Current altitude - large display
   drawText(10, 25, "ALT", COLOR_ALTITUDE);
-  drawNumber(35, 25, current_altitude, 1, COLOR_ALTITUDE);
+  drawNumber(35, 25, sensors.current_altitude, 1, COLOR_ALTITUDE);
   drawText(80, 25, "m", COLOR_ALTITUDE);
   
   // Max altitude
   drawText(10, 40, "MAX", COLOR_MAX_ALT);
-  drawNumber(35, 40, max_altitude, 1, COLOR_MAX_ALT);
+  drawNumber(35, 40, sensors.max_altitude, 1, COLOR_MAX_ALT);
   drawText(80, 40, "m", COLOR_MAX_ALT);
   
   // Current acceleration
   drawText(10, 55, "ACC", COLOR_ACCEL);
-  drawNumber(35, 55, current_acceleration, 2, COLOR_ACCEL);
+  drawNumber(35, 55, sensors.current_acceleration, 2, COLOR_ACCEL);
   drawText(80, 55, "g", COLOR_ACCEL);
   
   // Max acceleration with axis indicator
   drawText(10, 70, "MAX", COLOR_MAX_ACCEL);
-  drawNumber(35, 70, max_acceleration, 2, COLOR_MAX_ACCEL);
+  drawNumber(35, 70, sensors.max_acceleration, 2, COLOR_MAX_ACCEL);
   drawText(80, 70, "g", COLOR_MAX_ACCEL);
   
   // Show which axis had the max acceleration
-  char axis_text[2] = {max_acceleration_axis, '\0'};
+  char axis_text[2] = {sensors.max_acceleration_axis, '\0'};
   drawText(95, 70, axis_text, COLOR_MAX_ACCEL);
   
   // Temperature and pressure
   drawText(10, 90, "TEMP", COLOR_TEMP);
-  drawNumber(50, 90, temperature, 1, COLOR_TEMP);
+  drawNumber(50, 90, sensors.temperature, 1, COLOR_TEMP);
   drawText(90, 90, "C", COLOR_TEMP);
   
   drawText(10, 105, "PRESS", COLOR_PRESSURE);
-  drawNumber(50, 105, pressure/100.0, 0, COLOR_PRESSURE);
+  drawNumber(50, 105, sensors.pressure/100.0f, 0, COLOR_PRESSURE);
   drawText(90, 105, "hPa", COLOR_PRESSURE);
 }
 
@@ -488,27 +971,27 @@ void drawDetailedDisplay() {
   
   // Current altitude
   drawText(10, 25, "ALTITUDE", COLOR_ALTITUDE);
-  drawNumber(10, 40, current_altitude, 2, COLOR_ALTITUDE);
+  drawNumber(10, 40, sensors.current_altitude, 2, COLOR_ALTITUDE);
   drawText(90, 40, "m", COLOR_ALTITUDE);
   
   // Max altitude
   drawText(10, 55, "MAX ALT", COLOR_MAX_ALT);
-  drawNumber(10, 70, max_altitude, 2, COLOR_MAX_ALT);
+  drawNumber(10, 70, sensors.max_altitude, 2, COLOR_MAX_ALT);
   drawText(90, 70, "m", COLOR_MAX_ALT);
   
   // Current acceleration
   drawText(10, 85, "ACCEL", COLOR_ACCEL);
-  drawNumber(10, 100, current_acceleration, 2, COLOR_ACCEL);
+  drawNumber(10, 100, sensors.current_acceleration, 2, COLOR_ACCEL);
   drawText(90, 100, "g", COLOR_ACCEL);
   
   // Max acceleration with axis indicator
   drawText(10, 115, "MAX ACC", COLOR_MAX_ACCEL);
-  drawNumber(60, 115, max_acceleration, 2, COLOR_MAX_ACCEL);
+  drawNumber(60, 115, sensors.max_acceleration, 2, COLOR_MAX_ACCEL);
   drawText(95, 115, "g", COLOR_MAX_ACCEL);
   
   // Show which axis had the max acceleration (on next line due to space)
   char axis_label[4];
-  sprintf(axis_label, "(%c)", max_acceleration_axis);
+  sprintf(axis_label, "(%c)", sensors.max_acceleration_axis);
   drawText(105, 115, axis_label, COLOR_MAX_ACCEL);
 }
 
@@ -580,16 +1063,7 @@ void drawNumber(int x, int y, float value, int decimals, uint16_t color) {
   drawText(x, y, buffer, color);
 }
 
-void setupWiFi() {
-  WiFi.setHostname(wifi_hostname);
-  WiFi.mode(WIFI_AP);
-  WiFi.softAP(wifi_ssid, wifi_password);
-  
-  IPAddress ip = WiFi.softAPIP();
-  Serial.printf("✓ WiFi AP: %s\n", wifi_ssid);
-  Serial.printf("✓ IP: %s\n", ip.toString().c_str());
-}
-
+// Routes are registered once at boot; NetworkManager starts and ends the server
 void setupWebServer() {
   server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
     String html = R"html(
@@ -615,6 +1089,7 @@ void setupWebServer() {
         .ok { background: #d4edda; color: #155724; }
         .error { background: #f8d7da; color: #721c24; }
         button { padding: 10px 20px; margin: 10px; font-size: 16px; cursor: pointer; }
+        canvas { width: 100%; height: 160px; background: #f9f9f9; border-radius: 5px; }
     </style>
 </head>
 <body>
@@ -626,12 +1101,20 @@ void setupWebServer() {
             <div class="max-alt">Maximum Altitude: <span id="max-altitude">--</span> m</div>
             <div class="accel">Current Acceleration: <span id="acceleration">--</span> g</div>
             <div class="max-accel">Maximum Acceleration: <span id="max-acceleration">--</span> g (<span id="max-acceleration-axis">-</span> axis)</div>
+            <div class="altitude">Climb Rate: <span id="climb-rate-1s">--</span> m/s (10 s average <span id="climb-rate-10s">--</span> m/s)</div>
+            <div class="max-accel">Peak Acceleration: <span id="peak-acceleration">--</span> g at <span id="peak-acceleration-time">--</span> s (<span id="peak-acceleration-phase">-</span>)</div>
+            <div class="accel">Vertical Acceleration: <span id="vertical-acceleration">--</span> g (max <span id="max-vertical-acceleration">--</span> g), tilt <span id="tilt">--</span>°</div>
+            <div class="accel">Peak Acceleration (1 s): <span id="peak-acceleration-1s">--</span> g (10 s mean <span id="mean-acceleration-10s">--</span> g)</div>
             <div class="temp">Temperature: <span id="temperature">--</span> °C</div>
             <div class="pressure">Pressure: <span id="pressure">--</span> hPa</div>
             <div class="battery">Battery: <span id="battery-percentage">--</span>% (<span id="battery-voltage">--</span>V)</div>
             <div class="accel">Accelerometer: X=<span id="accel-x">--</span>g, Y=<span id="accel-y">--</span>g, Z=<span id="accel-z">--</span>g</div>
             <div class="accel">Gyroscope: X=<span id="gyro-x">--</span>°/s, Y=<span id="gyro-y">--</span>°/s, Z=<span id="gyro-z">--</span>°/s</div>
+            <div class="battery">Recording: <span id="recording-state">--</span>, <span id="recording-samples">--</span> samples in <span id="recording-kb">--</span> KB</div>
         </div>
+        <div class="data" id="flight-logs">Flight logs: --</div>
+        <div class="altitude">Altitude, last 10 minutes (<span id="history-range">--</span>)</div>
+        <canvas id="history" width="600" height="160"></canvas>
         <button onclick="resetMaxValues()">Reset Max Values</button>
         <button onclick="toggleDisplay()">Toggle Display</button>
         <button onclick="refreshData()">Refresh Data</button>
@@ -647,6 +1130,17 @@ void setupWebServer() {
                     document.getElementById('acceleration').textContent = data.acceleration.toFixed(2);
                     document.getElementById('max-acceleration').textContent = data.max_acceleration.toFixed(2);
                     document.getElementById('max-acceleration-axis').textContent = data.max_acceleration_axis;
+                    document.getElementById('vertical-acceleration').textContent = data.vertical_acceleration.toFixed(2);
+                    document.getElementById('max-vertical-acceleration').textContent = data.max_vertical_acceleration.toFixed(2);
+                    document.getElementById('tilt').textContent = data.tilt.toFixed(1);
+                    const peak = data.peaks.magnitude;
+                    document.getElementById('peak-acceleration').textContent = peak ? peak.g.toFixed(2) : '--';
+                    document.getElementById('peak-acceleration-time').textContent = peak ? (peak.time_ms / 1000).toFixed(3) : '--';
+                    document.getElementById('peak-acceleration-phase').textContent = peak ? peak.phase : '-';
+                    document.getElementById('climb-rate-1s').textContent = data.climb_rate_1s.toFixed(1);
+                    document.getElementById('climb-rate-10s').textContent = data.climb_rate_10s.toFixed(1);
+                    document.getElementById('peak-acceleration-1s').textContent = data.peak_acceleration_1s.toFixed(2);
+                    document.getElementById('mean-acceleration-10s').textContent = data.mean_acceleration_10s.toFixed(2);
                     document.getElementById('temperature').textContent = data.temperature.toFixed(1);
                     document.getElementById('pressure').textContent = data.pressure.toFixed(1);
                     document.getElementById('battery-percentage').textContent = data.battery_percentage;
@@ -657,6 +1151,9 @@ void setupWebServer() {
                     document.getElementById('gyro-x').textContent = data.gyro_x.toFixed(2);
                     document.getElementById('gyro-y').textContent = data.gyro_y.toFixed(2);
                     document.getElementById('gyro-z').textContent = data.gyro_z.toFixed(2);
+                    document.getElementById('recording-state').textContent = data.recording.active ? 'on' : 'stopped';
+                    document.getElementById('recording-samples').textContent = data.recording.imu_samples + data.recording.baro_samples;
+                    document.getElementById('recording-kb').textContent = (data.recording.bytes / 1024).toFixed(0);
                     
                     const statusDiv = document.getElementById('status');
                     if (data.bmp_status && data.imu_status) {
@@ -691,61 +1188,311 @@ void setupWebServer() {
             updateData();
         }
         
-        // Update data every 2 seconds
+        // Min/max envelope from /history, one point per canvas column
+        function updateHistory() {
+            const canvas = document.getElementById('history');
+            fetch('/history?channel=altitude&from=-600000&points=' + canvas.width)
+                .then(response => response.json())
+                .then(data => {
+                    const valid = data.points.filter(p => p[1] !== null);
+                    const ctx = canvas.getContext('2d');
+                    ctx.clearRect(0, 0, canvas.width, canvas.height);
+                    if (valid.length == 0) return;
+                    let low = Math.min(...valid.map(p => p[1]));
+                    let high = Math.max(...valid.map(p => p[2]));
+                    if (high - low < 2) { low -= 1; high += 1; }
+                    const y = v => canvas.height - 1 - (v - low) / (high - low) * (canvas.height - 1);
+                    ctx.strokeStyle = '#00aa00';
+                    data.points.forEach((p, i) => {
+                        if (p[1] === null) return;
+                        ctx.beginPath();
+                        ctx.moveTo(i + 0.5, y(p[2]));
+                        ctx.lineTo(i + 0.5, y(p[1]) + 1);
+                        ctx.stroke();
+                    });
+                    document.getElementById('history-range').textContent = low.toFixed(1) + ' to ' + high.toFixed(1) + ' m';
+                });
+        }
+        
+        // Stored flights with download links
+        function updateLogs() {
+            fetch('/logs')
+                .then(response => response.json())
+                .then(data => {
+                    const list = document.getElementById('flight-logs');
+                    list.innerHTML = 'Flight logs' + (data.saving ? ' (saving)' : '') + ':';
+                    data.flights.forEach(f => {
+                        const item = document.createElement('div');
+                        item.innerHTML = '<a href="/logs/download?name=' + f.name + '">Flight ' + f.flight + '</a> ' +
+                            f.duration_s.toFixed(1) + ' s, ' + (f.bytes / 1024).toFixed(0) + ' KB' +
+                            (f.complete ? '' : ' (cut short)') +
+                            ' <a href="/logs/summary?name=' + f.name + '">summary</a>';
+                        list.appendChild(item);
+                    });
+                });
+        }
+        
+        // Update data every 2 seconds, the graph every 10, the logs every 30
         setInterval(updateData, 2000);
+        setInterval(updateHistory, 10000);
+        setInterval(updateLogs, 30000);
         updateData(); // Initial load
+        updateHistory();
+        updateLogs();
     </script>
 </body>
 </html>
 )html";
+    web_requests.increment();
     request->send(200, "text/html", html);
   });
 
   server.on("/data", HTTP_GET, [](AsyncWebServerRequest *request){
-    request->send(200, "application/json", getAltimeterJSON());
+    web_requests.increment();
+    request->send(200, "application/json", getAltimeterJSON(pipeline, getAltimeterStatus()));
   });
 
-  server.on("/reset", HTTP_POST, [](AsyncWebServerRequest *request){
-    if (bmp_available) {
-      max_altitude = 0.0;
+  // Graph data from the history pyramid as a min/max/mean envelope:
+  // /history?channel=altitude&from=<ms>&to=<ms>&points=600. Times are
+  // pipeline milliseconds; negative ones count back from the newest sample.
+  // The body is generated chunk by chunk while it is sent, so a long
+  // series never sits in RAM.
+  server.on("/history", HTTP_GET, [](AsyncWebServerRequest *request){
+    web_requests.increment();
+    if (!history.isReady()) {
+      request->send(503, "application/json", "{\"error\":\"history unavailable\"}");
+      return;
     }
-    if (imu_available) {
-      max_acceleration = 0.0;
+    HistoryPyramid::Channel channel = HistoryPyramid::CHANNEL_ALTITUDE;
+    if (request->hasParam("channel") &&
+        !HistoryPyramid::parseChannel(request->getParam("channel")->value().c_str(), channel)) {
+      request->send(400, "application/json", "{\"error\":\"unknown channel\"}");
+      return;
     }
-    needs_full_refresh = true;
+    uint32_t newest_ms = history.getNewestMs();
+    uint32_t from_ms = request->hasParam("from") ? parseHistoryTime(request->getParam("from")->value(), newest_ms)
+                                                 : history.getOldestMs();
+    uint32_t to_ms = request->hasParam("to") ? parseHistoryTime(request->getParam("to")->value(), newest_ms)
+                                             : newest_ms + 1;
+    if (from_ms < history.getOldestMs()) {
+      from_ms = history.getOldestMs();
+    }
+    size_t points = request->hasParam("points") ? strtoul(request->getParam("points")->value().c_str(), nullptr, 10) : 600;
+    
+    std::shared_ptr<HistoryJsonStream> body = std::make_shared<HistoryJsonStream>(history, channel, from_ms, to_ms, points);
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+      [body](uint8_t *buffer, size_t max_length, size_t index) -> size_t {
+        return body->read(buffer, max_length);
+      });
+    request->send(response);
+  });
+
+  // Stored flight logs, newest first
+  server.on("/logs", HTTP_GET, [](AsyncWebServerRequest *request){
+    web_requests.increment();
+    request->send(200, "application/json", getFlightLogsJSON());
+  });
+
+  // /logs/summary?name=flight-3.ttfa: apogee, peak acceleration, rates and
+  // event times, computed from the stored log on request (the newest
+  // flight's is kept from its save)
+  server.on("/logs/summary", HTTP_GET, [](AsyncWebServerRequest *request){
+    web_requests.increment();
+    uint32_t flight;
+    if (!request->hasParam("name") || !parseFlightLogName(request->getParam("name")->value().c_str(), flight)) {
+      request->send(400, "application/json", "{\"error\":\"bad log name\"}");
+      return;
+    }
+    FlightSummary summary;
+    if (!recorder.summarise(flight, summary)) {
+      request->send(404, "application/json", "{\"error\":\"no such log\"}");
+      return;
+    }
+    request->send(200, "application/json", getFlightSummaryJSON(summary));
+  });
+
+  // /logs/download?name=flight-3.ttfa streams a log straight from flash in
+  // the server's own buffer, with Content-Length and single-range Range
+  // requests so an interrupted download can resume. The log being saved is
+  // not listed by the store yet, so it is not found.
+  server.on("/logs/download", HTTP_GET, [](AsyncWebServerRequest *request){
+    web_requests.increment();
+    uint32_t flight;
+    if (!request->hasParam("name") || !parseFlightLogName(request->getParam("name")->value().c_str(), flight)) {
+      request->send(400, "application/json", "{\"error\":\"bad log name\"}");
+      return;
+    }
+    size_t size = 0;
+    bool found = false;
+    if (recorder.getLogs().isReady()) {
+      recorder.lock();
+      const SegmentStore::Log* log = recorder.getLogs().findLog(flight);
+      if (log != nullptr) {
+        size = log->bytes;
+        found = true;
+      }
+      recorder.unlock();
+    }
+    if (!found) {
+      request->send(404, "application/json", "{\"error\":\"no such log\"}");
+      return;
+    }
+    
+    size_t start, length;
+    AsyncWebHeader* range_header = request->getHeader("Range");
+    ByteRangeResult range = parseByteRange(range_header ? range_header->value().c_str() : nullptr, size, start, length);
+    if (range == RANGE_UNSATISFIABLE) {
+      AsyncWebServerResponse *response = request->beginResponse(416, "text/plain", "");
+      response->addHeader("Content-Range", "bytes */" + String((unsigned long)size));
+      request->send(response);
+      return;
+    }
+    
+    // The log is looked up again for every read: if a new flight overwrites
+    // it mid-download the response stops short instead of sending other data
+    AsyncWebServerResponse *response = request->beginResponse("application/octet-stream", length,
+      [flight, start, length](uint8_t *buffer, size_t max_length, size_t index) -> size_t {
+        if (index >= length) {
+          return 0;
+        }
+        size_t n = length - index < max_length ? length - index : max_length;
+        recorder.lock();
+        SegmentStore& flight_logs = recorder.getLogs();
+        const SegmentStore::Log* log = flight_logs.findLog(flight);
+        size_t read = log != nullptr ? flight_logs.read(*log, start + index, buffer, n) : 0;
+        recorder.unlock();
+        return read;
+      });
+    if (range == RANGE_OK) {
+      response->setCode(206);
+      response->addHeader("Content-Range", "bytes " + String((unsigned long)start) + "-" +
+                          String((unsigned long)(start + length - 1)) + "/" + String((unsigned long)size));
+    }
+    response->addHeader("Accept-Ranges", "bytes");
+    response->addHeader("Content-Disposition", "attachment; filename=\"" + request->getParam("name")->value() + "\"");
+    request->send(response);
+  });
+
+  // Per-device I2C statistics from the bus scheduler
+  server.on("/i2c", HTTP_GET, [](AsyncWebServerRequest *request){
+    web_requests.increment();
+    request->send(200, "application/json", getI2CJSON());
+  });
+
+  // Runtime health counters - Prometheus text format, plus a JSON variant
+  server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+    web_requests.increment();
+    collectScrapeMetrics();
+    AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+    writeMetricsText(*response);
+    request->send(response);
+  });
+
+  server.on("/metrics.json", HTTP_GET, [](AsyncWebServerRequest *request){
+    web_requests.increment();
+    collectScrapeMetrics();
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    writeMetricsJSON(*response);
+    request->send(response);
+  });
+
+  server.on("/reset", HTTP_POST, [](AsyncWebServerRequest *request){
+    web_requests.increment();
+    reset_requested = true;  // Applied by loop(), which owns the pipeline
     request->send(200, "text/plain", "OK");
   });
 
   server.on("/toggle", HTTP_POST, [](AsyncWebServerRequest *request){
-    display_enabled = !display_enabled;
-    digitalWrite(TFT_BL, display_enabled ? HIGH : LOW);
-    if (display_enabled) needs_full_refresh = true;
-    request->send(200, "text/plain", display_enabled ? "ON" : "OFF");
+    web_requests.increment();
+    display_toggle_requested = true;  // Applied by loop(), which owns the SPI bus
+    request->send(200, "text/plain", display_enabled ? "OFF" : "ON");
   });
+}
 
+void startWebServer() {
   server.begin();
 }
 
-String getAltimeterJSON() {
-  String json = "{";
-  json += "\"altitude\":" + String(current_altitude, 2) + ",";
-  json += "\"max_altitude\":" + String(max_altitude, 2) + ",";
-  json += "\"acceleration\":" + String(current_acceleration, 2) + ",";
-  json += "\"max_acceleration\":" + String(max_acceleration, 2) + ",";
-  json += "\"max_acceleration_axis\":\"" + String(max_acceleration_axis) + "\",";
-  json += "\"accel_x\":" + String(accel_x, 2) + ",";
-  json += "\"accel_y\":" + String(accel_y, 2) + ",";
-  json += "\"accel_z\":" + String(accel_z, 2) + ",";
-  json += "\"gyro_x\":" + String(gyro_x, 2) + ",";
-  json += "\"gyro_y\":" + String(gyro_y, 2) + ",";
-  json += "\"gyro_z\":" + String(gyro_z, 2) + ",";
-  json += "\"temperature\":" + String(temperature, 2) + ",";
-  json += "\"pressure\":" + String(pressure/100.0, 2) + ",";
-  json += "\"battery_voltage\":" + String(battery_voltage, 2) + ",";
-  json += "\"battery_percentage\":" + String(battery_percentage) + ",";
-  json += "\"bmp_status\":" + String(bmp_available ? "true" : "false") + ",";
-  json += "\"imu_status\":" + String(imu_available ? "true" : "false");
-  json += "}";
+void stopWebServer() {
+  server.end();
+}
+
+// Listing from each log's archive header; the log being saved is left out
+String getFlightLogsJSON() {
+  String json = "{\"flights\":[";
+  SegmentStore& flight_logs = recorder.getLogs();
+  if (flight_logs.isReady()) {
+    recorder.lock();
+    bool first = true;
+    for (int i = flight_logs.getLogCount() - 1; i >= 0; i--) {
+      const SegmentStore::Log& log = flight_logs.getLog(i);
+      FlightArchiveHeader header;
+      if (!readFlightArchiveHeader(flight_logs, log, header)) {
+        continue;
+      }
+      const FlightArchiveStream& imu_stream = header.streams[ARCHIVE_STREAM_IMU];
+      const FlightArchiveStream& baro_stream = header.streams[ARCHIVE_STREAM_BARO];
+      if (!first) {
+        json += ",";
+      }
+      first = false;
+      json += "{\"name\":\"flight-" + String((unsigned long)log.id) + ".ttfa\",";
+      json += "\"flight\":" + String((unsigned long)log.id) + ",";
+      json += "\"bytes\":" + String((unsigned long)log.bytes) + ",";
+      json += "\"complete\":" + String(log.complete && log.bytes == getFlightArchiveSize(header) ? "true" : "false") + ",";
+      json += "\"imu_samples\":" + String((unsigned long)imu_stream.sample_count) + ",";
+      json += "\"baro_samples\":" + String((unsigned long)baro_stream.sample_count) + ",";
+      json += "\"duration_s\":" + String((imu_stream.last_time_us - imu_stream.first_time_us) / 1e6f, 1) + "}";
+    }
+    recorder.unlock();
+  }
+  json += "],\"saving\":" + String(recorder.isSaving() ? "true" : "false");
+  json += ",\"capacity_bytes\":" + String((unsigned long)flight_logs.getCapacityBytes()) + "}";
+  return json;
+}
+
+// Absolute pipeline time, or relative to the newest sample if negative
+uint32_t parseHistoryTime(const String& value, uint32_t newest_ms) {
+  long ms = strtol(value.c_str(), nullptr, 10);
+  if (ms >= 0) {
+    return (uint32_t)ms;
+  }
+  // In 64 bits: negating LONG_MIN (strtol's saturation) would overflow
+  int64_t t = (int64_t)newest_ms + 1 + ms;
+  return t < 0 ? 0 : (uint32_t)t;
+}
+
+AltimeterStatus getAltimeterStatus() {
+  AltimeterStatus status;
+  status.battery_voltage = battery_voltage;
+  status.battery_percentage = battery_percentage;
+  status.bmp_available = bmp_available;
+  status.imu_available = imu_available;
+  status.recording = recorder.isRecording();
+  status.baro_recording = &recorder.getBaroRecording();
+  status.imu_recording = &recorder.getImuRecording();
+  return status;
+}
+
+String getI2CJSON() {
+  String json = "{\"clock_hz\":" + String(i2c_bus.getClockHz()) + ",\"devices\":[";
+  for (int i = 0; i < i2c_bus.getDeviceCount(); i++) {
+    const I2CScheduler::DeviceStats& d = i2c_bus.getDeviceStats(i);
+    uint32_t mean_us = d.transactions > 0 ? (uint32_t)(d.latency_total_us / d.transactions) : 0;
+    if (i > 0) {
+      json += ",";
+    }
+    json += "{\"name\":\"" + String(d.name) + "\",";
+    json += "\"address\":" + String(d.address) + ",";
+    json += "\"priority\":" + String((int)d.priority) + ",";
+    json += "\"transactions\":" + String(d.transactions) + ",";
+    json += "\"errors\":" + String(d.errors) + ",";
+    json += "\"retries\":" + String(d.retries) + ",";
+    json += "\"bytes\":" + String(d.bytes) + ",";
+    json += "\"latency_mean_us\":" + String(mean_us) + ",";
+    json += "\"latency_max_us\":" + String(d.latency_max_us) + "}";
+  }
+  json += "]}";
   return json;
 }
 
@@ -0,0 +1,361 @@
+// Native (host) build of the altimeter: the firmware's sensor pipeline,
+// display and web payload code running on Linux behind the Arduino shims
+// in native/ (platformio.ini [env:native]).
+//
+// Flies the simulated model rocket as the device would without sensors:
+// FlightSimulator stands in for the barometer (50 Hz) and the QMI8658
+// (500 Hz) on a manual clock, so the run is reproducible and takes no
+// longer than the processing. Samples go through SensorPipeline and into
+// the compressed recording, AltimeterDisplay draws into an emulated ST7789
+// (asleep from launch to landing, as on the device), and the landed flight
+// is saved to a RAM flash partition through the segment store and
+// summarised in place. The /altimeter, /history and /logs/summary bodies
+// are printed at the end with the time each stage took.
+//
+//   pio run -e native -t exec
+//   .pio/build/native/program [--idle SECONDS] [--seed N] [--screens DIR]
+//     --idle SECONDS  stay on the ground, with the IMU from IMUSimulator
+//     --seed N        simulator seed (default 1)
+//     --screens DIR   write every display screen to DIR/screen-<n>.ppm
+//
+// Left out of `pio test -e native`, which links src/ into every test suite
+// and gives each its own main().
+
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <chrono>
+#include <vector>
+#include "native_hal.h"
+#include "st7789_panel.h"
+#include "tft_test.h"
+#include "altimeter_display.h"
+#include "imu_simulator.h"
+#include "flight_simulator.h"
+#include "sensor_pipeline.h"
+#include "history_pyramid.h"
+#include "history_json.h"
+#include "flight_recorder.h"
+#include "deferred_log.h"
+#include "web_json.h"
+
+// --- PANEL ---
+// Chip select and D/C as wired in tft_test.cpp; rotation 0 shows a 128x128
+// window of the controller's memory from column 2, row 1
+const uint8_t TFT_CS_PIN = 35;
+const uint8_t TFT_DC_PIN = 36;
+const int screen_x = 2;
+const int screen_y = 1;
+const int screen_size = 128;
+
+// --- TIMING ---
+const uint32_t imu_period_us = 2000;          // QMI8658 at 500 Hz
+const uint32_t baro_period_us = 20000;        // BMP3xx at 50 Hz
+const unsigned long display_interval = 500;   // As loop() on the device
+const int baseline_sample_count = 10;
+const uint32_t max_flight_s = 900;
+const uint64_t boot_time_us = 1000000;
+
+// NOR flash in RAM, standing in for the "flightlog" partition
+class RamFlash : public FlashDevice {
+public:
+  explicit RamFlash(size_t bytes) : memory(bytes, 0xFF) {}
+
+  size_t size() const override { return memory.size(); }
+  size_t sectorSize() const override { return 4096; }
+  const uint8_t* data() const { return memory.data(); }
+
+  bool read(size_t offset, void* out, size_t len) override {
+    if (offset + len > memory.size()) {
+      return false;
+    }
+    memcpy(out, memory.data() + offset, len);
+    return true;
+  }
+
+  bool write(size_t offset, const void* data, size_t len) override {
+    if (offset + len > memory.size()) {
+      return false;
+    }
+    const uint8_t* in = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+      memory[offset + i] &= in[i];
+    }
+    return true;
+  }
+
+  bool erase(size_t offset, size_t len) override {
+    if (offset + len > memory.size()) {
+      return false;
+    }
+    memset(memory.data() + offset, 0xFF, len);
+    return true;
+  }
+
+private:
+  std::vector<uint8_t> memory;
+};
+
+// Wall-clock time spent in one stage
+class StageTimer {
+public:
+  void start() { started = std::chrono::steady_clock::now(); }
+  void stop() {
+    double last = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    total += last;
+    longest = last > longest ? last : longest;
+    count++;
+  }
+  double getTotalMs() const { return total * 1e3; }
+  double getMaxMs() const { return longest * 1e3; }
+  double getMeanUs() const { return count > 0 ? total * 1e6 / count : 0.0; }
+  uint32_t getCount() const { return count; }
+
+private:
+  std::chrono::steady_clock::time_point started;
+  double total = 0.0;
+  double longest = 0.0;
+  uint32_t count = 0;
+};
+
+// --- GLOBAL OBJECTS ---
+St7789Panel panel(TFT_CS_PIN, TFT_DC_PIN);
+TFTTest tft;
+AltimeterDisplay display(&tft);
+FlightSimulator sensor_sim;
+IMUSimulator imu;
+SensorPipeline pipeline;
+const SensorState& sensors = pipeline.getState();
+HistoryPyramid history;
+FlightRecorder recorder;
+RamFlash flight_log_flash(2 * 1024 * 1024);
+bool landed = false;
+
+StageTimer pipeline_timer;
+StageTimer display_timer;
+StageTimer archive_timer;
+
+uint32_t sensorClock() {
+  return micros();
+}
+
+// The log drain task's job, done in line so the output keeps its order
+void drainLog() {
+  DeferredLog::Record record;
+  char line[192];
+  while (dlog.pop(record)) {
+    size_t len = DeferredLog::formatRecord(record, line, sizeof(line));
+    Serial.write((const uint8_t*)line, len);
+    Serial.println();
+  }
+}
+
+void onDisplayImuSample(ImuFilterBank::Stream /*stream*/, const ImuSample& sample) {
+  display.setIMUData(sample.accel_x, sample.accel_y, sample.accel_z, sample.gyro_x, sample.gyro_y, sample.gyro_z);
+}
+
+void onPipelineEvent(const SensorPipeline::Event& event) {
+  if (event.type != SensorPipeline::EVENT_PHASE_CHANGE) {
+    return;
+  }
+  static const uint16_t phase_messages[PHASE_COUNT] = {
+    LOG_PHASE_PRELAUNCH, LOG_PHASE_BOOST, LOG_PHASE_COAST, LOG_PHASE_DESCENT, LOG_PHASE_LANDED
+  };
+  dlog.log(phase_messages[event.phase], event.value);
+
+  // Headless in flight, as on the device
+  if (event.phase == PHASE_BOOST) {
+    tft.sleep();
+  } else if (event.phase == PHASE_LANDED) {
+    tft.wake();
+    display.forceRefresh();
+  }
+
+  if (event.phase == PHASE_LANDED) {
+    landed = true;
+  }
+  recorder.onPhaseChange(event.phase, true);
+}
+
+void updateDisplay(bool imu_ok) {
+  display.setPipelineData(pipeline);
+  display.setSensorStatus(false, imu_ok);
+  display.setBatteryData(0.0f, 0);
+  display_timer.start();
+  display.update();
+  display_timer.stop();
+}
+
+// Saves one block per call, then summarises the log in place a few blocks
+// per call
+void updateArchive() {
+  archive_timer.start();
+  bool finished = recorder.update();
+  archive_timer.stop();
+  if (finished) {
+    display.setFlightSummary(recorder.getLastSummary());
+  }
+}
+
+String readHistoryJSON(HistoryPyramid::Channel channel, size_t points) {
+  HistoryJsonStream body(history, channel, history.getOldestMs(), history.getNewestMs() + 1, points);
+  String json;
+  uint8_t buffer[512];
+  size_t len;
+  while ((len = body.read(buffer, sizeof(buffer) - 1)) > 0) {
+    buffer[len] = '\0';
+    json += (const char*)buffer;
+  }
+  return json;
+}
+
+bool writeScreens(const char* directory) {
+  for (int mode = 0; mode < AltimeterDisplay::MODE_COUNT; mode++) {
+    delay(display_interval);
+    display.update();
+    char path[256];
+    snprintf(path, sizeof(path), "%s/screen-%d.ppm", directory, mode);
+    if (!panel.writePPM(path, screen_x, screen_y, screen_size, screen_size)) {
+      Serial.printf("Cannot write %s\n", path);
+      return false;
+    }
+    display.nextDisplayMode();
+  }
+  Serial.printf("Wrote %d screens to %s\n", (int)AltimeterDisplay::MODE_COUNT, directory);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  uint32_t idle_s = 0;
+  uint32_t seed = 1;
+  const char* screens = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--idle") == 0 && i + 1 < argc) {
+      idle_s = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--screens") == 0 && i + 1 < argc) {
+      screens = argv[++i];
+    } else {
+      Serial.printf("usage: %s [--idle SECONDS] [--seed N] [--screens DIR]\n", argv[0]);
+      return 2;
+    }
+  }
+  // Sensor time from a fixed point after boot, so runs repeat exactly
+  nativeSetManualClock(true);
+  nativeSetMicros(boot_time_us);
+
+  // Display on the emulated panel
+  SPI.attachDevice(&panel);
+  tft.startInit();
+  while (!tft.pollInit()) {
+    delay(1);
+  }
+  size_t history_bytes = HistoryPyramid::requiredBytes();
+  if (history.begin(ps_malloc(history_bytes), history_bytes)) {
+    pipeline.setHistory(&history);
+    display.setHistory(&history);
+  }
+  display.begin();
+
+  // Sensors: the simulated flight, or the ground with IMUSimulator noise
+  sensor_sim.begin(idle_s > 0 ? FlightProfile::groundIdle() : FlightProfile::modelRocket(), seed);
+  sensor_sim.setClock(sensorClock);
+  BaroSource* baro_source = &sensor_sim;
+  ImuSource* imu_source = &sensor_sim;
+  if (idle_s > 0) {
+    imu.reseed(seed);
+    imu.begin();
+    imu_source = &imu;
+  }
+  recorder.begin();
+  recorder.beginLogs(&flight_log_flash, flight_log_flash.data());
+  pipeline.setEventHandler(onPipelineEvent);
+
+  // Ground reference from the first reading, as bootPollBarometer() does
+  BaroSample first;
+  if (!baro_source->read(first)) {
+    Serial.println("No barometer reading");
+    return 1;
+  }
+  pipeline.seed(first.pressure_pa, first.temperature_c);
+  pipeline.setGroundReference(first.pressure_pa, sensors.current_altitude);
+  pipeline.refineGroundReference(baseline_sample_count);
+  pipeline.resetMaxAcceleration(1.0);
+  pipeline.getImuStreams().setInputRate(1000000 / imu_period_us);
+  pipeline.getImuStreams().subscribe(ImuFilterBank::STREAM_DISPLAY, onDisplayImuSample);
+  Serial.printf("Native run: %s, seed %u\n", idle_s > 0 ? "ground idle with IMUSimulator" : "model rocket flight",
+                (unsigned)seed);
+
+  // Sampling at the sensors' rates until the flight is saved and summarised
+  uint64_t end_us = boot_time_us + (uint64_t)(idle_s > 0 ? idle_s : max_flight_s) * 1000000;
+  unsigned long last_display_update = millis();
+  uint32_t step = 0;
+  while (nativeGetMicros() < end_us && !(landed && !recorder.isSaving() && !recorder.isSummarising())) {
+    nativeAdvanceMicros(imu_period_us);
+    BaroSample baro;
+    ImuSample imu_sample;
+    bool have_baro = step++ % (baro_period_us / imu_period_us) == 0 && baro_source->read(baro);
+    bool have_imu = imu_source->read(imu_sample);
+    recorder.record(&baro, have_baro ? 1 : 0, &imu_sample, have_imu ? 1 : 0);
+    pipeline_timer.start();
+    pipeline.process(have_baro ? &baro : nullptr, have_imu ? &imu_sample : nullptr);
+    pipeline_timer.stop();
+
+    if (!tft.isSleeping() && !tft.isReady()) {
+      tft.pollInit();
+    }
+    if (tft.isReady() && millis() - last_display_update >= display_interval) {
+      updateDisplay(true);
+      last_display_update = millis();
+    }
+    if (recorder.isSaving() || recorder.isSummarising()) {
+      updateArchive();
+    }
+    drainLog();
+  }
+  if (tft.isReady()) {
+    updateDisplay(true);
+  }
+  drainLog();
+
+  Serial.printf("\nSimulated %.1f s: apogee %.1f m AGL (true %.1f m), max %.2f g, phase %s\n",
+                (nativeGetMicros() - boot_time_us) / 1e6, sensors.max_altitude - sensors.baseline_altitude, sensor_sim.getMaxAltitudeAgl(),
+                sensors.max_acceleration, FlightPhaseDetector::getPhaseName(pipeline.getPhaseDetector().getPhase()));
+  Serial.printf("Pipeline: %u baro + %u IMU samples, %.3f us per step\n", (unsigned)sensors.baro_samples,
+                (unsigned)sensors.imu_samples, pipeline_timer.getMeanUs());
+  Serial.printf("Display:  %u updates, %.1f us each, %u SPI bytes, %u pixels on the panel\n",
+                (unsigned)display_timer.getCount(), display_timer.getMeanUs(), (unsigned)tft.getBytesTransferred(),
+                (unsigned)panel.getPixelsWritten());
+  if (archive_timer.getCount() > 0) {
+    Serial.printf("Archive:  %u save and summary steps in %.2f ms, the longest %.2f ms\n",
+                  (unsigned)archive_timer.getCount(), archive_timer.getTotalMs(), archive_timer.getMaxMs());
+  }
+
+  AltimeterStatus status;
+  status.battery_voltage = 0.0f;
+  status.battery_percentage = 0;
+  status.bmp_available = false;
+  status.imu_available = true;
+  status.recording = recorder.isRecording();
+  status.baro_recording = &recorder.getBaroRecording();
+  status.imu_recording = &recorder.getImuRecording();
+  Serial.printf("\nGET /altimeter\n%s\n", getAltimeterJSON(pipeline, status).c_str());
+  if (history.isReady()) {
+    Serial.printf("\nGET /history?channel=altitude&points=40\n%s\n",
+                  readHistoryJSON(HistoryPyramid::CHANNEL_ALTITUDE, 40).c_str());
+  }
+  const FlightSummary* summary = recorder.getLastSummary();
+  if (summary != nullptr) {
+    Serial.printf("\nGET /logs/summary?name=flight-%u.ttfa\n%s\n", (unsigned)summary->flight_number,
+                  getFlightSummaryJSON(*summary).c_str());
+  }
+
+  if (screens != nullptr && !writeScreens(screens)) {
+    return 1;
+  }
+  Serial.flush();
+  return idle_s > 0 || summary != nullptr ? 0 : 1;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,47 @@
+#include "mapped_log.h"
+
+static_assert(SegmentStore::SEGMENT_DATA_BYTES % MappedLog::PAGE_BYTES == 0 &&
+              SegmentStore::DATA_OFFSET % MappedLog::PAGE_BYTES == 0, "segment data must be whole pages");
+
+MappedLog::MappedLog() {
+    clear();
+}
+
+void MappedLog::clear() {
+    page_count = 0;
+    size = 0;
+}
+
+bool MappedLog::mapStore(const SegmentStore& store, const SegmentStore::Log& log, const uint8_t* flash) {
+    clear();
+    if (flash == nullptr || !store.isReady() || log.bytes == 0) {
+        return false;
+    }
+    const uint32_t pages_per_segment = SegmentStore::SEGMENT_DATA_BYTES / PAGE_BYTES;
+    uint32_t count = (log.bytes + PAGE_BYTES - 1) / PAGE_BYTES;
+    if (count > MAX_PAGES) {
+        return false;
+    }
+    for (uint32_t p = 0; p < count; p++) {
+        int segment = (log.first_segment + (int)(p / pages_per_segment)) % store.getSegmentCount();
+        pages[p] = flash + store.getSegmentFlashOffset(segment) + SegmentStore::DATA_OFFSET +
+                   (p % pages_per_segment) * PAGE_BYTES;
+    }
+    page_count = count;
+    size = log.bytes;
+    return true;
+}
+
+bool MappedLog::mapMemory(const uint8_t* data, size_t bytes) {
+    clear();
+    uint32_t count = (bytes + PAGE_BYTES - 1) / PAGE_BYTES;
+    if (data == nullptr || bytes == 0 || count > MAX_PAGES) {
+        return false;
+    }
+    for (uint32_t p = 0; p < count; p++) {
+        pages[p] = data + (size_t)p * PAGE_BYTES;
+    }
+    page_count = count;
+    size = bytes;
+    return true;
+}
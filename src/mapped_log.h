@@ -0,0 +1,38 @@
+#ifndef MAPPED_LOG_H
+#define MAPPED_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "segment_store.h"
+
+// A stored log read in place from memory-mapped flash, as a table of
+// PAGE_BYTES pages. A log is split across segments, each starting after a
+// metadata sector and wrapping at the end of the partition, so it is not
+// contiguous even when mapped - but every page is, and a flight archive
+// block is exactly one page. Building the table reads nothing from flash.
+// The pages stay valid until the store overwrites the log's segments.
+class MappedLog {
+public:
+    static const size_t PAGE_BYTES = 4096;
+    static const uint32_t MAX_PAGES = SegmentStore::MAX_SEGMENTS * (SegmentStore::SEGMENT_DATA_BYTES / PAGE_BYTES);
+
+    MappedLog();
+
+    // flash is the store's device mapped from its offset 0
+    bool mapStore(const SegmentStore& store, const SegmentStore::Log& log, const uint8_t* flash);
+    // A whole log in one buffer, e.g. a downloaded file mmap()ed on a host
+    bool mapMemory(const uint8_t* data, size_t size);
+    void clear();
+
+    size_t getSize() const { return size; }
+    uint32_t getPageCount() const { return page_count; }   // The last may be partial
+    const uint8_t* getPage(uint32_t page) const { return pages[page]; }
+    const uint8_t* const* getPages() const { return pages; }
+
+private:
+    const uint8_t* pages[MAX_PAGES];
+    uint32_t page_count;
+    size_t size;
+};
+
+#endif // MAPPED_LOG_H
@@ -0,0 +1,81 @@
+#include "metrics.h"
+#include "deferred_log.h"
+
+// Zero-initialised before any dynamic initialisation, so registration from
+// global constructors in other translation units is safe
+static Metric* metrics_head = nullptr;
+static Metric* metrics_tail = nullptr;
+
+// --- SYSTEM METRICS ---
+static Gauge heap_free("altimeter_heap_free_bytes", "Free internal heap");
+static Gauge heap_min_free("altimeter_heap_min_free_bytes", "Lowest free internal heap since boot");
+static Gauge heap_largest_block("altimeter_heap_largest_free_block_bytes", "Largest allocatable internal heap block");
+static Gauge psram_size("altimeter_psram_size_bytes", "Total PSRAM");
+static Gauge psram_free("altimeter_psram_free_bytes", "Free PSRAM");
+static Gauge uptime("altimeter_uptime_seconds", "Time since boot");
+static Gauge log_dropped("altimeter_log_dropped_messages", "Deferred log messages dropped because the buffer was full");
+
+Metric::Metric(const char* metric_name, const char* metric_help, Type metric_type) {
+    name = metric_name;
+    help = metric_help;
+    type = metric_type;
+    next = nullptr;
+
+    // Append so the exposition order follows declaration order
+    if (metrics_tail == nullptr) {
+        metrics_head = this;
+    } else {
+        metrics_tail->next = this;
+    }
+    metrics_tail = this;
+}
+
+Metric* Metric::first() {
+    return metrics_head;
+}
+
+void Counter::printValue(Print& out) const {
+    out.printf("%u", (unsigned)get());
+}
+
+void Gauge::printValue(Print& out) const {
+    float v = get();
+    if (isnan(v) || isinf(v)) {
+        out.print("0");  // Neither format accepts NaN/Inf reliably
+    } else {
+        out.printf("%.3f", v);
+    }
+}
+
+void collectSystemMetrics() {
+    heap_free.set(ESP.getFreeHeap());
+    heap_min_free.set(ESP.getMinFreeHeap());
+    heap_largest_block.set(ESP.getMaxAllocHeap());
+    psram_size.set(ESP.getPsramSize());
+    psram_free.set(ESP.getFreePsram());
+    uptime.set(millis() / 1000.0f);
+    log_dropped.set(dlog.getDroppedCount());
+}
+
+void writeMetricsText(Print& out) {
+    for (Metric* m = Metric::first(); m != nullptr; m = m->getNext()) {
+        out.printf("# HELP %s %s\n", m->getName(), m->getHelp());
+        out.printf("# TYPE %s %s\n", m->getName(), m->getType() == Metric::TYPE_COUNTER ? "counter" : "gauge");
+        out.print(m->getName());
+        out.print(" ");
+        m->printValue(out);
+        out.print("\n");
+    }
+}
+
+void writeMetricsJSON(Print& out) {
+    out.print("{");
+    for (Metric* m = Metric::first(); m != nullptr; m = m->getNext()) {
+        out.printf("\"%s\":", m->getName());
+        m->printValue(out);
+        if (m->getNext() != nullptr) {
+            out.print(",");
+        }
+    }
+    out.print("}");
+}
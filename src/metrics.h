@@ -0,0 +1,72 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Runtime health metrics.
+// Counters and gauges are plain global objects that register themselves at
+// static-init time, so any subsystem can declare one next to the code that
+// updates it. Updates are single relaxed atomic operations and are safe from
+// any task; the registry is only walked when /metrics is scraped.
+class Metric {
+public:
+    enum Type {
+        TYPE_COUNTER = 0,
+        TYPE_GAUGE = 1
+    };
+
+    Metric(const char* name, const char* help, Type type);
+
+    const char* getName() const { return name; }
+    const char* getHelp() const { return help; }
+    Type getType() const { return type; }
+    Metric* getNext() const { return next; }
+
+    virtual void printValue(Print& out) const = 0;
+
+    static Metric* first();
+
+private:
+    const char* name;
+    const char* help;
+    Type type;
+    Metric* next;
+};
+
+class Counter : public Metric {
+public:
+    Counter(const char* name, const char* help) : Metric(name, help, TYPE_COUNTER), value(0) {}
+
+    void increment(uint32_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+    uint32_t get() const { return value.load(std::memory_order_relaxed); }
+
+    void printValue(Print& out) const override;
+
+private:
+    std::atomic<uint32_t> value;
+};
+
+class Gauge : public Metric {
+public:
+    Gauge(const char* name, const char* help) : Metric(name, help, TYPE_GAUGE), value(0.0f) {}
+
+    void set(float v) { value.store(v, std::memory_order_relaxed); }
+    float get() const { return value.load(std::memory_order_relaxed); }
+
+    void printValue(Print& out) const override;
+
+private:
+    std::atomic<float> value;
+};
+
+// Refreshes the heap/PSRAM/uptime gauges; called right before rendering
+void collectSystemMetrics();
+
+// Prometheus text exposition format (version 0.0.4)
+void writeMetricsText(Print& out);
+
+// Flat JSON object: {"metric_name": value, ...}
+void writeMetricsJSON(Print& out);
+
+#endif // METRICS_H
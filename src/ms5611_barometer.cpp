@@ -0,0 +1,172 @@
+#include "ms5611_barometer.h"
+
+// Commands (MS5611-01BA03 datasheet)
+#define MS5611_CMD_RESET    0x1E
+#define MS5611_CMD_ADC_READ 0x00
+#define MS5611_CMD_D1_4096  0x48
+#define MS5611_CMD_D2_4096  0x58
+#define MS5611_CMD_PROM     0xA0
+
+static const uint32_t conversion_time_us = 9040;
+
+Ms5611Barometer::Ms5611Barometer(I2CBus& i2c, uint8_t i2c_address) : bus(i2c) {
+    address = i2c_address;
+    for (int i = 0; i < 8; i++) {
+        prom[i] = 0;
+    }
+    state = STATE_IDLE;
+    conversion_start_us = 0;
+    pressure_count = 0;
+    d2 = 0;
+    have_temperature = false;
+    has_waiting = false;
+}
+
+// CRC4 over the PROM, application note AN520
+uint8_t Ms5611Barometer::crc4(const uint16_t* words) {
+    uint16_t n[8];
+    for (int i = 0; i < 8; i++) {
+        n[i] = words[i];
+    }
+    uint16_t crc_read = n[7];
+    n[7] &= 0xFF00;
+
+    uint16_t rem = 0;
+    for (int cnt = 0; cnt < 16; cnt++) {
+        if (cnt % 2 == 1) {
+            rem ^= n[cnt >> 1] & 0x00FF;
+        } else {
+            rem ^= n[cnt >> 1] >> 8;
+        }
+        for (int bit = 8; bit > 0; bit--) {
+            if (rem & 0x8000) {
+                rem = (rem << 1) ^ 0x3000;
+            } else {
+                rem = rem << 1;
+            }
+        }
+    }
+    n[7] = crc_read;
+    return (rem >> 12) & 0x0F;
+}
+
+bool Ms5611Barometer::begin() {
+    if (!bus.writeCommand(address, MS5611_CMD_RESET)) {
+        return false;
+    }
+    delay(3);   // Only at boot: PROM reload takes 2.8 ms
+
+    bool all_zero = true;
+    for (uint8_t i = 0; i < 8; i++) {
+        uint8_t raw[2];
+        if (!bus.readRegister(address, MS5611_CMD_PROM + i * 2, raw, 2)) {
+            return false;
+        }
+        prom[i] = (raw[0] << 8) | raw[1];
+        if (prom[i] != 0) {
+            all_zero = false;
+        }
+    }
+    // A BMP180 at the same address ACKs too; its answer fails the CRC
+    if (all_zero || crc4(prom) != (prom[7] & 0x0F)) {
+        return false;
+    }
+
+    have_temperature = false;
+    has_waiting = false;
+    return startConversion();
+}
+
+bool Ms5611Barometer::startCommand(uint8_t command, State next) {
+    if (!bus.writeCommand(address, command)) {
+        state = STATE_IDLE;
+        return false;
+    }
+    state = next;
+    conversion_start_us = micros();
+    return true;
+}
+
+bool Ms5611Barometer::startConversion() {
+    if (!have_temperature || pressure_count >= TEMPERATURE_EVERY) {
+        return startCommand(MS5611_CMD_D2_4096, STATE_TEMPERATURE);
+    }
+    return startCommand(MS5611_CMD_D1_4096, STATE_PRESSURE);
+}
+
+bool Ms5611Barometer::readAdc(uint32_t& value) {
+    uint8_t raw[3];
+    if (!bus.writeCommand(address, MS5611_CMD_ADC_READ) || !bus.read(address, raw, 3)) {
+        return false;
+    }
+    value = ((uint32_t)raw[0] << 16) | ((uint32_t)raw[1] << 8) | raw[2];
+    // Reading before the conversion finished returns 0
+    return value != 0;
+}
+
+bool Ms5611Barometer::poll() {
+    if (has_waiting) {
+        return true;
+    }
+    if (state == STATE_IDLE) {
+        startConversion();
+        return false;
+    }
+    if (micros() - conversion_start_us < conversion_time_us) {
+        return false;
+    }
+
+    uint32_t value;
+    bool ok = readAdc(value);
+    if (state == STATE_TEMPERATURE) {
+        if (ok) {
+            d2 = value;
+            have_temperature = true;
+            pressure_count = 0;
+        }
+    } else if (ok) {
+        pressure_count++;
+        compensate(value);
+    }
+    startConversion();
+    return has_waiting;
+}
+
+void Ms5611Barometer::compensate(uint32_t d1) {
+    // Datasheet first order, then second order below 20 C
+    int32_t dt = (int32_t)d2 - ((int32_t)prom[5] << 8);
+    int32_t temp = 2000 + (int32_t)(((int64_t)dt * prom[6]) >> 23);
+    int64_t off = ((int64_t)prom[2] << 16) + (((int64_t)prom[4] * dt) >> 7);
+    int64_t sens = ((int64_t)prom[1] << 15) + (((int64_t)prom[3] * dt) >> 8);
+
+    if (temp < 2000) {
+        int32_t t2 = (int32_t)(((int64_t)dt * dt) >> 31);
+        int64_t low = (int64_t)(temp - 2000) * (temp - 2000);
+        int64_t off2 = 5 * low / 2;
+        int64_t sens2 = 5 * low / 4;
+        if (temp < -1500) {
+            int64_t very_low = (int64_t)(temp + 1500) * (temp + 1500);
+            off2 += 7 * very_low;
+            sens2 += 11 * very_low / 2;
+        }
+        temp -= t2;
+        off -= off2;
+        sens -= sens2;
+    }
+
+    int32_t p = (int32_t)((((int64_t)d1 * sens >> 21) - off) >> 15);
+
+    waiting.time_us = conversion_start_us + conversion_time_us;
+    waiting.pressure_pa = p;
+    waiting.temperature_c = temp / 100.0f;
+    has_waiting = true;
+}
+
+size_t Ms5611Barometer::readBatch(BaroSample* out, size_t max) {
+    if (max == 0 || !poll()) {
+        return 0;
+    }
+    out[0] = waiting;
+    has_waiting = false;
+    return 1;
+}
@@ -0,0 +1,57 @@
+#ifndef MS5611_BAROMETER_H
+#define MS5611_BAROMETER_H
+
+#include "barometer.h"
+
+// MS5611 driver at OSR 4096 (~10 ms per conversion, 0.012 mbar RMS).
+// Like the BMP180 it alternates pressure (D1) and temperature (D2)
+// conversions, refreshing temperature only every TEMPERATURE_EVERY samples.
+class Ms5611Barometer : public Barometer {
+public:
+    static const uint8_t ADDRESS_PRIMARY = 0x77;     // CSB low
+    static const uint8_t ADDRESS_SECONDARY = 0x76;   // CSB high
+
+    Ms5611Barometer(I2CBus& bus, uint8_t address = ADDRESS_PRIMARY);
+
+    void setAddress(uint8_t i2c_address) { address = i2c_address; }
+
+    bool begin() override;
+    bool startConversion() override;
+    bool poll() override;
+    size_t readBatch(BaroSample* out, size_t max) override;
+
+    Type getType() const override { return TYPE_MS5611; }
+    const char* getName() const override { return "MS5611"; }
+    uint8_t getAddress() const override { return address; }
+    uint32_t getMaxClockHz() const override { return 400000; }
+
+private:
+    static const uint8_t TEMPERATURE_EVERY = 8;
+
+    enum State {
+        STATE_IDLE,
+        STATE_TEMPERATURE,
+        STATE_PRESSURE
+    };
+
+    I2CBus& bus;
+    uint8_t address;
+    uint16_t prom[8];   // prom[1..6] are the datasheet's C1..C6
+
+    State state;
+    uint32_t conversion_start_us;
+    uint8_t pressure_count;
+    uint32_t d2;        // Last raw temperature
+    bool have_temperature;
+
+    BaroSample waiting;
+    bool has_waiting;
+
+    bool startCommand(uint8_t command, State next);
+    bool readAdc(uint32_t& value);
+    void compensate(uint32_t d1);
+
+    static uint8_t crc4(const uint16_t* prom);
+};
+
+#endif // MS5611_BAROMETER_H
@@ -0,0 +1,124 @@
+#include "network_manager.h"
+#include <WiFi.h>
+#include "deferred_log.h"
+#include "metrics.h"
+
+static Gauge wifi_active("altimeter_wifi_active", "1 while the softAP and web server are running");
+static Gauge wifi_start_time("altimeter_wifi_start_ms", "Time taken by the last WiFi/web server start");
+static Gauge heap_wifi_off("altimeter_heap_free_wifi_off_bytes", "Free heap just before the network stack was last started");
+static Gauge heap_wifi_on("altimeter_heap_free_wifi_on_bytes", "Free heap just after the network stack was last started");
+static Counter wifi_starts("altimeter_wifi_starts_total", "Times the network stack was started");
+
+NetworkManager::NetworkManager(const char* ap_ssid, const char* ap_password, const char* ap_hostname) {
+    ssid = ap_ssid;
+    password = ap_password;
+    hostname = ap_hostname;
+    server_start = nullptr;
+    server_stop = nullptr;
+    desired_on = false;
+    allowed = true;
+    active = false;
+    worker = nullptr;
+}
+
+bool NetworkManager::begin(ServerHook on_start, ServerHook on_stop) {
+    server_start = on_start;
+    server_stop = on_stop;
+    if (worker != nullptr) {
+        return true;
+    }
+    // Low priority on core 0, next to the WiFi driver and away from loop()
+    return xTaskCreatePinnedToCore(workerTask, "netmgr", 4096, this, 1, &worker, 0) == pdPASS;
+}
+
+void NetworkManager::requestStart() {
+    desired_on = true;
+    notifyWorker();
+}
+
+void NetworkManager::requestStop() {
+    desired_on = false;
+    notifyWorker();
+}
+
+void NetworkManager::toggle() {
+    desired_on = !desired_on;
+    notifyWorker();
+}
+
+void NetworkManager::setAllowed(bool is_allowed) {
+    if (allowed == is_allowed) {
+        return;
+    }
+    allowed = is_allowed;
+    if (!allowed) {
+        desired_on = false;  // Don't come back on by surprise after the flight
+    }
+    notifyWorker();
+}
+
+uint8_t NetworkManager::getClientCount() {
+    return active ? WiFi.softAPgetStationNum() : 0;
+}
+
+void NetworkManager::notifyWorker() {
+    if (worker != nullptr) {
+        xTaskNotifyGive(worker);
+    }
+}
+
+void NetworkManager::applyState() {
+    bool want = desired_on && allowed;
+    if (want && !active) {
+        start();
+    } else if (!want && active) {
+        stop();
+    }
+}
+
+void NetworkManager::start() {
+    uint32_t heap_before = ESP.getFreeHeap();
+    uint32_t started = millis();
+
+    DLOG(WIFI_INIT);
+    WiFi.setHostname(hostname);
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(ssid, password);
+    if (server_start != nullptr) {
+        server_start();
+    }
+    active = true;
+
+    IPAddress ip = WiFi.softAPIP();
+    DLOG(WIFI_AP_SSID, ssid);
+    DLOG(WIFI_IP, ip[0], ip[1], ip[2], ip[3]);
+
+    uint32_t elapsed = millis() - started;
+    wifi_starts.increment();
+    wifi_active.set(1);
+    wifi_start_time.set(elapsed);
+    heap_wifi_off.set(heap_before);
+    heap_wifi_on.set(ESP.getFreeHeap());
+    DLOG(WIFI_READY);
+    DLOG(NET_STARTED, elapsed, heap_before, ESP.getFreeHeap());
+}
+
+void NetworkManager::stop() {
+    active = false;
+    if (server_stop != nullptr) {
+        server_stop();
+    }
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_OFF);  // Stops and deinitialises the driver, returning its heap
+
+    wifi_active.set(0);
+    DLOG(NET_STOPPED, ESP.getFreeHeap());
+}
+
+void NetworkManager::workerTask(void* param) {
+    NetworkManager* manager = static_cast<NetworkManager*>(param);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        manager->applyState();
+    }
+}
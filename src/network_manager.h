@@ -0,0 +1,49 @@
+#ifndef NETWORK_MANAGER_H
+#define NETWORK_MANAGER_H
+
+#include <Arduino.h>
+
+// On-demand softAP lifecycle.
+// The network stack is off by default. Start/stop requests only set the
+// desired state and wake a worker task on core 0, which brings WiFi and the
+// web server up or fully tears them down (releasing the WiFi driver heap),
+// so the sensing loop never waits on the radio. While not allowed (during
+// flight) any running stack is stopped and start requests are ignored.
+class NetworkManager {
+public:
+    typedef void (*ServerHook)();
+
+    NetworkManager(const char* ssid, const char* password, const char* hostname);
+
+    // Creates the worker task; on_start/on_stop begin and end the web server
+    bool begin(ServerHook on_start, ServerHook on_stop);
+
+    void requestStart();
+    void requestStop();
+    void toggle();
+    void setAllowed(bool is_allowed);
+
+    bool isActive() { return active; }
+    bool isAllowed() { return allowed; }
+    uint8_t getClientCount();
+
+private:
+    const char* ssid;
+    const char* password;
+    const char* hostname;
+    ServerHook server_start;
+    ServerHook server_stop;
+
+    volatile bool desired_on;
+    volatile bool allowed;
+    volatile bool active;
+    TaskHandle_t worker;
+
+    void notifyWorker();
+    void applyState();
+    void start();
+    void stop();
+    static void workerTask(void* param);
+};
+
+#endif // NETWORK_MANAGER_H
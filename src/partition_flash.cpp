@@ -0,0 +1,36 @@
+#include "partition_flash.h"
+
+PartitionFlash::PartitionFlash() {
+    partition = nullptr;
+    mapped = nullptr;
+    mapping = 0;
+}
+
+bool PartitionFlash::begin(const char* label) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    return partition != nullptr;
+}
+
+size_t PartitionFlash::size() const {
+    return partition != nullptr ? partition->size : 0;
+}
+
+bool PartitionFlash::read(size_t offset, void* out, size_t len) {
+    return partition != nullptr && esp_partition_read(partition, offset, out, len) == ESP_OK;
+}
+
+bool PartitionFlash::write(size_t offset, const void* data, size_t len) {
+    return partition != nullptr && esp_partition_write(partition, offset, data, len) == ESP_OK;
+}
+
+bool PartitionFlash::erase(size_t offset, size_t len) {
+    return partition != nullptr && esp_partition_erase_range(partition, offset, len) == ESP_OK;
+}
+
+const uint8_t* PartitionFlash::map() {
+    if (mapped == nullptr && partition != nullptr &&
+        esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &mapping) != ESP_OK) {
+        mapped = nullptr;
+    }
+    return static_cast<const uint8_t*>(mapped);
+}
@@ -0,0 +1,33 @@
+#ifndef PARTITION_FLASH_H
+#define PARTITION_FLASH_H
+
+#include <esp_partition.h>
+#include "flash_device.h"
+
+// FlashDevice on a raw data partition from partitions.csv, found by label.
+// map() also makes the whole partition readable in place through the
+// flash cache (esp_partition_mmap), so logs can be decoded without copying;
+// the mapping reflects later writes, as IDF invalidates the cache for them.
+class PartitionFlash : public FlashDevice {
+public:
+    PartitionFlash();
+
+    bool begin(const char* label);
+    bool isReady() const { return partition != nullptr; }
+
+    size_t size() const override;
+    size_t sectorSize() const override { return SPI_FLASH_SEC_SIZE; }
+    bool read(size_t offset, void* out, size_t len) override;
+    bool write(size_t offset, const void* data, size_t len) override;
+    bool erase(size_t offset, size_t len) override;
+
+    // Address of offset 0, mapped on first use; null if that fails
+    const uint8_t* map();
+
+private:
+    const esp_partition_t* partition;
+    const void* mapped;
+    esp_partition_mmap_handle_t mapping;
+};
+
+#endif // PARTITION_FLASH_H
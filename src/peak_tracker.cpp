@@ -0,0 +1,78 @@
+#include "peak_tracker.h"
+
+PeakTracker::PeakTracker() {
+    reset(AccelFx());
+}
+
+void PeakTracker::reset(AccelFx floor) {
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        Peak& p = peaks[c];
+        p.valid = false;
+        p.value = floor;
+        p.time_ms = 0;
+        p.time_us = 0;
+        p.phase = PHASE_PRELAUNCH;
+        p.context_count = 0;
+        p.peak_index = 0;
+        post_remaining[c] = 0;
+    }
+    history_count = 0;
+    history_next = 0;
+}
+
+void PeakTracker::add(uint32_t time_ms, uint32_t time_us, FlightPhase phase,
+                      const AccelFx accel[3], AccelFx magnitude) {
+    for (int i = 0; i < 3; i++) {
+        update(i, accel[i], accel[i].abs(), time_ms, time_us, phase);
+    }
+    update(CHANNEL_MAGNITUDE, magnitude, magnitude, time_ms, time_us, phase);
+
+    // The history ring only ever holds samples before the current one
+    for (int i = 0; i < 3; i++) {
+        history[i][history_next] = accel[i];
+    }
+    history[CHANNEL_MAGNITUDE][history_next] = magnitude;
+    history_next = (history_next + 1) % PRE_SAMPLES;
+    if (history_count < PRE_SAMPLES) {
+        history_count++;
+    }
+}
+
+void PeakTracker::update(int channel, AccelFx reading, AccelFx level,
+                         uint32_t time_ms, uint32_t time_us, FlightPhase phase) {
+    Peak& p = peaks[channel];
+
+    if (level > p.value) {
+        p.valid = true;
+        p.value = level;
+        p.time_ms = time_ms;
+        p.time_us = time_us;
+        p.phase = phase;
+
+        // Oldest history entry first
+        int start = (history_next + PRE_SAMPLES - history_count) % PRE_SAMPLES;
+        for (int i = 0; i < history_count; i++) {
+            p.context[i] = history[channel][(start + i) % PRE_SAMPLES];
+        }
+        p.peak_index = history_count;
+        p.context[history_count] = reading;
+        p.context_count = history_count + 1;
+        post_remaining[channel] = POST_SAMPLES;
+        return;
+    }
+
+    if (post_remaining[channel] > 0) {
+        p.context[p.context_count++] = reading;
+        post_remaining[channel]--;
+    }
+}
+
+const char* PeakTracker::getChannelName(Channel channel) {
+    switch (channel) {
+        case CHANNEL_X:         return "x";
+        case CHANNEL_Y:         return "y";
+        case CHANNEL_Z:         return "z";
+        case CHANNEL_MAGNITUDE: return "magnitude";
+        default:                return "unknown";
+    }
+}
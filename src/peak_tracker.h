@@ -0,0 +1,64 @@
+#ifndef PEAK_TRACKER_H
+#define PEAK_TRACKER_H
+
+#include <stdint.h>
+#include "fixed_point.h"
+#include "flight_phase.h"
+
+// Peak-hold acceleration tracking on every IMU sample.
+// Each channel (|X|, |Y|, |Z| and the vector magnitude) keeps its highest
+// reading together with when it happened, the flight phase at the time and
+// the samples around it: the PRE_SAMPLES before the peak come from a short
+// history ring, the POST_SAMPLES after it are filled in as they arrive. A new
+// peak restarts the capture. Work per sample is bounded by a copy of the
+// history ring, so the cost stays constant at any IMU rate.
+class PeakTracker {
+public:
+    enum Channel {
+        CHANNEL_X,
+        CHANNEL_Y,
+        CHANNEL_Z,
+        CHANNEL_MAGNITUDE,
+        CHANNEL_COUNT
+    };
+
+    static const int PRE_SAMPLES = 8;
+    static const int POST_SAMPLES = 8;
+    static const int CONTEXT_SAMPLES = PRE_SAMPLES + 1 + POST_SAMPLES;
+
+    struct Peak {
+        bool valid;                         // False until a reading beats the floor
+        AccelFx value;                      // Peak (absolute value for the axes)
+        uint32_t time_ms;                   // Pipeline clock
+        uint32_t time_us;                   // Sample timestamp
+        FlightPhase phase;
+        AccelFx context[CONTEXT_SAMPLES];   // Signed readings, oldest first
+        uint8_t context_count;
+        uint8_t peak_index;                 // Position of the peak in context
+    };
+
+    PeakTracker();
+
+    // Forgets all peaks; readings must exceed floor to count as a peak
+    void reset(AccelFx floor);
+
+    void add(uint32_t time_ms, uint32_t time_us, FlightPhase phase,
+             const AccelFx accel[3], AccelFx magnitude);
+
+    const Peak& getPeak(Channel channel) const { return peaks[channel]; }
+    bool isCapturing(Channel channel) const { return post_remaining[channel] > 0; }
+
+    static const char* getChannelName(Channel channel);
+
+private:
+    Peak peaks[CHANNEL_COUNT];
+    AccelFx history[CHANNEL_COUNT][PRE_SAMPLES];
+    uint8_t history_count;
+    uint8_t history_next;
+    uint8_t post_remaining[CHANNEL_COUNT];
+
+    void update(int channel, AccelFx reading, AccelFx level,
+                uint32_t time_ms, uint32_t time_us, FlightPhase phase);
+};
+
+#endif // PEAK_TRACKER_H
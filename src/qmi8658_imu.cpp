@@ -0,0 +1,244 @@
+#include "qmi8658_imu.h"
+#include "metrics.h"
+
+// Registers (QMI8658C datasheet, section 9)
+#define QMI_REG_WHO_AM_I      0x00
+#define QMI_REG_CTRL1         0x02
+#define QMI_REG_CTRL2         0x03
+#define QMI_REG_CTRL3         0x04
+#define QMI_REG_CTRL5         0x06
+#define QMI_REG_CTRL7         0x08
+#define QMI_REG_CTRL9         0x0A
+#define QMI_REG_FIFO_WTM_TH   0x13
+#define QMI_REG_FIFO_CTRL     0x14
+#define QMI_REG_FIFO_SMPL_CNT 0x15
+#define QMI_REG_FIFO_DATA     0x17
+#define QMI_REG_STATUSINT     0x2D
+#define QMI_REG_RESET         0x60
+
+#define QMI_WHO_AM_I          0x05
+#define QMI_RESET_VALUE       0xB0
+
+// CTRL9 host commands
+#define QMI_CMD_ACK           0x00
+#define QMI_CMD_RST_FIFO      0x04
+#define QMI_CMD_REQ_FIFO      0x05
+
+// CTRL1: register auto-increment, little endian, INT2 enabled, FIFO
+// interrupt routed to INT2
+#define QMI_CTRL1_VALUE       0x50
+
+// FIFO_CTRL: 128-sample FIFO in stream mode (oldest data overwritten)
+#define QMI_FIFO_CTRL_VALUE   ((3 << 2) | 2)
+#define QMI_FIFO_RD_MODE      0x80
+
+#define QMI_FIFO_STATUS_OVERFLOW 0x20
+
+// Full scale: +-16 g and +-2048 dps - a rocket exceeds the smaller ranges
+#define QMI_ACCEL_FS          (3 << 4)
+#define QMI_GYRO_FS           (7 << 4)
+static const float accel_lsb_per_g = 2048.0f;
+static const float gyro_lsb_per_dps = 16.0f;
+
+// ODR codes and the rates they give with both sensors enabled
+struct QmiRate {
+    uint16_t hz;
+    uint8_t code;
+    uint32_t period_us;
+};
+static const QmiRate qmi_rates[] = {
+    { 1000, 0x03, 1115 },   // 896.8 Hz
+    {  500, 0x04, 2230 },   // 448.4 Hz
+    {  250, 0x05, 4460 },   // 224.2 Hz
+    {  125, 0x06, 8921 },   // 112.1 Hz
+    {   62, 0x07, 17841 },  // 56.05 Hz
+    {   31, 0x08, 35682 }   // 28.025 Hz
+};
+
+static Counter fifo_overflows("altimeter_imu_fifo_overflows_total", "IMU FIFO overflows (samples lost before a drain)");
+static Counter fifo_bursts("altimeter_imu_fifo_bursts_total", "IMU FIFO burst reads");
+
+volatile bool Qmi8658Imu::watermark_flag = false;
+
+void IRAM_ATTR Qmi8658Imu::onWatermark() {
+    watermark_flag = true;
+}
+
+Qmi8658Imu::Qmi8658Imu(I2CBus& i2c, int int_pin) : bus(i2c) {
+    interrupt_pin = int_pin;
+    address = ADDRESS_PRIMARY;
+    sample_period_us = qmi_rates[0].period_us;
+    initialized = false;
+
+    current.time_us = 0;
+    current.accel_x = 0.0f;
+    current.accel_y = 0.0f;
+    current.accel_z = 1.0f;
+    current.gyro_x = 0.0f;
+    current.gyro_y = 0.0f;
+    current.gyro_z = 0.0f;
+}
+
+bool Qmi8658Imu::begin(uint16_t odr_hz) {
+    initialized = false;
+
+    const uint8_t addresses[] = { ADDRESS_PRIMARY, ADDRESS_SECONDARY };
+    bool found = false;
+    for (uint8_t addr : addresses) {
+        uint8_t who = 0;
+        if (bus.readRegister(addr, QMI_REG_WHO_AM_I, &who, 1) && who == QMI_WHO_AM_I) {
+            address = addr;
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    bus.writeRegister(address, QMI_REG_RESET, QMI_RESET_VALUE);
+    delay(15);   // Only at boot: the reset takes ~15 ms
+
+    const QmiRate* rate = &qmi_rates[sizeof(qmi_rates) / sizeof(qmi_rates[0]) - 1];
+    for (const QmiRate& r : qmi_rates) {
+        if (odr_hz >= r.hz) {
+            rate = &r;
+            break;
+        }
+    }
+    sample_period_us = rate->period_us;
+
+    bool ok = bus.writeRegister(address, QMI_REG_CTRL1, QMI_CTRL1_VALUE)
+              && bus.writeRegister(address, QMI_REG_CTRL2, QMI_ACCEL_FS | rate->code)
+              && bus.writeRegister(address, QMI_REG_CTRL3, QMI_GYRO_FS | rate->code)
+              && bus.writeRegister(address, QMI_REG_CTRL5, 0x11)     // Low-pass filters on, narrowest band
+              && bus.writeRegister(address, QMI_REG_FIFO_WTM_TH, WATERMARK)
+              && bus.writeRegister(address, QMI_REG_FIFO_CTRL, QMI_FIFO_CTRL_VALUE)
+              && command(QMI_CMD_RST_FIFO)
+              && bus.writeRegister(address, QMI_REG_CTRL7, 0x03);    // Accel + gyro on
+    if (!ok) {
+        return false;
+    }
+
+    if (interrupt_pin >= 0) {
+        watermark_flag = false;
+        pinMode(interrupt_pin, INPUT);
+        attachInterrupt(digitalPinToInterrupt(interrupt_pin), onWatermark, RISING);
+    }
+
+    initialized = true;
+    return true;
+}
+
+bool Qmi8658Imu::command(uint8_t cmd) {
+    if (!bus.writeRegister(address, QMI_REG_CTRL9, cmd)) {
+        return false;
+    }
+
+    // CmdDone comes back within a few microseconds; a handful of status
+    // reads is plenty and keeps a dead part from hanging the loop
+    bool done = false;
+    for (int i = 0; i < 10 && !done; i++) {
+        uint8_t status = 0;
+        if (bus.readRegister(address, QMI_REG_STATUSINT, &status, 1) && (status & 0x80)) {
+            done = true;
+        }
+    }
+    bus.writeRegister(address, QMI_REG_CTRL9, QMI_CMD_ACK);
+    return done;
+}
+
+bool Qmi8658Imu::fifoCount(size_t& samples) {
+    // FIFO_SMPL_CNT holds the low 8 bits, FIFO_STATUS the top 2; the count
+    // is in 16-bit words
+    uint8_t raw[2];
+    if (!bus.readRegister(address, QMI_REG_FIFO_SMPL_CNT, raw, 2)) {
+        return false;
+    }
+    if (raw[1] & QMI_FIFO_STATUS_OVERFLOW) {
+        fifo_overflows.increment();
+    }
+    size_t bytes = 2 * (((size_t)(raw[1] & 0x03) << 8) | raw[0]);
+    samples = bytes / FRAME_BYTES;
+    return true;
+}
+
+size_t Qmi8658Imu::readBatch(ImuSample* out, size_t max) {
+    if (!initialized || max == 0) {
+        return 0;
+    }
+    if (interrupt_pin >= 0 && !watermark_flag) {
+        return 0;
+    }
+
+    size_t available = 0;
+    if (!fifoCount(available) || available == 0) {
+        return 0;
+    }
+    size_t count = available < max ? available : max;
+
+    uint32_t read_time = micros();
+    if (!command(QMI_CMD_REQ_FIFO)) {
+        return 0;
+    }
+
+    uint8_t data[FRAMES_PER_BURST * FRAME_BYTES];
+    size_t n = 0;
+    while (n < count) {
+        size_t frames = count - n;
+        if (frames > FRAMES_PER_BURST) {
+            frames = FRAMES_PER_BURST;
+        }
+        if (!bus.readRegister(address, QMI_REG_FIFO_DATA, data, frames * FRAME_BYTES)) {
+            break;
+        }
+        fifo_bursts.increment();
+
+        for (size_t f = 0; f < frames; f++) {
+            const uint8_t* p = &data[f * FRAME_BYTES];
+            ImuSample& s = out[n + f];
+            s.accel_x = (int16_t)(p[0] | (p[1] << 8)) / accel_lsb_per_g;
+            s.accel_y = (int16_t)(p[2] | (p[3] << 8)) / accel_lsb_per_g;
+            s.accel_z = (int16_t)(p[4] | (p[5] << 8)) / accel_lsb_per_g;
+            s.gyro_x = (int16_t)(p[6] | (p[7] << 8)) / gyro_lsb_per_dps;
+            s.gyro_y = (int16_t)(p[8] | (p[9] << 8)) / gyro_lsb_per_dps;
+            s.gyro_z = (int16_t)(p[10] | (p[11] << 8)) / gyro_lsb_per_dps;
+        }
+        n += frames;
+    }
+
+    // Leave FIFO read mode so the part can write again
+    bus.writeRegister(address, QMI_REG_FIFO_CTRL, QMI_FIFO_CTRL_VALUE & ~QMI_FIFO_RD_MODE);
+
+    // The newest buffered sample is at most one period old; older ones are
+    // one ODR period apart. Samples left behind (max reached) stay queued.
+    for (size_t i = 0; i < n; i++) {
+        out[i].time_us = read_time - (uint32_t)(available - 1 - i) * sample_period_us;
+    }
+    if (n > 0) {
+        current = out[n - 1];
+    }
+    if (n == available) {
+        watermark_flag = false;   // Otherwise come back for the rest
+    }
+    return n;
+}
+
+bool Qmi8658Imu::update() {
+    Sample batch[WATERMARK * 2];
+    readBatch(batch, WATERMARK * 2);
+    return initialized;
+}
+
+bool Qmi8658Imu::read(ImuSample& out) {
+    if (!initialized) {
+        return false;
+    }
+    Sample batch[WATERMARK * 2];
+    size_t n = readBatch(batch, WATERMARK * 2);
+    if (n == 0) {
+        return false;
+    }
+    out = batch[n - 1];
+    return true;
+}
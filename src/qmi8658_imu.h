@@ -0,0 +1,68 @@
+#ifndef QMI8658_IMU_H
+#define QMI8658_IMU_H
+
+#include <Arduino.h>
+#include "i2c_bus.h"
+#include "sensor_source.h"
+
+// QMI8658C 6-axis IMU driver (the part fitted to the LOLIN S3 Mini Pro).
+// Accelerometer and gyroscope run together at up to ~1 kHz into the
+// on-chip FIFO; readBatch() pulls every buffered sample in a few burst
+// reads instead of one register read per axis per sample. When the INT2
+// pin is wired, the FIFO watermark interrupt tells the driver when a batch
+// is ready and the bus is not touched otherwise.
+//
+// The accessors match IMUSimulator, which remains the fallback backend.
+class Qmi8658Imu : public ImuSource {
+public:
+    typedef ImuSample Sample;
+
+    static const uint8_t ADDRESS_PRIMARY = 0x6B;     // SA0 high
+    static const uint8_t ADDRESS_SECONDARY = 0x6A;   // SA0 low
+    static const uint8_t WATERMARK = 16;             // Samples per interrupt
+    static const size_t FIFO_SAMPLES = 128;
+    static const uint32_t MAX_CLOCK_HZ = 400000;     // I2C fast mode
+
+    Qmi8658Imu(I2CBus& bus, int interrupt_pin = -1);
+
+    // Probes both addresses, resets the part and starts the FIFO.
+    // odr_hz is rounded down to 1000, 500, 250, 125, 62 or 31 Hz.
+    bool begin(uint16_t odr_hz = 1000);
+
+    // Drains the FIFO and keeps the newest sample for the accessors
+    bool update();
+    bool read(ImuSample& out) override;
+    size_t readBatch(ImuSample* out, size_t max) override;
+
+    float getAccelX() { return current.accel_x; }
+    float getAccelY() { return current.accel_y; }
+    float getAccelZ() { return current.accel_z; }
+    float getGyroX() { return current.gyro_x; }
+    float getGyroY() { return current.gyro_y; }
+    float getGyroZ() { return current.gyro_z; }
+    const Sample& getSample() { return current; }
+
+    bool isAvailable() { return initialized; }
+    uint8_t getAddress() const { return address; }
+    uint32_t getSamplePeriodUs() const { return sample_period_us; }
+
+private:
+    static const size_t FRAME_BYTES = 12;   // Accel XYZ + gyro XYZ, int16 LE
+    static const size_t FRAMES_PER_BURST = I2CBus::MAX_TRANSFER / FRAME_BYTES;
+
+    I2CBus& bus;
+    int interrupt_pin;
+    uint8_t address;
+    uint32_t sample_period_us;
+    bool initialized;
+
+    Sample current;
+
+    static volatile bool watermark_flag;
+    static void IRAM_ATTR onWatermark();
+
+    bool command(uint8_t cmd);
+    bool fifoCount(size_t& samples);
+};
+
+#endif // QMI8658_IMU_H
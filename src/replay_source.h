@@ -0,0 +1,75 @@
+#ifndef REPLAY_SOURCE_H
+#define REPLAY_SOURCE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "flight_record.h"
+#include "sensor_source.h"
+
+// Sequential reader for a flight log held in memory (e.g. a mapped flash
+// partition) or in a stdio file (LittleFS on the device, any file on a host).
+class FlightRecordReader {
+public:
+    FlightRecordReader();
+
+    bool openMemory(const uint8_t* data, size_t size);
+    bool openFile(FILE* file);   // Not closed by the reader
+
+    bool next(FlightRecord& out);
+    bool isOpen() const { return open; }
+    const FlightLogHeader& getHeader() const { return header; }
+    uint32_t getRecordsRead() const { return records_read; }
+
+private:
+    const uint8_t* memory;
+    size_t memory_size;
+    size_t offset;
+    FILE* file;
+    FlightLogHeader header;
+    uint32_t records_read;
+    bool open;
+};
+
+// Replays a recorded flight in place of the barometer and IMU.
+// In real-time mode advance() releases every record whose log time has
+// passed on the caller's clock; otherwise each advance() releases records
+// up to and including the next IMU sample (and any stamped at the same
+// time), so the pipeline runs as fast as it can process them. Samples keep their recorded timestamps, which is
+// what the pipeline uses for phase timing, so a run does not depend on how
+// fast the host or device gets through it.
+class ReplaySource : public BaroSource, public ImuSource {
+public:
+    ReplaySource();
+
+    bool begin(FlightRecordReader* record_reader, bool real_time);
+    void advance(uint32_t now_us);
+
+    bool read(BaroSample& out) override;
+    bool read(ImuSample& out) override;
+
+    bool isFinished() const { return finished; }
+    bool isRealTime() const { return real_time; }
+    uint32_t getEventCount() const { return events; }
+
+private:
+    FlightRecordReader* reader;
+    bool real_time;
+    bool started;
+    bool finished;
+    uint32_t clock_start_us;
+    uint32_t log_start_us;
+
+    FlightRecord pending;
+    bool has_pending;
+
+    BaroSample baro;
+    bool baro_fresh;
+    ImuSample imu;
+    bool imu_fresh;
+    uint32_t events;
+
+    bool fetch();
+    void consume();
+};
+
+#endif // REPLAY_SOURCE_H
@@ -0,0 +1,351 @@
+#include "segment_store.h"
+#include <string.h>
+
+static_assert(SegmentStore::DATA_OFFSET % 4096 == 0, "segment data must stay 4 KB aligned");
+
+// CRC-32 (IEEE, as zlib's crc32()), a nibble at a time
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+SegmentStore::SegmentStore() {
+    flash = nullptr;
+    segment_count = 0;
+    log_count = 0;
+    head = 0;
+    next_sequence = 1;
+    writing = false;
+    write_id = 0;
+    write_bytes = 0;
+    write_first = -1;
+    write_segment = -1;
+    write_index = 0;
+    segment_bytes = 0;
+    segment_crc = 0;
+}
+
+bool SegmentStore::begin(FlashDevice* device) {
+    flash = nullptr;
+    writing = false;
+    size_t count = device->size() / SEGMENT_BYTES;
+    if (count > MAX_SEGMENTS) {
+        count = MAX_SEGMENTS;
+    }
+    if (count < 2 || DATA_OFFSET % device->sectorSize() != 0) {
+        return false;
+    }
+    flash = device;
+    segment_count = (int)count;
+    for (int s = 0; s < segment_count; s++) {
+        readSegment(s);
+    }
+    rebuildLogs();
+    return true;
+}
+
+void SegmentStore::readSegment(int segment) {
+    Segment& info = segments[segment];
+    memset(&info, 0, sizeof(info));
+    info.state = SEGMENT_EMPTY;
+
+    SegmentHeader header;
+    SegmentCommit commit;
+    uint32_t offset = getSegmentFlashOffset(segment);
+    if (!flash->read(offset, &header, sizeof(header)) ||
+        !flash->read(offset + sizeof(header), &commit, sizeof(commit))) {
+        return;
+    }
+    if (header.magic != SEGMENT_MAGIC || header.version != SEGMENT_VERSION || header.data_offset != DATA_OFFSET ||
+        header.crc != crc32Update(0, &header, offsetof(SegmentHeader, crc))) {
+        return;
+    }
+    info.sequence = header.sequence;
+    info.log_id = header.log_id;
+    info.log_index = header.log_index;
+    info.erase_count = header.erase_count;
+    info.state = SEGMENT_OPEN;
+
+    if (commit.magic == COMMIT_MAGIC && commit.data_bytes <= SEGMENT_DATA_BYTES &&
+        commit.crc == crc32Update(0, &commit, offsetof(SegmentCommit, crc))) {
+        info.data_bytes = commit.data_bytes;
+        info.data_crc = commit.data_crc;
+        info.last = (commit.flags & COMMIT_LAST) != 0;
+        info.state = SEGMENT_COMMITTED;
+    }
+}
+
+// Walks the ring from the oldest segment. A log starts at a committed
+// segment with index 0 and continues while the next segment is the next
+// committed piece of it, opened right after it; it is complete when its
+// last segment says so.
+void SegmentStore::rebuildLogs() {
+    uint32_t newest = 0;
+    int newest_segment = -1;
+    for (int s = 0; s < segment_count; s++) {
+        if (segments[s].state != SEGMENT_EMPTY && (newest_segment < 0 || segments[s].sequence > newest)) {
+            newest = segments[s].sequence;
+            newest_segment = s;
+        }
+    }
+    head = newest_segment < 0 ? 0 : (newest_segment + 1) % segment_count;
+    next_sequence = newest_segment < 0 ? 1 : newest + 1;
+
+    log_count = 0;
+    Log* building = nullptr;
+    const Segment* previous = nullptr;
+    for (int i = 0; i < segment_count; i++) {
+        int s = (head + i) % segment_count;
+        const Segment& segment = segments[s];
+        if (building != nullptr) {
+            if (segment.state == SEGMENT_COMMITTED && segment.log_id == building->id &&
+                segment.log_index == previous->log_index + 1 && segment.sequence == previous->sequence + 1 &&
+                previous->data_bytes == SEGMENT_DATA_BYTES) {
+                building->bytes += segment.data_bytes;
+                building->segment_count++;
+                building->complete = segment.last;
+                previous = &segment;
+                if (segment.last) {
+                    building = nullptr;
+                }
+                continue;
+            }
+            building = nullptr;
+        }
+        if (segment.state != SEGMENT_COMMITTED || segment.log_index != 0 ||
+            (writing && segment.log_id == write_id)) {
+            continue;
+        }
+        Log& log = logs[log_count++];
+        log.id = segment.log_id;
+        log.bytes = segment.data_bytes;
+        log.first_segment = (uint16_t)s;
+        log.segment_count = 1;
+        log.complete = segment.last;
+        previous = &segment;
+        building = segment.last ? nullptr : &log;
+    }
+}
+
+const SegmentStore::Log* SegmentStore::findLog(uint32_t id) const {
+    for (int i = 0; i < log_count; i++) {
+        if (logs[i].id == id) {
+            return &logs[i];
+        }
+    }
+    return nullptr;
+}
+
+size_t SegmentStore::read(const Log& log, size_t offset, void* out, size_t len) {
+    if (!isReady() || offset >= log.bytes) {
+        return 0;
+    }
+    if (len > log.bytes - offset) {
+        len = log.bytes - offset;
+    }
+    uint8_t* bytes = (uint8_t*)out;
+    size_t done = 0;
+    while (done < len) {
+        size_t position = offset + done;
+        int segment = (log.first_segment + (int)(position / SEGMENT_DATA_BYTES)) % segment_count;
+        size_t within = position % SEGMENT_DATA_BYTES;
+        size_t n = SEGMENT_DATA_BYTES - within;
+        if (n > len - done) {
+            n = len - done;
+        }
+        if (!flash->read(getSegmentFlashOffset(segment) + DATA_OFFSET + within, bytes + done, n)) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+bool SegmentStore::verify(const Log& log) {
+    if (!isReady()) {
+        return false;
+    }
+    uint8_t buffer[256];
+    for (int i = 0; i < log.segment_count; i++) {
+        int s = (log.first_segment + i) % segment_count;
+        const Segment& segment = segments[s];
+        if (segment.state != SEGMENT_COMMITTED || segment.log_id != log.id) {
+            return false;
+        }
+        uint32_t crc = 0;
+        uint32_t offset = getSegmentFlashOffset(s) + DATA_OFFSET;
+        for (uint32_t done = 0; done < segment.data_bytes; ) {
+            uint32_t n = segment.data_bytes - done < sizeof(buffer) ? segment.data_bytes - done : sizeof(buffer);
+            if (!flash->read(offset + done, buffer, n)) {
+                return false;
+            }
+            crc = crc32Update(crc, buffer, n);
+            done += n;
+        }
+        if (crc != segment.data_crc) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SegmentStore::create(uint32_t id) {
+    if (!isReady() || writing || findLog(id) != nullptr) {
+        return false;
+    }
+    writing = true;
+    write_id = id;
+    write_bytes = 0;
+    write_first = -1;
+    if (!openSegment(0)) {
+        abort();
+        return false;
+    }
+    write_first = write_segment;
+    return true;
+}
+
+// Erases the head segment's metadata sector and writes its header. The
+// log that started there, if any, is gone from then on.
+bool SegmentStore::openSegment(uint32_t index) {
+    int s = head;
+    if (s == write_first) {
+        return false;   // The log would overwrite its own start
+    }
+    uint32_t erase_count = segments[s].erase_count + 1;
+    uint32_t offset = getSegmentFlashOffset(s);
+    segments[s].state = SEGMENT_EMPTY;
+    rebuildLogs();
+    if (!flash->erase(offset, flash->sectorSize())) {
+        return false;
+    }
+
+    SegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SEGMENT_MAGIC;
+    header.version = SEGMENT_VERSION;
+    header.data_offset = DATA_OFFSET;
+    header.sequence = next_sequence;
+    header.log_id = write_id;
+    header.log_index = index;
+    header.erase_count = erase_count;
+    header.crc = crc32Update(0, &header, offsetof(SegmentHeader, crc));
+    if (!flash->write(offset, &header, sizeof(header))) {
+        return false;
+    }
+
+    Segment& segment = segments[s];
+    memset(&segment, 0, sizeof(segment));
+    segment.sequence = next_sequence++;
+    segment.log_id = write_id;
+    segment.log_index = index;
+    segment.erase_count = erase_count;
+    segment.state = SEGMENT_OPEN;
+    head = (s + 1) % segment_count;
+    write_segment = s;
+    write_index = index;
+    segment_bytes = 0;
+    segment_crc = 0;
+    return true;
+}
+
+bool SegmentStore::commitSegment(bool last) {
+    SegmentCommit commit;
+    memset(&commit, 0, sizeof(commit));
+    commit.magic = COMMIT_MAGIC;
+    commit.data_bytes = segment_bytes;
+    commit.data_crc = segment_crc;
+    commit.flags = last ? COMMIT_LAST : 0;
+    commit.crc = crc32Update(0, &commit, offsetof(SegmentCommit, crc));
+    if (!flash->write(getSegmentFlashOffset(write_segment) + sizeof(SegmentHeader), &commit, sizeof(commit))) {
+        return false;
+    }
+    Segment& segment = segments[write_segment];
+    segment.data_bytes = segment_bytes;
+    segment.data_crc = segment_crc;
+    segment.last = last;
+    segment.state = SEGMENT_COMMITTED;
+    return true;
+}
+
+bool SegmentStore::append(const void* data, size_t len) {
+    if (!writing) {
+        return false;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    size_t sector = flash->sectorSize();
+    while (len > 0) {
+        if (segment_bytes == SEGMENT_DATA_BYTES && !(commitSegment(false) && openSegment(write_index + 1))) {
+            break;
+        }
+        uint32_t offset = getSegmentFlashOffset(write_segment) + DATA_OFFSET + segment_bytes;
+        if (segment_bytes % sector == 0 && !flash->erase(offset, sector)) {
+            break;
+        }
+        size_t n = sector - segment_bytes % sector;
+        if (n > len) {
+            n = len;
+        }
+        if (!flash->write(offset, bytes, n)) {
+            break;
+        }
+        segment_crc = crc32Update(segment_crc, bytes, n);
+        segment_bytes += n;
+        write_bytes += n;
+        bytes += n;
+        len -= n;
+    }
+    if (len > 0) {
+        abort();
+        return false;
+    }
+    return true;
+}
+
+// Keeps what was committed, as after a power loss
+void SegmentStore::abort() {
+    if (writing) {
+        writing = false;
+        rebuildLogs();
+    }
+}
+
+bool SegmentStore::close() {
+    if (!writing) {
+        return false;
+    }
+    bool ok = commitSegment(true);
+    writing = false;
+    rebuildLogs();
+    return ok;
+}
+
+uint32_t SegmentStore::getMinEraseCount() const {
+    uint32_t result = 0;
+    for (int s = 0; s < segment_count; s++) {
+        if (s == 0 || segments[s].erase_count < result) {
+            result = segments[s].erase_count;
+        }
+    }
+    return result;
+}
+
+uint32_t SegmentStore::getMaxEraseCount() const {
+    uint32_t result = 0;
+    for (int s = 0; s < segment_count; s++) {
+        if (segments[s].erase_count > result) {
+            result = segments[s].erase_count;
+        }
+    }
+    return result;
+}
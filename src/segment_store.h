@@ -0,0 +1,143 @@
+#ifndef SEGMENT_STORE_H
+#define SEGMENT_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "flash_device.h"
+
+// Crash-safe append-only log store on raw flash.
+// The device is split into SEGMENT_BYTES segments, used strictly round
+// robin so every sector is erased equally often. A log (one flight) is a
+// run of consecutive segments. The first sector of a segment holds only
+// its metadata:
+//   - SegmentHeader, written when the segment is opened: sequence number,
+//     log id, position in the log and erase count, with a CRC
+//   - SegmentCommit, programmed into the still-erased bytes after it once
+//     the segment's data is complete: data length, data CRC and whether
+//     it ends the log, with its own CRC
+// The data follows from DATA_OFFSET, so it stays 4 KB aligned. Data
+// sectors are erased one at a time as writing reaches them, so no single
+// call erases more than one sector.
+// begin() recovers by reading only the 64 bytes of metadata per segment.
+// Whatever power loss interrupts - an erase, a header, data or a commit -
+// the segment has no valid commit and is ignored. A log keeps every
+// committed segment before it and is reported as incomplete. Opening a
+// segment over the start of the oldest log drops that log.
+// Single writer, no locking and no Arduino dependency.
+class SegmentStore {
+public:
+    static const size_t SEGMENT_BYTES = 65536;
+    static const size_t DATA_OFFSET = 4096;
+    static const size_t SEGMENT_DATA_BYTES = SEGMENT_BYTES - DATA_OFFSET;
+    static const int MAX_SEGMENTS = 64;
+
+    struct Log {
+        uint32_t id;
+        uint32_t bytes;
+        uint16_t first_segment;
+        uint16_t segment_count;
+        bool complete;          // false if power was lost before it was closed
+    };
+
+    SegmentStore();
+
+    // Scans the segment headers; false if the device is too small
+    bool begin(FlashDevice* flash);
+    bool isReady() const { return flash != nullptr; }
+
+    // Stored logs, oldest first; the one being written is not listed
+    int getLogCount() const { return log_count; }
+    const Log& getLog(int index) const { return logs[index]; }
+    const Log* findLog(uint32_t id) const;
+
+    // Reads from a stored log; returns the bytes read
+    size_t read(const Log& log, size_t offset, void* out, size_t len);
+
+    // Checks every segment of a log against its data CRC
+    bool verify(const Log& log);
+
+    // Starts a new log; ids must be unique among stored logs
+    bool create(uint32_t id);
+    bool append(const void* data, size_t len);
+    bool close();
+    void abort();               // Stops writing; the log keeps its committed segments
+    bool isWriting() const { return writing; }
+    uint32_t getWriteBytes() const { return write_bytes; }
+
+    size_t getCapacityBytes() const { return segment_count * SEGMENT_DATA_BYTES; }
+    int getSegmentCount() const { return segment_count; }
+    uint32_t getSegmentFlashOffset(int segment) const { return (uint32_t)segment * SEGMENT_BYTES; }
+    uint32_t getMinEraseCount() const;
+    uint32_t getMaxEraseCount() const;
+
+private:
+    struct SegmentHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t data_offset;
+        uint32_t sequence;
+        uint32_t log_id;
+        uint32_t log_index;
+        uint32_t erase_count;
+        uint32_t reserved;
+        uint32_t crc;
+    };
+
+    struct SegmentCommit {
+        uint32_t magic;
+        uint32_t data_bytes;
+        uint32_t data_crc;
+        uint32_t flags;
+        uint32_t reserved[3];
+        uint32_t crc;
+    };
+
+    enum SegmentState : uint8_t {
+        SEGMENT_EMPTY,          // Erased or unreadable metadata
+        SEGMENT_OPEN,           // Valid header, no commit (torn, or being written)
+        SEGMENT_COMMITTED
+    };
+
+    struct Segment {
+        uint32_t sequence;
+        uint32_t log_id;
+        uint32_t log_index;
+        uint32_t erase_count;
+        uint32_t data_bytes;
+        uint32_t data_crc;
+        SegmentState state;
+        bool last;
+    };
+
+    static const uint32_t SEGMENT_MAGIC = 0x47535454;  // "TTSG"
+    static const uint32_t COMMIT_MAGIC = 0x43535454;   // "TTSC"
+    static const uint16_t SEGMENT_VERSION = 1;
+    static const uint32_t COMMIT_LAST = 1;
+
+    FlashDevice* flash;
+    int segment_count;
+    Segment segments[MAX_SEGMENTS];
+    Log logs[MAX_SEGMENTS];
+    int log_count;
+    int head;                   // Next segment to open
+    uint32_t next_sequence;
+
+    // Log being written
+    bool writing;
+    uint32_t write_id;
+    uint32_t write_bytes;
+    int write_first;
+    int write_segment;
+    uint32_t write_index;
+    uint32_t segment_bytes;
+    uint32_t segment_crc;
+
+    void readSegment(int segment);
+    void rebuildLogs();
+    bool openSegment(uint32_t index);
+    bool commitSegment(bool last);
+};
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len);
+
+#endif // SEGMENT_STORE_H
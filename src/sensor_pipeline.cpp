@@ -0,0 +1,352 @@
+#include "sensor_pipeline.h"
+#include "altitude_table.h"
+
+AltitudeFx pressureToAltitudeFx(PressureFx pressure) {
+    // Offset from the table base in Q.8 Pa: the top bits index the table,
+    // the low STEP_SHIFT + 8 bits are the interpolation fraction
+    const int frac_bits = ALTITUDE_TABLE_STEP_SHIFT + PressureFx::FRAC;
+    int64_t offset = (int64_t)pressure.getRaw() - ((int64_t)ALTITUDE_TABLE_BASE_PA << PressureFx::FRAC);
+    if (offset <= 0) {
+        return AltitudeFx::fromRaw(altitude_table[0]);
+    }
+    int64_t index = offset >> frac_bits;
+    if (index >= ALTITUDE_TABLE_SIZE - 1) {
+        return AltitudeFx::fromRaw(altitude_table[ALTITUDE_TABLE_SIZE - 1]);
+    }
+    int64_t frac = offset & (((int64_t)1 << frac_bits) - 1);
+    int64_t a = altitude_table[index];
+    int64_t b = altitude_table[index + 1];
+    return AltitudeFx::fromRaw((int32_t)(a + (((b - a) * frac) >> frac_bits)));
+}
+
+static const float MAX_AHRS_DT = 0.25f;   // s
+
+SensorPipeline::SensorPipeline() {
+    event_handler = nullptr;
+    history = nullptr;
+
+    SpikeFilter::Config spikes;
+    spikes.policy = SpikeFilter::POLICY_REPLACE;
+    spikes.taps = 5;
+    spikes.threshold = 6.0f;
+    spikes.min_mad = PressureFx::fromInt(4).getRaw();   // ~2x BMP180 noise
+    spike_filter.configure(spikes);
+
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        stats[c][WINDOW_1S].setWindow(1000000);
+        stats[c][WINDOW_10S].setWindow(10000000);
+    }
+    reset();
+}
+
+void SensorPipeline::reset() {
+    fx.pressure = PressureFx();
+    fx.temperature = TemperatureFx();
+    fx.altitude = AltitudeFx();
+    fx.max_altitude = AltitudeFx();
+    fx.baseline_pressure = PressureFx::fromInt(101325);  // Sea level pressure in Pascals
+    fx.baseline_altitude = AltitudeFx();
+    for (int i = 0; i < 3; i++) {
+        fx.accel[i] = AccelFx();
+    }
+    fx.acceleration = AccelFx();
+    fx.max_acceleration = AccelFx();
+    peaks.reset(AccelFx());
+    publishBaro();
+    publishImu();
+
+    state.gyro_x = 0.0f;
+    state.gyro_y = 0.0f;
+    state.gyro_z = 0.0f;
+    state.max_acceleration_axis = 'Z';
+    state.vertical_acceleration = 0.0f;
+    state.max_vertical_acceleration = 0.0f;
+    state.tilt = 0.0f;
+    state.baro_samples = 0;
+    state.baro_rejected = 0;
+    state.baro_spikes = 0;
+    state.imu_samples = 0;
+
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        for (int w = 0; w < WINDOW_COUNT; w++) {
+            stats[c][w].reset();
+        }
+    }
+
+    spike_filter.reset();
+    imu_streams.reset();
+    ahrs.reset();
+    if (history != nullptr) {
+        history->clear();
+    }
+    last_imu_us = 0;
+    have_imu = false;
+    phase_detector.reset();
+    elapsed_us = 0;
+    last_sample_us = 0;
+    have_time = false;
+    time_ms = 0;
+    refine_count = 0;
+    refine_remaining = 0;
+    have_altitude = false;
+}
+
+void SensorPipeline::setGroundReference(float pressure_pa, float altitude_m) {
+    fx.baseline_pressure = PressureFx::fromFloat(pressure_pa);
+    fx.baseline_altitude = AltitudeFx::fromFloat(altitude_m);
+    publishBaro();
+}
+
+void SensorPipeline::refineGroundReference(int sample_count) {
+    refine_count = 0;
+    refine_remaining = sample_count;
+}
+
+void SensorPipeline::seed(float pressure_pa, float temperature_c) {
+    fx.pressure = PressureFx::fromFloat(pressure_pa);
+    fx.temperature = TemperatureFx::fromFloat(temperature_c);
+    fx.altitude = pressureToAltitudeFx(fx.pressure);
+    fx.max_altitude = fx.altitude;
+    publishBaro();
+}
+
+bool SensorPipeline::process(const BaroSample* baro, const ImuSample* imu) {
+    bool accepted = true;
+
+    if (baro != nullptr) {
+        advanceClock(baro->time_us);
+        if (isPlausibleBaroReading(baro->temperature_c, baro->pressure_pa)) {
+            accepted = applyBaro(*baro);
+        } else {
+            // Keep the previous values rather than feeding garbage into max tracking
+            state.baro_rejected++;
+            accepted = false;
+        }
+    }
+
+    if (imu != nullptr) {
+        advanceClock(imu->time_us);
+        applyImu(*imu);
+    }
+
+    if (baro == nullptr && imu == nullptr) {
+        return accepted;
+    }
+
+    // Flight phase drives the network policy and headless mode in the firmware
+    phase_detector.update(time_ms, getAltitudeAgl(), state.current_acceleration);
+    if (phase_detector.phaseChanged()) {
+        emit(EVENT_PHASE_CHANGE, getAltitudeAgl());
+    }
+
+    return accepted;
+}
+
+size_t SensorPipeline::processBatch(const BaroSample* baro, size_t baro_count,
+                                    const ImuSample* imu, size_t imu_count) {
+    size_t rejected = 0;
+    size_t b = 0;
+    size_t i = 0;
+    while (b < baro_count || i < imu_count) {
+        bool take_baro;
+        if (b >= baro_count) {
+            take_baro = false;
+        } else if (i >= imu_count) {
+            take_baro = true;
+        } else {
+            // Wrap-safe comparison; ties go to the barometer
+            take_baro = (int32_t)(baro[b].time_us - imu[i].time_us) <= 0;
+        }
+
+        if (take_baro) {
+            if (!process(&baro[b++], nullptr)) {
+                rejected++;
+            }
+        } else {
+            process(nullptr, &imu[i++]);
+        }
+    }
+    return rejected;
+}
+
+void SensorPipeline::advanceClock(uint32_t sample_us) {
+    // Sample clocks are 32-bit microseconds and wrap after ~71 minutes;
+    // accumulate deltas so phase timing keeps working across the wrap
+    if (!have_time) {
+        have_time = true;
+        elapsed_us = sample_us;
+    } else {
+        int32_t delta = (int32_t)(sample_us - last_sample_us);
+        if (delta > 0) {
+            elapsed_us += delta;
+        }
+    }
+    last_sample_us = sample_us;
+    time_ms = (uint32_t)(elapsed_us / 1000);
+}
+
+bool SensorPipeline::applyBaro(const BaroSample& baro) {
+    // Spikes are caught before they reach max tracking or the ground reference
+    int32_t pressure_raw;
+    SpikeFilter::Verdict verdict = spike_filter.filter(PressureFx::fromFloat(baro.pressure_pa).getRaw(), pressure_raw);
+    if (verdict != SpikeFilter::VERDICT_PASS) {
+        state.baro_spikes++;
+    }
+    if (verdict == SpikeFilter::VERDICT_REJECTED) {
+        return false;
+    }
+
+    fx.temperature = TemperatureFx::fromFloat(baro.temperature_c);
+    fx.pressure = PressureFx::fromRaw(pressure_raw);
+
+    // Calculate absolute altitude using standard sea level pressure
+    fx.altitude = pressureToAltitudeFx(fx.pressure);
+
+    // Track maximum altitude
+    if (fx.altitude > fx.max_altitude) {
+        fx.max_altitude = fx.altitude;
+    }
+    state.baro_samples++;
+
+    // Average the first readings into the ground reference
+    bool baseline_ready = false;
+    if (refine_remaining > 0) {
+        refine_count++;
+        refine_remaining--;
+        fx.baseline_pressure += (fx.pressure - fx.baseline_pressure) / refine_count;
+        fx.baseline_altitude += (fx.altitude - fx.baseline_altitude) / refine_count;
+        baseline_ready = refine_remaining == 0;
+    }
+
+    publishBaro();
+    addStats(CHANNEL_ALTITUDE, baro.time_us, getAltitudeAgl());
+    addStats(CHANNEL_PRESSURE, baro.time_us, state.pressure);
+    addStats(CHANNEL_TEMPERATURE, baro.time_us, state.temperature);
+    if (history != nullptr) {
+        history->add(HistoryPyramid::CHANNEL_ALTITUDE, time_ms, getAltitudeAgl());
+        history->add(HistoryPyramid::CHANNEL_VERTICAL_SPEED, time_ms, stats[CHANNEL_ALTITUDE][WINDOW_1S].getRate());
+    }
+
+    if (!have_altitude) {
+        have_altitude = true;
+        emit(EVENT_FIRST_ALTITUDE, state.current_altitude);
+    }
+    if (baseline_ready) {
+        emit(EVENT_BASELINE_READY, state.baseline_altitude);
+    }
+    return true;
+}
+
+void SensorPipeline::applyImu(const ImuSample& imu) {
+    fx.accel[0] = AccelFx::fromFloat(imu.accel_x);
+    fx.accel[1] = AccelFx::fromFloat(imu.accel_y);
+    fx.accel[2] = AccelFx::fromFloat(imu.accel_z);
+    state.gyro_x = imu.gyro_x;
+    state.gyro_y = imu.gyro_y;
+    state.gyro_z = imu.gyro_z;
+    state.imu_samples++;
+
+    // Calculate total acceleration magnitude for display
+    fx.acceleration = AccelFx::magnitude(fx.accel[0], fx.accel[1], fx.accel[2]);
+
+    // Track maximum acceleration from any individual axis; ties keep the
+    // earlier axis, as before. Selects rather than branches: which axis is
+    // highest changes from sample to sample on noise
+    static const char axis_names[3] = { 'X', 'Y', 'Z' };
+    AccelFx max_current_axis = fx.accel[0].abs();
+    int current_max_axis = 0;
+    for (int i = 1; i < 3; i++) {
+        AccelFx a = fx.accel[i].abs();
+        bool higher = a > max_current_axis;
+        max_current_axis = higher ? a : max_current_axis;
+        current_max_axis = higher ? i : current_max_axis;
+    }
+
+    // Update maximum if this reading is higher
+    if (max_current_axis > fx.max_acceleration) {
+        fx.max_acceleration = max_current_axis;
+        state.max_acceleration_axis = axis_names[current_max_axis];
+    }
+
+    // Peak-hold with timestamp, phase and surrounding samples
+    peaks.add(time_ms, imu.time_us, phase_detector.getPhase(), fx.accel, fx.acceleration);
+    imu_streams.add(imu);
+
+    // Orientation at the IMU rate; a long gap (e.g. the 5 Hz simulator)
+    // is capped so one sample cannot integrate seconds of rotation
+    float dt = have_imu ? (int32_t)(imu.time_us - last_imu_us) * 1.0e-6f : 0.0f;
+    if (dt < 0.0f) {
+        dt = 0.0f;
+    } else if (dt > MAX_AHRS_DT) {
+        dt = MAX_AHRS_DT;
+    }
+    last_imu_us = imu.time_us;
+    have_imu = true;
+    ahrs.update(imu.gyro_x, imu.gyro_y, imu.gyro_z, imu.accel_x, imu.accel_y, imu.accel_z, dt);
+    state.vertical_acceleration = ahrs.getVerticalAcceleration();
+    state.tilt = ahrs.getTiltDeg();
+    if (state.vertical_acceleration > state.max_vertical_acceleration) {
+        state.max_vertical_acceleration = state.vertical_acceleration;
+    }
+
+    publishImu();
+    addStats(CHANNEL_ACCELERATION, imu.time_us, state.current_acceleration);
+    addStats(CHANNEL_ROTATION, imu.time_us,
+             sqrtf(imu.gyro_x * imu.gyro_x + imu.gyro_y * imu.gyro_y + imu.gyro_z * imu.gyro_z));
+    if (history != nullptr) {
+        history->add(HistoryPyramid::CHANNEL_ACCELERATION, time_ms, state.vertical_acceleration);
+    }
+}
+
+void SensorPipeline::addStats(StatsChannel channel, uint32_t time_us, float value) {
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        stats[channel][w].add(time_us, value);
+    }
+}
+
+void SensorPipeline::publishBaro() {
+    state.pressure = fx.pressure.toFloat();
+    state.temperature = fx.temperature.toFloat();
+    state.current_altitude = fx.altitude.toFloat();
+    state.max_altitude = fx.max_altitude.toFloat();
+    state.baseline_pressure = fx.baseline_pressure.toFloat();
+    state.baseline_altitude = fx.baseline_altitude.toFloat();
+}
+
+void SensorPipeline::publishImu() {
+    state.accel_x = fx.accel[0].toFloat();
+    state.accel_y = fx.accel[1].toFloat();
+    state.accel_z = fx.accel[2].toFloat();
+    state.current_acceleration = fx.acceleration.toFloat();
+    state.max_acceleration = fx.max_acceleration.toFloat();
+}
+
+void SensorPipeline::resetMaxAltitude() {
+    fx.max_altitude = fx.altitude;
+    publishBaro();
+}
+
+void SensorPipeline::resetMaxAcceleration(float start_g) {
+    fx.max_acceleration = AccelFx::fromFloat(start_g);
+    peaks.reset(fx.max_acceleration);
+    state.max_vertical_acceleration = 0.0f;
+    state.max_acceleration_axis = 'Z';
+    publishImu();
+}
+
+void SensorPipeline::rearmFlightDetection() {
+    phase_detector.reset();
+    emit(EVENT_PHASE_CHANGE, getAltitudeAgl());
+}
+
+void SensorPipeline::emit(EventType type, float value) {
+    if (event_handler == nullptr) {
+        return;
+    }
+    Event event;
+    event.type = type;
+    event.time_ms = time_ms;
+    event.phase = phase_detector.getPhase();
+    event.value = value;
+    event_handler(event);
+}
@@ -0,0 +1,178 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sensor_types.h"
+#include "flight_phase.h"
+#include "window_stats.h"
+#include "peak_tracker.h"
+#include "spike_filter.h"
+#include "imu_filter_bank.h"
+#include "ahrs.h"
+#include "history_pyramid.h"
+
+// Everything the display, web UI and logs show about the sensors
+struct SensorState {
+    float current_altitude;      // Absolute, from standard sea level pressure (m)
+    float max_altitude;
+    float temperature;           // C
+    float pressure;              // Pa
+    float baseline_pressure;     // Ground reference (Pa)
+    float baseline_altitude;     // Ground reference altitude (m)
+
+    float accel_x, accel_y, accel_z;   // g
+    float gyro_x, gyro_y, gyro_z;      // deg/s
+    float current_acceleration;        // Vector magnitude (g)
+    float max_acceleration;            // Highest single-axis reading (g)
+    char max_acceleration_axis;
+    float vertical_acceleration;       // Earth-frame up, gravity removed (g), from the AHRS
+    float max_vertical_acceleration;
+    float tilt;                        // Body Z axis from vertical (deg)
+
+    uint32_t baro_samples;       // Accepted barometer samples
+    uint32_t baro_rejected;      // Implausible barometer samples dropped
+    uint32_t baro_spikes;        // Pressure spikes replaced or dropped by the spike filter
+    uint32_t imu_samples;
+};
+
+// Sensor processing extracted from updateSensors(): altitude conversion,
+// ground reference averaging, max tracking and flight phase detection.
+// Acquisition, averaging and max tracking run in fixed point (fixed_point.h),
+// so results are bit-identical on the device and on a host; SensorState is
+// the float copy published for presentation. The orientation estimate
+// (ahrs.h) is float and only feeds the published vertical acceleration and
+// tilt.
+// It has no hardware or Arduino dependencies and takes its time from the
+// sample timestamps, so live data, simulation and log replay go through
+// exactly the same code and a replay reproduces the same events.
+class SensorPipeline {
+public:
+    enum EventType {
+        EVENT_FIRST_ALTITUDE,    // First accepted barometer sample
+        EVENT_BASELINE_READY,    // Ground reference averaging finished
+        EVENT_PHASE_CHANGE       // value = altitude AGL
+    };
+
+    struct Event {
+        EventType type;
+        uint32_t time_ms;
+        FlightPhase phase;
+        float value;
+    };
+
+    typedef void (*EventHandler)(const Event& event);
+
+    // Sliding-window statistics kept for every channel, e.g. 1 s peak g or
+    // 10 s average climb rate (the altitude channel's rate)
+    enum StatsChannel {
+        CHANNEL_ALTITUDE,        // m AGL
+        CHANNEL_ACCELERATION,    // Vector magnitude, g
+        CHANNEL_ROTATION,        // Gyro vector magnitude, deg/s
+        CHANNEL_PRESSURE,        // Pa
+        CHANNEL_TEMPERATURE,     // C
+        CHANNEL_COUNT
+    };
+
+    enum StatsWindow {
+        WINDOW_1S,
+        WINDOW_10S,
+        WINDOW_COUNT
+    };
+
+    typedef WindowStats<32> ChannelStats;
+
+    SensorPipeline();
+
+    void reset();
+    void setEventHandler(EventHandler handler) { event_handler = handler; }
+
+    // Ground reference: set directly (e.g. from the NVS cache), then
+    // optionally average the next sample_count barometer readings into it
+    void setGroundReference(float pressure_pa, float altitude_m);
+    void refineGroundReference(int sample_count);
+    bool isRefiningGroundReference() const { return refine_remaining > 0; }
+
+    // Seeds the current values without running the trackers (boot, cache)
+    void seed(float pressure_pa, float temperature_c);
+
+    // Pressure spike rejection ahead of max tracking and the ground
+    // reference; replaces 6-MAD outliers in a 5-sample window by default
+    void setSpikeFilter(const SpikeFilter::Config& config) { spike_filter.configure(config); }
+    const SpikeFilter& getSpikeFilter() const { return spike_filter; }
+
+    // Graph history: altitude AGL and vertical speed per barometer sample,
+    // vertical acceleration per IMU sample. The store is owned by the caller
+    // (its buckets live in PSRAM); null detaches it.
+    void setHistory(HistoryPyramid* new_history) { history = new_history; }
+
+    // One acquisition step. Either sample may be null if that sensor had
+    // nothing new; returns false if the barometer sample was rejected
+    // (implausible, or dropped as a spike).
+    bool process(const BaroSample* baro, const ImuSample* imu);
+
+    // Batched acquisition (FIFO drains): both lists are oldest first and
+    // are merged by timestamp so every sample is processed in the order it
+    // was measured. Returns the number of barometer samples rejected.
+    size_t processBatch(const BaroSample* baro, size_t baro_count,
+                        const ImuSample* imu, size_t imu_count);
+
+    void resetMaxAltitude();
+    void resetMaxAcceleration(float start_g);
+    void rearmFlightDetection();
+
+    const SensorState& getState() const { return state; }
+    FlightPhaseDetector& getPhaseDetector() { return phase_detector; }
+    const FlightPhaseDetector& getPhaseDetector() const { return phase_detector; }
+    const PeakTracker& getPeaks() const { return peaks; }
+    ImuFilterBank& getImuStreams() { return imu_streams; }   // Decimated IMU at the consumers' rates
+    const ImuFilterBank& getImuStreams() const { return imu_streams; }
+    const Ahrs& getAhrs() const { return ahrs; }
+    float getAltitudeAgl() const { return (fx.altitude - fx.baseline_altitude).toFloat(); }
+    uint32_t getTimeMs() const { return time_ms; }
+    const ChannelStats& getStats(StatsChannel channel, StatsWindow window) const { return stats[channel][window]; }
+
+private:
+    // Working values in fixed point; state is the float copy for display
+    struct FixedState {
+        PressureFx pressure;
+        TemperatureFx temperature;
+        AltitudeFx altitude;
+        AltitudeFx max_altitude;
+        PressureFx baseline_pressure;
+        AltitudeFx baseline_altitude;
+        AccelFx accel[3];
+        AccelFx acceleration;       // Vector magnitude
+        AccelFx max_acceleration;   // Highest single-axis reading
+    };
+
+    SensorState state;
+    FixedState fx;
+    ChannelStats stats[CHANNEL_COUNT][WINDOW_COUNT];
+    PeakTracker peaks;
+    SpikeFilter spike_filter;
+    ImuFilterBank imu_streams;
+    Ahrs ahrs;
+    HistoryPyramid* history;
+    uint32_t last_imu_us;
+    bool have_imu;
+    FlightPhaseDetector phase_detector;
+    EventHandler event_handler;
+    uint64_t elapsed_us;        // Sample clock, unwrapped
+    uint32_t last_sample_us;
+    bool have_time;
+    uint32_t time_ms;
+    int refine_count;
+    int refine_remaining;
+    bool have_altitude;
+
+    void publishBaro();
+    void publishImu();
+    bool applyBaro(const BaroSample& baro);
+    void applyImu(const ImuSample& imu);
+    void advanceClock(uint32_t sample_us);
+    void emit(EventType type, float value);
+    void addStats(StatsChannel channel, uint32_t time_us, float value);
+};
+
+#endif // SENSOR_PIPELINE_H
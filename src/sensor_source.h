@@ -0,0 +1,33 @@
+#ifndef SENSOR_SOURCE_H
+#define SENSOR_SOURCE_H
+
+#include <stddef.h>
+#include "sensor_types.h"
+
+// Common interface for anything that produces sensor samples: the real
+// drivers, the simulators and log replay. updateSensors() only sees these,
+// so a recorded flight can stand in for the hardware.
+//
+// read() returns true and fills in a new sample, or false if none is
+// available (not ready yet, failed read, or end of a replay). readBatch()
+// returns every waiting sample, oldest first - sources with a hardware FIFO
+// override it to drain many samples per bus transaction.
+class BaroSource {
+public:
+    virtual ~BaroSource() {}
+    virtual bool read(BaroSample& out) = 0;
+    virtual size_t readBatch(BaroSample* out, size_t max) {
+        return max > 0 && read(out[0]) ? 1 : 0;
+    }
+};
+
+class ImuSource {
+public:
+    virtual ~ImuSource() {}
+    virtual bool read(ImuSample& out) = 0;
+    virtual size_t readBatch(ImuSample* out, size_t max) {
+        return max > 0 && read(out[0]) ? 1 : 0;
+    }
+};
+
+#endif // SENSOR_SOURCE_H
@@ -0,0 +1,38 @@
+#ifndef SENSOR_TYPES_H
+#define SENSOR_TYPES_H
+
+#include <stdint.h>
+#include <math.h>
+#include "fixed_point.h"
+
+// Timestamped sensor samples shared by the drivers, simulators, replay and
+// the processing pipeline. Times are microseconds on the source's clock.
+struct BaroSample {
+    uint32_t time_us;
+    float pressure_pa;
+    float temperature_c;
+};
+
+struct ImuSample {
+    uint32_t time_us;
+    float accel_x, accel_y, accel_z;   // g
+    float gyro_x, gyro_y, gyro_z;      // deg/s
+};
+
+// BMP180 operating range: -40..85 C, 300..1100 hPa. A failed I2C read shows
+// up as data outside it.
+inline bool isPlausibleBaroReading(float temp_c, float pressure_pa) {
+    return temp_c >= -40.0f && temp_c <= 85.0f && pressure_pa >= 30000.0f && pressure_pa <= 110000.0f;
+}
+
+// Same barometric formula as Adafruit_BMP085::readAltitude, without a second conversion
+inline float pressureToAltitude(float pressure_pa, float sea_level_pa) {
+    return 44330.0f * (1.0f - powf(pressure_pa / sea_level_pa, 0.1903f));
+}
+
+// The same formula against standard sea level pressure, interpolated from a
+// table in fixed point - bit-exact everywhere, no powf(). Within 5 cm of
+// pressureToAltitude() over 300..1100 hPa; clamps outside it.
+AltitudeFx pressureToAltitudeFx(PressureFx pressure);
+
+#endif // SENSOR_TYPES_H
@@ -0,0 +1,51 @@
+#ifndef SIM_RANDOM_H
+#define SIM_RANDOM_H
+
+#include <stdint.h>
+
+// Small seeded PCG32 generator for the simulators.
+// Unlike Arduino random() the sequence depends only on the seed, so a
+// simulated run is bit-for-bit reproducible on the device and on the host.
+class SimRandom {
+private:
+    uint64_t state;
+    uint64_t increment;
+
+public:
+    explicit SimRandom(uint64_t seed = 1, uint64_t stream = 0x5851F42D4C957F2DULL) {
+        seedWith(seed, stream);
+    }
+
+    void seedWith(uint64_t seed, uint64_t stream = 0x5851F42D4C957F2DULL) {
+        state = 0;
+        increment = (stream << 1) | 1;
+        nextU32();
+        state += seed;
+        nextU32();
+    }
+
+    uint32_t nextU32() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    // Uniform in [0, 1)
+    float uniform() {
+        return (nextU32() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Approximately standard normal: sum of four 16-bit uniforms (Irwin-Hall),
+    // rescaled to unit variance. Two generator calls, no log/sqrt/trig.
+    float gaussian() {
+        uint32_t a = nextU32();
+        uint32_t b = nextU32();
+        int32_t sum = (int32_t)(a & 0xFFFF) + (int32_t)(a >> 16) + (int32_t)(b & 0xFFFF) + (int32_t)(b >> 16);
+        // Mean 4 * 32767.5, variance 4 * 65536^2 / 12
+        return (sum - 131070) * (1.0f / 37837.2f);
+    }
+};
+
+#endif // SIM_RANDOM_H
@@ -0,0 +1,112 @@
+#include "spike_filter.h"
+
+using median_network::median;
+
+SpikeFilter::SpikeFilter() {
+    Config defaults;
+    defaults.policy = POLICY_OFF;
+    defaults.taps = 5;
+    defaults.threshold = 6.0f;
+    defaults.min_mad = 0;
+    configure(defaults);
+}
+
+void SpikeFilter::configure(const Config& new_config) {
+    config = new_config;
+    if (config.taps != 3 && config.taps != 5 && config.taps != 7) {
+        config.taps = 5;
+    }
+    if (config.threshold < 0.0f) {
+        config.threshold = 0.0f;
+    }
+    threshold_q8 = (int32_t)(config.threshold * 256.0f + 0.5f);
+    reset();
+}
+
+void SpikeFilter::reset() {
+    next = 0;
+    count = 0;
+    outliers = 0;
+}
+
+SpikeFilter::Verdict SpikeFilter::filter(int32_t in, int32_t& out) {
+    if (config.policy == POLICY_OFF) {
+        out = in;
+        return VERDICT_PASS;
+    }
+
+    window[next] = in;
+    next = next + 1 == config.taps ? 0 : next + 1;
+
+    // Nothing to compare against until the window has filled once
+    if (count < config.taps) {
+        count++;
+        out = in;
+        return VERDICT_PASS;
+    }
+
+    // Order inside the window does not matter to a median, so the ring is
+    // used as is. int64 keeps the deviations exact for any raw values.
+    int32_t m = median(window, config.taps);
+    int32_t deviations[MAX_TAPS];
+    for (int i = 0; i < config.taps; i++) {
+        int64_t d = (int64_t)window[i] - m;
+        d = d < 0 ? -d : d;
+        deviations[i] = d > INT32_MAX ? INT32_MAX : (int32_t)d;
+    }
+    int32_t mad = median(deviations, config.taps);
+    if (mad < config.min_mad) {
+        mad = config.min_mad;
+    }
+
+    int64_t deviation = (int64_t)in - m;
+    deviation = deviation < 0 ? -deviation : deviation;
+    bool outlier = (deviation << 8) > (int64_t)threshold_q8 * mad;
+    if (outlier) {
+        outliers++;
+    }
+
+    switch (config.policy) {
+        case POLICY_MEDIAN:
+            out = m;
+            return outlier ? VERDICT_REPLACED : VERDICT_PASS;
+        case POLICY_REJECT:
+            if (outlier) {
+                return VERDICT_REJECTED;
+            }
+            out = in;
+            return VERDICT_PASS;
+        case POLICY_REPLACE:
+        default:
+            out = outlier ? m : in;
+            return outlier ? VERDICT_REPLACED : VERDICT_PASS;
+    }
+}
+
+void SpikeFilter::slidingMedian(const int32_t* in, int32_t* out, size_t n, int taps) {
+    if (n < (size_t)taps) {
+        return;
+    }
+    size_t outputs = n - taps + 1;
+
+    // One network per output with the taps as separate streams - independent
+    // straight-line min/max, which the compiler turns into SIMD lanes
+    switch (taps) {
+        case 3:
+            for (size_t i = 0; i < outputs; i++) {
+                out[i] = median_network::median3(in[i], in[i + 1], in[i + 2]);
+            }
+            break;
+        case 5:
+            for (size_t i = 0; i < outputs; i++) {
+                out[i] = median_network::median5(in[i], in[i + 1], in[i + 2], in[i + 3], in[i + 4]);
+            }
+            break;
+        default:
+            for (size_t i = 0; i < outputs; i++) {
+                out[i] = median_network::median7(in[i], in[i + 1], in[i + 2], in[i + 3],
+                                                 in[i + 4], in[i + 5], in[i + 6]);
+            }
+            break;
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef SPIKE_FILTER_H
+#define SPIKE_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Branch-free median selection networks. Every compare-exchange is a
+// min/max pair, so there are no data-dependent branches: the cost is the
+// same for every input and the host compiler can vectorise loops over them
+// (see SpikeFilter::slidingMedian).
+namespace median_network {
+
+inline void sort2(int32_t& a, int32_t& b) {
+    int32_t lo = a < b ? a : b;
+    int32_t hi = a < b ? b : a;
+    a = lo;
+    b = hi;
+}
+
+inline int32_t median3(int32_t a, int32_t b, int32_t c) {
+    sort2(a, b);
+    sort2(b, c);
+    sort2(a, b);
+    return b;
+}
+
+// 7 compare-exchanges
+inline int32_t median5(int32_t p0, int32_t p1, int32_t p2, int32_t p3, int32_t p4) {
+    sort2(p0, p1); sort2(p3, p4); sort2(p0, p3);
+    sort2(p1, p4); sort2(p1, p2); sort2(p2, p3);
+    sort2(p1, p2);
+    return p2;
+}
+
+// 13 compare-exchanges
+inline int32_t median7(int32_t p0, int32_t p1, int32_t p2, int32_t p3,
+                       int32_t p4, int32_t p5, int32_t p6) {
+    sort2(p0, p5); sort2(p0, p3); sort2(p1, p6);
+    sort2(p2, p4); sort2(p0, p1); sort2(p3, p5);
+    sort2(p2, p6); sort2(p2, p3); sort2(p3, p6);
+    sort2(p4, p5); sort2(p1, p4); sort2(p1, p3);
+    sort2(p3, p4);
+    return p3;
+}
+
+inline int32_t median(const int32_t* p, int taps) {
+    switch (taps) {
+        case 3:  return median3(p[0], p[1], p[2]);
+        case 5:  return median5(p[0], p[1], p[2], p[3], p[4]);
+        default: return median7(p[0], p[1], p[2], p[3], p[4], p[5], p[6]);
+    }
+}
+
+} // namespace median_network
+
+// Spike rejection for one channel of raw fixed-point values (the pipeline
+// feeds it PressureFx raw pressure).
+// Each new sample goes into a window of the last 3, 5 or 7 samples; it is an
+// outlier if it lies further from the window median than threshold times the
+// median absolute deviation (MAD) of the window. The MAD is floored at
+// min_mad so a quiet or coarsely quantised sensor does not make every small
+// step look like a spike. A real level change becomes the median after
+// (taps + 1) / 2 samples and is let through from then on.
+// Constant time per sample: two median networks and no loops over history.
+class SpikeFilter {
+public:
+    enum Policy {
+        POLICY_OFF,       // Pass every sample through
+        POLICY_REPLACE,   // Outliers are replaced by the window median
+        POLICY_REJECT,    // Outliers are dropped
+        POLICY_MEDIAN     // Always output the window median (smoother, (taps - 1) / 2 samples late)
+    };
+
+    enum Verdict {
+        VERDICT_PASS,
+        VERDICT_REPLACED,
+        VERDICT_REJECTED
+    };
+
+    struct Config {
+        Policy policy;
+        int taps;          // 3, 5 or 7
+        float threshold;   // Outlier if |x - median| > threshold * MAD
+        int32_t min_mad;   // MAD floor, in raw input units
+    };
+
+    static const int MAX_TAPS = 7;
+
+    SpikeFilter();
+
+    void configure(const Config& config);
+    const Config& getConfig() const { return config; }
+    void reset();
+
+    // Filters one sample; out is only written if the verdict is not REJECTED
+    Verdict filter(int32_t in, int32_t& out);
+
+    uint32_t getOutlierCount() const { return outliers; }
+
+    // Median of every taps-long run of in[], for offline analysis on a host:
+    // out[i] = median(in[i .. i + taps - 1]), n - taps + 1 outputs
+    static void slidingMedian(const int32_t* in, int32_t* out, size_t n, int taps);
+
+private:
+    Config config;
+    int32_t window[MAX_TAPS];
+    int next;
+    int count;
+    int32_t threshold_q8;     // config.threshold in Q.8
+    uint32_t outliers;
+};
+
+#endif // SPIKE_FILTER_H
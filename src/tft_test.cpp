@@ -81,11 +81,139 @@ TFTTest::TFTTest() {
     width = TFT_WIDTH;
     height = TFT_HEIGHT;
     rotation = 0;
+    bytes_transferred = 0;
+    output_hash = 2166136261u;
+    hashing = false;
+    init_state = INIT_IDLE;
+    init_cmd_index = 0;
+    init_deadline = 0;
+    sleep_pending = false;
 }
 
 void TFTTest::begin() {
     Serial.println("TFT Test Driver: Initializing...");
     
+    setupPins();
+    
+    Serial.println("TFT Test Driver: Hardware reset...");
+    hardReset();
+    
+    Serial.println("TFT Test Driver: Initializing display...");
+    initDisplay();
+    
+    Serial.println("TFT Test Driver: Setting rotation...");
+    setRotation(0);
+    
+    Serial.println("TFT Test Driver: Turning on backlight...");
+    digitalWrite(TFT_BL, HIGH);  // Turn on backlight
+    init_state = INIT_DONE;
+    
+    Serial.println("TFT Test Driver: Initialization complete!");
+}
+
+void TFTTest::startInit() {
+    setupPins();
+    
+    // Same sequence as hardReset(), with each wait turned into a deadline
+    digitalWrite(TFT_CS, LOW);
+    digitalWrite(TFT_RST, HIGH);
+    init_state = INIT_RESET_HIGH;
+    init_deadline = millis() + 10;
+}
+
+bool TFTTest::pollInit() {
+    const uint8_t num_cmds = sizeof(init_cmds) / sizeof(InitCmd);
+    
+    while (init_state != INIT_DONE) {
+        if (init_state == INIT_IDLE || init_state == INIT_SLEEPING || (long)(millis() - init_deadline) < 0) {
+            return false;
+        }
+        
+        switch (init_state) {
+            case INIT_RESET_HIGH:
+                digitalWrite(TFT_RST, LOW);
+                init_state = INIT_RESET_LOW;
+                init_deadline = millis() + 10;
+                break;
+            case INIT_RESET_LOW:
+                digitalWrite(TFT_RST, HIGH);
+                init_state = INIT_RESET_WAIT;
+                init_deadline = millis() + 120;
+                break;
+            case INIT_RESET_WAIT:
+                digitalWrite(TFT_CS, HIGH);
+                init_state = INIT_COMMANDS;
+                init_cmd_index = 0;
+                break;
+            case INIT_WAKING:
+                writeCommand(ST7789_DISPON);
+                return finishInit();
+            case INIT_COMMANDS:
+                if (init_cmd_index < num_cmds) {
+                    const InitCmd& cmd = init_cmds[init_cmd_index++];
+                    writeCommand(cmd.cmd, (uint8_t*)cmd.data, cmd.len);
+                    init_deadline = millis() + cmd.delay_ms;
+                } else {
+                    setRotation(0);
+                    return finishInit();
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    
+    return true;
+}
+
+// Last step of init and wake-up: backlight on, unless sleep() came meanwhile
+bool TFTTest::finishInit() {
+    init_state = INIT_DONE;
+    if (sleep_pending) {
+        sleep();
+        return false;
+    }
+    digitalWrite(TFT_BL, HIGH);
+    return true;
+}
+
+void TFTTest::sleep() {
+    if (init_state == INIT_SLEEPING) {
+        return;
+    }
+    if (init_state != INIT_DONE) {
+        sleep_pending = true;
+        return;
+    }
+    sleep_pending = false;
+    
+    digitalWrite(TFT_BL, LOW);
+    writeCommand(ST7789_DISPOFF);
+    writeCommand(ST7789_SLPIN);
+    
+    // Nothing else uses this SPI bus, so release it until wake()
+    SPI.end();
+    init_state = INIT_SLEEPING;
+}
+
+void TFTTest::wake() {
+    sleep_pending = false;
+    if (init_state != INIT_SLEEPING) {
+        return;
+    }
+    
+    SPI.begin(TFT_SCLK, TFT_MISO, TFT_MOSI, TFT_CS);
+    SPI.setFrequency(40000000);
+    SPI.setDataMode(SPI_MODE0);
+    SPI.setBitOrder(MSBFIRST);
+    
+    // ST7789 needs 120 ms after SLPOUT before it is fully awake
+    writeCommand(ST7789_SLPOUT);
+    init_state = INIT_WAKING;
+    init_deadline = millis() + 120;
+}
+
+void TFTTest::setupPins() {
     // Initialize pins
     pinMode(TFT_CS, OUTPUT);
     pinMode(TFT_DC, OUTPUT);
@@ -103,20 +231,6 @@ void TFTTest::begin() {
     SPI.setFrequency(40000000);  // 40MHz
     SPI.setDataMode(SPI_MODE0);
     SPI.setBitOrder(MSBFIRST);
-    
-    Serial.println("TFT Test Driver: Hardware reset...");
-    hardReset();
-    
-    Serial.println("TFT Test Driver: Initializing display...");
-    initDisplay();
-    
-    Serial.println("TFT Test Driver: Setting rotation...");
-    setRotation(0);
-    
-    Serial.println("TFT Test Driver: Turning on backlight...");
-    digitalWrite(TFT_BL, HIGH);  // Turn on backlight
-    
-    Serial.println("TFT Test Driver: Initialization complete!");
 }
 
 void TFTTest::hardReset() {
@@ -135,6 +249,8 @@ void TFTTest::writeCommand(uint8_t cmd) {
     digitalWrite(TFT_DC, LOW);  // Command mode
     SPI.transfer(cmd);
     digitalWrite(TFT_CS, HIGH);
+    bytes_transferred += 1;
+    if (hashing) hashByte(cmd);
 }
 
 void TFTTest::writeData(uint8_t data) {
@@ -142,6 +258,8 @@ void TFTTest::writeData(uint8_t data) {
     digitalWrite(TFT_DC, HIGH);  // Data mode
     SPI.transfer(data);
     digitalWrite(TFT_CS, HIGH);
+    bytes_transferred += 1;
+    if (hashing) hashByte(data);
 }
 
 void TFTTest::writeData16(uint16_t data) {
@@ -150,6 +268,11 @@ void TFTTest::writeData16(uint16_t data) {
     SPI.transfer(data >> 8);
     SPI.transfer(data & 0xFF);
     digitalWrite(TFT_CS, HIGH);
+    bytes_transferred += 2;
+    if (hashing) {
+        hashByte(data >> 8);
+        hashByte(data & 0xFF);
+    }
 }
 
 void TFTTest::writeCommand(uint8_t cmd, uint8_t* data, uint8_t len) {
@@ -168,6 +291,13 @@ void TFTTest::writeCommand(uint8_t cmd, uint8_t* data, uint8_t len) {
     }
     
     digitalWrite(TFT_CS, HIGH);
+    bytes_transferred += 1 + len;
+    if (hashing) {
+        hashByte(cmd);
+        for (uint8_t i = 0; i < len && data != nullptr; i++) {
+            hashByte(data[i]);
+        }
+    }
 }
 
 void TFTTest::initDisplay() {
@@ -265,6 +395,15 @@ void TFTTest::fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t
     }
     
     digitalWrite(TFT_CS, HIGH);
+    bytes_transferred += pixels * 2;
+    if (hashing) {
+        // Colour and count identify the fill - no need to hash every pixel
+        hashByte(hi);
+        hashByte(lo);
+        for (uint8_t shift = 0; shift < 32; shift += 8) {
+            hashByte(pixels >> shift);
+        }
+    }
 }
 
 void TFTTest::drawPixel(uint16_t x, uint16_t y, uint16_t color) {
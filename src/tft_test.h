@@ -9,6 +9,29 @@ private:
     uint16_t width, height;
     uint16_t xstart, ystart;
     uint8_t rotation;
+    uint32_t bytes_transferred;  // SPI bytes sent since begin(), for metrics
+    uint32_t output_hash;        // FNV-1a of everything sent, while hashing is on
+    bool hashing;
+    
+    void hashByte(uint8_t b) { output_hash = (output_hash ^ b) * 16777619u; }
+    
+    // Non-blocking initialization state (startInit/pollInit)
+    enum InitState {
+        INIT_IDLE,
+        INIT_RESET_HIGH,
+        INIT_RESET_LOW,
+        INIT_RESET_WAIT,
+        INIT_COMMANDS,
+        INIT_WAKING,
+        INIT_SLEEPING,
+        INIT_DONE
+    };
+    InitState init_state;
+    uint8_t init_cmd_index;
+    unsigned long init_deadline;
+    bool sleep_pending;          // sleep() arrived before init finished
+    
+    bool finishInit();
     
     // Low-level SPI communication
     void writeCommand(uint8_t cmd);
@@ -17,6 +40,7 @@ private:
     void writeCommand(uint8_t cmd, uint8_t* data, uint8_t len);
     
     // Display initialization
+    void setupPins();
     void hardReset();
     void initDisplay();
     
@@ -29,6 +53,21 @@ public:
     // Initialization
     void begin();
     
+    // Non-blocking initialization: startInit() begins the reset sequence and
+    // pollInit() advances it, returning true once the panel accepts drawing.
+    // The ST7789 reset/sleep-out waits then overlap with other boot work.
+    void startInit();
+    bool pollInit();
+    bool isReady() { return init_state == INIT_DONE; }
+    
+    // Power saving: sleep() blanks the panel, sends SLPIN and releases the SPI
+    // bus; wake() sends SLPOUT and pollInit() finishes the sleep-out wait.
+    // A sleep() during init or wake-up is applied when pollInit() completes
+    // it, so the backlight never comes on for a display that is off.
+    void sleep();
+    void wake();
+    bool isSleeping() { return init_state == INIT_SLEEPING; }
+    
     // Display control
     void setRotation(uint8_t rot);
     
@@ -54,6 +93,12 @@ public:
     uint16_t getWidth() { return width; }
     uint16_t getHeight() { return height; }
     uint8_t getRotation() { return rotation; }
+    uint32_t getBytesTransferred() { return bytes_transferred; }
+    
+    // Fingerprint of the command/pixel stream, so rendered frames from two
+    // runs (e.g. a log replay) can be compared without capturing pixels
+    void setOutputHashing(bool enabled) { hashing = enabled; output_hash = 2166136261u; }
+    uint32_t getOutputHash() { return output_hash; }
 };
 
 #endif // TFT_TEST_H 
\ No newline at end of file
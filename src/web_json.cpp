@@ -0,0 +1,98 @@
+#include "web_json.h"
+
+String getAltimeterJSON(const SensorPipeline& pipeline, const AltimeterStatus& status) {
+    const SensorState& sensors = pipeline.getState();
+    String json = "{";
+    json += "\"altitude\":" + String(sensors.current_altitude, 2) + ",";
+    json += "\"max_altitude\":" + String(sensors.max_altitude, 2) + ",";
+    json += "\"acceleration\":" + String(sensors.current_acceleration, 2) + ",";
+    json += "\"max_acceleration\":" + String(sensors.max_acceleration, 2) + ",";
+    json += "\"max_acceleration_axis\":\"" + String(sensors.max_acceleration_axis) + "\",";
+    float q[4];
+    pipeline.getAhrs().getQuaternion(q);
+    json += "\"vertical_acceleration\":" + String(sensors.vertical_acceleration, 2) + ",";
+    json += "\"max_vertical_acceleration\":" + String(sensors.max_vertical_acceleration, 2) + ",";
+    json += "\"tilt\":" + String(sensors.tilt, 1) + ",";
+    json += "\"quaternion\":[" + String(q[0], 4) + "," + String(q[1], 4) + "," + String(q[2], 4) + "," + String(q[3], 4) + "],";
+    const SensorPipeline::ChannelStats& alt_1s = pipeline.getStats(SensorPipeline::CHANNEL_ALTITUDE, SensorPipeline::WINDOW_1S);
+    const SensorPipeline::ChannelStats& alt_10s = pipeline.getStats(SensorPipeline::CHANNEL_ALTITUDE, SensorPipeline::WINDOW_10S);
+    const SensorPipeline::ChannelStats& accel_1s = pipeline.getStats(SensorPipeline::CHANNEL_ACCELERATION, SensorPipeline::WINDOW_1S);
+    const SensorPipeline::ChannelStats& accel_10s = pipeline.getStats(SensorPipeline::CHANNEL_ACCELERATION, SensorPipeline::WINDOW_10S);
+    json += "\"climb_rate_1s\":" + String(alt_1s.getRate(), 2) + ",";
+    json += "\"climb_rate_10s\":" + String(alt_10s.getRate(), 2) + ",";
+    json += "\"altitude_stddev_1s\":" + String(alt_1s.getStdDev(), 3) + ",";
+    json += "\"altitude_min_10s\":" + String(alt_10s.getMin(), 2) + ",";
+    json += "\"altitude_max_10s\":" + String(alt_10s.getMax(), 2) + ",";
+    json += "\"peak_acceleration_1s\":" + String(accel_1s.getMax(), 2) + ",";
+    json += "\"mean_acceleration_10s\":" + String(accel_10s.getMean(), 2) + ",";
+    const ImuSample& imu_web = pipeline.getImuStreams().getLatest(ImuFilterBank::STREAM_WEB);
+    json += "\"accel_x\":" + String(imu_web.accel_x, 2) + ",";
+    json += "\"accel_y\":" + String(imu_web.accel_y, 2) + ",";
+    json += "\"accel_z\":" + String(imu_web.accel_z, 2) + ",";
+    json += "\"gyro_x\":" + String(imu_web.gyro_x, 2) + ",";
+    json += "\"gyro_y\":" + String(imu_web.gyro_y, 2) + ",";
+    json += "\"gyro_z\":" + String(imu_web.gyro_z, 2) + ",";
+    json += "\"temperature\":" + String(sensors.temperature, 2) + ",";
+    json += "\"pressure\":" + String(sensors.pressure/100.0f, 2) + ",";
+    json += "\"battery_voltage\":" + String(status.battery_voltage, 2) + ",";
+    json += "\"battery_percentage\":" + String(status.battery_percentage) + ",";
+    json += "\"bmp_status\":" + String(status.bmp_available ? "true" : "false") + ",";
+    json += "\"imu_status\":" + String(status.imu_available ? "true" : "false") + ",";
+    json += "\"baro_spikes\":" + String(sensors.baro_spikes) + ",";
+    const CompressedSeries& baro_recording = *status.baro_recording;
+    const CompressedSeries& imu_recording = *status.imu_recording;
+    json += "\"recording\":{\"active\":" + String(status.recording ? "true" : "false");
+    json += ",\"imu_samples\":" + String(imu_recording.getSampleCount());
+    json += ",\"baro_samples\":" + String(baro_recording.getSampleCount());
+    json += ",\"bytes\":" + String((unsigned)(imu_recording.getBytesUsed() + baro_recording.getBytesUsed()));
+    json += ",\"capacity\":" + String((unsigned)(imu_recording.getCapacityBytes() + baro_recording.getCapacityBytes()));
+    json += ",\"dropped\":" + String(imu_recording.getDroppedSamples() + baro_recording.getDroppedSamples()) + "},";
+    json += "\"peaks\":{";
+    for (int c = 0; c < PeakTracker::CHANNEL_COUNT; c++) {
+        PeakTracker::Channel channel = (PeakTracker::Channel)c;
+        if (c > 0) json += ",";
+        json += "\"" + String(PeakTracker::getChannelName(channel)) + "\":" + getPeakJSON(pipeline.getPeaks().getPeak(channel));
+    }
+    json += "},";
+    json += "\"flight_phase\":\"" + String(FlightPhaseDetector::getPhaseName(pipeline.getPhaseDetector().getPhase())) + "\"";
+    json += "}";
+    return json;
+}
+
+String getPeakJSON(const PeakTracker::Peak& peak) {
+    if (!peak.valid) {
+        return "null";
+    }
+    String json = "{\"g\":" + String(peak.value.toFloat(), 3);
+    json += ",\"time_ms\":" + String(peak.time_ms);
+    json += ",\"phase\":\"" + String(FlightPhaseDetector::getPhaseName(peak.phase)) + "\"";
+    json += ",\"peak_index\":" + String(peak.peak_index);
+    json += ",\"context\":[";
+    for (int i = 0; i < peak.context_count; i++) {
+        if (i > 0) json += ",";
+        json += String(peak.context[i].toFloat(), 3);
+    }
+    json += "]}";
+    return json;
+}
+
+String getFlightSummaryJSON(const FlightSummary& summary) {
+    auto seconds = [](float s) { return s == FlightSummary::NOT_SEEN ? String("null") : String(s, 2); };
+    String json = "{\"flight\":" + String((unsigned long)summary.flight_number) + ",";
+    json += "\"launched\":" + String(summary.launched ? "true" : "false") + ",";
+    json += "\"landed\":" + String(summary.landed ? "true" : "false") + ",";
+    json += "\"apogee_m\":" + String(summary.apogee_m, 1) + ",";
+    json += "\"max_acceleration_g\":" + String(summary.max_acceleration_g, 2) + ",";
+    json += "\"max_ascent_rate\":" + String(summary.max_ascent_rate, 1) + ",";
+    json += "\"max_descent_rate\":" + String(summary.max_descent_rate, 1) + ",";
+    json += "\"mean_descent_rate\":" + String(summary.mean_descent_rate, 1) + ",";
+    json += "\"launch_s\":" + seconds(summary.launch_s) + ",";
+    json += "\"burnout_s\":" + seconds(summary.burnout_s) + ",";
+    json += "\"apogee_s\":" + seconds(summary.apogee_s) + ",";
+    json += "\"touchdown_s\":" + seconds(summary.touchdown_s) + ",";
+    json += "\"max_acceleration_s\":" + seconds(summary.max_acceleration_s) + ",";
+    json += "\"recording_s\":" + String(summary.recording_s, 1) + ",";
+    json += "\"baro_samples\":" + String((unsigned long)summary.baro_samples) + ",";
+    json += "\"imu_samples\":" + String((unsigned long)summary.imu_samples) + "}";
+    return json;
+}
@@ -0,0 +1,35 @@
+#ifndef WEB_JSON_H
+#define WEB_JSON_H
+
+#include <Arduino.h>
+#include "sensor_pipeline.h"
+#include "compressed_series.h"
+#include "flight_summary.h"
+
+// Device state reported by /altimeter alongside the pipeline's
+struct AltimeterStatus {
+    float battery_voltage;
+    int battery_percentage;
+    bool bmp_available;
+    bool imu_available;
+    bool recording;
+    const CompressedSeries* baro_recording;
+    const CompressedSeries* imu_recording;
+};
+
+// Web API response bodies. Each is built only from the objects it
+// describes, with no server or hardware state, so the native build can
+// produce the same bytes the device serves.
+
+// /altimeter: current readings, window statistics, recording and peaks
+String getAltimeterJSON(const SensorPipeline& pipeline, const AltimeterStatus& status);
+
+// One channel's peak: value, when and in which phase it happened, and the
+// readings around it (peak_index marks the peak itself); null if unset
+String getPeakJSON(const PeakTracker::Peak& peak);
+
+// /logs/summary; event times are seconds into the recording, null if the
+// event was missed
+String getFlightSummaryJSON(const FlightSummary& summary);
+
+#endif // WEB_JSON_H
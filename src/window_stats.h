@@ -0,0 +1,274 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// Sliding-window statistics for one telemetry channel: min, max, mean,
+// variance and rate of change over the last window_us microseconds.
+//
+// Samples are merged into BUCKETS time buckets of window_us / BUCKETS each,
+// so memory is fixed however fast samples arrive and the window slides in
+// bucket steps. Every operation is O(1) (amortised): min/max come from
+// monotonic deques of bucket extremes, mean/variance from Welford
+// accumulators that are combined when a bucket closes and removed again when
+// it leaves the window. Removal is not exact in floating point, so the
+// running totals are rebuilt from the buckets once per BUCKETS evictions,
+// and straight away when a removal takes out most of the variance.
+template<size_t BUCKETS>
+class WindowStats {
+public:
+    static_assert(BUCKETS >= 2 && BUCKETS <= 65535, "WindowStats needs 2..65535 buckets");
+
+    explicit WindowStats(uint32_t window_us = 1000000) {
+        setWindow(window_us);
+    }
+
+    void setWindow(uint32_t window_us) {
+        window = window_us;
+        bucket_us = window_us / BUCKETS;
+        if (bucket_us == 0) {
+            bucket_us = 1;
+        }
+        reset();
+    }
+
+    void reset() {
+        head_seq = 0;
+        tail_seq = 0;
+        max_head = max_tail = 0;
+        min_head = min_tail = 0;
+        evictions = 0;
+        clearAccumulator(closed);
+        open_bucket = false;
+    }
+
+    void add(uint32_t time_us, float value) {
+        if (open_bucket && (int32_t)(time_us - current.start_us) >= (int32_t)bucket_us) {
+            closeBucket();
+        }
+        if (!open_bucket) {
+            startBucket(time_us);
+        }
+        expire(time_us);
+
+        Bucket& b = current;
+        if (b.acc.count == 0) {
+            b.first = value;
+            b.first_us = time_us;
+            b.min = value;
+            b.max = value;
+        } else {
+            if (value < b.min) {
+                b.min = value;
+            }
+            if (value > b.max) {
+                b.max = value;
+            }
+        }
+        b.last = value;
+        b.last_us = time_us;
+        welfordAdd(b.acc, value);
+    }
+
+    bool isEmpty() const { return closed.count == 0 && (!open_bucket || current.acc.count == 0); }
+    uint32_t getCount() const { return closed.count + (open_bucket ? current.acc.count : 0); }
+    uint32_t getWindowUs() const { return window; }
+
+    float getMin() const {
+        float m = open_bucket ? current.min : 0.0f;
+        if (min_head != min_tail) {
+            float d = bucketAt(min_deque[min_head % BUCKETS]).min;
+            if (!open_bucket || current.acc.count == 0 || d < m) {
+                m = d;
+            }
+        }
+        return m;
+    }
+
+    float getMax() const {
+        float m = open_bucket ? current.max : 0.0f;
+        if (max_head != max_tail) {
+            float d = bucketAt(max_deque[max_head % BUCKETS]).max;
+            if (!open_bucket || current.acc.count == 0 || d > m) {
+                m = d;
+            }
+        }
+        return m;
+    }
+
+    float getMean() const { return total().mean; }
+
+    float getVariance() const {
+        Accumulator t = total();
+        return t.count > 1 ? t.m2 / (t.count - 1) : 0.0f;
+    }
+
+    float getStdDev() const { return sqrtf(getVariance()); }
+
+    // Change per second between the oldest and newest sample in the window
+    float getRate() const {
+        if (isEmpty()) {
+            return 0.0f;
+        }
+        const Bucket& oldest = head_seq != tail_seq ? bucketAt(head_seq) : current;
+        const Bucket& newest = open_bucket && current.acc.count > 0 ? current : bucketAt(tail_seq - 1);
+        int32_t dt = (int32_t)(newest.last_us - oldest.first_us);
+        if (dt <= 0) {
+            return 0.0f;
+        }
+        return (newest.last - oldest.first) * (1.0e6f / dt);
+    }
+
+private:
+    struct Accumulator {
+        uint32_t count;
+        float mean;
+        float m2;
+    };
+
+    struct Bucket {
+        uint32_t start_us;
+        uint32_t first_us, last_us;
+        float first, last;
+        float min, max;
+        Accumulator acc;
+    };
+
+    uint32_t window;
+    uint32_t bucket_us;
+
+    // Closed buckets, oldest at head_seq; sequence numbers only grow, so
+    // deque entries stay valid while their bucket is in the ring
+    Bucket ring[BUCKETS];
+    uint32_t head_seq;
+    uint32_t tail_seq;
+
+    uint32_t max_deque[BUCKETS];   // Sequence numbers, bucket max decreasing
+    uint32_t max_head, max_tail;
+    uint32_t min_deque[BUCKETS];   // Sequence numbers, bucket min increasing
+    uint32_t min_head, min_tail;
+
+    Accumulator closed;            // All closed buckets in the window
+    uint32_t evictions;
+
+    Bucket current;
+    bool open_bucket;
+
+    Bucket& bucketAt(uint32_t seq) { return ring[seq % BUCKETS]; }
+    const Bucket& bucketAt(uint32_t seq) const { return ring[seq % BUCKETS]; }
+
+    static void clearAccumulator(Accumulator& a) {
+        a.count = 0;
+        a.mean = 0.0f;
+        a.m2 = 0.0f;
+    }
+
+    static void welfordAdd(Accumulator& a, float value) {
+        a.count++;
+        float delta = value - a.mean;
+        a.mean += delta / a.count;
+        a.m2 += delta * (value - a.mean);
+    }
+
+    // Chan et al. parallel combination of two sample sets
+    static Accumulator combine(const Accumulator& a, const Accumulator& b) {
+        if (a.count == 0) {
+            return b;
+        }
+        if (b.count == 0) {
+            return a;
+        }
+        Accumulator r;
+        r.count = a.count + b.count;
+        float delta = b.mean - a.mean;
+        r.mean = a.mean + delta * b.count / r.count;
+        r.m2 = a.m2 + b.m2 + delta * delta * ((float)a.count * b.count / r.count);
+        return r;
+    }
+
+    // Inverse of combine(): takes the set b back out of a
+    static Accumulator remove(const Accumulator& a, const Accumulator& b) {
+        Accumulator r;
+        if (b.count >= a.count) {
+            clearAccumulator(r);
+            return r;
+        }
+        r.count = a.count - b.count;
+        // From the difference of the means, not of the sums: a sum of a few
+        // hundred pressures in float is only good to a few Pa
+        r.mean = a.mean + (a.mean - b.mean) * ((float)b.count / r.count);
+        float delta = b.mean - r.mean;
+        r.m2 = a.m2 - b.m2 - delta * delta * ((float)r.count * b.count / a.count);
+        if (r.m2 < 0.0f) {
+            r.m2 = 0.0f;
+        }
+        return r;
+    }
+
+    Accumulator total() const {
+        return open_bucket ? combine(closed, current.acc) : closed;
+    }
+
+    void startBucket(uint32_t time_us) {
+        current.start_us = time_us;
+        clearAccumulator(current.acc);
+        open_bucket = true;
+    }
+
+    void closeBucket() {
+        open_bucket = false;
+        if (current.acc.count == 0) {
+            return;
+        }
+        if (tail_seq - head_seq == BUCKETS) {
+            evict();
+        }
+
+        uint32_t seq = tail_seq++;
+        bucketAt(seq) = current;
+        closed = combine(closed, current.acc);
+
+        while (max_tail != max_head && bucketAt(max_deque[(max_tail - 1) % BUCKETS]).max <= current.max) {
+            max_tail--;
+        }
+        max_deque[max_tail++ % BUCKETS] = seq;
+        while (min_tail != min_head && bucketAt(min_deque[(min_tail - 1) % BUCKETS]).min >= current.min) {
+            min_tail--;
+        }
+        min_deque[min_tail++ % BUCKETS] = seq;
+    }
+
+    void evict() {
+        uint32_t seq = head_seq++;
+        if (max_head != max_tail && max_deque[max_head % BUCKETS] == seq) {
+            max_head++;
+        }
+        if (min_head != min_tail && min_deque[min_head % BUCKETS] == seq) {
+            min_head++;
+        }
+
+        // Rebuilt too when most of the spread left with the bucket: what
+        // is left of m2 is then mostly rounding error of the subtraction
+        Accumulator rest = remove(closed, bucketAt(seq).acc);
+        if (++evictions >= BUCKETS || rest.m2 < closed.m2 * (1.0f / 16)) {
+            evictions = 0;
+            clearAccumulator(closed);
+            for (uint32_t s = head_seq; s != tail_seq; s++) {
+                closed = combine(closed, bucketAt(s).acc);
+            }
+        } else {
+            closed = rest;
+        }
+    }
+
+    // Drops closed buckets that ended before the window
+    void expire(uint32_t now_us) {
+        while (head_seq != tail_seq && (int32_t)(now_us - bucketAt(head_seq).last_us) > (int32_t)window) {
+            evict();
+        }
+    }
+};
+
+#endif // WINDOW_STATS_H
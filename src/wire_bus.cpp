@@ -0,0 +1,29 @@
+#include "wire_bus.h"
+
+WireBus::WireBus(TwoWire& bus) : wire(bus) {
+}
+
+bool WireBus::write(uint8_t address, const uint8_t* data, size_t len) {
+    wire.beginTransmission(address);
+    wire.write(data, len);
+    return wire.endTransmission() == 0;
+}
+
+bool WireBus::read(uint8_t address, uint8_t* out, size_t len) {
+    if (len > MAX_TRANSFER || wire.requestFrom(address, len) != len) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        out[i] = wire.read();
+    }
+    return true;
+}
+
+bool WireBus::readRegister(uint8_t address, uint8_t reg, uint8_t* out, size_t len) {
+    wire.beginTransmission(address);
+    wire.write(reg);
+    if (wire.endTransmission(false) != 0) {
+        return false;
+    }
+    return read(address, out, len);
+}
@@ -0,0 +1,22 @@
+#ifndef WIRE_BUS_H
+#define WIRE_BUS_H
+
+#include <Wire.h>
+#include "i2c_bus.h"
+
+// I2CBus on an Arduino TwoWire peripheral. Each call is a single attempt;
+// retries, ordering and statistics belong to the I2CScheduler in front of it.
+class WireBus : public I2CBus {
+public:
+    explicit WireBus(TwoWire& wire);
+
+    bool write(uint8_t address, const uint8_t* data, size_t len) override;
+    bool read(uint8_t address, uint8_t* out, size_t len) override;
+    bool readRegister(uint8_t address, uint8_t reg, uint8_t* out, size_t len) override;
+    void setClock(uint32_t hz) override { wire.setClock(hz); }
+
+private:
+    TwoWire& wire;
+};
+
+#endif // WIRE_BUS_H
@@ -0,0 +1,65 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+// Assertions shared by the host test suites in test/, which run against the
+// firmware sources on the native environment:
+//
+//     pio test -e native                          every suite
+//     pio test -e native -f test_segment_store    one suite
+//     pio test -e native -v                       with each check printed
+//
+// Each suite's tests are void functions run by Unity's RUN_TEST(). check()
+// prints its result and keeps going after a failure, so a run lists every
+// check that failed, not just the first; the test fails when it ends if any
+// did. The overload with a value also prints what was measured and the
+// limit or expected value it was held to. expect() prints nothing unless it
+// fails, for checks inside long loops.
+//
+// Include once per suite: it also defines Unity's setUp() and tearDown().
+
+#include <cstdio>
+#include <unity.h>
+
+inline int check_failures = 0;   // In the running test
+
+inline void check(bool ok, const char* what) {
+    printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) {
+        check_failures++;
+    }
+}
+
+inline void check(bool ok, const char* what, double value, double reference) {
+    printf("%s  %-48s %12.6g (against %g)\n", ok ? "ok  " : "FAIL", what, value, reference);
+    if (!ok) {
+        check_failures++;
+    }
+}
+
+inline void expect(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL  %s\n", what);
+        check_failures++;
+    }
+}
+
+inline void expect(bool ok, const char* what, double value) {
+    if (!ok) {
+        printf("FAIL  %s (%g)\n", what, value);
+        check_failures++;
+    }
+}
+
+void setUp() {
+    check_failures = 0;
+}
+
+void tearDown() {
+    if (check_failures > 0) {
+        char message[48];
+        snprintf(message, sizeof(message), "%d check(s) failed", check_failures);
+        TEST_FAIL_MESSAGE(message);
+    }
+}
+
+#endif // TEST_CHECK_H
@@ -0,0 +1,194 @@
+// Host accuracy test and benchmark for the Mahony AHRS.
+//
+// Checks fastInvSqrt() against 1/sqrt() in double, then drives Ahrs with
+// synthetic IMU data generated from an exactly integrated (double
+// precision) reference attitude:
+//   - static tilts: alignment from the first accelerometer sample
+//   - tumbling: changing body rates with gyro bias and noise for 60 s
+//   - boost: 8 g along a 10 degree tilted, spinning airframe, where the
+//     accelerometer is gated out and the gyro carries the attitude
+// and reports the error in the estimated up direction (yaw is not
+// observable without a magnetometer) and in vertical acceleration.
+// Finishes with the time per update().
+//
+// Run from the repository root:
+//     pio test -e native -f test_ahrs
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "check.h"
+#include "ahrs.h"
+#include "sim_random.h"
+
+// Reference attitude, body to earth, Hamilton convention as in Ahrs
+struct Quat {
+    double w, x, y, z;
+};
+
+static Quat multiply(const Quat& a, const Quat& b) {
+    return {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+    };
+}
+
+// Exact rotation by body rates (rad/s) over dt
+static Quat rotate(const Quat& q, double wx, double wy, double wz, double dt) {
+    double rate = sqrt(wx * wx + wy * wy + wz * wz);
+    if (rate < 1e-15) {
+        return q;
+    }
+    double half = 0.5 * rate * dt;
+    double s = sin(half) / rate;
+    return multiply(q, { cos(half), wx * s, wy * s, wz * s });
+}
+
+static void upVector(const Quat& q, double v[3]) {
+    v[0] = 2.0 * (q.x * q.z - q.w * q.y);
+    v[1] = 2.0 * (q.w * q.x + q.y * q.z);
+    v[2] = q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z;
+}
+
+static Quat fromRollPitch(double roll, double pitch) {
+    Quat r = { cos(roll / 2), sin(roll / 2), 0, 0 };
+    Quat p = { cos(pitch / 2), 0, sin(pitch / 2), 0 };
+    return multiply(r, p);
+}
+
+// Angle between the estimated and the true up direction (degrees)
+static double upError(const Ahrs& ahrs, const Quat& truth) {
+    float e[3];
+    double t[3];
+    ahrs.getUpVector(e);
+    upVector(truth, t);
+    double d = (e[0] * t[0] + e[1] * t[1] + e[2] * t[2]) /
+               sqrt(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+    return acos(fmin(1.0, fmax(-1.0, d))) * 180.0 / M_PI;
+}
+
+static void testInvSqrt() {
+    double worst = 0.0;
+    for (double x = 1e-6; x < 1e6; x *= 1.0007) {
+        double exact = 1.0 / sqrt((double)(float)x);
+        worst = fmax(worst, fabs(fastInvSqrt((float)x) - exact) / exact);
+    }
+    check(worst < 5e-6, "fastInvSqrt relative error", worst, 5e-6);
+}
+
+static void testStaticTilts() {
+    double worst = 0.0;
+    for (int roll = -170; roll <= 170; roll += 17) {
+        for (int pitch = -85; pitch <= 85; pitch += 17) {
+            Quat truth = fromRollPitch(roll * M_PI / 180, pitch * M_PI / 180);
+            double up[3];
+            upVector(truth, up);
+            Ahrs ahrs;
+            for (int i = 0; i < 2; i++) {
+                ahrs.update(0, 0, 0, up[0], up[1], up[2], 0.002f);
+            }
+            worst = fmax(worst, upError(ahrs, truth));
+        }
+    }
+    check(worst < 0.05, "static alignment error (deg)", worst, 0.05);
+}
+
+// 500 Hz for 60 s of tumbling with 0.5 deg/s gyro bias and sensor noise
+static void testTumbling() {
+    const double dt = 0.002;
+    SimRandom rng;
+    rng.seedWith(3);
+    Quat truth = fromRollPitch(0.3, -0.2);
+    Ahrs ahrs;
+    double worst = 0.0;
+    double sum_sq = 0.0;
+    int count = 0;
+    for (int i = 0; i < 30000; i++) {
+        double t = i * dt;
+        double wx = 1.2 * sin(0.7 * t);
+        double wy = 0.9 * cos(0.45 * t);
+        double wz = 2.0 + 0.5 * sin(0.2 * t);
+        truth = rotate(truth, wx, wy, wz, dt);
+        double up[3];
+        upVector(truth, up);
+        float rad_to_deg = 180.0f / (float)M_PI;
+        ahrs.update((float)wx * rad_to_deg + 0.5f + 0.1f * rng.gaussian(),
+                    (float)wy * rad_to_deg - 0.3f + 0.1f * rng.gaussian(),
+                    (float)wz * rad_to_deg + 0.4f + 0.1f * rng.gaussian(),
+                    (float)up[0] + 0.005f * rng.gaussian(),
+                    (float)up[1] + 0.005f * rng.gaussian(),
+                    (float)up[2] + 0.005f * rng.gaussian(), (float)dt);
+        if (t > 5.0) {
+            double e = upError(ahrs, truth);
+            worst = fmax(worst, e);
+            sum_sq += e * e;
+            count++;
+        }
+    }
+    check(sqrt(sum_sq / count) < 1.0, "tumbling RMS up-direction error (deg)", sqrt(sum_sq / count), 1.0);
+    check(worst < 3.0, "tumbling worst up-direction error (deg)", worst, 3.0);
+}
+
+// Pad, then 2 s boost at 8 g along body Z on a 10 degree tilted airframe
+// spinning at 90 deg/s, then 5 s coast in free fall
+static void testBoost() {
+    const double dt = 0.002;
+    Quat truth = fromRollPitch(10.0 * M_PI / 180, 0.0);
+    Ahrs ahrs;
+    double worst_up = 0.0;
+    double worst_vertical = 0.0;
+    for (int i = 0; i < 4000; i++) {
+        double t = i * dt;
+        double spin = t > 1.0 ? 90.0 * M_PI / 180 : 0.0;
+        truth = rotate(truth, 0, 0, spin, dt);
+        double up[3];
+        upVector(truth, up);
+
+        // Specific force in the body frame: gravity reaction on the pad,
+        // thrust along Z in boost, nothing in free fall
+        double f[3] = { up[0], up[1], up[2] };
+        if (t > 1.0 && t <= 3.0) {
+            f[0] = 0;
+            f[1] = 0;
+            f[2] = 8.0;
+        } else if (t > 3.0) {
+            f[0] = f[1] = f[2] = 0.0;
+        }
+        ahrs.update(0, 0, (float)(spin * 180 / M_PI), (float)f[0], (float)f[1], (float)f[2], (float)dt);
+
+        double vertical = f[0] * up[0] + f[1] * up[1] + f[2] * up[2] - 1.0;
+        if (t > 0.1) {
+            worst_up = fmax(worst_up, upError(ahrs, truth));
+            worst_vertical = fmax(worst_vertical, fabs(ahrs.getVerticalAcceleration() - vertical));
+        }
+    }
+    check(worst_up < 0.5, "boost worst up-direction error (deg)", worst_up, 0.5);
+    check(worst_vertical < 0.02, "boost worst vertical acceleration error (g)", worst_vertical, 0.02);
+}
+
+static void benchmark() {
+    Ahrs ahrs;
+    const int updates = 5000000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < updates; i++) {
+        float phase = (i & 1023) * 0.006f;
+        ahrs.update(10.0f, -5.0f, 90.0f, 0.01f * phase, -0.02f, 1.0f - 0.001f * phase, 0.002f);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    float q[4];
+    ahrs.getQuaternion(q);
+    printf("\nupdate(): %.1f ns (check %.3f)\n", ns / updates, q[0]);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testInvSqrt);
+    RUN_TEST(testStaticTilts);
+    RUN_TEST(testTumbling);
+    RUN_TEST(testBoost);
+    RUN_TEST(benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,334 @@
+// Host check for the barometer drivers against register models.
+//
+// Runs the real drivers through WireBus on the native Wire bus, with the
+// register models from native/sensor_models.h attached, on a manual clock:
+//   - BMP180 and MS5611 compensation against the datasheets' worked
+//     examples, and the MS5611 second-order branch below 20 C and below
+//     -15 C against the datasheet formulas worked by hand; conversions are
+//     only read once finished, and samples are stamped at their end
+//   - BMP3xx configuration, compensation against the datasheet's float
+//     formulas in double, parsing of every FIFO frame type (0x94, 0x90,
+//     0x84, 0xA0, config), a frame cut off by the burst length, and
+//     back-dated timestamps, also across several bursts after a full FIFO
+//   - detectBarometer() with each part at each address, a BMP180 answering
+//     at the MS5611 address, and an empty bus
+//
+// Run from the repository root:
+//     pio test -e native -f test_barometer
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "check.h"
+#include "native_hal.h"
+#include "sensor_models.h"
+#include "barometer.h"
+#include "bmp180_barometer.h"
+#include "bmp3_barometer.h"
+#include "ms5611_barometer.h"
+#include "wire_bus.h"
+
+static WireBus bus(Wire);
+
+// Polls every 100 us of simulated time until a sample comes out
+static bool nextSample(Barometer& baro, BaroSample& out, uint32_t timeout_us = 100000) {
+    for (uint32_t waited = 0; waited < timeout_us; waited += 100) {
+        if (baro.readBatch(&out, 1) == 1) {
+            return true;
+        }
+        nativeAdvanceMicros(100);
+    }
+    return false;
+}
+
+// --- BMP180 ---
+
+// Datasheet section 3.5 example
+static const Bmp180Model::Calibration bmp180_example = {
+    408, -72, -14383, 32741, 32757, 23153, 6190, 4, -32768, -8711, 2868
+};
+
+static void checkBmp180() {
+    Bmp180Model model(bmp180_example);
+    model.setRaw(27898, 23843);
+    Wire.attachDevice(Bmp180Barometer::ADDRESS, &model);
+
+    Bmp180Barometer baro(bus, 0);
+    uint32_t start = micros();
+    check(baro.begin(), "BMP180: begin() reads the chip ID and calibration");
+    BaroSample sample;
+    bool got = nextSample(baro, sample);
+    printf("BMP180: %.0f Pa, %.1f C at %u us\n", sample.pressure_pa, sample.temperature_c, sample.time_us - start);
+    check(got && sample.pressure_pa == 69964.0f && sample.temperature_c == 15.0f,
+          "BMP180: datasheet example gives 69964 Pa and 15.0 C");
+    check(sample.time_us == start + 4500 + 4500, "BMP180: stamped at the end of the pressure conversion");
+
+    // Temperature once per 8 pressure conversions
+    int samples = 1;
+    bool same = true;
+    while (samples < 32 && nextSample(baro, sample)) {
+        same = same && sample.pressure_pa == 69964.0f;
+        samples++;
+    }
+    check(samples == 32 && same, "BMP180: 32 samples in a row, all the same");
+    check(model.getConversions() <= 32 + 32 / 8 + 1, "BMP180: temperature re-measured every 8th sample only");
+    Wire.attachDevice(Bmp180Barometer::ADDRESS, nullptr);
+}
+
+// --- MS5611 ---
+
+// Datasheet (MS5611-01BA03) example C1..C6
+static const uint16_t ms5611_example[6] = { 40127, 36924, 23317, 23282, 33464, 28312 };
+
+static bool ms5611Sample(Ms5611Model& model, uint32_t d1, uint32_t d2, BaroSample& out, uint32_t& start) {
+    model.setRaw(d1, d2);
+    Ms5611Barometer baro(bus, Ms5611Barometer::ADDRESS_PRIMARY);
+    if (!baro.begin()) {
+        return false;
+    }
+    start = micros();
+    return nextSample(baro, out);
+}
+
+static void checkMs5611() {
+    Ms5611Model model(ms5611_example);
+    Wire.attachDevice(Ms5611Barometer::ADDRESS_PRIMARY, &model);
+
+    struct Case {
+        uint32_t d1, d2;
+        float pressure_pa, temperature_c;
+        const char* what;
+    };
+    // The first is the datasheet's; the others are its second-order formulas
+    // worked by hand: dT -166784 gives TEMP 1437, T2 12, OFF2 792422,
+    // SENS2 396211; dT -1166784 gives TEMP -1938, T2 633, OFF2 40112518,
+    // SENS2 20439947 (including the below -15 C terms)
+    const Case cases[] = {
+        { 9085466, 8569150, 100009.0f, 20.07f, "MS5611: datasheet example gives 100009 Pa and 20.07 C" },
+        { 9085466, 8400000, 98882.0f, 14.25f, "MS5611: second order below 20 C gives 98882 Pa and 14.25 C" },
+        { 9085466, 7400000, 90941.0f, -25.71f, "MS5611: second order below -15 C gives 90941 Pa and -25.71 C" },
+    };
+    for (const Case& c : cases) {
+        BaroSample sample;
+        uint32_t start = 0;
+        bool got = ms5611Sample(model, c.d1, c.d2, sample, start);
+        printf("MS5611: D1 %u D2 %u: %.0f Pa, %.2f C\n", c.d1, c.d2, sample.pressure_pa, sample.temperature_c);
+        check(got && sample.pressure_pa == c.pressure_pa && sample.temperature_c == c.temperature_c, c.what);
+        // Temperature is read at the first 100 us poll after 9.04 ms, which starts pressure
+        check(sample.time_us == start + 9100 + 9040, "MS5611: stamped at the end of the pressure conversion");
+    }
+    check(model.getEarlyReads() == 0, "MS5611: the ADC is never read before a conversion finishes");
+    Wire.attachDevice(Ms5611Barometer::ADDRESS_PRIMARY, nullptr);
+}
+
+// --- BMP3xx ---
+
+struct Bmp3Calibration {
+    uint16_t t1, t2;
+    int8_t t3;
+    int16_t p1, p2;
+    int8_t p3, p4;
+    uint16_t p5, p6;
+    int8_t p7, p8;
+    int16_t p9;
+    int8_t p10, p11;
+};
+
+static const Bmp3Calibration bmp3_cal = { 27472, 19306, -10, -1166, -6035, 35, 1, 19948, 23683, 3, -6, 3840, 1, -60 };
+
+static void packBmp3Calibration(const Bmp3Calibration& c, uint8_t nvm[21]) {
+    const uint16_t words[] = { c.t1, c.t2, (uint16_t)c.p1, (uint16_t)c.p2, c.p5, c.p6, (uint16_t)c.p9 };
+    const int offsets[] = { 0, 2, 5, 7, 11, 13, 17 };
+    for (int i = 0; i < 7; i++) {
+        nvm[offsets[i]] = words[i] & 0xFF;
+        nvm[offsets[i] + 1] = words[i] >> 8;
+    }
+    nvm[4] = (uint8_t)c.t3;
+    nvm[9] = (uint8_t)c.p3;
+    nvm[10] = (uint8_t)c.p4;
+    nvm[15] = (uint8_t)c.p7;
+    nvm[16] = (uint8_t)c.p8;
+    nvm[19] = (uint8_t)c.p10;
+    nvm[20] = (uint8_t)c.p11;
+}
+
+// Datasheet section 9.2/9.3, in double
+static double bmp3Temperature(uint32_t raw) {
+    double partial1 = raw - bmp3_cal.t1 * 256.0;
+    return partial1 * (bmp3_cal.t2 / pow(2, 30)) + partial1 * partial1 * (bmp3_cal.t3 / pow(2, 48));
+}
+
+static double bmp3Pressure(uint32_t raw, double t) {
+    const Bmp3Calibration& c = bmp3_cal;
+    double p1 = (c.p1 - 16384) / pow(2, 20), p2 = (c.p2 - 16384) / pow(2, 29), p3 = c.p3 / pow(2, 32);
+    double p4 = c.p4 / pow(2, 37), p5 = c.p5 * 8.0, p6 = c.p6 / 64.0, p7 = c.p7 / 256.0, p8 = c.p8 / 32768.0;
+    double p9 = c.p9 / pow(2, 48), p10 = c.p10 / pow(2, 48), p11 = c.p11 / pow(2, 65);
+    double out1 = p5 + p6 * t + p7 * t * t + p8 * t * t * t;
+    double out2 = raw * (p1 + p2 * t + p3 * t * t + p4 * t * t * t);
+    double out3 = (double)raw * raw * (p9 + p10 * t) + (double)raw * raw * raw * p11;
+    return out1 + out2 + out3;
+}
+
+static void putLe24(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+}
+
+static size_t drainAll(Bmp3Barometer& baro, BaroSample* out, size_t max) {
+    size_t total = 0;
+    size_t n;
+    while (total < max && (n = baro.readBatch(out + total, max - total < 8 ? max - total : 8)) > 0) {
+        total += n;
+    }
+    return total;
+}
+
+static void checkBmp3() {
+    uint8_t nvm[21];
+    packBmp3Calibration(bmp3_cal, nvm);
+    Bmp3Model model(0x50, nvm);
+    Wire.attachDevice(Bmp3Barometer::ADDRESS_PRIMARY, &model);
+    const uint32_t period_us = 1000000 / Bmp3Barometer::ODR_HZ;
+
+    Bmp3Barometer baro(bus, Bmp3Barometer::ADDRESS_PRIMARY);
+    check(baro.begin() && strcmp(baro.getName(), "BMP388") == 0, "BMP3: begin() finds a BMP388");
+    check(model.getRegister(0x17) == 0x19, "BMP3: FIFO on with pressure and temperature, stop-on-full off");
+    check(model.getRegister(0x1B) == 0x33 && model.getRegister(0x1C) == 0x03 && model.getRegister(0x1D) == 0x02,
+          "BMP3: normal mode, x8 pressure oversampling, 50 Hz");
+
+    // Compensation, and timestamps back from the read
+    const uint32_t raw_t[3] = { 8000000, 8300000, 8600000 };
+    const uint32_t raw_p[3] = { 3700000, 3800000, 3900000 };
+    for (int i = 0; i < 3; i++) {
+        model.measure(raw_t[i], raw_p[i]);
+    }
+    BaroSample out[128];
+    nativeAdvanceMicros(5000);
+    uint32_t read_time = micros();
+    size_t n = drainAll(baro, out, 128);
+    bool close = n == 3;
+    bool stamped = n == 3;
+    for (size_t i = 0; i < n && i < 3; i++) {
+        double t = bmp3Temperature(raw_t[i]);
+        double p = bmp3Pressure(raw_p[i], t);
+        printf("BMP3: raw %u/%u: %.2f Pa (reference %.2f), %.3f C (reference %.3f)\n", raw_t[i], raw_p[i],
+               out[i].pressure_pa, p, out[i].temperature_c, t);
+        close = close && fabs(out[i].pressure_pa - p) < 0.5 && fabs(out[i].temperature_c - t) < 0.001;
+        stamped = stamped && out[i].time_us == read_time - (2 - i) * period_us;
+    }
+    check(close, "BMP3: compensation within 0.5 Pa and 0.001 C of the datasheet formulas");
+    check(stamped, "BMP3: newest sample stamped at the read, older ones one period apart");
+
+    // Every frame type: sensor time and config frames are skipped, a
+    // temperature-only frame feeds the pressure-only frame after it
+    uint8_t payload[6];
+    putLe24(payload, 0x123456);
+    model.addFrame(0xA0, payload, 3);
+    putLe24(payload, raw_t[2]);
+    model.addFrame(0x90, payload, 3);
+    putLe24(payload, raw_p[0]);
+    model.addFrame(0x84, payload, 3);
+    payload[0] = 0;
+    model.addFrame(0x48, payload, 1);
+    putLe24(payload, raw_t[0]);
+    putLe24(payload + 3, raw_p[1]);
+    model.addFrame(0x94, payload, 6);
+    n = drainAll(baro, out, 128);
+    double t_high = bmp3Temperature(raw_t[2]);
+    double t_low = bmp3Temperature(raw_t[0]);
+    check(n == 2 && fabs(out[0].temperature_c - t_high) < 0.001 &&
+              fabs(out[0].pressure_pa - bmp3Pressure(raw_p[0], t_high)) < 0.5 &&
+              fabs(out[1].temperature_c - t_low) < 0.001 && fabs(out[1].pressure_pa - bmp3Pressure(raw_p[1], t_low)) < 0.5,
+          "BMP3: 0xA0, 0x90, 0x84, 0x48 and 0x94 frames parse to two samples");
+
+    // 18 bytes: the driver asks for two 7-byte frames' worth, which cuts the
+    // third frame; the model sends it again with the next read
+    model.addFrame(0x90, payload, 3);
+    model.measure(raw_t[1], raw_p[1]);
+    model.measure(raw_t[1], raw_p[2]);
+    nativeAdvanceMicros(1000);
+    read_time = micros();
+    n = drainAll(baro, out, 128);
+    check(n == 2 && fabs(out[1].pressure_pa - bmp3Pressure(raw_p[2], bmp3Temperature(raw_t[1]))) < 0.5,
+          "BMP3: a frame cut off by the burst length comes with the next read");
+    check(n == 2 && out[0].time_us == read_time - period_us && out[1].time_us == read_time,
+          "BMP3: the cut-off frame counts as still in the FIFO for the timestamps");
+
+    // A late drain: 100 frames into a 512-byte FIFO keeps the newest 73
+    for (uint32_t i = 0; i < 100; i++) {
+        model.measure(raw_t[1], 3700000 + i * 1000);
+    }
+    nativeAdvanceMicros(2000000);
+    read_time = micros();
+    n = drainAll(baro, out, 128);
+    bool spaced = n == 73;
+    for (size_t i = 1; i < n; i++) {
+        spaced = spaced && out[i].time_us - out[i - 1].time_us == period_us;
+    }
+    double newest = bmp3Pressure(3700000 + 99 * 1000, bmp3Temperature(raw_t[1]));
+    printf("BMP3: full FIFO: %zu samples, %u frames overwritten\n", n, model.getDroppedFrames());
+    check(n == 73 && model.getDroppedFrames() == 27 && fabs(out[n - 1].pressure_pa - newest) < 0.5,
+          "BMP3: a full FIFO keeps the newest frames");
+    check(spaced && out[n - 1].time_us == read_time,
+          "BMP3: samples from several bursts are one period apart, the newest at the read");
+    Wire.attachDevice(Bmp3Barometer::ADDRESS_PRIMARY, nullptr);
+}
+
+// --- Detection ---
+
+static void checkDetect() {
+    Bmp180Model bmp180(bmp180_example);
+    Ms5611Model ms5611(ms5611_example);
+    uint8_t nvm[21];
+    packBmp3Calibration(bmp3_cal, nvm);
+    Bmp3Model bmp390(0x60, nvm);
+
+    check(detectBarometer(bus) == nullptr, "detect: nothing on an empty bus");
+
+    struct Case {
+        uint8_t address;
+        NativeI2cDevice* model;
+        uint8_t second_address;
+        NativeI2cDevice* second;
+        Barometer::Type type;
+        uint8_t found_at;
+        const char* what;
+    };
+    const Case cases[] = {
+        { 0x77, &bmp180, 0, nullptr, Barometer::TYPE_BMP180, 0x77, "detect: BMP180 at 0x77" },
+        { 0x77, &ms5611, 0, nullptr, Barometer::TYPE_MS5611, 0x77, "detect: MS5611 at 0x77" },
+        { 0x76, &ms5611, 0, nullptr, Barometer::TYPE_MS5611, 0x76, "detect: MS5611 at 0x76" },
+        { 0x77, &bmp390, 0, nullptr, Barometer::TYPE_BMP3XX, 0x77, "detect: BMP390 at 0x77" },
+        { 0x76, &bmp390, 0, nullptr, Barometer::TYPE_BMP3XX, 0x76, "detect: BMP390 at 0x76" },
+        { 0x77, &bmp180, 0x76, &ms5611, Barometer::TYPE_BMP180, 0x77, "detect: BMP180 before an MS5611 at 0x76" },
+        { 0x77, &ms5611, 0x76, &bmp390, Barometer::TYPE_BMP3XX, 0x76, "detect: BMP3xx before an MS5611" },
+    };
+    for (const Case& c : cases) {
+        Wire.attachDevice(c.address, c.model);
+        if (c.second != nullptr) {
+            Wire.attachDevice(c.second_address, c.second);
+        }
+        Barometer* found = detectBarometer(bus);
+        check(found != nullptr && found->getType() == c.type && found->getAddress() == c.found_at, c.what);
+        Wire.attachDevice(0x76, nullptr);
+        Wire.attachDevice(0x77, nullptr);
+    }
+
+    // The BMP180 ACKs the MS5611's commands at 0x77; the PROM CRC rejects it
+    Wire.attachDevice(0x77, &bmp180);
+    Ms5611Barometer ms5611_driver(bus, 0x77);
+    check(!ms5611_driver.begin(), "detect: the MS5611 driver rejects a BMP180 at its address");
+    Wire.attachDevice(0x77, nullptr);
+}
+
+int main() {
+    nativeSetManualClock(true);
+    UNITY_BEGIN();
+    RUN_TEST(checkBmp180);
+    RUN_TEST(checkMs5611);
+    RUN_TEST(checkBmp3);
+    RUN_TEST(checkDetect);
+    return UNITY_END();
+}
@@ -0,0 +1,213 @@
+// Host benchmark and round-trip check for CompressedSeries.
+//
+// Records simulated model rocket flights - IMU at the QMI8658's ~448 Hz
+// with FIFO batch timing jitter, barometer at 50 Hz - into CompressedSeries
+// with each column encoding, decodes them again and reports:
+//   - bytes per sample and the ratio to the raw FlightRecord (32 bytes)
+//   - encode and decode time per sample
+//   - how many minutes of flight fit in 1 MB of PSRAM
+// IMU values are put on the sensor's LSB grid (1/2048 g, 1/16 deg/s), as
+// the driver delivers them. Also checks that XOR columns round-trip exactly,
+// DELTA columns to within half a quantum (plus float rounding), and that
+// timestamps survive the 32-bit wrap and ring recycling.
+//
+// Run from the repository root:
+//     pio test -e native -f test_compressed_series
+
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "check.h"
+#include "compressed_series.h"
+#include "flight_record.h"
+#include "flight_simulator.h"
+#include "sim_random.h"
+
+struct Stream {
+    std::vector<uint32_t> time_us;
+    std::vector<float> values;   // columns per sample, interleaved
+    int columns;
+    double seconds;
+};
+
+static float onGrid(float value, float lsb) {
+    return roundf(value / lsb) * lsb;
+}
+
+// One 60 s flight starting at start_us; FIFO reads every 10 IMU samples
+// land with up to +-40 us of jitter, as the back-dated driver timestamps do
+static void simulate(uint64_t seed, uint32_t start_us, Stream& imu, Stream& baro) {
+    FlightSimulator sim;
+    sim.begin(FlightProfile::modelRocket(), seed);
+    SimRandom rng;
+    rng.seedWith(seed + 100);
+
+    const uint32_t imu_period_us = 2230;
+    const uint32_t baro_period_us = 20000;
+    int32_t jitter = 0;
+    uint32_t next_baro = 0;
+    for (uint32_t i = 0, t = 0; t < 60000000u; i++, t += imu_period_us) {
+        if (i % 10 == 0) {
+            jitter = (int32_t)(rng.nextU32() % 81) - 40;
+        }
+        const SimSample& s = sim.update(t);
+        imu.time_us.push_back(start_us + t + jitter);
+        imu.values.push_back(onGrid(s.accel_x, 1.0f / 2048));
+        imu.values.push_back(onGrid(s.accel_y, 1.0f / 2048));
+        imu.values.push_back(onGrid(s.accel_z, 1.0f / 2048));
+        imu.values.push_back(onGrid(s.gyro_x, 1.0f / 16));
+        imu.values.push_back(onGrid(s.gyro_y, 1.0f / 16));
+        imu.values.push_back(onGrid(s.gyro_z, 1.0f / 16));
+        if (t >= next_baro) {
+            baro.time_us.push_back(start_us + t);
+            baro.values.push_back(s.pressure_pa);
+            baro.values.push_back(s.temperature_c);
+            next_baro += baro_period_us;
+        }
+    }
+    imu.columns = 6;
+    baro.columns = 2;
+    imu.seconds += 60.0;
+    baro.seconds += 60.0;
+}
+
+struct Result {
+    double bytes_per_sample;
+    double encode_ns;
+    double decode_ns;
+    double worst_error;          // DELTA: in units of the allowed error
+    bool times_exact;
+};
+
+static Result run(const char* name, const Stream& stream, const CompressedSeries::Column* columns,
+                  std::vector<uint8_t>& memory) {
+    CompressedSeries series;
+    series.configure(columns, stream.columns);
+    series.begin(memory.data(), memory.size());
+
+    size_t samples = stream.time_us.size();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < samples; i++) {
+        series.append(stream.time_us[i], &stream.values[i * stream.columns]);
+    }
+    double encode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    Result r;
+    r.times_exact = series.getDroppedSamples() == 0 && series.getSampleCount() == samples;
+    r.worst_error = 0.0;
+    start = std::chrono::steady_clock::now();
+    CompressedSeries::Iterator it = series.iterate();
+    uint32_t time_us;
+    float values[CompressedSeries::MAX_COLUMNS];
+    size_t decoded = 0;
+    while (it.next(time_us, values)) {
+        if (decoded < samples) {
+            r.times_exact = r.times_exact && time_us == stream.time_us[decoded];
+            for (int c = 0; c < stream.columns; c++) {
+                double original = stream.values[decoded * stream.columns + c];
+                double e = fabs((double)values[c] - original);
+                if (columns[c].encoding == CompressedSeries::ENCODING_DELTA) {
+                    // Half a quantum, plus the float's own rounding of the result
+                    e /= 0.5 * columns[c].resolution + fabs(original) * FLT_EPSILON;
+                }
+                r.worst_error = fmax(r.worst_error, e);
+            }
+        }
+        decoded++;
+    }
+    double decode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    r.times_exact = r.times_exact && decoded == samples;
+
+    r.bytes_per_sample = (double)series.getBytesUsed() / samples;
+    r.encode_ns = encode_ns / samples;
+    r.decode_ns = decode_ns / samples;
+
+    size_t raw = sizeof(FlightRecord);
+    printf("%-28s %7.2f B/sample  %5.1fx  encode %6.1f ns  decode %6.1f ns  %6.1f min/MB\n", name,
+           r.bytes_per_sample, raw / r.bytes_per_sample, r.encode_ns, r.decode_ns,
+           1048576.0 / r.bytes_per_sample / (samples / stream.seconds) / 60.0);
+    return r;
+}
+
+// PSRAM stand-in shared by the tests
+static std::vector<uint8_t> memory(64u << 20);
+
+// Timestamps straddling the 32-bit wrap, and a ring too small for the data
+static void testWrapAndRecycle() {
+    CompressedSeries::Column column = { CompressedSeries::ENCODING_DELTA, 1.0f };
+    CompressedSeries series;
+    series.configure(&column, 1);
+    series.begin(memory.data(), CompressedSeries::BLOCK_BYTES * 3);
+
+    uint32_t t = 0xFFFFFFFFu - 500000;
+    const int samples = 20000;
+    std::vector<uint32_t> times;
+    for (int i = 0; i < samples; i++) {
+        t += 1000 + (i % 7 == 0 ? 123456 : 0);
+        times.push_back(t);
+        float v = (float)((i * 37) % 1000 - 500);
+        series.append(t, &v);
+    }
+    expect(series.getDroppedSamples() > 0, "ring recycled its oldest blocks");
+    expect(series.getSampleCount() + series.getDroppedSamples() == (uint32_t)samples, "sample accounting");
+
+    CompressedSeries::Iterator it = series.iterate();
+    uint32_t time_us;
+    float value;
+    size_t index = series.getDroppedSamples();
+    bool ok = series.getFirstTimeUs() == times[index];
+    while (it.next(time_us, &value)) {
+        ok = ok && index < times.size() && time_us == times[index] &&
+             value == (float)(((int)index * 37) % 1000 - 500);
+        index++;
+    }
+    expect(ok && index == (size_t)samples, "timestamps and values across the wrap after recycling");
+}
+
+static void testEncodings() {
+    const int flights = 3;
+    Stream imu = Stream();
+    Stream baro = Stream();
+    for (int f = 0; f < flights; f++) {
+        simulate(f + 1, (uint32_t)f * 61000000u, imu, baro);
+    }
+    printf("%d simulated flights: %zu IMU samples, %zu barometer samples\n\n", flights, imu.time_us.size(),
+           baro.time_us.size());
+
+    const CompressedSeries::Column imu_xor[6] = {
+        { CompressedSeries::ENCODING_XOR, 0 }, { CompressedSeries::ENCODING_XOR, 0 },
+        { CompressedSeries::ENCODING_XOR, 0 }, { CompressedSeries::ENCODING_XOR, 0 },
+        { CompressedSeries::ENCODING_XOR, 0 }, { CompressedSeries::ENCODING_XOR, 0 }
+    };
+    const CompressedSeries::Column imu_delta[6] = {
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 2048 }, { CompressedSeries::ENCODING_DELTA, 1.0f / 2048 },
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 2048 }, { CompressedSeries::ENCODING_DELTA, 1.0f / 16 },
+        { CompressedSeries::ENCODING_DELTA, 1.0f / 16 }, { CompressedSeries::ENCODING_DELTA, 1.0f / 16 }
+    };
+    const CompressedSeries::Column baro_xor[2] = {
+        { CompressedSeries::ENCODING_XOR, 0 }, { CompressedSeries::ENCODING_XOR, 0 }
+    };
+    const CompressedSeries::Column baro_delta[2] = {
+        { CompressedSeries::ENCODING_DELTA, 0.01f }, { CompressedSeries::ENCODING_DELTA, 0.01f }
+    };
+
+    Result r = run("IMU, XOR floats", imu, imu_xor, memory);
+    expect(r.times_exact && r.worst_error == 0.0, "IMU XOR round trip is exact");
+    r = run("IMU, delta at sensor LSB", imu, imu_delta, memory);
+    expect(r.times_exact && r.worst_error <= 1.0, "IMU delta round trip within half an LSB");
+    r = run("baro, XOR floats", baro, baro_xor, memory);
+    expect(r.times_exact && r.worst_error == 0.0, "baro XOR round trip is exact");
+    r = run("baro, delta at 0.01 Pa/C", baro, baro_delta, memory);
+    expect(r.times_exact && r.worst_error <= 1.0, "baro delta round trip within half a quantum");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testEncodings);
+    RUN_TEST(testWrapAndRecycle);
+    return UNITY_END();
+}
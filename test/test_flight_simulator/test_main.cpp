@@ -0,0 +1,320 @@
+// Host regression run for the flight simulator.
+//
+// Flies FlightProfile::modelRocket() with a range of seeds and checks the
+// trajectory against the profile: ignition and burnout at the profile's
+// times, apogee and its time against an independent double-precision RK4
+// integration of the same physics, drogue at apogee, main at the deploy
+// altitude, the descent rates under each canopy, and touchdown. Then checks
+// that the truth does not depend on the seed or on how often update() is
+// called, that a seed reproduces its samples exactly, that the sensor noise
+// has the profile's statistics, and that SensorPipeline sees launch, apogee
+// and landing where the simulator put them.
+//
+// Run from the repository root:
+//     pio test -e native -f test_flight_simulator
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "flight_simulator.h"
+#include "sensor_pipeline.h"
+
+static const double GRAVITY = 9.80665;
+
+// --- Reference trajectory ---
+// The same physics as the simulator, written out separately in double with
+// RK4 at 0.1 ms, from ignition until touchdown
+
+struct Reference {
+    double apogee_m;
+    double apogee_s;       // From ignition
+    double main_s;
+    double touchdown_s;
+    double drogue_rate;    // Descent rate just before the main opens
+    double main_rate;      // Descent rate just before touchdown
+};
+
+static double airDensity(const FlightProfile& p, double altitude_agl) {
+    return 1.225 * pow(1.0 - 2.25577e-5 * (p.ground_altitude_m + altitude_agl), 4.25588);
+}
+
+static double referenceAcceleration(const FlightProfile& p, SimPhase phase, double t, double h, double v) {
+    double rho = airDensity(p, h);
+    double mass = p.dry_mass_kg;
+    double thrust = 0.0;
+    double drag_area = p.drag_area_m2;
+    if (phase == SIM_BOOST) {
+        thrust = p.thrust_n;
+        mass += p.propellant_mass_kg * (1.0 - t / p.burn_time_s);
+    } else if (phase == SIM_DROGUE) {
+        drag_area += 2.0 * mass * GRAVITY / (rho * p.drogue_rate_ms * p.drogue_rate_ms);
+    } else if (phase == SIM_MAIN) {
+        drag_area += 2.0 * mass * GRAVITY / (rho * p.main_rate_ms * p.main_rate_ms);
+    }
+    return (thrust - 0.5 * rho * v * fabs(v) * drag_area) / mass - GRAVITY;
+}
+
+static Reference flyReference(const FlightProfile& p) {
+    const double dt = 1.0e-4;
+    Reference r = {};
+    SimPhase phase = SIM_BOOST;
+    double t = 0.0, h = 0.0, v = 0.0;
+    while (phase != SIM_LANDED && t < 600.0) {
+        double a1 = referenceAcceleration(p, phase, t, h, v);
+        double a2 = referenceAcceleration(p, phase, t + dt / 2, h + v * dt / 2, v + a1 * dt / 2);
+        double a3 = referenceAcceleration(p, phase, t + dt / 2, h + (v + a1 * dt / 2) * dt / 2, v + a2 * dt / 2);
+        double a4 = referenceAcceleration(p, phase, t + dt, h + (v + a2 * dt / 2) * dt, v + a3 * dt);
+        h += dt * (v + dt * (a1 + a2 + a3) / 6.0);
+        v += dt * (a1 + 2 * a2 + 2 * a3 + a4) / 6.0;
+        t += dt;
+
+        if (h > r.apogee_m) {
+            r.apogee_m = h;
+            r.apogee_s = t;
+        }
+        if (phase == SIM_BOOST && t >= p.burn_time_s) {
+            phase = SIM_COAST;
+        } else if (phase == SIM_COAST && v <= 0.0) {
+            phase = SIM_DROGUE;
+        } else if (phase == SIM_DROGUE && h <= p.main_deploy_agl_m) {
+            r.drogue_rate = -v;
+            r.main_s = t;
+            phase = SIM_MAIN;
+        } else if (phase == SIM_MAIN && h <= 0.0) {
+            r.main_rate = -v;
+            r.touchdown_s = t;
+            phase = SIM_LANDED;
+        }
+    }
+    return r;
+}
+
+// --- Simulated flight ---
+
+struct Flight {
+    double phase_s[SIM_LANDED + 1];   // Time each phase began, from power-on
+    double apogee_m;
+    double drogue_rate;
+    double main_rate;
+    float truth_at_20s;
+};
+
+static Flight flySimulator(const FlightProfile& p, uint64_t seed, uint32_t step_us) {
+    FlightSimulator sim;
+    sim.begin(p, seed);
+    Flight f = {};
+    SimPhase last = SIM_GROUND_IDLE;
+    float last_velocity = 0.0f;
+    for (uint32_t now = step_us; now < 300000000 && !sim.hasLanded(); now += step_us) {
+        sim.update(now);
+        if (now == 20000000) {
+            f.truth_at_20s = sim.getTrueAltitudeAgl();
+        }
+        SimPhase phase = sim.getPhase();
+        if (phase != last) {
+            f.phase_s[phase] = now * 1.0e-6;
+            if (phase == SIM_MAIN) {
+                f.drogue_rate = -last_velocity;
+            } else if (phase == SIM_LANDED) {
+                f.main_rate = -last_velocity;
+            }
+            last = phase;
+        }
+        last_velocity = sim.getTrueVelocity();
+    }
+    f.apogee_m = sim.getMaxAltitudeAgl();
+    return f;
+}
+
+static void checkTrajectory(const FlightProfile& p) {
+    Reference ref = flyReference(p);
+    printf("reference: apogee %.2f m at +%.3f s, main at +%.2f s, touchdown at +%.2f s\n",
+           ref.apogee_m, ref.apogee_s, ref.main_s, ref.touchdown_s);
+
+    Flight first = flySimulator(p, 1, 1000);
+    const double ignition = p.pad_time_s;
+    printf("simulator: apogee %.2f m at +%.3f s, main at +%.2f s, touchdown at +%.2f s\n",
+           first.apogee_m, first.phase_s[SIM_DROGUE] - ignition, first.phase_s[SIM_MAIN] - ignition,
+           first.phase_s[SIM_LANDED] - ignition);
+    printf("descent:   %.2f m/s under drogue, %.2f m/s under main (profile %.1f, %.1f)\n",
+           first.drogue_rate, first.main_rate, p.drogue_rate_ms, p.main_rate_ms);
+
+    check(fabs(first.phase_s[SIM_BOOST] - ignition) <= 0.001, "ignition at the end of the pad time");
+    check(fabs(first.phase_s[SIM_COAST] - ignition - p.burn_time_s) <= 0.002, "burnout after the burn time");
+    check(fabs(first.apogee_m - ref.apogee_m) < 0.005 * ref.apogee_m, "apogee within 0.5% of the reference");
+    check(fabs(first.phase_s[SIM_DROGUE] - ignition - ref.apogee_s) < 0.05, "drogue opens at apogee (50 ms)");
+    check(fabs(first.phase_s[SIM_MAIN] - ignition - ref.main_s) < 0.2, "main opens at the deploy altitude (0.2 s)");
+    check(fabs(first.drogue_rate - p.drogue_rate_ms) < 0.02 * p.drogue_rate_ms, "drogue descent rate within 2% of the profile");
+    check(fabs(first.main_rate - p.main_rate_ms) < 0.02 * p.main_rate_ms, "main descent rate within 2% of the profile");
+    check(fabs(first.phase_s[SIM_LANDED] - ignition - ref.touchdown_s) < 0.5, "touchdown within 0.5 s of the reference");
+
+    // Noise never feeds back into the truth, and the 1 ms integration step
+    // does not depend on the update cadence
+    bool same = true;
+    for (uint64_t seed = 2; seed <= 20; seed++) {
+        Flight f = flySimulator(p, seed, seed % 2 == 0 ? 1000 : 5000);
+        // Phase changes are seen at the next update, so up to one step late
+        same = same && f.apogee_m == first.apogee_m && f.truth_at_20s == first.truth_at_20s &&
+               fabs(f.phase_s[SIM_LANDED] - first.phase_s[SIM_LANDED]) < 0.005;
+    }
+    check(same, "same trajectory for seeds 2..20 at 1 ms and 5 ms updates");
+}
+
+static void checkSeeds(const FlightProfile& p) {
+    FlightSimulator a, b, c;
+    a.begin(p, 42);
+    b.begin(p, 42);
+    c.begin(p, 43);
+    bool repeat = true;
+    bool differ = false;
+    for (uint32_t now = 0; now < 60000000; now += 2000) {
+        const SimSample& sa = a.update(now);
+        const SimSample& sb = b.update(now);
+        const SimSample& sc = c.update(now);
+        repeat = repeat && memcmp(&sa, &sb, sizeof(SimSample)) == 0;
+        differ = differ || sa.pressure_pa != sc.pressure_pa;
+    }
+    check(repeat, "a seed reproduces every sample");
+    check(differ, "different seeds give different noise");
+
+    a.reset();
+    FlightSimulator d;
+    d.begin(p, 42);
+    bool after_reset = true;
+    for (uint32_t now = 0; now < 20000000; now += 2000) {
+        const SimSample& sa = a.update(now);
+        const SimSample& sd = d.update(now);
+        after_reset = after_reset && memcmp(&sa, &sd, sizeof(SimSample)) == 0;
+    }
+    check(after_reset, "reset() starts the same flight again");
+}
+
+static void checkNoise(const FlightProfile& p) {
+    FlightSimulator sim;
+    sim.begin(p, 5);
+    const int n = 9000;   // 9 s on the pad at 1 kHz
+    double sum_p = 0, sum_p2 = 0, sum_az = 0, sum_az2 = 0;
+    for (int i = 1; i <= n; i++) {
+        const SimSample& s = sim.update(i * 1000);
+        sum_p += s.pressure_pa;
+        sum_p2 += (double)s.pressure_pa * s.pressure_pa;
+        sum_az += s.accel_z;
+        sum_az2 += (double)s.accel_z * s.accel_z;
+    }
+    double mean_p = sum_p / n;
+    double sd_p = sqrt(sum_p2 / n - mean_p * mean_p);
+    double mean_az = sum_az / n;
+    double sd_az = sqrt(sum_az2 / n - mean_az * mean_az);
+    double isa_p = 101325.0 * pow(1.0 - 2.25577e-5 * p.ground_altitude_m, 5.25588);
+    printf("pad: pressure %.2f Pa (ISA %.2f) sd %.2f, accel z %.4f g sd %.4f\n", mean_p, isa_p, sd_p, mean_az, sd_az);
+    check(fabs(mean_p - isa_p) < 0.5, "pad pressure is ISA at the site elevation");
+    check(fabs(sd_p - p.pressure_noise_pa) < 0.1 * p.pressure_noise_pa, "pressure noise matches the profile");
+    check(fabs(mean_az - 1.0) < 0.001, "accelerometer reads 1 g on the pad");
+    check(fabs(sd_az - p.accel_noise_g) < 0.1 * p.accel_noise_g, "accelerometer noise matches the profile");
+}
+
+// --- Through the pipeline, as the firmware runs it ---
+
+struct PhaseEvent {
+    FlightPhase phase;
+    uint32_t time_ms;
+};
+static std::vector<PhaseEvent> events;
+
+static void onEvent(const SensorPipeline::Event& event) {
+    if (event.type == SensorPipeline::EVENT_PHASE_CHANGE) {
+        events.push_back({ event.phase, event.time_ms });
+    }
+}
+
+static void checkPipeline(const FlightProfile& p, uint64_t seed) {
+    FlightSimulator sim;
+    sim.begin(p, seed);
+    SensorPipeline pipeline;
+    pipeline.setEventHandler(onEvent);
+    events.clear();
+
+    const SimSample& first = sim.update(0);
+    pipeline.seed(first.pressure_pa, first.temperature_c);
+    pipeline.setGroundReference(first.pressure_pa, pipeline.getState().current_altitude);
+    pipeline.refineGroundReference(10);
+
+    // 500 Hz IMU, 50 Hz barometer, until 20 s after touchdown
+    uint32_t touchdown_us = 0;
+    for (uint32_t now = 2000; now < 300000000; now += 2000) {
+        const SimSample& s = sim.update(now);
+        ImuSample imu = { s.time_us, s.accel_x, s.accel_y, s.accel_z, s.gyro_x, s.gyro_y, s.gyro_z };
+        BaroSample baro = { s.time_us, s.pressure_pa, s.temperature_c };
+        pipeline.process(now % 20000 == 0 ? &baro : nullptr, &imu);
+        if (sim.hasLanded() && touchdown_us == 0) {
+            touchdown_us = now;
+        }
+        if (touchdown_us != 0 && now - touchdown_us > 20000000) {
+            break;
+        }
+    }
+
+    Flight truth = flySimulator(p, seed, 1000);
+    double boost_s = -1, descent_s = -1, landed_s = -1;
+    bool ordered = events.size() == 4;
+    static const FlightPhase expected[4] = { PHASE_BOOST, PHASE_COAST, PHASE_DESCENT, PHASE_LANDED };
+    for (size_t i = 0; i < events.size() && i < 4; i++) {
+        ordered = ordered && events[i].phase == expected[i];
+        if (events[i].phase == PHASE_BOOST) boost_s = events[i].time_ms / 1000.0;
+        if (events[i].phase == PHASE_DESCENT) descent_s = events[i].time_ms / 1000.0;
+        if (events[i].phase == PHASE_LANDED) landed_s = events[i].time_ms / 1000.0;
+    }
+    float apogee = pipeline.getState().max_altitude - pipeline.getState().baseline_altitude;
+    printf("seed %llu: launch %.2f s, apogee detected %.2f s (true %.2f), landed %.2f s (touchdown %.2f), "
+           "max %.2f m AGL (true %.2f)\n", (unsigned long long)seed, boost_s, descent_s,
+           truth.phase_s[SIM_DROGUE], landed_s, truth.phase_s[SIM_LANDED], apogee, truth.apogee_m);
+    check(ordered, "  phases BOOST, COAST, DESCENT, LANDED once each");
+    check(boost_s >= truth.phase_s[SIM_BOOST] && boost_s - truth.phase_s[SIM_BOOST] < 0.2, "  launch within 0.2 s of ignition");
+    check(descent_s > truth.phase_s[SIM_DROGUE] && descent_s - truth.phase_s[SIM_DROGUE] < 2.0, "  apogee confirmed within 2 s");
+    check(landed_s > truth.phase_s[SIM_LANDED] && landed_s - truth.phase_s[SIM_LANDED] < 10.0,
+          "  landing confirmed within 10 s of touchdown (5 s still window)");
+    check(fabs(apogee - truth.apogee_m) < 1.0, "  max altitude within 1 m of the true apogee");
+}
+
+// The bench profile must never leave the pad
+static void checkGroundIdle() {
+    FlightSimulator idle;
+    idle.begin(FlightProfile::groundIdle(), 1);
+    for (uint32_t now = 0; now < 600000000; now += 100000) {
+        idle.update(now);
+    }
+    check(idle.getPhase() == SIM_GROUND_IDLE && idle.getMaxAltitudeAgl() == 0.0f, "groundIdle() stays on the pad for 10 min");
+}
+
+static const FlightProfile rocket = FlightProfile::modelRocket();
+
+static void testTrajectory() {
+    checkTrajectory(rocket);
+}
+
+static void testSeeds() {
+    checkSeeds(rocket);
+}
+
+static void testNoise() {
+    checkNoise(rocket);
+}
+
+static void testPipeline() {
+    for (uint64_t seed = 1; seed <= 5; seed++) {
+        checkPipeline(rocket, seed);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testTrajectory);
+    RUN_TEST(testSeeds);
+    RUN_TEST(testNoise);
+    RUN_TEST(testPipeline);
+    RUN_TEST(checkGroundIdle);
+    return UNITY_END();
+}
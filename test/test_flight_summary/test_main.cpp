@@ -0,0 +1,288 @@
+// Host check and benchmark for flight summaries read from mapped flash.
+//
+// Simulates a model rocket flight (IMU at ~448 Hz, barometer at 50 Hz,
+// timestamps crossing the 32-bit wrap) through SensorPipeline and records
+// it into CompressedSeries with the firmware's column settings until the
+// pipeline reports LANDED, as the firmware does. It is saved through
+// SegmentStore into a flash image file that is mmap()ed, as the partition is with
+// esp_partition_mmap() on the device. Earlier logs push the flight across
+// the end of the partition, so its pages wrap. The log is then mapped with
+// MappedLog, iterated in place and summarised, and the result is checked:
+//   - launch and landing seen, though the recording ends 5 s after touchdown
+//   - apogee, touchdown time, maximum and mean descent rate against the
+//     simulator's truth; the maximum acceleration exactly against the
+//     recorded samples
+//   - the same summary from a contiguous copy read with openMemory(), and
+//     fed to FlightSummariser a few blocks at a time
+// Reports the time per record and per flight.
+//
+// Run from the repository root:
+//     pio test -e native -f test_flight_summary
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+
+#include "check.h"
+#include "flight_archive.h"
+#include "flight_simulator.h"
+#include "flight_summary.h"
+#include "mapped_log.h"
+#include "segment_store.h"
+#include "sensor_pipeline.h"
+
+// NOR flash on a shared file mapping; the store writes through the same
+// memory the reader maps
+class MappedFileFlash : public FlashDevice {
+public:
+    MappedFileFlash(uint8_t* memory, size_t bytes) : base(memory), bytes_total(bytes) {}
+
+    size_t size() const override { return bytes_total; }
+    size_t sectorSize() const override { return 4096; }
+
+    bool read(size_t offset, void* out, size_t len) override {
+        if (offset + len > bytes_total) {
+            return false;
+        }
+        memcpy(out, base + offset, len);
+        return true;
+    }
+
+    bool write(size_t offset, const void* data, size_t len) override {
+        const uint8_t* in = (const uint8_t*)data;
+        for (size_t i = 0; i < len; i++) {
+            base[offset + i] &= in[i];
+        }
+        return true;
+    }
+
+    bool erase(size_t offset, size_t len) override {
+        memset(base + offset, 0xFF, len);
+        return true;
+    }
+
+private:
+    uint8_t* base;
+    size_t bytes_total;
+};
+
+struct Truth {
+    float apogee_m;
+    float apogee_s;
+    float touchdown_s;
+    float drogue_rate;
+    float mean_descent_rate;
+    float max_acceleration_g;
+    float landed_s;              // When the pipeline reported LANDED
+};
+
+static float onGrid(float value, float lsb) {
+    return roundf(value / lsb) * lsb;
+}
+
+static bool pipeline_landed = false;
+
+static void onEvent(const SensorPipeline::Event& event) {
+    if (event.type == SensorPipeline::EVENT_PHASE_CHANGE && event.phase == PHASE_LANDED) {
+        pipeline_landed = true;
+    }
+}
+
+// Pad and flight into the two recording series, through SensorPipeline as
+// on the device; recording stops at its LANDED, as onSensorEvent() does
+static Truth simulate(CompressedSeries& baro, CompressedSeries& imu, uint32_t start_us) {
+    FlightSimulator sim;
+    sim.begin(FlightProfile::modelRocket(), 5);   // Its own detector would not confirm landing
+    static SensorPipeline pipeline;
+    pipeline.setEventHandler(onEvent);
+    pipeline.reset();
+    pipeline.refineGroundReference(10);    // As baseline_sample_count in main.cpp
+    pipeline.resetMaxAcceleration(1.0);
+    pipeline_landed = false;
+
+    const uint32_t imu_period_us = 2230;
+    const uint32_t baro_period_us = 20000;
+    Truth truth = { 0.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, -1.0f };
+    uint32_t next_baro = 0;
+    bool touched_down = false;
+    for (uint32_t t = 0; !pipeline_landed && t < 600000000u; t += imu_period_us) {
+        const SimSample& s = sim.update(t);
+        float accel[6] = {
+            onGrid(s.accel_x, 1.0f / 2048), onGrid(s.accel_y, 1.0f / 2048), onGrid(s.accel_z, 1.0f / 2048),
+            onGrid(s.gyro_x, 1.0f / 16), onGrid(s.gyro_y, 1.0f / 16), onGrid(s.gyro_z, 1.0f / 16)
+        };
+        imu.append(start_us + t, accel);
+        float g = sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+        if (g > truth.max_acceleration_g) {
+            truth.max_acceleration_g = g;
+        }
+        ImuSample imu_sample = { start_us + t, accel[0], accel[1], accel[2], accel[3], accel[4], accel[5] };
+        BaroSample baro_sample = { start_us + t, s.pressure_pa, s.temperature_c };
+        bool baro_due = t >= next_baro;
+        if (baro_due) {
+            float values[2] = { s.pressure_pa, s.temperature_c };
+            baro.append(start_us + t, values);
+            next_baro += baro_period_us;
+        }
+        pipeline.processBatch(&baro_sample, baro_due ? 1 : 0, &imu_sample, 1);
+
+        if (sim.getTrueAltitudeAgl() >= sim.getMaxAltitudeAgl() && sim.getMaxAltitudeAgl() > 0.0f) {
+            truth.apogee_s = t / 1.0e6f;
+        }
+        if (sim.getPhase() == SIM_DROGUE) {
+            truth.drogue_rate = -sim.getTrueVelocity();
+        }
+        if (!touched_down && sim.hasLanded()) {
+            touched_down = true;
+            truth.touchdown_s = t / 1.0e6f;
+        }
+        if (pipeline_landed) {
+            truth.landed_s = t / 1.0e6f;
+        }
+    }
+    truth.apogee_m = sim.getMaxAltitudeAgl();
+    truth.mean_descent_rate = truth.apogee_m / (truth.touchdown_s - truth.apogee_s);
+    return truth;
+}
+
+static double summariseTimed(FlightArchiveReader& reader, FlightSummary& out, int repeats, uint32_t& records) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        summariseFlightArchive(reader, out);
+    }
+    records = out.baro_samples + out.imu_samples;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+static void testMappedFlight() {
+    const int repeats = 20;
+
+    // Recording as on the device
+    CompressedSeries::Column baro_columns[2] = {
+        { CompressedSeries::ENCODING_DELTA, 0.01f }, { CompressedSeries::ENCODING_DELTA, 0.01f }
+    };
+    CompressedSeries::Column imu_columns[6];
+    for (int c = 0; c < 6; c++) {
+        imu_columns[c] = { CompressedSeries::ENCODING_DELTA, c < 3 ? 1.0f / 2048 : 1.0f / 16 };
+    }
+    std::vector<uint8_t> baro_memory(128 * 1024), imu_memory(896 * 1024);
+    CompressedSeries baro, imu;
+    baro.configure(baro_columns, 2);
+    imu.configure(imu_columns, 6);
+    baro.begin(baro_memory.data(), baro_memory.size());
+    imu.begin(imu_memory.data(), imu_memory.size());
+    Truth truth = simulate(baro, imu, 0xFFF00000u);
+    printf("Recorded %u IMU and %u barometer samples (%u dropped), stopped at LANDED %.2f s after touchdown\n",
+           imu.getSampleCount(), baro.getSampleCount(), imu.getDroppedSamples() + baro.getDroppedSamples(),
+           truth.landed_s - truth.touchdown_s);
+
+    // The "flightlog" partition as a mapped image file
+    const size_t flash_bytes = 2 * 1024 * 1024;
+    FILE* file = tmpfile();
+    std::vector<uint8_t> erased(flash_bytes, 0xFF);
+    fwrite(erased.data(), 1, erased.size(), file);
+    fflush(file);
+    uint8_t* image = (uint8_t*)mmap(nullptr, flash_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(file), 0);
+    if (image == MAP_FAILED) {
+        check(false, "mapping the flash image");
+        return;
+    }
+    MappedFileFlash flash(image, flash_bytes);
+    SegmentStore store;
+    store.begin(&flash);
+
+    // Fill most of the ring first so the flight wraps past its end
+    std::vector<uint8_t> filler(SegmentStore::SEGMENT_DATA_BYTES * 3);
+    for (uint32_t id = 1; id <= 10; id++) {
+        store.create(id);
+        store.append(filler.data(), filler.size());
+        store.close();
+    }
+    FlightArchiveWriter writer;
+    writer.begin(&store, baro, imu, 42);
+    while (writer.step()) {
+    }
+    const SegmentStore::Log* log = store.findLog(42);
+    if (!writer.isDone() || log == nullptr) {
+        check(false, "saving the flight");
+        return;
+    }
+    bool wraps = log->first_segment + log->segment_count > store.getSegmentCount();
+    printf("Flight log: %u bytes in %u segments from segment %u%s\n", log->bytes, log->segment_count,
+           log->first_segment, wraps ? ", wrapping" : "");
+    check(wraps, "flight log wraps the partition end", wraps, 1);
+
+    // In place, page by page
+    static MappedLog mapped;
+    FlightArchiveReader reader;
+    if (!mapped.mapStore(store, *log, image) || !reader.openMapped(mapped)) {
+        check(false, "opening the mapped flight");
+        return;
+    }
+    FlightSummary summary;
+    uint32_t records;
+    double seconds = summariseTimed(reader, summary, repeats, records);
+    printf("Summary of flight %u: apogee %.1f m at %.2f s, %.2f g max, up %.1f m/s, down %.1f m/s max, "
+           "%.1f m/s mean, launch %.2f s, burnout %.2f s, touchdown %.2f s\n",
+           summary.flight_number, summary.apogee_m, summary.apogee_s, summary.max_acceleration_g,
+           summary.max_ascent_rate, summary.max_descent_rate, summary.mean_descent_rate, summary.launch_s,
+           summary.burnout_s, summary.touchdown_s);
+    printf("%u records in %.2f ms, %.1f ns per record\n", records, seconds * 1e3, seconds * 1e9 / records);
+
+    check(summary.flight_number == 42, "flight number", summary.flight_number, 42);
+    check(truth.landed_s > truth.touchdown_s, "recording stopped at the pipeline's LANDED", truth.landed_s,
+          truth.touchdown_s);
+    check(summary.launched, "launch seen", summary.launched, 1);
+    check(summary.landed, "landing seen", summary.landed, 1);
+    check(fabsf(summary.apogee_m - truth.apogee_m) < truth.apogee_m * 0.01f, "apogee (m)", summary.apogee_m,
+          truth.apogee_m);
+    check(summary.max_acceleration_g == truth.max_acceleration_g, "max acceleration (g)", summary.max_acceleration_g,
+          truth.max_acceleration_g);
+    check(fabsf(summary.touchdown_s - truth.touchdown_s) < 1.0f, "touchdown (s)", summary.touchdown_s,
+          truth.touchdown_s);
+    check(summary.max_descent_rate >= truth.drogue_rate * 0.9f && summary.max_descent_rate < truth.drogue_rate * 1.5f,
+          "max descent rate (m/s)", summary.max_descent_rate, truth.drogue_rate);
+    check(fabsf(summary.mean_descent_rate - truth.mean_descent_rate) < truth.mean_descent_rate * 0.05f,
+          "mean descent rate (m/s)", summary.mean_descent_rate, truth.mean_descent_rate);
+    check(summary.burnout_s > summary.launch_s && summary.apogee_s > summary.burnout_s &&
+          summary.touchdown_s > summary.apogee_s, "event order", 0, 0);
+    check(summary.imu_samples == imu.getSampleCount() && summary.baro_samples == baro.getSampleCount(),
+          "every sample read", records, imu.getSampleCount() + baro.getSampleCount());
+
+    // A contiguous copy gives the same answer
+    std::vector<uint8_t> copy(log->bytes);
+    store.read(*log, 0, copy.data(), copy.size());
+    FlightArchiveReader copy_reader;
+    FlightSummary copy_summary;
+    bool same = copy_reader.openMemory(copy.data(), copy.size()) && summariseFlightArchive(copy_reader, copy_summary) &&
+                memcmp(&copy_summary, &summary, sizeof(summary)) == 0;
+    check(same, "same summary from a contiguous copy", same, 1);
+
+    // As FlightRecorder::update() does after a save, a few blocks per call
+    FlightArchiveReader step_reader;
+    FlightSummariser summariser;
+    FlightSummary step_summary;
+    FlightRecord record;
+    bool more = step_reader.openMapped(mapped);
+    while (more) {
+        for (int i = 0; i < 2048 && (more = step_reader.next(record)); i++) {
+            summariser.add(record);
+        }
+    }
+    same = finishFlightArchiveSummary(step_reader, summariser, step_summary) &&
+           memcmp(&step_summary, &summary, sizeof(summary)) == 0;
+    check(same, "same summary fed 2048 records at a time");
+
+    munmap(image, flash_bytes);
+    fclose(file);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testMappedFlight);
+    return UNITY_END();
+}
@@ -0,0 +1,260 @@
+// Host check for HistoryPyramid against a brute-force history.
+//
+// Records 30 hours of three channels at 5 Hz, with jitter, samples of
+// different channels in the same bucket, a two-hour gap with no data and a
+// burst of samples at the same time, so every level wraps its ring several
+// times and stale slots have to be told apart from current ones. A
+// reference keeps every sample. Along the way, random queries (any range,
+// 1-600 points, inside, across and outside the data) are answered by both.
+// The reference takes the level the pyramid reports for the query and uses
+// only samples that level still holds. Each point must have the same
+// validity, exactly the same min and max, and a mean within float rounding.
+// Streamed queries (a few points at a time) must equal the single call.
+// Also checks the level choice, retention (getOldestMs) and clear().
+//
+// Run from the repository root:
+//     pio test -e native -f test_history_pyramid
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "history_pyramid.h"
+
+struct Sample {
+    uint32_t time_ms;
+    float value;
+};
+
+class BruteForceHistory {
+public:
+    void add(int channel, uint32_t time_ms, float value) {
+        samples[channel].push_back({ time_ms, value });
+        newest_ms = std::max(newest_ms, time_ms);
+    }
+
+    // The point over [t0, t1) read from buckets of bucket_ms that a ring of
+    // capacity still holds
+    HistoryPyramid::Point point(int channel, uint32_t t0, uint32_t t1, uint32_t bucket_ms, uint32_t capacity,
+                                double& mean) const {
+        uint32_t newest_index = newest_ms / bucket_ms;
+        uint32_t first_index = t0 / bucket_ms;
+        uint32_t last_index = (t1 - 1) / bucket_ms;
+        if (newest_index >= capacity) {
+            first_index = std::max(first_index, newest_index - capacity + 1);
+        }
+
+        HistoryPyramid::Point p = { t0, 0.0f, 0.0f, 0.0f, false };
+        double sum = 0.0;
+        uint32_t n = 0;
+        if (first_index <= last_index) {
+            const std::vector<Sample>& v = samples[channel];
+            uint64_t from = (uint64_t)first_index * bucket_ms;
+            uint64_t to = ((uint64_t)last_index + 1) * bucket_ms;
+            auto it = std::lower_bound(v.begin(), v.end(), from,
+                                       [](const Sample& s, uint64_t t) { return s.time_ms < t; });
+            for (; it != v.end() && it->time_ms < to; ++it) {
+                if (!p.valid) {
+                    p.min = p.max = it->value;
+                    p.valid = true;
+                }
+                p.min = std::min(p.min, it->value);
+                p.max = std::max(p.max, it->value);
+                sum += it->value;
+                n++;
+            }
+        }
+        mean = n > 0 ? sum / n : 0.0;
+        return p;
+    }
+
+    uint32_t newest_ms = 0;
+
+private:
+    std::vector<Sample> samples[HistoryPyramid::CHANNEL_COUNT];
+};
+
+struct QueryStats {
+    uint32_t queries = 0;
+    uint32_t points = 0;
+    uint32_t valid_points = 0;
+    uint32_t levels_used[HistoryPyramid::LEVELS] = {};
+    bool exact = true;         // Validity, min, max
+    bool mean_ok = true;
+    bool streamed_ok = true;
+    bool level_ok = true;
+};
+
+static int levelOf(uint32_t bucket_ms) {
+    for (int level = 0; level < HistoryPyramid::LEVELS; level++) {
+        if (HistoryPyramid::getBucketMs(level) == bucket_ms) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+static void compareQuery(const HistoryPyramid& pyramid, const BruteForceHistory& ref, int channel, uint32_t from_ms,
+                         uint32_t to_ms, size_t count, QueryStats& stats) {
+    static HistoryPyramid::Point got[600];
+    static HistoryPyramid::Point streamed[600];
+    size_t n = pyramid.query((HistoryPyramid::Channel)channel, from_ms, to_ms, got, count);
+    stats.queries++;
+    if (n != count) {
+        stats.exact = false;
+        return;
+    }
+
+    uint32_t bucket_ms = pyramid.getQueryBucketMs(from_ms, to_ms, count);
+    int level = levelOf(bucket_ms);
+    stats.levels_used[level]++;
+
+    // The finest level that is no wider than a point and still holds from_ms
+    uint32_t per_point = (to_ms - from_ms) / count;
+    int expected_level = 0;
+    while (expected_level + 1 < HistoryPyramid::LEVELS &&
+           (HistoryPyramid::getBucketMs(expected_level + 1) <= per_point ||
+            (ref.newest_ms / HistoryPyramid::getBucketMs(expected_level) >= HistoryPyramid::getCapacity(expected_level) &&
+             from_ms < (ref.newest_ms / HistoryPyramid::getBucketMs(expected_level) -
+                        HistoryPyramid::getCapacity(expected_level) + 1) * HistoryPyramid::getBucketMs(expected_level)))) {
+        expected_level++;
+    }
+    stats.level_ok = stats.level_ok && level == expected_level;
+
+    uint32_t span = to_ms - from_ms;
+    for (size_t k = 0; k < count; k++) {
+        uint32_t t0 = from_ms + (uint32_t)((uint64_t)span * k / count);
+        uint32_t t1 = from_ms + (uint32_t)((uint64_t)span * (k + 1) / count);
+        if (t1 <= t0) {
+            t1 = t0 + 1;
+        }
+        double mean;
+        HistoryPyramid::Point want = ref.point(channel, t0, t1, bucket_ms, HistoryPyramid::getCapacity(level), mean);
+        const HistoryPyramid::Point& p = got[k];
+        stats.points++;
+        bool same = p.time_ms == t0 && p.valid == want.valid && (!p.valid || (p.min == want.min && p.max == want.max));
+        if (!same && stats.exact) {
+            printf("channel %d [%u, %u) x%zu point %zu: valid %d/%d min %g/%g max %g/%g\n", channel, from_ms, to_ms,
+                   count, k, p.valid, want.valid, p.min, want.min, p.max, want.max);
+        }
+        stats.exact = stats.exact && same;
+        if (p.valid) {
+            stats.valid_points++;
+            // Float sums of up to ~50000 samples around 1000
+            double tolerance = 1.0e-4 * std::max(fabs(want.min), fabs(want.max)) + 1.0e-5;
+            stats.mean_ok = stats.mean_ok && fabs(p.mean - mean) <= tolerance;
+        }
+    }
+
+    // The same query a few points at a time
+    size_t chunk = 1 + count / 7;
+    for (size_t first = 0; first < count; first += chunk) {
+        size_t m = pyramid.query((HistoryPyramid::Channel)channel, from_ms, to_ms, count, first, streamed + first, chunk);
+        stats.streamed_ok = stats.streamed_ok && m == std::min(chunk, count - first);
+    }
+    for (size_t k = 0; k < count; k++) {
+        const HistoryPyramid::Point& a = got[k];
+        const HistoryPyramid::Point& b = streamed[k];
+        stats.streamed_ok = stats.streamed_ok && a.time_ms == b.time_ms && a.valid == b.valid && a.min == b.min &&
+                            a.max == b.max && a.mean == b.mean;
+    }
+}
+
+static void randomQueries(const HistoryPyramid& pyramid, const BruteForceHistory& ref, std::mt19937& rng,
+                          int queries, QueryStats& stats) {
+    const uint32_t newest = ref.newest_ms;
+    for (int q = 0; q < queries; q++) {
+        // Spans from a second to a day and a half, evenly on a log scale,
+        // ending anywhere from 30 h back to an hour after the newest sample
+        std::uniform_real_distribution<double> log_span(0.0, log(36.0 * 3600));
+        uint32_t span = (uint32_t)(1000.0 * exp(log_span(rng)));
+        uint32_t to = newest + 3600000 - rng() % (31u * 3600 * 1000);
+        if (to > newest + 3600000 || to < span) {
+            to = newest;
+        }
+        if (span > to) {
+            span = to;
+        }
+        size_t count = 1 + rng() % 600;
+        compareQuery(pyramid, ref, rng() % HistoryPyramid::CHANNEL_COUNT, to - span, to, count, stats);
+    }
+}
+
+static void checkBegin() {
+    std::vector<uint8_t> memory(HistoryPyramid::requiredBytes());
+    HistoryPyramid pyramid;
+    check(!pyramid.begin(memory.data(), memory.size() - 1), "begin() refuses too little memory");
+    check(pyramid.begin(memory.data(), memory.size()) && pyramid.isEmpty(), "begin() with requiredBytes()");
+}
+
+static void checkThirtyHours() {
+    std::vector<uint8_t> memory(HistoryPyramid::requiredBytes());
+    HistoryPyramid pyramid;
+    pyramid.begin(memory.data(), memory.size());
+
+    BruteForceHistory ref;
+    std::mt19937 rng(11);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    QueryStats stats;
+
+    // 30 h at ~5 Hz; hours 7-9 have no data; a burst at one time at 20 h
+    uint32_t t = 3600 * 1000;
+    const uint32_t end = t + 30u * 3600 * 1000;
+    uint32_t next_check = t + 600000;
+    while (t < end) {
+        bool gap = t - 3600 * 1000 >= 7u * 3600 * 1000 && t - 3600 * 1000 < 9u * 3600 * 1000;
+        if (!gap) {
+            double hours = (t - 3600 * 1000) / 3.6e6;
+            float values[HistoryPyramid::CHANNEL_COUNT] = {
+                (float)(1000.0 + 800.0 * sin(hours)) + noise(rng),
+                (float)(20.0 * cos(hours * 7.0)) + 0.1f * noise(rng),
+                (float)(1.0 + 0.05 * noise(rng))
+            };
+            int repeats = t - 3600 * 1000 == 20u * 3600 * 1000 ? 500 : 1;
+            for (int r = 0; r < repeats; r++) {
+                for (int c = 0; c < HistoryPyramid::CHANNEL_COUNT; c++) {
+                    // Channels are a few ms apart, so they can straddle a bucket edge
+                    uint32_t tc = t + c * 3;
+                    pyramid.add((HistoryPyramid::Channel)c, tc, values[c] + r);
+                    ref.add(c, tc, values[c] + r);
+                }
+            }
+        }
+        t += 150 + rng() % 100;
+        if (t >= next_check) {
+            randomQueries(pyramid, ref, rng, 20, stats);
+            next_check += 600000 + rng() % 1200000;
+        }
+    }
+    randomQueries(pyramid, ref, rng, 500, stats);
+
+    printf("%u queries, %u points (%u with data); levels used %u/%u/%u/%u\n", stats.queries, stats.points,
+           stats.valid_points, stats.levels_used[0], stats.levels_used[1], stats.levels_used[2], stats.levels_used[3]);
+    check(stats.levels_used[0] > 0 && stats.levels_used[1] > 0 && stats.levels_used[2] > 0 && stats.levels_used[3] > 0,
+          "queries read every level");
+    check(stats.level_ok, "each query reads the finest level no wider than a point that still holds its start");
+    check(stats.exact, "every point has the brute force's validity, min and max exactly");
+    check(stats.mean_ok, "every mean within float rounding of the exact mean");
+    check(stats.streamed_ok, "streamed queries give the same points as one call");
+
+    uint32_t oldest = pyramid.getOldestMs();
+    uint32_t coarsest = HistoryPyramid::getBucketMs(HistoryPyramid::LEVELS - 1);
+    check(oldest == (ref.newest_ms / coarsest - HistoryPyramid::getCapacity(HistoryPyramid::LEVELS - 1) + 1) * coarsest,
+          "getOldestMs() is the start of the coarsest ring");
+
+    pyramid.clear();
+    HistoryPyramid::Point p;
+    check(pyramid.isEmpty() && pyramid.query(HistoryPyramid::CHANNEL_ALTITUDE, end - 60000, end, &p, 1) == 1 && !p.valid,
+          "clear() forgets everything");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkBegin);
+    RUN_TEST(checkThirtyHours);
+    return UNITY_END();
+}
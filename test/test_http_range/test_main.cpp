@@ -0,0 +1,141 @@
+// Host check for parseByteRange() on the edge cases of the Range header.
+//
+// Runs a table of Range values against files of 0, 1, 1000 and 4 GiB - 1
+// bytes: closed, open-ended and suffix ranges, ranges reaching past the end
+// (clamped), starting at or past the end (416), zero-length suffixes (416),
+// reversed ranges, multiple ranges, other units, a missing header, signs,
+// spaces and other malformed numbers (whole file), and numbers too big for
+// 64 bits, which saturate instead of wrapping. Each value must give the
+// expected result and, for 206, the expected start and length; every range
+// accepted must lie inside the file.
+//
+// Run from the repository root:
+//     pio test -e native -f test_http_range
+
+#include <cstdio>
+
+#include "check.h"
+#include "http_range.h"
+
+struct Case {
+    const char* header;
+    size_t size;
+    ByteRangeResult result;
+    size_t start;     // For RANGE_OK; otherwise the whole file
+    size_t length;
+};
+
+static const size_t BIG = 0xFFFFFFFFu;   // Largest size_t on the ESP32
+
+static const Case cases[] = {
+    // No usable header: the whole file
+    { nullptr, 1000, RANGE_NONE, 0, 0 },
+    { "", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=-", 1000, RANGE_NONE, 0, 0 },
+    { "items=0-10", 1000, RANGE_NONE, 0, 0 },
+    { "bytes 0-10", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=10", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=0-10,20-30", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=-5,0-1", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=10-5", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=2000-5", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=a-5", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=5-b", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=5-10x", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=-5x", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=+5-10", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=5-+10", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=--5", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=5--10", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=- 5", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=5- 10", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=5 -10", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=0-10 ", 1000, RANGE_NONE, 0, 0 },
+    { "bytes=0x10-20", 1000, RANGE_NONE, 0, 0 },
+
+    // Closed and open-ended ranges
+    { "bytes=0-0", 1000, RANGE_OK, 0, 1 },
+    { "bytes=0-999", 1000, RANGE_OK, 0, 1000 },
+    { "bytes=10-19", 1000, RANGE_OK, 10, 10 },
+    { "bytes=999-999", 1000, RANGE_OK, 999, 1 },
+    { "bytes=500-", 1000, RANGE_OK, 500, 500 },
+    { "bytes=0-", 1000, RANGE_OK, 0, 1000 },
+    { "bytes=999-", 1000, RANGE_OK, 999, 1 },
+    { "bytes= 10-19", 1000, RANGE_OK, 10, 10 },
+    { "BYTES=10-19", 1000, RANGE_OK, 10, 10 },
+    { "bytes=0010-0019", 1000, RANGE_OK, 10, 10 },
+
+    // Past the end: clamped, or 416 if nothing is left
+    { "bytes=500-5000", 1000, RANGE_OK, 500, 500 },
+    { "bytes=0-18446744073709551615", 1000, RANGE_OK, 0, 1000 },
+    { "bytes=0-99999999999999999999999", 1000, RANGE_OK, 0, 1000 },
+    { "bytes=1000-", 1000, RANGE_UNSATISFIABLE, 0, 0 },
+    { "bytes=1000-2000", 1000, RANGE_UNSATISFIABLE, 0, 0 },
+    { "bytes=99999999999999999999999-", 1000, RANGE_UNSATISFIABLE, 0, 0 },
+    { "bytes=4294967296-4294967300", 1000, RANGE_UNSATISFIABLE, 0, 0 },
+
+    // Suffix ranges
+    { "bytes=-1", 1000, RANGE_OK, 999, 1 },
+    { "bytes=-100", 1000, RANGE_OK, 900, 100 },
+    { "bytes=-1000", 1000, RANGE_OK, 0, 1000 },
+    { "bytes=-5000", 1000, RANGE_OK, 0, 1000 },
+    { "bytes=-99999999999999999999999", 1000, RANGE_OK, 0, 1000 },
+    { "bytes=-0", 1000, RANGE_UNSATISFIABLE, 0, 0 },
+    { "bytes=-000", 1000, RANGE_UNSATISFIABLE, 0, 0 },
+
+    // Empty and one-byte files
+    { "bytes=0-", 0, RANGE_UNSATISFIABLE, 0, 0 },
+    { "bytes=0-0", 0, RANGE_UNSATISFIABLE, 0, 0 },
+    { "bytes=0-10", 0, RANGE_UNSATISFIABLE, 0, 0 },
+    { "bytes=-10", 0, RANGE_UNSATISFIABLE, 0, 0 },
+    { "bytes=5-2", 0, RANGE_NONE, 0, 0 },
+    { "bytes=0-0", 1, RANGE_OK, 0, 1 },
+    { "bytes=0-", 1, RANGE_OK, 0, 1 },
+    { "bytes=-1", 1, RANGE_OK, 0, 1 },
+    { "bytes=-2", 1, RANGE_OK, 0, 1 },
+    { "bytes=1-", 1, RANGE_UNSATISFIABLE, 0, 0 },
+
+    // The largest file a 32-bit size_t can describe
+    { "bytes=4294967294-", BIG, RANGE_OK, BIG - 1, 1 },
+    { "bytes=0-", BIG, RANGE_OK, 0, BIG },
+    { "bytes=0-4294967295", BIG, RANGE_OK, 0, BIG },
+    { "bytes=-4294967296", BIG, RANGE_OK, 0, BIG },
+    { "bytes=4294967295-", BIG, RANGE_UNSATISFIABLE, 0, 0 },
+};
+
+static const char* resultName(ByteRangeResult r) {
+    return r == RANGE_OK ? "206" : r == RANGE_UNSATISFIABLE ? "416" : "whole file";
+}
+
+static void checkCases() {
+    int wrong = 0;
+    bool inside = true;
+    for (const Case& c : cases) {
+        size_t start = 12345, length = 12345;
+        ByteRangeResult r = parseByteRange(c.header, c.size, start, length);
+        bool ok = r == c.result;
+        if (r == RANGE_OK) {
+            ok = ok && start == c.start && length == c.length;
+            inside = inside && length > 0 && start < c.size && length <= c.size - start;
+        } else {
+            // Anything but 206 leaves start and length at the whole file
+            ok = ok && start == 0 && length == c.size;
+        }
+        if (!ok) {
+            printf("\"%s\" on %zu bytes: %s %zu+%zu, expected %s %zu+%zu\n", c.header ? c.header : "(none)", c.size,
+                   resultName(r), start, length, resultName(c.result), c.start,
+                   c.result == RANGE_OK ? c.length : c.size);
+            wrong++;
+        }
+    }
+    printf("%zu Range values, %d wrong\n", sizeof(cases) / sizeof(cases[0]), wrong);
+    check(wrong == 0, "every Range value gives the expected status, start and length");
+    check(inside, "every range accepted is non-empty and inside the file");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkCases);
+    return UNITY_END();
+}
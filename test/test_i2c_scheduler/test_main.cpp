@@ -0,0 +1,297 @@
+// Host check for the I2C bus scheduler against a fake bus.
+//
+// Runs I2CScheduler over a scripted I2CBus that records every transfer,
+// fails on request and can hold the bus. Checks that probes run at
+// 400 kHz, that the clock only rises to fast mode plus while every
+// registered device supports it and drops to the slowest one, that a
+// barometer alone keeps the bus at 400 kHz, that a failed transfer is
+// retried exactly once, the per-device transaction, byte, error and retry
+// counts, that transactions run inline before begin(), and that with the
+// bus task running, queued transactions go IMU first, then barometer, then
+// everything else (unregistered addresses included), in order within a
+// class, with blocking calls from another thread waiting for their turn.
+//
+// Run from the repository root:
+//     pio test -e native -f test_i2c_scheduler
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "bmp180_barometer.h"
+#include "bmp3_barometer.h"
+#include "i2c_scheduler.h"
+
+static const uint8_t IMU = 0x6B;
+static const uint8_t BARO = 0x77;
+static const uint8_t OTHER = 0x3C;
+static const uint8_t UNKNOWN = 0x50;
+
+// Every transfer attempt is logged as (address, first byte written).
+// fail(address, n) makes the next n attempts at that address fail, and
+// hold(address) stalls the next transfer to it until release().
+class FakeBus : public I2CBus {
+public:
+    struct Attempt {
+        uint8_t address;
+        uint8_t first;
+    };
+
+    bool write(uint8_t address, const uint8_t* data, size_t len) override {
+        return attempt(address, len > 0 ? data[0] : 0);
+    }
+
+    bool read(uint8_t address, uint8_t* out, size_t len) override {
+        memset(out, 0xA5, len);
+        return attempt(address, 0);
+    }
+
+    bool readRegister(uint8_t address, uint8_t reg, uint8_t* out, size_t len) override {
+        for (size_t i = 0; i < len; i++) {
+            out[i] = reg + i;
+        }
+        return attempt(address, reg);
+    }
+
+    void setClock(uint32_t hz) override {
+        clocks.push_back(hz);
+    }
+
+    void fail(uint8_t address, int n) {
+        fail_address = address;
+        fail_count = n;
+    }
+
+    void hold(uint8_t address) {
+        hold_address = address;
+        holding = true;
+    }
+
+    void release() { holding = false; }
+    bool isHeld() const { return held; }
+
+    std::vector<Attempt> takeLog() {
+        std::lock_guard<std::mutex> guard(log_lock);
+        std::vector<Attempt> out;
+        out.swap(log);
+        return out;
+    }
+
+    std::vector<uint32_t> clocks;
+
+private:
+    std::mutex log_lock;
+    std::vector<Attempt> log;
+    uint8_t fail_address = 0;
+    int fail_count = 0;
+    std::atomic<uint8_t> hold_address { 0 };
+    std::atomic<bool> holding { false };
+    std::atomic<bool> held { false };
+
+    bool attempt(uint8_t address, uint8_t first) {
+        if (holding && address == hold_address) {
+            held = true;
+            while (holding) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            held = false;
+        }
+        {
+            std::lock_guard<std::mutex> guard(log_lock);
+            log.push_back({ address, first });
+        }
+        if (address == fail_address && fail_count > 0) {
+            fail_count--;
+            return false;
+        }
+        return true;
+    }
+};
+
+// One scheduler for the whole suite: the tests run in order, each carrying
+// on from the state the last one left
+static FakeBus fake;
+static I2CScheduler scheduler(fake);
+
+static const I2CScheduler::DeviceStats* statsFor(const I2CScheduler& scheduler, uint8_t address) {
+    for (int i = 0; i < scheduler.getDeviceCount(); i++) {
+        if (scheduler.getDeviceStats(i).address == address) {
+            return &scheduler.getDeviceStats(i);
+        }
+    }
+    return nullptr;
+}
+
+static bool waitUntil(const std::atomic<bool>& flag) {
+    for (int i = 0; i < 2000 && !flag; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return flag;
+}
+
+static bool waitDone(std::vector<I2CScheduler::Transaction>& ts) {
+    for (int i = 0; i < 2000; i++) {
+        bool done = true;
+        for (const I2CScheduler::Transaction& t : ts) {
+            done = done && t.state != I2CScheduler::STATE_QUEUED;
+        }
+        if (done) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+static void checkClock() {
+    uint8_t out[2];
+    check(scheduler.getClockHz() == I2CScheduler::PROBE_CLOCK_HZ, "clock starts at the probe clock");
+    scheduler.readRegister(UNKNOWN, 0x00, out, 2);
+    check(fake.clocks == std::vector<uint32_t>({ 400000 }), "a probe before any device registers runs at 400 kHz");
+
+    scheduler.addDevice(OTHER, I2CScheduler::PRIORITY_OTHER, 1000000, "other");
+    scheduler.readRegister(OTHER, 0x00, out, 2);
+    check(scheduler.getClockHz() == I2CScheduler::MAX_CLOCK_HZ && fake.clocks.back() == I2CScheduler::MAX_CLOCK_HZ,
+          "every device registered supports fast mode plus: the clock rises to the maximum");
+    scheduler.readRegister(UNKNOWN, 0x00, out, 2);
+    scheduler.readRegister(OTHER, 0x00, out, 2);
+    check(fake.clocks == std::vector<uint32_t>({ 400000, 1000000, 400000, 1000000 }),
+          "a probe drops to 400 kHz for its transfer only");
+
+    scheduler.addDevice(IMU, I2CScheduler::PRIORITY_IMU, 400000, "imu");
+    scheduler.readRegister(OTHER, 0x00, out, 2);
+    check(scheduler.getClockHz() == 400000 && fake.clocks.back() == 400000,
+          "a 400 kHz device lowers the clock to 400 kHz");
+    scheduler.addDevice(BARO, I2CScheduler::PRIORITY_BARO, 3400000, "baro");
+    scheduler.readRegister(OTHER, 0x00, out, 2);
+    check(scheduler.getClockHz() == 400000 && fake.clocks.size() == 5, "a faster device does not raise it again");
+}
+
+// As on the board before the IMU starts: only the barometer is registered,
+// with the limit its driver reports
+static void checkBarometerOnly() {
+    FakeBus bus;
+    I2CScheduler only_baro(bus);
+    Bmp180Barometer bmp180(bus);
+    Bmp3Barometer bmp3(bus);
+    check(bmp180.getMaxClockHz() == 400000 && bmp3.getMaxClockHz() == 400000,
+          "BMP180 and BMP3 drivers report 400 kHz, not Hs mode");
+
+    uint8_t out[2];
+    only_baro.addDevice(BARO, I2CScheduler::PRIORITY_BARO, bmp3.getMaxClockHz(), "baro");
+    only_baro.readRegister(BARO, 0x00, out, 2);
+    only_baro.readRegister(IMU, 0x00, out, 2);
+    only_baro.readRegister(BARO, 0x00, out, 2);
+    check(only_baro.getClockHz() == 400000 && bus.clocks == std::vector<uint32_t>({ 400000 }),
+          "barometer reads and an IMU probe all run at 400 kHz");
+}
+
+static void checkRetries() {
+    uint8_t out[4];
+
+    // Inline: the task is not running yet
+    fake.takeLog();
+    check(scheduler.readRegister(BARO, 0x10, out, 4) && out[0] == 0x10 && out[3] == 0x13,
+          "a register read runs inline before begin()");
+
+    fake.fail(BARO, 1);
+    bool ok = scheduler.readRegister(BARO, 0x20, out, 2);
+    check(ok && fake.takeLog().size() == 3, "one failure: retried once and succeeds");
+
+    fake.fail(BARO, 5);
+    ok = scheduler.readRegister(BARO, 0x30, out, 2);
+    check(!ok && fake.takeLog().size() == 2, "repeated failure: exactly one retry, then fails");
+    fake.fail(BARO, 0);
+
+    const uint8_t data[3] = { 0x40, 1, 2 };
+    check(scheduler.write(IMU, data, 3) && scheduler.read(IMU, out, 4), "plain write and read");
+
+    const I2CScheduler::DeviceStats* baro = statsFor(scheduler, BARO);
+    const I2CScheduler::DeviceStats* imu = statsFor(scheduler, IMU);
+    check(baro != nullptr && baro->transactions == 3 && baro->retries == 2 && baro->errors == 1 && baro->bytes == 3 + 3 + 5,
+          "barometer: 3 transactions, 2 retries, 1 error, 11 bytes");
+    check(imu != nullptr && imu->transactions == 2 && imu->retries == 0 && imu->errors == 0 && imu->bytes == 7,
+          "IMU: 2 transactions, no retries or errors, 7 bytes");
+}
+
+static void checkPriority() {
+    check(scheduler.begin(), "bus task starts");
+
+    // Hold the bus with one transaction, queue the rest behind it
+    fake.takeLog();
+    fake.hold(OTHER);
+    static uint8_t regs[8];
+    static uint8_t rx[8][2];
+    for (int i = 0; i < 8; i++) {
+        regs[i] = 0x80 + i;
+    }
+    std::vector<I2CScheduler::Transaction> ts(7);
+    auto queue = [&](int i, uint8_t address) {
+        ts[i] = { address, &regs[i], 1, rx[i], 2, I2CScheduler::STATE_IDLE, 0, nullptr, nullptr };
+        scheduler.submit(ts[i]);
+    };
+    queue(0, OTHER);
+    std::atomic<bool> held { false };
+    std::thread watcher([&]() {
+        while (!fake.isHeld()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        held = true;
+    });
+    check(waitUntil(held), "the first transaction holds the bus");
+    watcher.join();
+
+    queue(1, OTHER);
+    queue(2, BARO);
+    queue(3, IMU);
+    queue(4, UNKNOWN);
+    queue(5, BARO);
+    queue(6, IMU);
+
+    // A blocking call from another task waits its turn (barometer class)
+    std::atomic<bool> blocking_done { false };
+    bool blocking_ok = false;
+    std::thread caller([&]() {
+        uint8_t out[2];
+        blocking_ok = scheduler.readRegister(BARO, 0x87, out, 2) && out[0] == 0x87;
+        blocking_done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    check(!blocking_done, "a blocking call waits while the bus is held");
+    fake.release();
+
+    check(waitDone(ts), "every queued transaction completes");
+    caller.join();
+    check(blocking_ok, "the blocking call completes with its data");
+
+    std::vector<FakeBus::Attempt> log = fake.takeLog();
+    const uint8_t expected[] = { 0x80, 0x83, 0x86, 0x82, 0x85, 0x87, 0x81, 0x84 };
+    bool ordered = log.size() == sizeof(expected);
+    printf("bus order:");
+    for (size_t i = 0; i < log.size(); i++) {
+        printf(" %02X@%02X", log[i].first, log[i].address);
+        ordered = ordered && i < sizeof(expected) && log[i].first == expected[i];
+    }
+    printf("\n");
+    check(ordered, "IMU, then barometer, then other and unregistered, in order within each class");
+
+    bool all_done = true;
+    for (const I2CScheduler::Transaction& t : ts) {
+        all_done = all_done && t.state == I2CScheduler::STATE_DONE;
+    }
+    check(all_done && rx[6][0] == 0x86 && rx[6][1] == 0x87, "queued transactions get their data");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkClock);
+    RUN_TEST(checkBarometerOnly);
+    RUN_TEST(checkRetries);
+    RUN_TEST(checkPriority);
+    return UNITY_END();
+}
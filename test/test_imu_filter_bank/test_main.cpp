@@ -0,0 +1,223 @@
+// Host check for the ImuFilterBank frequency response.
+//
+// Feeds 500 Hz sine sweeps through the bank, one frequency at a time from
+// 0.2 Hz to the input Nyquist, and fits the amplitude and phase of each
+// output stream. Checks, for the log (100 Hz), web (25 Hz) and display
+// (5 Hz) streams:
+//   - the measured gain against the response of the Q15 tables themselves,
+//     cascaded stage by stage (|H| of each stage at the input frequency)
+//   - passband flat to 0.1 dB up to 40% of the output Nyquist, with the
+//     output timestamps in phase with the input (linear phase, centre tap)
+//   - everything that would alias into the passband attenuated by at least
+//     the design's 60 dB, less what Q15 rounding of the taps costs
+//   - a constant input comes out bit-exact (unity DC gain), a full-scale
+//     step saturates instead of wrapping, and the sample counts and rates
+//     follow the decimation factors
+//
+// Run from the repository root:
+//     pio test -e native -f test_imu_filter_bank
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <vector>
+
+#include "check.h"
+#include "imu_filter_bank.h"
+
+static const uint32_t INPUT_HZ = 500;
+static const uint32_t PERIOD_US = 1000000 / INPUT_HZ;
+static const double AMPLITUDE_G = 8.0;
+static const double AMPLITUDE_DPS = 1000.0;
+static const double STOPBAND_DB = 58.0;   // 60 dB design, Q15 taps
+
+static const char* const STREAM_NAMES[ImuFilterBank::STREAM_COUNT] = { "log", "web", "display" };
+
+// |H| of the cascade up to a stream, from the tables, at f Hz
+static double tableGain(int stream, double f) {
+    double rate = INPUT_HZ;
+    double gain = 1.0;
+    for (int k = 0; k <= stream; k++) {
+        const DecimationStageTable& t = decimation_stages[k];
+        std::complex<double> h = 0.0;
+        for (int j = 0; j < t.taps; j++) {
+            h += std::polar((double)t.coeffs[j], -2.0 * M_PI * f * j / rate);
+        }
+        gain *= std::abs(h) / (1 << DECIMATION_COEFF_FRAC_BITS);
+        rate /= t.factor;
+    }
+    return gain;
+}
+
+struct Output {
+    uint32_t time_us;
+    float accel_x;
+    float gyro_z;
+};
+
+static std::vector<Output> outputs[ImuFilterBank::STREAM_COUNT];
+
+static void collect(ImuFilterBank::Stream stream, const ImuSample& s) {
+    outputs[stream].push_back({ s.time_us, s.accel_x, s.gyro_z });
+}
+
+struct Fit {
+    double amplitude;
+    double phase;   // Of the output against the input, radians
+};
+
+// Least squares y = a sin(wt) + b cos(wt) over the outputs after settle_us
+static Fit fitSine(const std::vector<Output>& out, bool gyro, double f, uint32_t start_us, uint32_t settle_us) {
+    double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0;
+    for (const Output& o : out) {
+        if (o.time_us - start_us < settle_us) {
+            continue;
+        }
+        double t = (o.time_us - start_us) * 1.0e-6;
+        double s = sin(2 * M_PI * f * t);
+        double c = cos(2 * M_PI * f * t);
+        double y = gyro ? o.gyro_z : o.accel_x;
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        ys += y * s;
+        yc += y * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+    return { sqrt(a * a + b * b), atan2(b, a) };
+}
+
+// The output frequency a tone at f lands on, as a fraction of the output rate
+static double aliasFraction(double f, double out_hz) {
+    double r = fmod(f, out_hz) / out_hz;
+    return r > 0.5 ? 1.0 - r : r;
+}
+
+static void checkResponse() {
+    ImuFilterBank bank;
+    bank.setInputRate(INPUT_HZ);
+    for (int s = 0; s < ImuFilterBank::STREAM_COUNT; s++) {
+        bank.subscribe((ImuFilterBank::Stream)s, collect);
+    }
+
+    double worst_table_error[ImuFilterBank::STREAM_COUNT] = {};
+    double worst_ripple_db[ImuFilterBank::STREAM_COUNT] = {};
+    double worst_phase[ImuFilterBank::STREAM_COUNT] = {};
+    double worst_stop_db[ImuFilterBank::STREAM_COUNT] = { 1000, 1000, 1000 };
+    int fitted[ImuFilterBank::STREAM_COUNT] = {};
+
+    // 0.2 Hz to 249.8 Hz in steps that avoid landing on DC or Nyquist
+    // of every output too often
+    for (double f = 0.2; f < INPUT_HZ / 2.0; f *= 1.031) {
+        bank.reset();
+        for (int s = 0; s < ImuFilterBank::STREAM_COUNT; s++) {
+            outputs[s].clear();
+        }
+        const uint32_t start_us = 0xFFF00000u;   // Crosses the 32-bit wrap
+        const uint32_t duration_us = 40000000;
+        for (uint32_t t = 0; t < duration_us; t += PERIOD_US) {
+            double phase = 2 * M_PI * f * t * 1.0e-6;
+            ImuSample in = {};
+            in.time_us = start_us + t;
+            in.accel_x = (float)(AMPLITUDE_G * sin(phase));
+            in.gyro_z = (float)(AMPLITUDE_DPS * sin(phase));
+            bank.add(in);
+        }
+
+        for (int s = 0; s < ImuFilterBank::STREAM_COUNT; s++) {
+            double out_hz = bank.getRateHz((ImuFilterBank::Stream)s);
+            double alias = aliasFraction(f, out_hz);
+            if (alias < 0.03 || alias > 0.47) {
+                continue;   // Too close to DC or Nyquist to fit a sine
+            }
+            fitted[s]++;
+            double expected = tableGain(s, f);
+            Fit accel = fitSine(outputs[s], false, f, start_us, 5000000);
+            Fit gyro = fitSine(outputs[s], true, f, start_us, 5000000);
+            double error = fmax(fabs(accel.amplitude / AMPLITUDE_G - expected),
+                                fabs(gyro.amplitude / AMPLITUDE_DPS - expected));
+            worst_table_error[s] = fmax(worst_table_error[s], error);
+
+            double pass_hz = 0.4 * out_hz / 2;
+            if (f <= pass_hz) {
+                worst_ripple_db[s] = fmax(worst_ripple_db[s], fabs(20 * log10(accel.amplitude / AMPLITUDE_G)));
+                worst_phase[s] = fmax(worst_phase[s], fabs(accel.phase));
+            }
+            if (f >= out_hz - pass_hz) {
+                double db = -20 * log10(fmax(gyro.amplitude / AMPLITUDE_DPS, 1.0e-9));
+                worst_stop_db[s] = fmin(worst_stop_db[s], db);
+            }
+        }
+    }
+
+    for (int s = 0; s < ImuFilterBank::STREAM_COUNT; s++) {
+        printf("%-8s %3d tones: gain vs tables %.1e, passband ripple %.3f dB, phase %.4f rad, stopband %.1f dB\n",
+               STREAM_NAMES[s], fitted[s], worst_table_error[s], worst_ripple_db[s], worst_phase[s], worst_stop_db[s]);
+        char what[96];
+        snprintf(what, sizeof(what), "%s: measured gain matches the cascaded Q15 tables to 1e-5", STREAM_NAMES[s]);
+        check(worst_table_error[s] < 1.0e-5, what);
+        snprintf(what, sizeof(what), "%s: passband within 0.1 dB and in phase", STREAM_NAMES[s]);
+        check(worst_ripple_db[s] < 0.1 && worst_phase[s] < 0.01, what);
+        snprintf(what, sizeof(what), "%s: aliasing tones down at least %.0f dB", STREAM_NAMES[s], STOPBAND_DB);
+        check(worst_stop_db[s] >= STOPBAND_DB, what);
+    }
+}
+
+static void checkDcAndLimits() {
+    ImuFilterBank bank;
+    bank.setInputRate(INPUT_HZ);
+    check(bank.getRateHz(ImuFilterBank::STREAM_LOG) == 100.0f && bank.getRateHz(ImuFilterBank::STREAM_WEB) == 25.0f &&
+              bank.getRateHz(ImuFilterBank::STREAM_DISPLAY) == 5.0f,
+          "500 Hz in: 100, 25 and 5 Hz out");
+
+    ImuSample in = { 0, 1.2345f, -0.5f, 0.98765f, 12.5f, -2000.0f, 0.0f };
+    bool exact = true;
+    for (uint32_t i = 0; i < 5000; i++) {
+        in.time_us = i * PERIOD_US;
+        bank.add(in);
+        for (int s = 0; s < ImuFilterBank::STREAM_COUNT; s++) {
+            if (bank.hasSample((ImuFilterBank::Stream)s)) {
+                const ImuSample& o = bank.getLatest((ImuFilterBank::Stream)s);
+                exact = exact && o.accel_x == Fixed<16>::fromFloat(in.accel_x).toFloat() &&
+                        o.accel_y == -0.5f && o.gyro_y == -2000.0f && o.gyro_x == 12.5f;
+            }
+        }
+    }
+    check(exact, "a constant input comes out bit-exact on every stream");
+    check(bank.getOutputCount(ImuFilterBank::STREAM_LOG) == 1000 &&
+              bank.getOutputCount(ImuFilterBank::STREAM_WEB) == 250 &&
+              bank.getOutputCount(ImuFilterBank::STREAM_DISPLAY) == 50,
+          "5000 samples in: 1000, 250 and 50 out");
+
+    // +-32767 g steps overshoot past full scale in the FIR: saturate
+    bank.reset();
+    float highest = 0.0f, lowest = 0.0f;
+    for (uint32_t i = 0; i < 2000; i++) {
+        ImuSample step = {};
+        step.time_us = i * PERIOD_US;
+        step.accel_x = (i / 50) % 2 ? 32767.0f : -32768.0f;
+        bank.add(step);
+        const ImuSample& o = bank.getLatest(ImuFilterBank::STREAM_LOG);
+        highest = fmaxf(highest, o.accel_x);
+        lowest = fminf(lowest, o.accel_x);
+    }
+    check(highest > 32767.0f && highest <= 32768.0f && lowest >= -32768.0f && lowest < -32767.0f,
+          "full-scale steps saturate at the Q15.16 limits instead of wrapping");
+
+    // Rate 0: every stream passes raw samples through
+    bank.setInputRate(0);
+    in.time_us = 1234;
+    bank.add(in);
+    check(bank.getOutputCount(ImuFilterBank::STREAM_DISPLAY) == 1 &&
+              bank.getLatest(ImuFilterBank::STREAM_DISPLAY).time_us == 1234,
+          "input rate 0 bypasses the filters");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkDcAndLimits);
+    RUN_TEST(checkResponse);
+    return UNITY_END();
+}
@@ -0,0 +1,198 @@
+// Host check and benchmark for the IMU simulator's block API.
+//
+// Checks that generate() is reproducible: the same seed gives the same
+// samples however the run is split into blocks, reseed() starts over and a
+// different seed differs. Runs a phasor oscillator for 10^8 samples and the
+// simulator for 6 hours at 1 kHz to check that amplitude and frequency do not
+// drift. Checks the stress mode's readBatch() on a manual clock (sample
+// count, back-dated timestamps, dropping more than a second of backlog).
+// Then prints generate() throughput per block size and the pipeline's cost
+// per sample when fed simulator blocks, as the IMU_STRESS_HZ build does on
+// the device.
+//
+// Run from the repository root:
+//     pio test -e native -f test_imu_simulator
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "native_hal.h"
+#include "imu_simulator.h"
+#include "sensor_pipeline.h"
+
+static bool sameSamples(const std::vector<ImuSample>& a, const std::vector<ImuSample>& b) {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(ImuSample)) == 0;
+}
+
+static std::vector<ImuSample> generateInBlocks(uint32_t seed, size_t total, size_t block, uint32_t dt_us) {
+    IMUSimulator sim;
+    sim.reseed(seed);
+    std::vector<ImuSample> out(total);
+    for (size_t i = 0; i < total; i += block) {
+        sim.generate(&out[i], total - i < block ? total - i : block, dt_us);
+    }
+    return out;
+}
+
+static void checkReproducible() {
+    const size_t total = 100000;
+    std::vector<ImuSample> whole = generateInBlocks(7, total, total, 250);
+    bool split = true;
+    for (size_t block : { (size_t)1, (size_t)7, (size_t)128, (size_t)1000 }) {
+        split = split && sameSamples(whole, generateInBlocks(7, total, block, 250));
+    }
+    check(split, "same seed gives the same samples for any block size");
+    check(!sameSamples(whole, generateInBlocks(8, total, total, 250)), "a different seed gives different samples");
+
+    IMUSimulator sim;
+    sim.reseed(7);
+    std::vector<ImuSample> first(total);
+    sim.generate(first.data(), total, 250);
+    sim.reseed(7);
+    std::vector<ImuSample> again(total);
+    sim.generate(again.data(), total, 250);
+    check(sameSamples(first, again), "reseed() restarts the sequence");
+    check(sameSamples(first, whole), "reseed() matches a fresh simulator");
+}
+
+static void checkOscillator() {
+    // Amplitude 1 at 2.1 rad/s, 8 kHz: 10^8 samples is 3.5 hours
+    const double omega = 2.1;
+    const uint32_t dt_us = 125;
+    PhasorOscillator osc(1.0f, (float)omega);
+    const uint64_t n = 100000000;
+    const uint64_t period = (uint64_t)(2 * M_PI / omega * 1e6 / dt_us) + 1;
+    float first_peak = 0.0f;
+    float last_peak = 0.0f;
+    float previous = 0.0f;
+    float v = 0.0f;
+    for (uint64_t i = 0; i < n; i++) {
+        previous = v;
+        v = osc.next(dt_us);
+        if (i < period) {
+            first_peak = fmaxf(first_peak, fabsf(v));
+        } else if (i >= n - period) {
+            last_peak = fmaxf(last_peak, fabsf(v));
+        }
+    }
+    // Phase of the last sample from its value and slope, against omega * t
+    double phase = atan2(v, (v - previous) / (omega * dt_us * 1e-6));
+    double expected = fmod(omega * (n * dt_us * 1e-6), 2 * M_PI);
+    double phase_error = remainder(phase - expected, 2 * M_PI);
+    double frequency_error = phase_error / (omega * (n * dt_us * 1e-6));
+    printf("oscillator: peak %.7f after one period, %.7f after %.1f h; phase error %.4f rad (frequency %.1e)\n",
+           first_peak, last_peak, n * dt_us * 1e-6 / 3600, phase_error, frequency_error);
+    check(fabsf(first_peak - 1.0f) < 1e-4f && fabsf(last_peak - 1.0f) < 1e-4f, "amplitude holds over 10^8 samples");
+    check(fabs(frequency_error) < 1e-5, "frequency within 10 ppm over 10^8 samples");
+}
+
+static void checkLongRun() {
+    // 6 hours at 1 kHz, in FIFO-sized blocks; compare the first and last minute
+    IMUSimulator sim;
+    sim.reseed(3);
+    const size_t minute = 60000;
+    const size_t minutes = 360;
+    std::vector<ImuSample> block(minute);
+    double first_mean = 0, last_mean = 0;
+    float first_range = 0, last_range = 0;
+    for (size_t m = 0; m < minutes; m++) {
+        sim.generate(block.data(), minute, 1000);
+        if (m == 0 || m == minutes - 1) {
+            double sum = 0;
+            float lo = 1e9f, hi = -1e9f;
+            for (const ImuSample& s : block) {
+                sum += s.accel_z;
+                lo = fminf(lo, s.accel_z);
+                hi = fmaxf(hi, s.accel_z);
+            }
+            (m == 0 ? first_mean : last_mean) = sum / minute;
+            (m == 0 ? first_range : last_range) = hi - lo;
+        }
+    }
+    printf("accel z: first minute mean %.4f g range %.4f g, minute 360 mean %.4f g range %.4f g\n",
+           first_mean, first_range, last_mean, last_range);
+    check(fabs(first_mean - 1.0) < 0.02 && fabs(last_mean - 1.0) < 0.02, "accel z stays at 1 g");
+    check(fabsf(last_range - first_range) < 0.1f * first_range, "accel z spread unchanged after 6 hours");
+    check(block[minute - 1].time_us == (uint32_t)(minute * minutes * 1000), "timestamps advance by dt per sample");
+}
+
+static void checkBlockRate() {
+    nativeSetManualClock(true);
+    IMUSimulator sim;
+    sim.begin();
+    sim.setBlockRate(4000);
+    ImuSample out[128];
+    uint32_t start = micros();
+
+    nativeAdvanceMicros(10000);
+    size_t n = sim.readBatch(out, 128);
+    bool spaced = n == 40;
+    for (size_t i = 0; i < n; i++) {
+        spaced = spaced && out[i].time_us == start + (i + 1) * 250;
+    }
+    check(spaced, "readBatch() returns the 40 samples due in 10 ms at 4 kHz, 250 us apart");
+
+    nativeAdvanceMicros(100000);
+    size_t total = 0;
+    while ((n = sim.readBatch(out, 128)) > 0) {
+        total += n;
+    }
+    check(total == 400 && out[127].time_us == start + 110000 - 16 * 250, "a backlog comes out in FIFO-sized batches");
+
+    nativeAdvanceMicros(3000000);
+    total = 0;
+    while ((n = sim.readBatch(out, 128)) > 0) {
+        total += n;
+    }
+    check(total == 4000 && sim.getDroppedSamples() == 8000, "more than a second behind drops the oldest samples");
+
+    sim.setBlockRate(0);
+    nativeAdvanceMicros(5000);
+    check(sim.readBatch(out, 128) == 1 && out[0].time_us == micros(), "rate 0 goes back to one sample per read");
+    nativeSetManualClock(false);
+}
+
+static void benchmark() {
+    printf("\n");
+    const size_t total = 4000000;
+    std::vector<ImuSample> out(1024);
+    for (size_t block : { (size_t)1, (size_t)32, (size_t)128, (size_t)1024 }) {
+        IMUSimulator sim;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < total; i += block) {
+            sim.generate(out.data(), block, 125);
+        }
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("generate() blocks of %4zu: %6.1f M samples/s, %5.0fx real time at 8 kHz\n",
+               block, total / s / 1e6, total / s / 8000);
+    }
+
+    // The IMU_STRESS_HZ path: FIFO-sized blocks through the whole pipeline
+    for (uint32_t rate : { 1000u, 4000u, 8000u }) {
+        SensorPipeline pipeline;
+        pipeline.getImuStreams().setInputRate(rate);
+        IMUSimulator sim;
+        const size_t samples = 2000000;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < samples; i += 128) {
+            sim.generate(out.data(), 128, 1000000 / rate);
+            pipeline.processBatch(nullptr, 0, out.data(), 128);
+        }
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("pipeline at %4u Hz: %6.1f ns/sample, %5.0fx real time\n", rate, s / samples * 1e9, samples / s / rate);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkReproducible);
+    RUN_TEST(checkOscillator);
+    RUN_TEST(checkLongRun);
+    RUN_TEST(checkBlockRate);
+    RUN_TEST(benchmark);
+    return UNITY_END();
+}
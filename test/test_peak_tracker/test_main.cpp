@@ -0,0 +1,190 @@
+// Host check for PeakTracker against a brute-force search.
+//
+// Feeds random IMU streams into PeakTracker while keeping every sample, and
+// after each add compares every channel with the answer found by scanning
+// the whole stream: the first strictly highest reading above the floor (the
+// axes by absolute value), its time and phase, the signed readings from
+// PRE_SAMPLES before to POST_SAMPLES after it (fewer at the start of the
+// stream or while the capture is still running), and whether it is still
+// capturing. Streams are quantised so ties are common, include full-scale
+// readings of both signs (|RAW_MIN| saturates), peaks in the first samples,
+// back-to-back peaks that restart the capture, resets with a floor in the
+// middle of a stream, and over a million samples.
+//
+// Run from the repository root:
+//     pio test -e native -f test_peak_tracker
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "peak_tracker.h"
+
+struct Sample {
+    uint32_t time_ms;
+    uint32_t time_us;
+    FlightPhase phase;
+    AccelFx reading[PeakTracker::CHANNEL_COUNT];   // Signed axes, then magnitude
+};
+
+// Everything since the last reset, scanned from scratch
+class BruteForcePeaks {
+public:
+    void reset(AccelFx floor_value) {
+        floor = floor_value;
+        samples.clear();
+    }
+
+    void add(const Sample& s) { samples.push_back(s); }
+
+    // Returns false (and says why) if the tracker's channel differs
+    bool matches(const PeakTracker& tracker, int channel, char* why, size_t why_len) const {
+        const PeakTracker::Peak& p = tracker.getPeak((PeakTracker::Channel)channel);
+        int k = -1;
+        AccelFx best = floor;
+        for (size_t i = 0; i < samples.size(); i++) {
+            AccelFx level = channel == PeakTracker::CHANNEL_MAGNITUDE ? samples[i].reading[channel]
+                                                                      : samples[i].reading[channel].abs();
+            if (level > best) {
+                best = level;
+                k = (int)i;
+            }
+        }
+        if (k < 0) {
+            if (p.valid || p.value != floor || tracker.isCapturing((PeakTracker::Channel)channel)) {
+                snprintf(why, why_len, "no peak yet, tracker has one");
+                return false;
+            }
+            return true;
+        }
+
+        const Sample& s = samples[k];
+        int first = k - PeakTracker::PRE_SAMPLES > 0 ? k - PeakTracker::PRE_SAMPLES : 0;
+        int last = k + PeakTracker::POST_SAMPLES < (int)samples.size() - 1 ? k + PeakTracker::POST_SAMPLES
+                                                                          : (int)samples.size() - 1;
+        bool capturing = (int)samples.size() - 1 - k < PeakTracker::POST_SAMPLES;
+        if (!p.valid || p.value != best || p.time_ms != s.time_ms || p.time_us != s.time_us || p.phase != s.phase) {
+            snprintf(why, why_len, "peak %d at %u us, tracker %d at %u us", best.getRaw(), s.time_us,
+                     p.value.getRaw(), p.time_us);
+            return false;
+        }
+        if (p.context_count != last - first + 1 || p.peak_index != k - first ||
+            tracker.isCapturing((PeakTracker::Channel)channel) != capturing) {
+            snprintf(why, why_len, "context %d samples, peak at %d; tracker %d, %d", last - first + 1, k - first,
+                     p.context_count, p.peak_index);
+            return false;
+        }
+        for (int i = first; i <= last; i++) {
+            if (p.context[i - first] != samples[i].reading[channel]) {
+                snprintf(why, why_len, "context sample %d differs", i - first);
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    AccelFx floor;
+    std::vector<Sample> samples;
+};
+
+// Readings on a coarse grid, so equal peaks happen; occasionally a spike or
+// (unless growing) a full-scale reading
+static AccelFx reading(std::mt19937& rng, int level, bool growing) {
+    std::uniform_int_distribution<int> pick(growing ? 2 : 0, 999);
+    int r = pick(rng);
+    if (r == 0) {
+        return AccelFx::fromRaw(AccelFx::RAW_MIN);
+    }
+    if (r == 1) {
+        return AccelFx::fromRaw(AccelFx::RAW_MAX);
+    }
+    std::uniform_int_distribution<int> grid(-level, level);
+    int scale = r < 20 ? 16 : 1;   // Spikes
+    return AccelFx::fromRaw(grid(rng) * scale * (AccelFx::RAW_ONE / 8));
+}
+
+// With growing set, the level rises through the stream, so new peaks keep
+// coming until the end
+static bool runStream(uint32_t samples, uint32_t seed, int level, uint32_t reset_every, bool growing = false) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> phase_pick(0, 4);
+    PeakTracker tracker;
+    BruteForcePeaks ref;
+    ref.reset(AccelFx());
+
+    uint32_t time_us = 0xFFFFFF00u;   // Crosses the wrap
+    for (uint32_t i = 0; i < samples; i++) {
+        if (reset_every > 0 && i % reset_every == reset_every - 1) {
+            AccelFx floor = AccelFx::fromRaw((int32_t)(rng() % (uint32_t)(level * AccelFx::RAW_ONE / 8 + 1)));
+            tracker.reset(floor);
+            ref.reset(floor);
+        }
+        Sample s;
+        time_us += 1000 + rng() % 3;
+        s.time_us = time_us;
+        s.time_ms = time_us / 1000;
+        s.phase = (FlightPhase)phase_pick(rng);
+        for (int a = 0; a < 3; a++) {
+            s.reading[a] = reading(rng, growing ? level + (int)(i >> 12) : level, growing);
+        }
+        s.reading[PeakTracker::CHANNEL_MAGNITUDE] = AccelFx::magnitude(s.reading[0], s.reading[1], s.reading[2]);
+        tracker.add(s.time_ms, s.time_us, s.phase, s.reading, s.reading[PeakTracker::CHANNEL_MAGNITUDE]);
+        ref.add(s);
+
+        // The brute force is O(n), so compare often early on, then sparsely
+        if (i < 5000 || i % 9973 == 0 || reset_every > 0) {
+            for (int c = 0; c < PeakTracker::CHANNEL_COUNT; c++) {
+                char why[96];
+                if (!ref.matches(tracker, c, why, sizeof(why))) {
+                    printf("seed %u sample %u channel %s: %s\n", seed, i,
+                           PeakTracker::getChannelName((PeakTracker::Channel)c), why);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void checkFirstSample() {
+    // A peak in the very first sample has no history before it
+    PeakTracker tracker;
+    const AccelFx first[3] = { AccelFx::fromInt(-3), AccelFx::fromInt(1), AccelFx::fromInt(2) };
+    tracker.add(1, 1000, PHASE_BOOST, first, AccelFx::fromInt(4));
+    const PeakTracker::Peak& x = tracker.getPeak(PeakTracker::CHANNEL_X);
+    check(x.valid && x.value == AccelFx::fromInt(3) && x.context_count == 1 && x.peak_index == 0 &&
+              x.context[0] == AccelFx::fromInt(-3) && x.phase == PHASE_BOOST && tracker.isCapturing(PeakTracker::CHANNEL_X),
+          "first sample: peak |X| = 3 with the signed reading and no history");
+}
+
+static void checkShortStreams() {
+    bool ok = true;
+    for (uint32_t seed = 1; seed <= 50; seed++) {
+        ok = ok && runStream(2000, seed, 4 + seed % 20, 0);
+    }
+    check(ok, "50 short streams, coarse grids with many ties: every channel matches after every sample");
+}
+
+static void checkResets() {
+    bool ok = true;
+    for (uint32_t seed = 100; seed < 110; seed++) {
+        ok = ok && runStream(3000, seed, 16, 37 + seed);
+    }
+    check(ok, "resets with a random floor every ~40 samples");
+}
+
+static void checkLongStream() {
+    check(runStream(1000000, 7, 64, 0, true), "a long stream with a rising level: peaks until the end");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkFirstSample);
+    RUN_TEST(checkShortStreams);
+    RUN_TEST(checkResets);
+    RUN_TEST(checkLongStream);
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+// Host check for the QMI8658C driver against its register model.
+//
+// Runs Qmi8658Imu through WireBus on the native Wire bus, with the model
+// from native/sensor_models.h attached, on a manual clock. Checks probing
+// at both addresses, the configuration written by begin() for each ODR,
+// sample scaling at the +-16 g / +-2048 dps full scales, FIFO drains in
+// 10-sample bursts inside FIFO read mode, partial drains, back-dated
+// timestamps across drains, a stream-mode overflow (newest 128 samples
+// kept, overflow counted in /metrics), and the watermark interrupt on INT2.
+//
+// Run from the repository root:
+//     pio test -e native -f test_qmi8658
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "check.h"
+#include "native_hal.h"
+#include "sensor_models.h"
+#include "metrics.h"
+#include "qmi8658_imu.h"
+#include "wire_bus.h"
+
+static WireBus bus(Wire);
+static const int INT2_PIN = 10;
+
+static uint32_t counter(const char* name) {
+    for (Metric* m = Metric::first(); m != nullptr; m = m->getNext()) {
+        if (strcmp(m->getName(), name) == 0 && m->getType() == Metric::TYPE_COUNTER) {
+            return static_cast<Counter*>(m)->get();
+        }
+    }
+    return 0;
+}
+
+// Sample i of a test sequence: every axis distinct and traceable
+static void measureSequence(Qmi8658Model& model, int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        model.measure(i, -i, 2048, 16 * i, -16, 0);
+    }
+}
+
+static bool isSequence(const ImuSample* out, size_t n, int first) {
+    for (size_t i = 0; i < n; i++) {
+        int k = first + (int)i;
+        if (out[i].accel_x != k / 2048.0f || out[i].accel_y != -k / 2048.0f || out[i].accel_z != 1.0f ||
+            out[i].gyro_x != (float)k || out[i].gyro_y != -1.0f || out[i].gyro_z != 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkBegin() {
+    Qmi8658Model model;
+    check(!Qmi8658Imu(bus).begin(), "begin() fails with no IMU on the bus");
+
+    Wire.attachDevice(Qmi8658Imu::ADDRESS_SECONDARY, &model);
+    Qmi8658Imu secondary(bus);
+    check(secondary.begin() && secondary.getAddress() == Qmi8658Imu::ADDRESS_SECONDARY,
+          "found at the secondary address 0x6A");
+    Wire.attachDevice(Qmi8658Imu::ADDRESS_SECONDARY, nullptr);
+
+    Wire.attachDevice(Qmi8658Imu::ADDRESS_PRIMARY, &model);
+    struct Case {
+        uint16_t odr_hz;
+        uint8_t code;
+        uint32_t period_us;
+    };
+    const Case cases[] = { { 1000, 0x03, 1115 }, { 700, 0x04, 2230 }, { 250, 0x05, 4460 }, { 10, 0x08, 35682 } };
+    bool configured = true;
+    for (const Case& c : cases) {
+        Qmi8658Imu imu(bus);
+        configured = configured && imu.begin(c.odr_hz) && imu.getSamplePeriodUs() == c.period_us &&
+                     model.getRegister(0x03) == (0x30 | c.code) && model.getRegister(0x04) == (0x70 | c.code);
+    }
+    check(configured, "begin() rounds the ODR down and sets +-16 g / +-2048 dps at that rate");
+    check(model.getRegister(0x02) == 0x50 && model.getRegister(0x08) == 0x03 && model.getRegister(0x13) == 16 &&
+              model.getRegister(0x14) == 0x0E,
+          "auto-increment, INT2, both sensors, watermark 16, 128-sample stream FIFO");
+    check((model.getRegister(0x2D) & 0x80) == 0, "the FIFO reset command is acknowledged");
+    Wire.attachDevice(Qmi8658Imu::ADDRESS_PRIMARY, nullptr);
+}
+
+static void checkFifo() {
+    Qmi8658Model model;
+    Wire.attachDevice(Qmi8658Imu::ADDRESS_PRIMARY, &model);
+    Qmi8658Imu imu(bus);
+    imu.begin(1000);
+    const uint32_t period_us = imu.getSamplePeriodUs();
+    ImuSample out[160];
+
+    // Scaling at the full-scale limits
+    model.measure(2048, -4096, 32767, 16, -32768, 160);
+    check(imu.readBatch(out, 160) == 1 && out[0].accel_x == 1.0f && out[0].accel_y == -2.0f &&
+              out[0].accel_z == 32767 / 2048.0f && out[0].gyro_x == 1.0f && out[0].gyro_y == -2048.0f &&
+              out[0].gyro_z == 10.0f,
+          "scaling: 2048 LSB/g and 16 LSB/dps, signed");
+
+    // A drain: all samples in order, in bursts of 10, only in read mode
+    uint32_t bursts = counter("altimeter_imu_fifo_bursts_total");
+    uint32_t reads = model.getFifoReads();
+    measureSequence(model, 0, 40);
+    nativeAdvanceMicros(500);
+    uint32_t read_time = micros();
+    size_t n = imu.readBatch(out, 160);
+    check(n == 40 && isSequence(out, n, 0), "40 samples drained in order");
+    check(model.getFifoReads() - reads == 4 && counter("altimeter_imu_fifo_bursts_total") - bursts == 4,
+          "in 4 bursts of 10");
+    check(model.getBadFifoReads() == 0 && !model.isFifoReadMode() && model.getFifoSamples() == 0,
+          "FIFO read only in read mode, which is left afterwards");
+    bool stamped = n == 40;
+    for (size_t i = 0; i < n; i++) {
+        stamped = stamped && out[i].time_us == read_time - (39 - i) * period_us;
+    }
+    check(stamped, "newest sample stamped at the read, older ones one ODR period apart");
+    check(imu.getAccelX() == 39 / 2048.0f, "accessors show the newest sample");
+
+    // A partial drain leaves the rest, stamped as one sequence
+    measureSequence(model, 100, 40);
+    read_time = micros();
+    n = imu.readBatch(out, 16);
+    size_t rest = imu.readBatch(out + 16, 160);
+    check(n == 16 && rest == 24 && isSequence(out, 40, 100), "a partial drain leaves the rest for the next call");
+    bool continuous = true;
+    for (size_t i = 0; i < 40; i++) {
+        continuous = continuous && out[i].time_us == read_time - (39 - i) * period_us;
+    }
+    check(continuous, "timestamps continue across the partial drains");
+
+    // Overflow: stream mode keeps the newest 128
+    uint32_t overflows = counter("altimeter_imu_fifo_overflows_total");
+    measureSequence(model, 1000, 150);
+    n = imu.readBatch(out, 160);
+    printf("overflow: %zu samples read, %u overwritten\n", n, model.getOverwrittenSamples());
+    check(n == 128 && isSequence(out, n, 1022) && model.getOverwrittenSamples() == 22,
+          "an overflowed FIFO gives the newest 128 samples");
+    check(counter("altimeter_imu_fifo_overflows_total") - overflows == 1, "the overflow is counted once");
+    measureSequence(model, 0, 5);
+    imu.readBatch(out, 160);
+    check(counter("altimeter_imu_fifo_overflows_total") - overflows == 1, "and cleared by the drain");
+    Wire.attachDevice(Qmi8658Imu::ADDRESS_PRIMARY, nullptr);
+}
+
+static void checkWatermark() {
+    Qmi8658Model model(INT2_PIN);
+    Wire.attachDevice(Qmi8658Imu::ADDRESS_PRIMARY, &model);
+    Qmi8658Imu imu(bus, INT2_PIN);
+    imu.begin(1000);
+    ImuSample out[64];
+
+    uint32_t reads = model.getFifoReads();
+    measureSequence(model, 0, 15);
+    check(imu.readBatch(out, 64) == 0 && model.getFifoReads() == reads, "below the watermark the bus is not read");
+    measureSequence(model, 15, 1);
+    check(digitalRead(INT2_PIN) == HIGH, "INT2 rises at 16 samples");
+    size_t n = imu.readBatch(out, 10);
+    size_t rest = imu.readBatch(out + 10, 64);
+    check(n == 10 && rest == 6 && isSequence(out, 16, 0), "the interrupt drains all 16, across two calls");
+    check(digitalRead(INT2_PIN) == LOW && imu.readBatch(out, 64) == 0, "and waits for the next one");
+    Wire.attachDevice(Qmi8658Imu::ADDRESS_PRIMARY, nullptr);
+}
+
+int main() {
+    nativeSetManualClock(true);
+    UNITY_BEGIN();
+    RUN_TEST(checkBegin);
+    RUN_TEST(checkFifo);
+    RUN_TEST(checkWatermark);
+    return UNITY_END();
+}
@@ -0,0 +1,297 @@
+// Host check that a recorded flight log replays to the same pipeline events.
+//
+// Flies FlightProfile::modelRocket() for 10 minutes (IMU at 1 kHz, barometer
+// every 20 ms) through SensorPipeline the way updateSensors() does, in 10 ms
+// loop batches, and records the samples and the pipeline's events as a .ttfl
+// log. The log is then replayed with FlightRecordReader and ReplaySource -
+// from a file and from memory as fast as possible, and in real-time mode on
+// a simulated 1 ms clock - and every replay must produce exactly the events
+// of the live run (type, time, phase and value) and the events recorded in
+// the log, with the same sample counts and maxima. Each replay must take
+// less than 10 s. With REPLAY_LOG set to a .ttfl path the same replays
+// and checks also run on that log.
+//
+// Run from the repository root:
+//     pio test -e native -f test_replay
+//     REPLAY_LOG=flight.ttfl pio test -e native -f test_replay
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "flight_simulator.h"
+#include "replay_source.h"
+#include "sensor_pipeline.h"
+
+static const uint32_t FLIGHT_US = 600000000u;    // 10 minutes
+static const uint32_t LOOP_US = 10000;
+static const uint32_t BARO_PERIOD_US = 20000;
+static const int BASELINE_SAMPLES = 10;          // As baseline_sample_count in main.cpp
+static const double MAX_REPLAY_S = 10.0;
+
+struct Run {
+    std::vector<SensorPipeline::Event> events;
+    uint32_t baro_samples;
+    uint32_t imu_samples;
+    float max_altitude;
+    float max_acceleration;
+    double seconds;
+};
+
+// The pipeline's handler is a plain function pointer
+static std::vector<SensorPipeline::Event>* captured = nullptr;
+static std::vector<FlightRecord> batch;   // Records of the current loop while recording
+static bool recording = false;
+
+static void append(std::vector<uint8_t>& log, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    log.insert(log.end(), bytes, bytes + size);
+}
+
+static void onEvent(const SensorPipeline::Event& event) {
+    captured->push_back(event);
+    if (recording) {
+        batch.push_back(makeEventRecord(event.time_ms * 1000u, (uint8_t)event.type, (float)event.phase, event.value));
+    }
+}
+
+// Same start as startReplay() in main.cpp
+static void startPipeline(SensorPipeline& pipeline, std::vector<SensorPipeline::Event>& events) {
+    captured = &events;
+    pipeline.setEventHandler(onEvent);
+    pipeline.reset();
+    pipeline.refineGroundReference(BASELINE_SAMPLES);
+    pipeline.resetMaxAcceleration(1.0);
+}
+
+static void finishRun(const SensorPipeline& pipeline, Run& run) {
+    run.baro_samples = pipeline.getState().baro_samples;
+    run.imu_samples = pipeline.getState().imu_samples;
+    run.max_altitude = pipeline.getState().max_altitude;
+    run.max_acceleration = pipeline.getState().max_acceleration;
+}
+
+static Run recordFlight(std::vector<uint8_t>& log) {
+    Run run;
+    FlightSimulator sim;
+    sim.begin(FlightProfile::modelRocket(), 7);
+    SensorPipeline pipeline;
+    startPipeline(pipeline, run.events);
+
+    FlightLogHeader header;
+    initFlightLogHeader(header, 0);
+    append(log, &header, sizeof(header));
+    recording = true;
+
+    auto start = std::chrono::steady_clock::now();
+    BaroSample baro[1];
+    ImuSample imu[LOOP_US / 1000];
+    for (uint32_t loop_us = 0; loop_us < FLIGHT_US; loop_us += LOOP_US) {
+        size_t baro_count = 0;
+        size_t imu_count = 0;
+        for (uint32_t t = loop_us + 1000; t <= loop_us + LOOP_US; t += 1000) {
+            const SimSample& s = sim.update(t);
+            imu[imu_count++] = { t, s.accel_x, s.accel_y, s.accel_z, s.gyro_x, s.gyro_y, s.gyro_z };
+            if (t % BARO_PERIOD_US == 0) {
+                baro[baro_count++] = { t, s.pressure_pa, s.temperature_c };
+            }
+        }
+        // The log is in time order, with each event after the sample that raised it
+        batch.clear();
+        for (size_t i = 0; i < baro_count; i++) {
+            batch.push_back(makeBaroRecord(baro[i]));
+        }
+        for (size_t i = 0; i < imu_count; i++) {
+            batch.push_back(makeImuRecord(imu[i]));
+        }
+        pipeline.processBatch(baro, baro_count, imu, imu_count);
+        std::stable_sort(batch.begin(), batch.end(), [](const FlightRecord& a, const FlightRecord& b) {
+            return a.time_us < b.time_us || (a.time_us == b.time_us && a.type != RECORD_EVENT && b.type == RECORD_EVENT);
+        });
+        append(log, batch.data(), batch.size() * sizeof(FlightRecord));
+    }
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    recording = false;
+    finishRun(pipeline, run);
+    return run;
+}
+
+// The event records written into the log by the live run
+static std::vector<SensorPipeline::Event> loggedEvents(FlightRecordReader& reader) {
+    std::vector<SensorPipeline::Event> events;
+    FlightRecord record;
+    while (reader.next(record)) {
+        if (record.type == RECORD_EVENT) {
+            SensorPipeline::Event event;
+            event.type = (SensorPipeline::EventType)record.flags;
+            event.time_ms = record.time_us / 1000;
+            event.phase = (FlightPhase)(int)record.values[0];
+            event.value = record.values[1];
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+// Drives a replay the way updateSensors() does: advance, then read both sources
+static Run replay(FlightRecordReader& reader, bool real_time, uint32_t& recorded_events) {
+    Run run;
+    ReplaySource source;
+    source.begin(&reader, real_time);
+    BaroSource* baro_source = &source;   // As baro_source/imu_source in main.cpp
+    ImuSource* imu_source = &source;
+    SensorPipeline pipeline;
+    startPipeline(pipeline, run.events);
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t clock_us = 0;
+    while (!source.isFinished()) {
+        source.advance(clock_us);
+        clock_us += 1000;
+        BaroSample baro;
+        ImuSample imu;
+        size_t baro_count = baro_source->readBatch(&baro, 1);
+        size_t imu_count = imu_source->readBatch(&imu, 1);
+        pipeline.processBatch(&baro, baro_count, &imu, imu_count);
+    }
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    recorded_events = source.getEventCount();
+    finishRun(pipeline, run);
+    return run;
+}
+
+static bool sameEvents(const std::vector<SensorPipeline::Event>& a, const std::vector<SensorPipeline::Event>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].type != b[i].type || a[i].time_ms != b[i].time_ms || a[i].phase != b[i].phase ||
+            memcmp(&a[i].value, &b[i].value, sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sameRun(const Run& a, const Run& b) {
+    return sameEvents(a.events, b.events) && a.baro_samples == b.baro_samples && a.imu_samples == b.imu_samples &&
+           a.max_altitude == b.max_altitude && a.max_acceleration == b.max_acceleration;
+}
+
+static void printRun(const char* name, const Run& run) {
+    printf("%-18s %zu events, %u baro + %u IMU samples, max %.2f m / %.3f g, %.3f s\n", name, run.events.size(),
+           run.baro_samples, run.imu_samples, run.max_altitude, run.max_acceleration, run.seconds);
+}
+
+static void printEvents(const std::vector<SensorPipeline::Event>& events) {
+    static const char* types[] = { "first altitude", "baseline ready", "phase change" };
+    for (const SensorPipeline::Event& event : events) {
+        printf("  %9.3f s  %-15s phase %d  %.2f\n", event.time_ms / 1000.0, types[event.type], event.phase,
+               event.value);
+    }
+}
+
+static bool hasPhase(const std::vector<SensorPipeline::Event>& events, FlightPhase phase) {
+    for (const SensorPipeline::Event& event : events) {
+        if (event.type == SensorPipeline::EVENT_PHASE_CHANGE && event.phase == phase) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void replayAll(const std::vector<uint8_t>& log, const Run* live) {
+    FILE* file = tmpfile();
+    if (file == nullptr || fwrite(log.data(), 1, log.size(), file) != log.size()) {
+        check(false, "write the log to a temporary file");
+        return;
+    }
+
+    FlightRecordReader reader;
+    reader.openMemory(log.data(), log.size());
+    std::vector<SensorPipeline::Event> logged = loggedEvents(reader);
+
+    uint32_t file_events = 0, memory_events = 0, real_time_events = 0;
+    rewind(file);
+    check(reader.openFile(file), "log opens from a file");
+    Run from_file = replay(reader, false, file_events);
+    check(reader.openMemory(log.data(), log.size()), "log opens from memory");
+    Run from_memory = replay(reader, false, memory_events);
+    reader.openMemory(log.data(), log.size());
+    Run real_time = replay(reader, true, real_time_events);
+    fclose(file);
+
+    printf("\n");
+    if (live != nullptr) {
+        printRun("live", *live);
+    }
+    printRun("replay (file)", from_file);
+    printRun("replay (memory)", from_memory);
+    printRun("replay (real time)", real_time);
+    printEvents(from_file.events);
+    printf("\n");
+
+    const Run& reference = live != nullptr ? *live : from_file;
+    check(hasPhase(reference.events, PHASE_BOOST) && hasPhase(reference.events, PHASE_LANDED),
+          "the flight has a launch and a landing");
+    if (live != nullptr) {
+        check(sameRun(from_file, *live), "file replay: same events, counts and maxima as the live run");
+        check(sameRun(from_memory, *live), "memory replay: same events, counts and maxima as the live run");
+        check(sameRun(real_time, *live), "real-time replay: same events, counts and maxima as the live run");
+    } else {
+        check(sameRun(from_memory, from_file), "memory replay matches the file replay");
+        check(sameRun(real_time, from_file), "real-time replay matches the file replay");
+    }
+    if (!logged.empty() || live != nullptr) {
+        check(sameEvents(from_file.events, logged), "replayed events match the events recorded in the log");
+    }
+    check(file_events == logged.size() && memory_events == logged.size() && real_time_events == logged.size(),
+          "every recorded event record is passed over");
+
+    double slowest = from_file.seconds;
+    slowest = from_memory.seconds > slowest ? from_memory.seconds : slowest;
+    slowest = real_time.seconds > slowest ? real_time.seconds : slowest;
+    double flight_s = (from_file.imu_samples > 0 ? from_file.imu_samples : 1) / 1000.0;
+    printf("slowest replay %.3f s for %.0f s of flight (%.0fx real time)\n", slowest, flight_s, flight_s / slowest);
+    char what[80];
+    snprintf(what, sizeof(what), "each replay takes less than %.0f s", MAX_REPLAY_S);
+    check(slowest < MAX_REPLAY_S, what);
+}
+
+static void checkSimulatedFlight() {
+    std::vector<uint8_t> log;
+    Run live = recordFlight(log);
+    printf("recorded %.0f s of flight: %zu bytes\n", FLIGHT_US / 1e6, log.size());
+    replayAll(log, &live);
+}
+
+static void checkRecordedLog() {
+    const char* path = getenv("REPLAY_LOG");
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        check(false, "open the REPLAY_LOG file");
+        return;
+    }
+    std::vector<uint8_t> log;
+    uint8_t buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        log.insert(log.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    printf("%s: %zu bytes\n", path, log.size());
+    replayAll(log, nullptr);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkSimulatedFlight);
+    if (getenv("REPLAY_LOG") != nullptr) {
+        RUN_TEST(checkRecordedLog);
+    }
+    return UNITY_END();
+}
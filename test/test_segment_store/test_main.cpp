@@ -0,0 +1,325 @@
+// Host power-loss test for the segment store.
+//
+// Runs SegmentStore against a file-backed NOR flash emulator: erase sets a
+// sector to 0xFF, a write can only clear bits (setting one is counted as a
+// store bug), and power can be cut after any number of programmed or
+// erased bytes. The byte being written when power goes keeps a random mix
+// of its old and new bits, and the rest of the operation never happens.
+//
+// A scripted session writes logs of random sizes in random chunks until
+// the store has wrapped several times. It is replayed once per cut point
+// (half of them anywhere, half inside a metadata sector erase, header or
+// commit, which are a tiny share of the bytes), then the store is
+// recovered from the file and checked:
+//   - every log closed before the cut, and not since overwritten, is back
+//     complete, with the same bytes and passing its data CRCs
+//   - any other recovered log holds only data that was written to it,
+//     in whole committed segments
+//   - the recovered store can write a new log that survives a reboot
+// Finishes with the erase count spread of a long run and the bytes read
+// by a mount.
+//
+// Run from the repository root:
+//     pio test -e native -f test_segment_store
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "segment_store.h"
+#include "sim_random.h"
+
+// NOR flash in a file. budget counts programmed or erased bytes until the
+// power is cut; -1 never cuts.
+class FileFlash : public FlashDevice {
+public:
+    FileFlash(FILE* backing, size_t bytes, long cut_after, uint64_t seed)
+        : file(backing), bytes_total(bytes), budget(cut_after), random(seed) {}
+
+    size_t size() const override { return bytes_total; }
+    size_t sectorSize() const override { return 4096; }
+
+    bool read(size_t offset, void* out, size_t len) override {
+        if (powered_off || offset + len > bytes_total) {
+            return false;
+        }
+        bytes_read += len;
+        fseek(file, offset, SEEK_SET);
+        return fread(out, 1, len, file) == len;
+    }
+
+    bool write(size_t offset, const void* data, size_t len) override {
+        const uint8_t* in = (const uint8_t*)data;
+        return change(offset, len, [&](size_t i, uint8_t old) {
+            if ((old & in[i]) != in[i]) {
+                violations++;
+            }
+            return (uint8_t)(old & in[i]);
+        });
+    }
+
+    bool erase(size_t offset, size_t len) override {
+        if (offset % sectorSize() != 0 || len % sectorSize() != 0) {
+            violations++;
+            return false;
+        }
+        return change(offset, len, [](size_t, uint8_t) { return (uint8_t)0xFF; });
+    }
+
+    bool isPoweredOff() const { return powered_off; }
+    long violations = 0;
+    long bytes_changed = 0;
+    size_t bytes_read = 0;
+    std::vector<long> metadata_bytes;   // bytes_changed at each metadata sector byte
+
+private:
+    FILE* file;
+    size_t bytes_total;
+    long budget;
+    SimRandom random;
+    bool powered_off = false;
+
+    template <typename F>
+    bool change(size_t offset, size_t len, F next) {
+        if (powered_off || offset + len > bytes_total) {
+            return false;
+        }
+        std::vector<uint8_t> buffer(len);
+        fseek(file, offset, SEEK_SET);
+        if (fread(buffer.data(), 1, len, file) != len) {
+            return false;
+        }
+        size_t done = len;
+        for (size_t i = 0; i < len; i++) {
+            uint8_t value = next(i, buffer[i]);
+            if (budget == 0) {
+                // Cut mid-byte: some bits made it, some did not
+                uint8_t mask = (uint8_t)random.nextU32();
+                buffer[i] = (buffer[i] & ~mask) | (value & mask);
+                powered_off = true;
+                done = i + 1;
+                break;
+            }
+            if (budget > 0) {
+                budget--;
+            }
+            if ((offset + i) % SegmentStore::SEGMENT_BYTES < SegmentStore::DATA_OFFSET) {
+                metadata_bytes.push_back(bytes_changed);
+            }
+            bytes_changed++;
+            buffer[i] = value;
+        }
+        fseek(file, offset, SEEK_SET);
+        fwrite(buffer.data(), 1, done, file);
+        fflush(file);
+        return !powered_off;
+    }
+};
+
+static const size_t FLASH_BYTES = 8 * SegmentStore::SEGMENT_BYTES;
+static const int SESSION_LOGS = 14;
+
+static uint8_t pattern(uint32_t id, size_t offset) {
+    uint32_t x = id * 0x9E3779B9u + (uint32_t)offset * 0x85EBCA6Bu;
+    x ^= x >> 15;
+    return (uint8_t)(x * 0x2C1B3C6Du >> 24);
+}
+
+static size_t sessionLogBytes(uint32_t id) {
+    SimRandom random(id);
+    return 1 + random.nextU32() % (3 * SegmentStore::SEGMENT_DATA_BYTES);
+}
+
+struct Survivor {
+    uint32_t id;
+    size_t bytes;
+};
+
+// Writes the session's logs; returns the ones that should survive a cut
+static std::vector<Survivor> runSession(SegmentStore& store, uint64_t seed) {
+    SimRandom random(seed);
+    std::vector<Survivor> closed;
+    std::vector<uint8_t> chunk;
+    for (uint32_t id = 1; id <= SESSION_LOGS; id++) {
+        if (!store.create(id)) {
+            break;
+        }
+        size_t bytes = sessionLogBytes(id);
+        bool ok = true;
+        for (size_t offset = 0; offset < bytes && ok; ) {
+            size_t n = 1 + random.nextU32() % 6000;
+            if (n > bytes - offset) {
+                n = bytes - offset;
+            }
+            chunk.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                chunk[i] = pattern(id, offset + i);
+            }
+            ok = store.append(chunk.data(), n);
+            offset += n;
+        }
+        if (!ok || !store.close()) {
+            break;
+        }
+        closed.push_back({ id, bytes });
+    }
+    // Only what the store still lists; older logs were overwritten
+    std::vector<Survivor> survivors;
+    for (const Survivor& s : closed) {
+        if (store.findLog(s.id) != nullptr) {
+            survivors.push_back(s);
+        }
+    }
+    return survivors;
+}
+
+static bool logMatches(SegmentStore& store, const SegmentStore::Log& log) {
+    std::vector<uint8_t> data(log.bytes);
+    if (store.read(log, 0, data.data(), data.size()) != log.bytes) {
+        return false;
+    }
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] != pattern(log.id, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkRecovered(FILE* file, const std::vector<Survivor>& survivors) {
+    FileFlash flash(file, FLASH_BYTES, -1, 0);
+    SegmentStore store;
+    expect(store.begin(&flash), "recovery mount", 0);
+
+    for (const Survivor& s : survivors) {
+        const SegmentStore::Log* log = store.findLog(s.id);
+        expect(log != nullptr, "closed log lost", s.id);
+        if (log != nullptr) {
+            expect(log->complete && log->bytes == s.bytes, "closed log changed", s.id);
+        }
+    }
+    for (int i = 0; i < store.getLogCount(); i++) {
+        const SegmentStore::Log& log = store.getLog(i);
+        expect(log.id >= 1 && log.id <= SESSION_LOGS, "unknown log id", log.id);
+        size_t bytes = sessionLogBytes(log.id);
+        expect(log.complete ? log.bytes == bytes : log.bytes <= bytes && log.bytes % SegmentStore::SEGMENT_DATA_BYTES == 0,
+              "recovered log length", log.id);
+        expect(store.verify(log), "recovered log CRC", log.id);
+        expect(logMatches(store, log), "recovered log data", log.id);
+    }
+
+    // The store must carry on where it was cut
+    uint32_t id = 100;
+    std::vector<uint8_t> data(SegmentStore::SEGMENT_DATA_BYTES + 1234);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = pattern(id, i);
+    }
+    expect(store.create(id) && store.append(data.data(), data.size()) && store.close(), "write after recovery", 0);
+    SegmentStore remount;
+    expect(remount.begin(&flash), "remount", 0);
+    const SegmentStore::Log* log = remount.findLog(id);
+    expect(log != nullptr && log->complete && log->bytes == data.size() && logMatches(remount, *log),
+          "log written after recovery", id);
+    expect(flash.violations == 0, "bits set without an erase", flash.violations);
+}
+
+static FILE* freshFlash() {
+    FILE* file = tmpfile();
+    std::vector<uint8_t> erased(FLASH_BYTES, 0xFF);
+    fwrite(erased.data(), 1, erased.size(), file);
+    fflush(file);
+    return file;
+}
+
+// Uninterrupted session, to size the cut range
+struct SessionSize {
+    long total;                       // Bytes programmed or erased
+    std::vector<long> metadata_bytes; // Cut points inside metadata writes
+};
+
+static SessionSize sizeSession() {
+    SessionSize size;
+    FILE* file = freshFlash();
+    FileFlash flash(file, FLASH_BYTES, -1, 0);
+    SegmentStore store;
+    store.begin(&flash);
+    std::vector<Survivor> survivors = runSession(store, 1);
+    size.total = flash.bytes_changed;
+    size.metadata_bytes = flash.metadata_bytes;
+    expect(flash.violations == 0, "bits set without an erase", flash.violations);
+    printf("Session: %zu of %d logs kept in %d segments, %ld bytes programmed or erased\n",
+           survivors.size(), SESSION_LOGS, store.getSegmentCount(), size.total);
+    fclose(file);
+    return size;
+}
+
+// Power loss at random byte offsets, plus the first and last byte
+static void testPowerCuts() {
+    const int cuts = 400;
+    SessionSize size = sizeSession();
+    SimRandom random(12345);
+    int failed = 0;
+    for (int c = 0; c < cuts; c++) {
+        long cut;
+        if (c < 2) {
+            cut = c == 0 ? 0 : size.total - 1;
+        } else if (c % 2 == 0) {
+            cut = (long)(random.nextU32() % (uint32_t)size.total);
+        } else {
+            cut = size.metadata_bytes[random.nextU32() % size.metadata_bytes.size()];
+        }
+        FILE* file = freshFlash();
+        std::vector<Survivor> survivors;
+        {
+            FileFlash flash(file, FLASH_BYTES, cut, cut);
+            SegmentStore store;
+            store.begin(&flash);
+            survivors = runSession(store, 1);
+            expect(flash.isPoweredOff(), "session finished before its cut", cut);
+            expect(flash.violations == 0, "bits set without an erase", flash.violations);
+        }
+        int before = check_failures;
+        checkRecovered(file, survivors);
+        if (check_failures != before) {
+            printf("      after a cut at byte %ld\n", cut);
+            failed++;
+        }
+        fclose(file);
+    }
+    printf("Power cuts: %d checked\n", cuts);
+    check(failed == 0, "every cut recovers its closed logs and can write again", failed, 0);
+}
+
+// Wear over a long run: round robin keeps erase counts within one
+static void testWear() {
+    FILE* file = freshFlash();
+    FileFlash flash(file, FLASH_BYTES, -1, 0);
+    SegmentStore store;
+    store.begin(&flash);
+    std::vector<uint8_t> data(150000);
+    for (uint32_t id = 1; id <= 200; id++) {
+        size_t bytes = 1 + (size_t)id * 7919 % data.size();
+        expect(store.create(id) && store.append(data.data(), bytes) && store.close(), "wear run write", id);
+    }
+    printf("Erase counts after 200 logs: %u..%u\n", store.getMinEraseCount(), store.getMaxEraseCount());
+    check(store.getMaxEraseCount() - store.getMinEraseCount() <= 1, "erase count spread",
+          store.getMaxEraseCount() - store.getMinEraseCount(), 1);
+
+    flash.bytes_read = 0;
+    SegmentStore mount;
+    mount.begin(&flash);
+    printf("Mount reads %zu bytes for %d segments, %d logs\n", flash.bytes_read, mount.getSegmentCount(),
+           mount.getLogCount());
+    check(flash.bytes_read <= (size_t)mount.getSegmentCount() * 64, "mount reads only metadata (bytes)",
+          (double)flash.bytes_read, mount.getSegmentCount() * 64);
+    fclose(file);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testPowerCuts);
+    RUN_TEST(testWear);
+    return UNITY_END();
+}
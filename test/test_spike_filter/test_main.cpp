@@ -0,0 +1,201 @@
+// Host check for the barometer spike filter.
+//
+// Verifies the median networks against a sort for every input pattern, then
+// runs a simulated flight through SensorPipeline three times - clean, with
+// spikes injected and no filter, and with spikes and each filter policy -
+// and compares maximum altitude and how many spikes got through. Spikes are
+// single-sample I2C glitches (+-300..5000 Pa) and two-sample transients at
+// ejection. Finishes with slidingMedian() throughput.
+//
+// Run from the repository root:
+//     pio test -e native -f test_spike_filter
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "check.h"
+#include "spike_filter.h"
+#include "sensor_pipeline.h"
+#include "flight_simulator.h"
+#include "sim_random.h"
+
+// Every input of taps values drawn from 0..taps-1 covers all orderings,
+// including ties
+static bool networksMatchSort(int taps) {
+    int patterns = 1;
+    for (int i = 0; i < taps; i++) {
+        patterns *= taps;
+    }
+    for (int v = 0; v < patterns; v++) {
+        int32_t in[SpikeFilter::MAX_TAPS];
+        int x = v;
+        for (int i = 0; i < taps; i++) {
+            in[i] = x % taps;
+            x /= taps;
+        }
+        int32_t sorted[SpikeFilter::MAX_TAPS];
+        std::copy(in, in + taps, sorted);
+        std::sort(sorted, sorted + taps);
+        if (median_network::median(in, taps) != sorted[taps / 2]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Trace {
+    std::vector<BaroSample> baro;
+    std::vector<bool> spiked;
+};
+
+// Model rocket flight with 50 Hz barometer samples
+static Trace makeTrace(bool with_spikes) {
+    FlightSimulator sim;
+    sim.begin(FlightProfile::modelRocket(), 7);
+    SimRandom rng;
+    rng.seedWith(99);
+
+    Trace t;
+    int transient_left = 0;
+    float transient_pa = 0.0f;
+    for (uint32_t now = 0; now < 70000000; now += 20000) {
+        const SimSample& s = sim.update(now);
+        BaroSample b = { s.time_us, s.pressure_pa, s.temperature_c };
+        bool spiked = false;
+        if (with_spikes) {
+            if (transient_left > 0) {
+                b.pressure_pa += transient_pa;
+                transient_left--;
+                spiked = true;
+            } else if (sim.getPhase() == SIM_DROGUE && rng.uniform() < 0.01f) {
+                // Ejection charge: a short pressure pulse over two samples
+                transient_pa = 800.0f + 1200.0f * rng.uniform();
+                b.pressure_pa += transient_pa;
+                transient_left = 1;
+                spiked = true;
+            } else if (rng.uniform() < 0.005f) {
+                // Bus glitch: one bad sample
+                float size = 300.0f + 4700.0f * rng.uniform();
+                b.pressure_pa += rng.uniform() < 0.5f ? size : -size;
+                spiked = true;
+            }
+        }
+        t.baro.push_back(b);
+        t.spiked.push_back(spiked);
+    }
+    return t;
+}
+
+struct Result {
+    float max_altitude;
+    uint32_t spikes;
+    uint32_t missed;         // Spiked samples that kept over a quarter of their altitude error
+    uint32_t false_alarms;   // Clean samples the filter touched
+};
+
+static Result run(const Trace& t, const Trace& clean, SpikeFilter::Policy policy, int taps) {
+    SensorPipeline pipeline;
+    SpikeFilter::Config config = pipeline.getSpikeFilter().getConfig();
+    config.policy = policy;
+    config.taps = taps;
+    pipeline.setSpikeFilter(config);
+    pipeline.setGroundReference(clean.baro[0].pressure_pa, pressureToAltitude(clean.baro[0].pressure_pa, 101325.0f));
+
+    Result r = { 0.0f, 0, 0, 0 };
+    for (size_t i = 0; i < t.baro.size(); i++) {
+        uint32_t before = pipeline.getState().baro_spikes;
+        pipeline.process(&t.baro[i], nullptr);
+        bool touched = pipeline.getState().baro_spikes != before;
+        // A replaced or dropped sample lags the climb by a sample or two,
+        // so judge each spike against its own size
+        float clean_altitude = pressureToAltitude(clean.baro[i].pressure_pa, 101325.0f);
+        float spike_error = fabsf(pressureToAltitude(t.baro[i].pressure_pa, 101325.0f) - clean_altitude);
+        if (t.spiked[i] && fabsf(pipeline.getState().current_altitude - clean_altitude) > 0.25f * spike_error) {
+            r.missed++;
+        }
+        if (!t.spiked[i] && touched) {
+            r.false_alarms++;
+        }
+    }
+    r.max_altitude = pipeline.getState().max_altitude;
+    r.spikes = pipeline.getState().baro_spikes;
+    return r;
+}
+
+static void checkNetworks() {
+    check(networksMatchSort(3), "3-tap network matches sort");
+    check(networksMatchSort(5), "5-tap network matches sort");
+    check(networksMatchSort(7), "7-tap network matches sort");
+}
+
+static const int taps[] = { 3, 5, 7 };
+
+static void checkPolicies() {
+    Trace clean = makeTrace(false);
+    Trace spiky = makeTrace(true);
+    uint32_t injected = 0;
+    for (size_t i = 0; i < spiky.spiked.size(); i++) {
+        injected += spiky.spiked[i];
+    }
+
+    Result reference = run(clean, clean, SpikeFilter::POLICY_OFF, 5);
+    Result unfiltered = run(spiky, clean, SpikeFilter::POLICY_OFF, 5);
+    printf("\n%zu samples, %u spiked\n", spiky.baro.size(), injected);
+    printf("%-14s taps  max alt (m)  error (m)  flagged  missed  false alarms\n", "policy");
+    printf("%-14s   -   %10.2f  %9.2f        -  %6u             -\n", "clean", reference.max_altitude, 0.0f, 0u);
+    printf("%-14s   -   %10.2f  %9.2f        -  %6u             -\n", "unfiltered",
+           unfiltered.max_altitude, unfiltered.max_altitude - reference.max_altitude, unfiltered.missed);
+
+    static const struct { SpikeFilter::Policy policy; const char* name; } policies[] = {
+        { SpikeFilter::POLICY_REPLACE, "replace" },
+        { SpikeFilter::POLICY_REJECT, "reject" },
+        { SpikeFilter::POLICY_MEDIAN, "median" },
+    };
+    for (const auto& p : policies) {
+        for (int n : taps) {
+            Result r = run(spiky, clean, p.policy, n);
+            float error = r.max_altitude - reference.max_altitude;
+            printf("%-14s   %d   %10.2f  %9.2f  %7u  %6u  %12u\n",
+                   p.name, n, r.max_altitude, error, r.spikes, r.missed, r.false_alarms);
+            // Two-sample transients can hide in a 3-tap window by design
+            if (n >= 5) {
+                check(fabsf(error) < 1.0f, "  max altitude within 1 m of the clean flight");
+                check(r.missed == 0, "  no spike reached the altitude");
+            }
+        }
+    }
+
+    Result clean_filtered = run(clean, clean, SpikeFilter::POLICY_REPLACE, 5);
+    check(clean_filtered.spikes == 0, "default filter leaves the clean flight untouched");
+}
+
+// Offline sliding median throughput
+static void benchSlidingMedian() {
+    Trace spiky = makeTrace(true);
+    std::vector<int32_t> raw(spiky.baro.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+        raw[i] = PressureFx::fromFloat(spiky.baro[i].pressure_pa).getRaw();
+    }
+    std::vector<int32_t> out(raw.size());
+    printf("\n");
+    for (int n : taps) {
+        const int repeats = 200;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++) {
+            SpikeFilter::slidingMedian(raw.data(), out.data(), raw.size(), n);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("slidingMedian %d taps: %.2f ns/sample (check %d)\n", n, ns / ((double)raw.size() * repeats), out[raw.size() / 2] & 0xff);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkNetworks);
+    RUN_TEST(checkPolicies);
+    RUN_TEST(benchSlidingMedian);
+    return UNITY_END();
+}
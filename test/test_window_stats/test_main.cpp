@@ -0,0 +1,254 @@
+// Host check for WindowStats against a brute-force window.
+//
+// Feeds long random streams into WindowStats and into a reference that
+// keeps every sample and recomputes min, max, mean, variance (two-pass, in
+// double) and rate from scratch after each add. The reference buckets
+// samples by the documented rule (a bucket spans window / BUCKETS from its
+// first sample; a closed bucket leaves when its last sample is more than a
+// window old, or when BUCKETS newer ones are closed), and is also checked
+// against the plain time window: everything from the last window is in,
+// nothing older than a window and a bucket. The streams cross the 32-bit
+// microsecond wrap, have bursts, gaps longer than the window and single-
+// sample buckets, and run through many rebuilds of the running totals;
+// channels include a pressure-sized offset, where removal from the float
+// totals loses the most. Min, max and the sample count must match exactly,
+// mean, variance and rate to float precision (see Errors) over the whole
+// stream, so error may not build up between rebuilds.
+//
+// Run from the repository root:
+//     pio test -e native -f test_window_stats
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+
+#include "check.h"
+#include "window_stats.h"
+
+// Every sample, grouped into the same buckets as WindowStats
+template<size_t BUCKETS>
+class BruteForceWindow {
+public:
+    explicit BruteForceWindow(uint32_t window_us) : window(window_us) {
+        bucket_us = window_us / BUCKETS > 0 ? window_us / BUCKETS : 1;
+    }
+
+    void add(uint32_t time_us, float value) {
+        if (!buckets.empty() && buckets.back().open && (int32_t)(time_us - buckets.back().start_us) >= (int32_t)bucket_us) {
+            buckets.back().open = false;
+            if (buckets.size() > BUCKETS) {
+                buckets.pop_front();
+            }
+        }
+        if (buckets.empty() || !buckets.back().open) {
+            buckets.push_back(Bucket { time_us, true, {} });
+        }
+        while (!buckets.front().open && (int32_t)(time_us - buckets.front().samples.back().time_us) > (int32_t)window) {
+            buckets.pop_front();
+        }
+        buckets.back().samples.push_back({ time_us, value });
+        now = time_us;
+    }
+
+    uint32_t count() const {
+        uint32_t n = 0;
+        for (const Bucket& b : buckets) {
+            n += b.samples.size();
+        }
+        return n;
+    }
+
+    // Oldest sample age in the window, and whether every sample of the
+    // last window is still in
+    uint32_t oldestAge() const { return now - buckets.front().samples.front().time_us; }
+
+    template<typename F>
+    void each(F f) const {
+        for (const Bucket& b : buckets) {
+            for (const Sample& s : b.samples) {
+                f(s);
+            }
+        }
+    }
+
+    float min() const {
+        float m = INFINITY;
+        each([&](const Sample& s) { m = fminf(m, s.value); });
+        return m;
+    }
+
+    float max() const {
+        float m = -INFINITY;
+        each([&](const Sample& s) { m = fmaxf(m, s.value); });
+        return m;
+    }
+
+    double mean() const {
+        double sum = 0.0;
+        each([&](const Sample& s) { sum += s.value; });
+        return sum / count();
+    }
+
+    double variance() const {
+        uint32_t n = count();
+        if (n < 2) {
+            return 0.0;
+        }
+        double m = mean();
+        double sum = 0.0;
+        each([&](const Sample& s) { sum += (s.value - m) * (s.value - m); });
+        return sum / (n - 1);
+    }
+
+    double rate() const {
+        const Sample& first = buckets.front().samples.front();
+        const Sample& last = buckets.back().samples.back();
+        int32_t dt = (int32_t)(last.time_us - first.time_us);
+        return dt > 0 ? ((double)last.value - first.value) * 1.0e6 / dt : 0.0;
+    }
+
+private:
+    struct Sample {
+        uint32_t time_us;
+        float value;
+    };
+
+    struct Bucket {
+        uint32_t start_us;
+        bool open;
+        std::deque<Sample> samples;
+    };
+
+    uint32_t window;
+    uint32_t bucket_us;
+    uint32_t now = 0;
+    std::deque<Bucket> buckets;
+};
+
+struct Stream {
+    const char* name;
+    uint32_t window_us;
+    uint32_t mean_step_us;
+    float offset;          // Value level
+    float noise;           // Sample-to-sample spread
+    float drift_per_s;     // Steady change, for the rate
+};
+
+// Worst error of each statistic as a fraction of what float allows. The
+// accumulators are float, so a 101325 Pa mean is only good to ~0.01 Pa:
+// mean and rate get 1% of the standard deviation plus a few float steps at
+// the value's level; the variance 2%, plus float steps of the squared range
+// (taking a bucket out of the totals cancels that much), plus what bucket
+// means that are a few float steps off do to it
+struct Errors {
+    bool exact = true;        // Count, min, max
+    bool in_window = true;    // Against the plain time window
+    double mean = 0.0;
+    double variance = 0.0;
+    double rate = 0.0;
+};
+
+template<size_t BUCKETS>
+static Errors runStream(const Stream& s, uint32_t samples, uint32_t seed) {
+    WindowStats<BUCKETS> stats(s.window_us);
+    BruteForceWindow<BUCKETS> ref(s.window_us);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, s.noise);
+
+    // Start 10 windows before the 32-bit wrap
+    uint32_t t = 0u - 10 * s.window_us;
+    double level = s.offset;
+    Errors e;
+    const uint32_t bucket_us = s.window_us / BUCKETS;
+    for (uint32_t i = 0; i < samples; i++) {
+        float r = unit(rng);
+        uint32_t step;
+        if (r < 0.001f) {
+            step = s.window_us + (uint32_t)(unit(rng) * 2 * s.window_us);   // Gap: the window empties
+        } else if (r < 0.01f) {
+            step = bucket_us + (uint32_t)(unit(rng) * 4 * bucket_us);      // Bucket-sized holes
+        } else if (r < 0.2f) {
+            step = 0;                                                      // Same timestamp
+        } else {
+            step = (uint32_t)(unit(rng) * 2 * s.mean_step_us);
+        }
+        t += step;
+        level += s.drift_per_s * step * 1.0e-6;
+        float value = (float)level + noise(rng);
+        stats.add(t, value);
+        ref.add(t, value);
+
+        e.exact = e.exact && stats.getCount() == ref.count() && stats.getMin() == ref.min() && stats.getMax() == ref.max();
+        e.in_window = e.in_window && ref.oldestAge() <= s.window_us + bucket_us;
+
+        double var = ref.variance();
+        double sd = sqrt(var);
+        double spread = (double)ref.max() - ref.min();
+        double mean_allowed = 0.01 * sd + 32 * FLT_EPSILON * fabs(ref.mean());
+        double steps = 4 * FLT_EPSILON * fabs(ref.mean());
+        double var_allowed = 0.02 * var + 64 * FLT_EPSILON * spread * spread + 4 * steps * spread + steps * steps;
+        double rate_allowed = (0.01 * sd + steps) * 1.0e6 / s.window_us + 4 * FLT_EPSILON * fabs(ref.rate());
+        e.mean = fmax(e.mean, fabs(stats.getMean() - ref.mean()) / mean_allowed);
+        e.variance = fmax(e.variance, fabs(stats.getVariance() - var) / var_allowed);
+        e.rate = fmax(e.rate, fabs(stats.getRate() - ref.rate()) / rate_allowed);
+    }
+    return e;
+}
+
+// Every sample of the last window is counted, none older than a window and
+// a bucket, on a steady 1 kHz stream
+static void checkWindowEdges() {
+    WindowStats<32> stats(1000000);
+    uint32_t t = 0u - 500000;
+    bool edges = true;
+    for (int i = 0; i < 5000; i++, t += 1000) {
+        stats.add(t, (float)i);
+        if (i >= 1100) {
+            float oldest = (float)i - stats.getCount() + 1;
+            edges = edges && stats.getMin() == oldest && i - oldest >= 1000 && i - oldest <= 1000 + 31;
+        }
+    }
+    check(edges, "1 kHz ramp: the window holds 1000 to 1031 ms of samples, across the wrap");
+    check(fabsf(stats.getRate() - 1000.0f) < 0.01f, "1 kHz ramp: rate 1000 per second");
+    stats.add(t + 1500000, 7.0f);
+    check(stats.getCount() == 1 && stats.getMin() == 7.0f && stats.getMax() == 7.0f && stats.getRate() == 0.0f &&
+              stats.getVariance() == 0.0f,
+          "a gap longer than the window leaves only the new sample");
+}
+
+static void checkStreams() {
+    const uint32_t samples = 300000;
+
+    // The pipeline's channels (1 s and 10 s, 32 buckets), the summariser's
+    // smoothing, and a window shorter than the sample spacing
+    const Stream streams[] = {
+        { "altitude 1 s", 1000000, 1000, 350.0f, 0.3f, 25.0f },
+        { "pressure 10 s", 10000000, 20000, 101325.0f, 2.0f, -3.0f },
+        { "acceleration 1 s", 1000000, 250, 1.0f, 0.05f, 0.0f },
+        { "temperature 10 s", 10000000, 50000, 24.0f, 0.01f, 0.001f },
+        { "short window", 100, 200, -40.0f, 1.0f, 0.0f },
+    };
+    uint32_t seed = 1;
+    for (const Stream& s : streams) {
+        Errors e = s.window_us >= 1000000 ? runStream<32>(s, samples, seed++) : runStream<8>(s, samples, seed++);
+        printf("%-18s worst error / allowed: mean %.2f  variance %.2f  rate %.2f\n", s.name, e.mean, e.variance, e.rate);
+        char what[96];
+        snprintf(what, sizeof(what), "%s: count, min and max match the brute force exactly", s.name);
+        check(e.exact, what);
+        snprintf(what, sizeof(what), "%s: no sample older than a window and a bucket", s.name);
+        check(e.in_window, what);
+        snprintf(what, sizeof(what), "%s: mean, variance and rate within float precision", s.name);
+        check(e.mean <= 1.0 && e.variance <= 1.0 && e.rate <= 1.0, what);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(checkWindowEdges);
+    RUN_TEST(checkStreams);
+    return UNITY_END();
+}
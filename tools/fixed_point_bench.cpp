@@ -0,0 +1,201 @@
+// Host benchmark: fixed-point sensor processing vs the old float path.
+//
+// Feeds one simulated flight through the per-sample work of SensorPipeline
+// (altitude conversion, max tracking, acceleration magnitude and per-axis
+// max) twice - once with the fixed-point code the firmware now uses, once
+// with the float/powf version it replaced - and reports the time per sample,
+// split into the altitude conversion and the acceleration magnitude, and how
+// far the two results drift apart.
+//
+// On a desktop CPU the fixed-point path is a little slower per sample, even
+// though on their own the table lookup gains more over powf() than the exact
+// integer root loses to sqrtf(). It is kept for its results - the same bits
+// on every target, saturation instead of wrap, no libm dependence - not for
+// speed; on the ESP32-S3 powf() is a software routine, which this
+// benchmark cannot measure.
+//
+// Build and run from the repository root:
+//     g++ -O2 -std=gnu++17 -Isrc -o fixed_point_bench tools/fixed_point_bench.cpp
+//         src/sensor_pipeline.cpp src/peak_tracker.cpp src/spike_filter.cpp
+//         src/imu_filter_bank.cpp src/ahrs.cpp src/history_pyramid.cpp src/flight_phase.cpp
+//         src/flight_simulator.cpp
+//     ./fixed_point_bench [samples]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "fixed_point.h"
+#include "sensor_types.h"
+#include "flight_simulator.h"
+
+struct FloatResult {
+    float altitude;
+    float max_altitude;
+    float max_acceleration;
+    float acceleration_sum;
+    char max_axis;
+};
+
+struct FixedResult {
+    AltitudeFx altitude;
+    AltitudeFx max_altitude;
+    AccelFx max_acceleration;
+    int64_t acceleration_sum;
+    char max_axis;
+};
+
+static FloatResult runFloat(const std::vector<BaroSample>& baro, const std::vector<ImuSample>& imu) {
+    FloatResult r = { 0.0f, -1.0e9f, 0.0f, 0.0f, 'Z' };
+    for (size_t i = 0; i < baro.size(); i++) {
+        r.altitude = pressureToAltitude(baro[i].pressure_pa, 101325.0f);
+        if (r.altitude > r.max_altitude) {
+            r.max_altitude = r.altitude;
+        }
+        const ImuSample& s = imu[i];
+        r.acceleration_sum += sqrtf(s.accel_x * s.accel_x + s.accel_y * s.accel_y + s.accel_z * s.accel_z);
+        // Per-axis maximum and its axis, with the same selects as the
+        // fixed path so only the arithmetic differs
+        static const char axis_names[3] = { 'X', 'Y', 'Z' };
+        const float a[3] = { s.accel_x, s.accel_y, s.accel_z };
+        float m = fabsf(a[0]);
+        int axis = 0;
+        for (int k = 1; k < 3; k++) {
+            float v = fabsf(a[k]);
+            bool higher = v > m;
+            m = higher ? v : m;
+            axis = higher ? k : axis;
+        }
+        if (m > r.max_acceleration) {
+            r.max_acceleration = m;
+            r.max_axis = axis_names[axis];
+        }
+    }
+    return r;
+}
+
+static FixedResult runFixed(const std::vector<PressureFx>& baro, const std::vector<AccelFx>& imu) {
+    FixedResult r = { AltitudeFx(), AltitudeFx::fromInt(-30000), AccelFx(), 0, 'Z' };
+    for (size_t i = 0; i < baro.size(); i++) {
+        r.altitude = pressureToAltitudeFx(baro[i]);
+        if (r.altitude > r.max_altitude) {
+            r.max_altitude = r.altitude;
+        }
+        const AccelFx* a = &imu[i * 3];
+        r.acceleration_sum += AccelFx::magnitude(a[0], a[1], a[2]).getRaw();
+        // As SensorPipeline::applyImu() does it
+        static const char axis_names[3] = { 'X', 'Y', 'Z' };
+        AccelFx m = a[0].abs();
+        int axis = 0;
+        for (int k = 1; k < 3; k++) {
+            AccelFx v = a[k].abs();
+            bool higher = v > m;
+            m = higher ? v : m;
+            axis = higher ? k : axis;
+        }
+        if (m > r.max_acceleration) {
+            r.max_acceleration = m;
+            r.max_axis = axis_names[axis];
+        }
+    }
+    return r;
+}
+
+static float floatAltitudes(const std::vector<BaroSample>& baro) {
+    float sum = 0.0f;
+    for (const BaroSample& b : baro) {
+        sum += pressureToAltitude(b.pressure_pa, 101325.0f);
+    }
+    return sum;
+}
+
+static int64_t fixedAltitudes(const std::vector<PressureFx>& baro) {
+    int64_t sum = 0;
+    for (PressureFx p : baro) {
+        sum += pressureToAltitudeFx(p).getRaw();
+    }
+    return sum;
+}
+
+static float floatMagnitudes(const std::vector<ImuSample>& imu) {
+    float sum = 0.0f;
+    for (const ImuSample& s : imu) {
+        sum += sqrtf(s.accel_x * s.accel_x + s.accel_y * s.accel_y + s.accel_z * s.accel_z);
+    }
+    return sum;
+}
+
+static int64_t fixedMagnitudes(const std::vector<AccelFx>& imu) {
+    int64_t sum = 0;
+    for (size_t i = 0; i + 2 < imu.size(); i += 3) {
+        sum += AccelFx::magnitude(imu[i], imu[i + 1], imu[i + 2]).getRaw();
+    }
+    return sum;
+}
+
+template<typename F>
+static double nsPerSample(F run, size_t samples, int repeats) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; i++) {
+        run();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ((double)samples * repeats);
+}
+
+int main(int argc, char** argv) {
+    size_t samples = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+
+    // A whole flight, sampled evenly
+    FlightSimulator sim;
+    sim.begin(FlightProfile::modelRocket(), 1);
+    uint32_t step_us = 60000000u / samples + 1;
+
+    std::vector<BaroSample> baro(samples);
+    std::vector<ImuSample> imu(samples);
+    std::vector<PressureFx> baro_fx(samples);
+    std::vector<AccelFx> imu_fx(samples * 3);
+    for (size_t i = 0; i < samples; i++) {
+        const SimSample& s = sim.update((uint32_t)(i * step_us));
+        baro[i] = { s.time_us, s.pressure_pa, s.temperature_c };
+        imu[i] = { s.time_us, s.accel_x, s.accel_y, s.accel_z, s.gyro_x, s.gyro_y, s.gyro_z };
+        baro_fx[i] = PressureFx::fromFloat(s.pressure_pa);
+        imu_fx[i * 3] = AccelFx::fromFloat(s.accel_x);
+        imu_fx[i * 3 + 1] = AccelFx::fromFloat(s.accel_y);
+        imu_fx[i * 3 + 2] = AccelFx::fromFloat(s.accel_z);
+    }
+
+    // Worst-case conversion error over the whole plausible pressure range
+    float worst_altitude_error = 0.0f;
+    for (int32_t p = 30000; p <= 110000; p += 7) {
+        float a = pressureToAltitude((float)p, 101325.0f);
+        float b = pressureToAltitudeFx(PressureFx::fromInt(p)).toFloat();
+        worst_altitude_error = fmaxf(worst_altitude_error, fabsf(a - b));
+    }
+
+    volatile float sink_float = 0.0f;
+    volatile int64_t sink_fixed = 0;
+    const int repeats = 20;
+    double float_ns = nsPerSample([&]() { sink_float = runFloat(baro, imu).acceleration_sum; }, samples, repeats);
+    double fixed_ns = nsPerSample([&]() { sink_fixed = runFixed(baro_fx, imu_fx).acceleration_sum; }, samples, repeats);
+    double powf_ns = nsPerSample([&]() { sink_float = floatAltitudes(baro); }, samples, repeats);
+    double table_ns = nsPerSample([&]() { sink_fixed = fixedAltitudes(baro_fx); }, samples, repeats);
+    double sqrtf_ns = nsPerSample([&]() { sink_float = floatMagnitudes(imu); }, samples, repeats);
+    double isqrt_ns = nsPerSample([&]() { sink_fixed = fixedMagnitudes(imu_fx); }, samples, repeats);
+
+    FloatResult f = runFloat(baro, imu);
+    FixedResult x = runFixed(baro_fx, imu_fx);
+
+    printf("samples:               %zu\n", samples);
+    printf("float path:            %.1f ns/sample\n", float_ns);
+    printf("fixed path:            %.1f ns/sample (%+.0f%%)\n", fixed_ns, 100.0 * (fixed_ns - float_ns) / float_ns);
+    printf("  altitude:            powf %.1f ns, table %.1f ns\n", powf_ns, table_ns);
+    printf("  magnitude:           sqrtf %.1f ns, exact isqrt %.1f ns\n", sqrtf_ns, isqrt_ns);
+    printf("max altitude:          float %.3f m, fixed %.3f m\n", f.max_altitude, x.max_altitude.toFloat());
+    printf("max acceleration:      float %.4f g, fixed %.4f g\n", f.max_acceleration, x.max_acceleration.toFloat());
+    printf("worst altitude error:  %.4f m (300..1100 hPa)\n", worst_altitude_error);
+    printf("fixed checksum:        %08x\n", (unsigned)(x.acceleration_sum ^ x.max_altitude.getRaw()));
+    return 0;
+}
@@ -0,0 +1,748 @@
+// Host analysis and conversion tool for recorded flights.
+//
+// Reads logs with the firmware's own decoders, so it always understands
+// what the device wrote:
+//   - flight archives (.ttfa) as saved to the flightlog partition and
+//     served by /logs/download
+//   - FlightRecord logs (.ttfl), e.g. replay files
+//   - raw dumps of the flightlog partition (esptool read_flash), where
+//     every log the segment store can recover is processed
+// Inputs are mmap()ed and decoded in place. Logs are shared out to worker
+// threads (-j, all cores by default) and the results are printed in input
+// order, so a season of flights is processed as fast as the disk allows.
+//
+// Commands:
+//   stats    FlightSummary (apogee, peak g, rates, event times) and min/
+//            max/mean/stddev of every recorded column, then season totals
+//   events   Timeline of the pipeline's events (ground reference, phase
+//            changes) merged with the summary's apogee and peak g
+//   csv      One row per record: time_s,type and every column
+//   columns  Columnar output: per log and stream a directory with one raw
+//            little-endian file per column (time_s float64, the rest
+//            float32) and a schema.json, e.g. for numpy.fromfile()
+//   replay   Re-runs SensorPipeline (spike filter, fixed-point altitude,
+//            filter bank, AHRS, phase detection) and writes its output per
+//            barometer sample as CSV
+// With one input csv, events, stats and replay write to stdout; with
+// several, -o DIR gets one file per log. columns always needs -o DIR.
+//
+// Build from the repository root:
+//     g++ -O2 -std=gnu++17 -pthread -Isrc -o flight_tool tools/flight_tool.cpp
+//         src/flight_archive.cpp src/flight_summary.cpp src/mapped_log.cpp src/segment_store.cpp
+//         src/compressed_series.cpp src/replay_source.cpp src/flight_phase.cpp
+//         src/sensor_pipeline.cpp src/peak_tracker.cpp src/spike_filter.cpp src/imu_filter_bank.cpp
+//         src/ahrs.cpp src/history_pyramid.cpp
+//     ./flight_tool stats -j 8 season/*.ttfa
+//     ./flight_tool columns -o out flightlog.bin
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flight_archive.h"
+#include "flight_record.h"
+#include "flight_summary.h"
+#include "mapped_log.h"
+#include "replay_source.h"
+#include "segment_store.h"
+#include "sensor_pipeline.h"
+
+// A whole file mapped read-only
+class MappedFile {
+public:
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (memory != MAP_FAILED) {
+                data = (const uint8_t*)memory;
+                size = info.st_size;
+                madvise(memory, size, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        return data != nullptr;
+    }
+
+    void close() {
+        if (data != nullptr) {
+            munmap((void*)data, size);
+        }
+        data = nullptr;
+        size = 0;
+    }
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// A flightlog partition dump, read-only
+class ImageFlash : public FlashDevice {
+public:
+    ImageFlash(const uint8_t* memory, size_t bytes) : base(memory), bytes_total(bytes) {}
+
+    size_t size() const override { return bytes_total; }
+    size_t sectorSize() const override { return 4096; }
+
+    bool read(size_t offset, void* out, size_t len) override {
+        if (offset + len > bytes_total) {
+            return false;
+        }
+        memcpy(out, base + offset, len);
+        return true;
+    }
+
+    bool write(size_t, const void*, size_t) override { return false; }
+    bool erase(size_t, size_t) override { return false; }
+
+private:
+    const uint8_t* base;
+    size_t bytes_total;
+};
+
+enum InputKind {
+    INPUT_ARCHIVE,
+    INPUT_RECORDS,
+    INPUT_IMAGE
+};
+
+static bool hasMagic(const MappedFile& file, uint32_t magic) {
+    uint32_t value;
+    if (file.size < sizeof(value)) {
+        return false;
+    }
+    memcpy(&value, file.data, sizeof(value));
+    return value == magic;
+}
+
+static bool detectKind(const MappedFile& file, InputKind& kind) {
+    if (hasMagic(file, FLIGHT_ARCHIVE_MAGIC)) {
+        kind = INPUT_ARCHIVE;
+    } else if (hasMagic(file, FLIGHT_LOG_MAGIC)) {
+        kind = INPUT_RECORDS;
+    } else if (file.size % SegmentStore::SEGMENT_BYTES == 0) {
+        kind = INPUT_IMAGE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// One log to process, and what came of it
+struct Job {
+    std::string path;
+    std::string name;            // Output name: file name, plus the flight for image logs
+    uint32_t log_id = 0;         // INPUT_IMAGE only
+    std::string output;          // Report text, printed in input order
+    std::string error;
+    FlightSummary summary;
+    bool summarised = false;
+};
+
+// Records of one log in time order, whatever it is stored in
+class RecordSource {
+public:
+    bool open(const Job& job, std::string& error) {
+        if (!file.open(job.path)) {
+            error = "cannot map file";
+            return false;
+        }
+        if (!detectKind(file, kind)) {
+            error = "not a flight archive, record log or partition image";
+            return false;
+        }
+        if (kind == INPUT_RECORDS) {
+            if (!records.openMemory(file.data, file.size)) {
+                error = "bad record log header";
+                return false;
+            }
+            return true;
+        }
+        if (kind == INPUT_ARCHIVE) {
+            if (!archive.openMemory(file.data, file.size)) {
+                error = "bad flight archive header";
+                return false;
+            }
+            return true;
+        }
+        // A log in a partition image: read where it lies, like the device
+        flash.reset(new ImageFlash(file.data, file.size));
+        store.reset(new SegmentStore());
+        pages.reset(new MappedLog());
+        const SegmentStore::Log* log = store->begin(flash.get()) ? store->findLog(job.log_id) : nullptr;
+        if (log == nullptr || !pages->mapStore(*store, *log, file.data) || !archive.openMapped(*pages)) {
+            error = "log not readable in the image";
+            return false;
+        }
+        return true;
+    }
+
+    bool next(FlightRecord& out) {
+        return kind == INPUT_RECORDS ? records.next(out) : archive.next(out);
+    }
+
+    // Event records in .ttfl logs are skipped: the tool re-derives events
+    bool nextSample(FlightRecord& out) {
+        while (next(out)) {
+            if (out.type == RECORD_BARO || out.type == RECORD_IMU) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const char* describe() const {
+        if (kind == INPUT_RECORDS) {
+            return "record log";
+        }
+        return archive.isTruncated() ? "flight archive, cut short" : "flight archive";
+    }
+
+    // Archives are saved at the live LANDED; see FlightSummariser::endAtLanding()
+    bool endsAtLanding() const { return kind != INPUT_RECORDS && !archive.isTruncated(); }
+
+    uint32_t getFlightNumber() const { return kind == INPUT_RECORDS ? 0 : archive.getHeader().flight_number; }
+
+private:
+    MappedFile file;
+    InputKind kind = INPUT_RECORDS;
+    FlightRecordReader records;
+    FlightArchiveReader archive;
+    std::unique_ptr<ImageFlash> flash;
+    std::unique_ptr<SegmentStore> store;
+    std::unique_ptr<MappedLog> pages;
+};
+
+// Seconds since the first record, across the 32-bit microsecond wrap
+class RecordClock {
+public:
+    double seconds(uint32_t time_us) {
+        if (!started) {
+            started = true;
+            elapsed_us = 0;
+        } else {
+            elapsed_us += (int32_t)(time_us - last_us);
+        }
+        last_us = time_us;
+        return elapsed_us / 1e6;
+    }
+
+private:
+    bool started = false;
+    uint32_t last_us = 0;
+    int64_t elapsed_us = 0;
+};
+
+struct ColumnInfo {
+    const char* name;
+    uint8_t type;
+    int index;
+};
+
+static const ColumnInfo COLUMNS[] = {
+    { "pressure_pa", RECORD_BARO, 0 },
+    { "temperature_c", RECORD_BARO, 1 },
+    { "accel_x_g", RECORD_IMU, 0 },
+    { "accel_y_g", RECORD_IMU, 1 },
+    { "accel_z_g", RECORD_IMU, 2 },
+    { "gyro_x_dps", RECORD_IMU, 3 },
+    { "gyro_y_dps", RECORD_IMU, 4 },
+    { "gyro_z_dps", RECORD_IMU, 5 }
+};
+static const int COLUMN_COUNT = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+
+struct Options {
+    std::string command;
+    std::vector<std::string> inputs;
+    std::string out_dir;
+    unsigned threads = 0;
+};
+
+static std::string format(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static std::string format(const char* fmt, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    return buffer;
+}
+
+static std::string eventTime(float seconds) {
+    return seconds == FlightSummary::NOT_SEEN ? std::string("-") : format("%.2f s", seconds);
+}
+
+// stdout with a single input, else DIR/<name><suffix>
+static FILE* openOutput(const Options& options, const Job& job, const char* suffix) {
+    if (options.out_dir.empty()) {
+        return stdout;
+    }
+    std::string path = options.out_dir + "/" + job.name + suffix;
+    return fopen(path.c_str(), "w");
+}
+
+static void closeOutput(FILE* out) {
+    if (out != stdout && out != nullptr) {
+        fclose(out);
+    }
+}
+
+static void runStats(RecordSource& source, Job& job) {
+    FlightSummariser summariser;
+    struct Moments {
+        uint64_t count = 0;
+        double min = 0.0, max = 0.0, mean = 0.0, m2 = 0.0;
+    } moments[COLUMN_COUNT];
+
+    FlightRecord record;
+    while (source.nextSample(record)) {
+        summariser.add(record);
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            if (COLUMNS[c].type != record.type) {
+                continue;
+            }
+            Moments& m = moments[c];
+            double value = record.values[COLUMNS[c].index];
+            if (m.count == 0 || value < m.min) m.min = value;
+            if (m.count == 0 || value > m.max) m.max = value;
+            m.count++;
+            double delta = value - m.mean;
+            m.mean += delta / m.count;
+            m.m2 += delta * (value - m.mean);
+        }
+    }
+    if (source.endsAtLanding()) {
+        summariser.endAtLanding();
+    }
+    summariser.getSummary(job.summary);
+    job.summary.flight_number = source.getFlightNumber();
+    job.summarised = true;
+
+    const FlightSummary& s = job.summary;
+    std::string& out = job.output;
+    out += format("%s: %s, %u barometer and %u IMU samples over %.1f s\n", job.name.c_str(), source.describe(),
+                  s.baro_samples, s.imu_samples, s.recording_s);
+    out += format("  apogee %.1f m at %s, peak %.2f g at %s\n", s.apogee_m, eventTime(s.apogee_s).c_str(),
+                  s.max_acceleration_g, eventTime(s.max_acceleration_s).c_str());
+    out += format("  climb %.1f m/s max, descent %.1f m/s max, %.1f m/s mean\n", s.max_ascent_rate,
+                  s.max_descent_rate, s.mean_descent_rate);
+    out += format("  launch %s, burnout %s, touchdown %s\n", eventTime(s.launch_s).c_str(),
+                  eventTime(s.burnout_s).c_str(), eventTime(s.touchdown_s).c_str());
+    out += format("  %-14s %9s %12s %12s %12s %12s\n", "column", "count", "min", "max", "mean", "stddev");
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        const Moments& m = moments[c];
+        double stddev = m.count > 1 ? sqrt(m.m2 / (m.count - 1)) : 0.0;
+        out += format("  %-14s %9llu %12.4f %12.4f %12.4f %12.4f\n", COLUMNS[c].name, (unsigned long long)m.count,
+                      m.min, m.max, m.mean, stddev);
+    }
+}
+
+// The pipeline reports events through a plain function pointer; each
+// worker thread collects its own
+struct TimelineEntry {
+    double seconds;
+    std::string text;
+};
+static thread_local std::vector<TimelineEntry>* pipeline_events = nullptr;
+static thread_local double pipeline_start_s = 0.0;
+
+static void onPipelineEvent(const SensorPipeline::Event& event) {
+    if (pipeline_events == nullptr) {
+        return;
+    }
+    double seconds = event.time_ms / 1000.0 - pipeline_start_s;
+    std::string text;
+    switch (event.type) {
+        case SensorPipeline::EVENT_FIRST_ALTITUDE:
+            text = "first altitude";
+            break;
+        case SensorPipeline::EVENT_BASELINE_READY:
+            text = "ground reference ready";
+            break;
+        case SensorPipeline::EVENT_PHASE_CHANGE:
+            text = format("%s at %.1f m AGL", FlightPhaseDetector::getPhaseName(event.phase), event.value);
+            break;
+    }
+    pipeline_events->push_back({ seconds, text });
+}
+
+static BaroSample toBaro(const FlightRecord& record) {
+    BaroSample sample;
+    sample.time_us = record.time_us;
+    sample.pressure_pa = record.values[0];
+    sample.temperature_c = record.values[1];
+    return sample;
+}
+
+static ImuSample toImu(const FlightRecord& record) {
+    ImuSample sample;
+    sample.time_us = record.time_us;
+    sample.accel_x = record.values[0];
+    sample.accel_y = record.values[1];
+    sample.accel_z = record.values[2];
+    sample.gyro_x = record.values[3];
+    sample.gyro_y = record.values[4];
+    sample.gyro_z = record.values[5];
+    return sample;
+}
+
+// Feeds a log through a fresh pipeline the way a replay on the device
+// does; calls row() after every accepted barometer sample
+template <typename RowFunction>
+static void replayLog(RecordSource& source, SensorPipeline& pipeline, FlightSummariser& summariser, RowFunction row) {
+    pipeline.setEventHandler(onPipelineEvent);
+    pipeline.refineGroundReference(10);
+    RecordClock clock;
+    FlightRecord record;
+    bool first = true;
+    while (source.nextSample(record)) {
+        if (first) {
+            pipeline_start_s = (record.time_us / 1000) / 1000.0;
+            first = false;
+        }
+        double seconds = clock.seconds(record.time_us);
+        summariser.add(record);
+        if (record.type == RECORD_BARO) {
+            BaroSample baro = toBaro(record);
+            if (pipeline.process(&baro, nullptr)) {
+                row(seconds);
+            }
+        } else {
+            ImuSample imu = toImu(record);
+            pipeline.process(nullptr, &imu);
+        }
+    }
+}
+
+static void runEvents(RecordSource& source, Job& job) {
+    std::vector<TimelineEntry> timeline;
+    pipeline_events = &timeline;
+    std::unique_ptr<SensorPipeline> pipeline(new SensorPipeline());
+    FlightSummariser summariser;
+    replayLog(source, *pipeline, summariser, [](double) {});
+    pipeline_events = nullptr;
+
+    if (source.endsAtLanding()) {
+        summariser.endAtLanding();
+    }
+    summariser.getSummary(job.summary);
+    job.summary.flight_number = source.getFlightNumber();
+    job.summarised = true;
+    const FlightSummary& s = job.summary;
+    if (s.apogee_s != FlightSummary::NOT_SEEN) {
+        timeline.push_back({ s.apogee_s, format("apogee %.1f m", s.apogee_m) });
+    }
+    if (s.max_acceleration_s != FlightSummary::NOT_SEEN) {
+        timeline.push_back({ s.max_acceleration_s, format("peak %.2f g", s.max_acceleration_g) });
+    }
+    if (s.touchdown_s != FlightSummary::NOT_SEEN) {
+        timeline.push_back({ s.touchdown_s, format("touchdown, %.1f m/s mean descent", s.mean_descent_rate) });
+    }
+    std::stable_sort(timeline.begin(), timeline.end(),
+                     [](const TimelineEntry& a, const TimelineEntry& b) { return a.seconds < b.seconds; });
+
+    job.output += format("%s: %s\n", job.name.c_str(), source.describe());
+    for (const TimelineEntry& entry : timeline) {
+        job.output += format("  %9.3f s  %s\n", entry.seconds, entry.text.c_str());
+    }
+}
+
+static void runCsv(RecordSource& source, Job& job, const Options& options) {
+    FILE* out = openOutput(options, job, ".csv");
+    if (out == nullptr) {
+        job.error = "cannot create output";
+        return;
+    }
+    fprintf(out, "time_s,type");
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        fprintf(out, ",%s", COLUMNS[c].name);
+    }
+    fprintf(out, "\n");
+
+    RecordClock clock;
+    FlightRecord record;
+    uint64_t rows = 0;
+    while (source.nextSample(record)) {
+        bool baro = record.type == RECORD_BARO;
+        fprintf(out, "%.6f,%s", clock.seconds(record.time_us), baro ? "baro" : "imu");
+        if (baro) {
+            fprintf(out, ",%.2f,%.2f,,,,,,\n", record.values[0], record.values[1]);
+        } else {
+            fprintf(out, ",,,%.5f,%.5f,%.5f,%.4f,%.4f,%.4f\n", record.values[0], record.values[1], record.values[2],
+                    record.values[3], record.values[4], record.values[5]);
+        }
+        rows++;
+    }
+    closeOutput(out);
+    if (out != stdout) {
+        job.output += format("%s: %llu rows\n", job.name.c_str(), (unsigned long long)rows);
+    }
+}
+
+// One directory per stream; every column is a flat array of rows
+static void runColumns(RecordSource& source, Job& job, const Options& options) {
+    static const char* STREAMS[2] = { "baro", "imu" };
+    FILE* files[2][7] = {};
+    uint64_t rows[2] = { 0, 0 };
+    std::vector<char> buffers(2 * 7 * 65536);
+    bool ok = true;
+    for (int s = 0; s < 2 && ok; s++) {
+        std::string dir = options.out_dir + "/" + job.name + "." + STREAMS[s];
+        mkdir(dir.c_str(), 0755);
+        int column = 0;
+        files[s][column++] = fopen((dir + "/time_s.f64").c_str(), "wb");
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            if (COLUMNS[c].type == (s == 0 ? RECORD_BARO : RECORD_IMU)) {
+                files[s][column++] = fopen((dir + "/" + COLUMNS[c].name + ".f32").c_str(), "wb");
+            }
+        }
+        for (int c = 0; c < column; c++) {
+            ok = ok && files[s][c] != nullptr;
+            if (files[s][c] != nullptr) {
+                setvbuf(files[s][c], &buffers[(s * 7 + c) * 65536], _IOFBF, 65536);
+            }
+        }
+    }
+
+    RecordClock clock;
+    FlightRecord record;
+    while (ok && source.nextSample(record)) {
+        int s = record.type == RECORD_BARO ? 0 : 1;
+        double seconds = clock.seconds(record.time_us);
+        fwrite(&seconds, sizeof(seconds), 1, files[s][0]);
+        for (int c = 0; c < (s == 0 ? 2 : 6); c++) {
+            fwrite(&record.values[c], sizeof(float), 1, files[s][c + 1]);
+        }
+        rows[s]++;
+    }
+
+    for (int s = 0; s < 2; s++) {
+        for (int c = 0; c < 7; c++) {
+            if (files[s][c] != nullptr) {
+                fclose(files[s][c]);
+            }
+        }
+        if (!ok) {
+            continue;
+        }
+        std::string path = options.out_dir + "/" + job.name + "." + STREAMS[s] + "/schema.json";
+        FILE* schema = fopen(path.c_str(), "w");
+        if (schema == nullptr) {
+            ok = false;
+            continue;
+        }
+        fprintf(schema, "{\"rows\":%llu,\"byte_order\":\"little\",\"columns\":[{\"name\":\"time_s\",\"type\":\"float64\"}",
+                (unsigned long long)rows[s]);
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            if (COLUMNS[c].type == (s == 0 ? RECORD_BARO : RECORD_IMU)) {
+                fprintf(schema, ",{\"name\":\"%s\",\"type\":\"float32\"}", COLUMNS[c].name);
+            }
+        }
+        fprintf(schema, "]}\n");
+        fclose(schema);
+    }
+    if (!ok) {
+        job.error = "cannot create output";
+        return;
+    }
+    job.output += format("%s: %llu barometer and %llu IMU rows\n", job.name.c_str(), (unsigned long long)rows[0],
+                         (unsigned long long)rows[1]);
+}
+
+static void runReplay(RecordSource& source, Job& job, const Options& options) {
+    FILE* out = openOutput(options, job, ".replay.csv");
+    if (out == nullptr) {
+        job.error = "cannot create output";
+        return;
+    }
+    fprintf(out, "time_s,pressure_pa,altitude_agl_m,climb_rate_1s,acceleration_g,vertical_acceleration_g,tilt_deg,"
+                 "phase,spikes\n");
+    std::unique_ptr<SensorPipeline> pipeline(new SensorPipeline());
+    FlightSummariser summariser;
+    SensorPipeline& p = *pipeline;
+    replayLog(source, p, summariser, [&](double seconds) {
+        const SensorState& state = p.getState();
+        fprintf(out, "%.6f,%.2f,%.3f,%.3f,%.3f,%.3f,%.2f,%s,%u\n", seconds, state.pressure, p.getAltitudeAgl(),
+                p.getStats(SensorPipeline::CHANNEL_ALTITUDE, SensorPipeline::WINDOW_1S).getRate(),
+                state.current_acceleration, state.vertical_acceleration, state.tilt,
+                FlightPhaseDetector::getPhaseName(p.getPhaseDetector().getPhase()), state.baro_spikes);
+    });
+    closeOutput(out);
+    if (out != stdout) {
+        const SensorState& state = p.getState();
+        job.output += format("%s: max %.1f m AGL, %.2f g on one axis, %u spikes\n", job.name.c_str(), state.max_altitude -
+                             state.baseline_altitude, state.max_acceleration, state.baro_spikes);
+    }
+}
+
+static void runJob(Job& job, const Options& options) {
+    RecordSource source;
+    if (!source.open(job, job.error)) {
+        return;
+    }
+    if (options.command == "stats") {
+        runStats(source, job);
+    } else if (options.command == "events") {
+        runEvents(source, job);
+    } else if (options.command == "csv") {
+        runCsv(source, job, options);
+    } else if (options.command == "columns") {
+        runColumns(source, job, options);
+    } else {
+        runReplay(source, job, options);
+    }
+}
+
+static std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+// A partition image becomes one job per stored log, oldest first
+static void addJobs(const std::string& path, std::vector<Job>& jobs) {
+    Job job;
+    job.path = path;
+    job.name = baseName(path);
+    MappedFile file;
+    InputKind kind;
+    if (!file.open(path) || !detectKind(file, kind) || kind != INPUT_IMAGE) {
+        jobs.push_back(job);   // Any error is reported when it runs
+        return;
+    }
+    ImageFlash flash(file.data, file.size);
+    std::unique_ptr<SegmentStore> store(new SegmentStore());
+    if (!store->begin(&flash) || store->getLogCount() == 0) {
+        job.error = "no flight logs in the image";
+        jobs.push_back(job);
+        return;
+    }
+    for (int i = 0; i < store->getLogCount(); i++) {
+        Job log_job = job;
+        log_job.log_id = store->getLog(i).id;
+        log_job.name = job.name + "-flight-" + std::to_string(log_job.log_id);
+        jobs.push_back(log_job);
+    }
+}
+
+static void printSeason(const std::vector<Job>& jobs) {
+    int flights = 0;
+    double flight_s = 0.0;
+    const Job* highest = nullptr;
+    const Job* hardest = nullptr;
+    for (const Job& job : jobs) {
+        if (!job.summarised || !job.summary.launched) {
+            continue;
+        }
+        flights++;
+        if (job.summary.landed) {
+            flight_s += job.summary.touchdown_s - job.summary.launch_s;
+        }
+        if (highest == nullptr || job.summary.apogee_m > highest->summary.apogee_m) {
+            highest = &job;
+        }
+        if (hardest == nullptr || job.summary.max_acceleration_g > hardest->summary.max_acceleration_g) {
+            hardest = &job;
+        }
+    }
+    printf("Season: %d flights in %zu logs, %.1f s in the air", flights, jobs.size(), flight_s);
+    if (highest != nullptr) {
+        printf(", highest %.1f m (%s), hardest %.2f g (%s)", highest->summary.apogee_m, highest->name.c_str(),
+               hardest->summary.max_acceleration_g, hardest->name.c_str());
+    }
+    printf("\n");
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: flight_tool stats|events|csv|columns|replay [-j threads] [-o dir] log...\n"
+            "  logs: .ttfa flight archives, .ttfl record logs or flightlog partition dumps\n");
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            options.threads = (unsigned)atoi(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            options.out_dir = argv[++i];
+        } else if (options.command.empty()) {
+            options.command = arg;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    const char* commands[] = { "stats", "events", "csv", "columns", "replay" };
+    if (std::find_if(std::begin(commands), std::end(commands),
+                     [&](const char* c) { return options.command == c; }) == std::end(commands) ||
+        options.inputs.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::vector<Job> jobs;
+    for (const std::string& input : options.inputs) {
+        addJobs(input, jobs);
+    }
+    bool to_stdout = options.command == "csv" || options.command == "replay";
+    if (options.out_dir.empty() && (options.command == "columns" || (to_stdout && jobs.size() > 1))) {
+        fprintf(stderr, "flight_tool: %s of %zu logs needs -o DIR\n", options.command.c_str(), jobs.size());
+        return 2;
+    }
+    if (!options.out_dir.empty()) {
+        mkdir(options.out_dir.c_str(), 0755);
+    }
+
+    unsigned threads = options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+    threads = std::max(1u, std::min(threads, (unsigned)jobs.size()));
+    std::atomic<size_t> next_job(0);
+    auto worker = [&]() {
+        for (size_t j = next_job++; j < jobs.size(); j = next_job++) {
+            if (jobs[j].error.empty()) {
+                runJob(jobs[j], options);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    int failed = 0;
+    for (const Job& job : jobs) {
+        if (!job.error.empty()) {
+            fprintf(stderr, "%s: %s\n", job.name.c_str(), job.error.c_str());
+            failed++;
+        }
+        fputs(job.output.c_str(), stdout);
+    }
+    if (options.command == "stats" && jobs.size() > 1) {
+        printSeason(jobs);
+    }
+    return failed > 0 ? 1 : 0;
+}
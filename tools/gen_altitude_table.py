@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+"""Generate src/altitude_table.h, the fixed-point pressure-to-altitude table.
+
+The firmware converts pressure to altitude by linear interpolation in this
+table instead of calling powf(), so the result is bit-exact on every
+platform. The values use the same formula and sea level pressure as
+pressureToAltitude() in src/sensor_types.h, evaluated in double precision.
+
+Usage:
+    python3 tools/gen_altitude_table.py > src/altitude_table.h
+"""
+
+SEA_LEVEL_PA = 101325.0
+BASE_PA = 30000          # Bottom of the plausible pressure range
+STEP_SHIFT = 8           # 256 Pa between entries: < 5 cm interpolation error
+TOP_PA = 110000
+ALTITUDE_FRAC_BITS = 16  # AltitudeFx
+
+
+def altitude(pressure_pa):
+    return 44330.0 * (1.0 - (pressure_pa / SEA_LEVEL_PA) ** 0.1903)
+
+
+def main():
+    step = 1 << STEP_SHIFT
+    count = (TOP_PA - BASE_PA + step - 1) // step + 2
+    values = [round(altitude(BASE_PA + i * step) * (1 << ALTITUDE_FRAC_BITS)) for i in range(count)]
+
+    print("#ifndef ALTITUDE_TABLE_H")
+    print("#define ALTITUDE_TABLE_H")
+    print()
+    print("#include <stdint.h>")
+    print()
+    print("// Generated by tools/gen_altitude_table.py - do not edit.")
+    print("// Altitude (Q15.16 m) at BASE_PA + i * 2^STEP_SHIFT Pa, sea level %.0f Pa." % SEA_LEVEL_PA)
+    print("static const int32_t ALTITUDE_TABLE_BASE_PA = %d;" % BASE_PA)
+    print("static const int ALTITUDE_TABLE_STEP_SHIFT = %d;" % STEP_SHIFT)
+    print("static const int ALTITUDE_TABLE_SIZE = %d;" % count)
+    print()
+    print("static const int32_t altitude_table[ALTITUDE_TABLE_SIZE] = {")
+    for i in range(0, count, 6):
+        row = ", ".join("%d" % v for v in values[i:i + 6])
+        print("    %s%s" % (row, "," if i + 6 < count else ""))
+    print("};")
+    print()
+    print("#endif // ALTITUDE_TABLE_H")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Generate src/decimation_filters.h, the IMU decimation FIR coefficients.
+
+Each stage of ImuFilterBank is a linear-phase low-pass FIR that runs once per
+output sample (polyphase decimation). The taps are a Kaiser-windowed sinc
+designed for the stage's decimation factor M:
+  - passband up to PASSBAND of the output Nyquist frequency
+  - stopband from fs_out - passband, so nothing that would alias into the
+    passband survives the downsampling, attenuated by ATTENUATION_DB
+Coefficients are Q15 and each table sums to exactly 1.0 (32768), so a
+constant input comes out unchanged.
+
+Usage:
+    python3 tools/gen_decimation_filters.py > src/decimation_filters.h
+"""
+
+import math
+
+PASSBAND = 0.4           # Of the output Nyquist frequency
+ATTENUATION_DB = 60.0
+COEFF_FRAC_BITS = 15
+STAGES = [5, 4, 5]       # 500 Hz -> 100 Hz -> 25 Hz -> 5 Hz at the default IMU rate
+
+
+def bessel_i0(x):
+    total = 1.0
+    term = 1.0
+    k = 1
+    while term > 1e-12 * total:
+        term *= (x / (2.0 * k)) ** 2
+        total += term
+        k += 1
+    return total
+
+
+def design(m):
+    """Kaiser-windowed sinc low-pass for decimation by m, as Q15 integers."""
+    # Frequencies as a fraction of the input sample rate
+    f_out = 1.0 / m
+    f_pass = PASSBAND * f_out / 2.0
+    f_stop = f_out - f_pass
+    cutoff = (f_pass + f_stop) / 2.0
+    width = f_stop - f_pass
+
+    a = ATTENUATION_DB
+    beta = 0.1102 * (a - 8.7) if a > 50 else 0.5842 * (a - 21) ** 0.4 + 0.07886 * (a - 21)
+    taps = int(math.ceil((a - 8.0) / (2.285 * 2.0 * math.pi * width))) + 1
+    taps |= 1  # Odd length: symmetric about a centre tap
+
+    centre = (taps - 1) / 2.0
+    h = []
+    for n in range(taps):
+        t = n - centre
+        ideal = 2.0 * cutoff if t == 0 else math.sin(2.0 * math.pi * cutoff * t) / (math.pi * t)
+        window = bessel_i0(beta * math.sqrt(1.0 - (t / centre) ** 2)) / bessel_i0(beta)
+        h.append(ideal * window)
+    total = sum(h)
+
+    scale = 1 << COEFF_FRAC_BITS
+    q = [round(v / total * scale) for v in h]
+    q[taps // 2] += scale - sum(q)  # Exact unity DC gain
+    return q
+
+
+def main():
+    filters = [design(m) for m in STAGES]
+
+    print("#ifndef DECIMATION_FILTERS_H")
+    print("#define DECIMATION_FILTERS_H")
+    print()
+    print("#include <stdint.h>")
+    print()
+    print("// Generated by tools/gen_decimation_filters.py - do not edit.")
+    print("// Kaiser-windowed sinc low-pass per decimation stage, Q15, unity DC gain;")
+    print("// passband %.0f%% of the output Nyquist, %.0f dB stopband." % (PASSBAND * 100, ATTENUATION_DB))
+    print("static const int DECIMATION_COEFF_FRAC_BITS = %d;" % COEFF_FRAC_BITS)
+    print("static const int DECIMATION_STAGES = %d;" % len(STAGES))
+    print("static const int DECIMATION_MAX_TAPS = %d;" % max(len(f) for f in filters))
+    print()
+    for i, (m, q) in enumerate(zip(STAGES, filters)):
+        print("// Stage %d: decimate by %d, %d taps" % (i, m, len(q)))
+        print("static const int16_t decimation_stage%d[%d] = {" % (i, len(q)))
+        for j in range(0, len(q), 10):
+            row = ", ".join("%d" % v for v in q[j:j + 10])
+            print("    %s%s" % (row, "," if j + 10 < len(q) else ""))
+        print("};")
+        print()
+    print("struct DecimationStageTable {")
+    print("    uint8_t factor;")
+    print("    uint8_t taps;")
+    print("    const int16_t* coeffs;")
+    print("};")
+    print()
+    print("static const DecimationStageTable decimation_stages[DECIMATION_STAGES] = {")
+    for i, (m, q) in enumerate(zip(STAGES, filters)):
+        print("    { %d, %d, decimation_stage%d }%s" % (m, len(q), i, "," if i + 1 < len(STAGES) else ""))
+    print("};")
+    print()
+    print("#endif // DECIMATION_FILTERS_H")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Decode binary frames written by the firmware's DeferredLog in OUTPUT_BINARY mode.
+
+The format strings are read from src/log_messages.h, so the decoder always
+matches the firmware it was built alongside.
+
+Usage:
+    python3 tools/log_decode.py capture.bin
+    python3 tools/log_decode.py /dev/ttyACM0 --serial    (requires pyserial)
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC = b"\xA5\x5A"
+HEADER_SIZE = 12
+MAX_ARGS = 8
+
+ARG_NONE, ARG_INT, ARG_UINT, ARG_FLOAT, ARG_TEXT = 0, 1, 2, 3, 4
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(__file__), "..", "src", "log_messages.h")
+
+ENTRY_RE = re.compile(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+SPEC_RE = re.compile(r"%([-+ #0-9.]*)[lhz]*([a-zA-Z%])")
+
+
+def load_formats(header_path):
+    with open(header_path, encoding="utf-8") as f:
+        text = f.read()
+    table = text[text.index("#define LOG_MESSAGES(X)"):]
+    formats = []
+    for name, literal in ENTRY_RE.findall(table):
+        formats.append((name, literal.encode("utf-8").decode("unicode_escape").encode("latin-1").decode("utf-8")))
+    return formats
+
+
+def format_message(fmt, types, args):
+    index = 0
+    out = []
+    pos = 0
+    for match in SPEC_RE.finditer(fmt):
+        out.append(fmt[pos:match.start()])
+        pos = match.end()
+        flags, conv = match.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if conv == "s":
+            # 4 characters per slot, up to the slot holding the terminating NUL
+            text = b""
+            while index < len(args) and types[index] == ARG_TEXT:
+                chunk = struct.pack("<I", args[index])
+                index += 1
+                text += chunk.split(b"\0")[0]
+                if b"\0" in chunk:
+                    break
+            out.append(text.decode("utf-8", "replace"))
+            continue
+        raw = args[index] if index < len(args) else 0
+        kind = types[index] if index < len(types) else ARG_NONE
+        index += 1
+        if kind == ARG_FLOAT:
+            value = struct.unpack("<f", struct.pack("<I", raw))[0]
+        elif kind == ARG_INT:
+            value = struct.unpack("<i", struct.pack("<I", raw))[0]
+        else:
+            value = raw
+        if conv in "feEgGaA":
+            out.append(("%" + flags + conv) % float(value))
+        elif conv == "c":
+            out.append(chr(int(value) & 0xFF))
+        else:
+            out.append(("%" + flags + ("d" if conv in "di" else conv)) % int(value))
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode_frames(data, formats):
+    """Returns ([(timestamp_ms, name, text)], consumed) for the valid frames in data.
+
+    Corrupt bytes are skipped by resynchronising on the next sync word; consumed
+    is where a trailing partial frame (if any) begins.
+    """
+    frames = []
+    pos = 0
+    while True:
+        start = data.find(SYNC, pos)
+        if start < 0:
+            return frames, max(pos, len(data) - 1)
+        if start + HEADER_SIZE > len(data):
+            return frames, start
+        msg_id, arg_types, timestamp = struct.unpack_from("<HII", data, start + 2)
+        types = [(arg_types >> (i * 4)) & 0x0F for i in range(MAX_ARGS)]
+        arg_count = max([i + 1 for i, t in enumerate(types) if t != ARG_NONE], default=0)
+        end = start + HEADER_SIZE + arg_count * 4 + 1
+        if end > len(data):
+            return frames, start
+        checksum = 0
+        for b in data[start + 2:end - 1]:
+            checksum ^= b
+        if checksum != data[end - 1] or msg_id >= len(formats):
+            pos = start + 1
+            continue
+        args = list(struct.unpack_from("<%dI" % arg_count, data, start + HEADER_SIZE))
+        name, fmt = formats[msg_id]
+        frames.append((timestamp, name, format_message(fmt, types, args)))
+        pos = end
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode DeferredLog binary frames")
+    parser.add_argument("source", help="capture file, or serial port with --serial")
+    parser.add_argument("--serial", action="store_true", help="read live from a serial port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--header", default=DEFAULT_HEADER, help="path to log_messages.h")
+    parser.add_argument("--names", action="store_true", help="prefix lines with the message name")
+    args = parser.parse_args()
+
+    formats = load_formats(args.header)
+
+    def emit(timestamp, name, text):
+        prefix = "%10.3f " % (timestamp / 1000.0)
+        if args.names:
+            prefix += "%-16s " % name
+        print(prefix + text)
+
+    if not args.serial:
+        with open(args.source, "rb") as f:
+            data = f.read()
+        frames, _ = decode_frames(data, formats)
+        for frame in frames:
+            emit(*frame)
+        return 0
+
+    import serial  # pyserial, only needed for live decoding
+
+    buffer = b""
+    with serial.Serial(args.source, args.baud, timeout=0.2) as port:
+        while True:
+            buffer += port.read(4096)
+            frames, consumed = decode_frames(buffer, formats)
+            for frame in frames:
+                emit(*frame)
+            buffer = buffer[consumed:]
+
+
+if __name__ == "__main__":
+    sys.exit(main())